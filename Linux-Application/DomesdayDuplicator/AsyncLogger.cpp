@@ -0,0 +1,181 @@
+#include "AsyncLogger.h"
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+AsyncLogger::AsyncLogger(const ILogger& targetLog)
+:targetLog(targetLog)
+{
+    static_assert((QueueLength & (QueueLength - 1)) == 0, "Expected the queue length to be a power of two");
+
+    // Each queue entry is marked with the write position it can next be filled at. An entry is ready to be read when its
+    // sequence number is one past its position, and is handed back to the writers by advancing it a full lap of the
+    // queue.
+    queue.reset(new QueueEntry[QueueLength]);
+    for (size_t i = 0; i < QueueLength; ++i)
+    {
+        queue[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    loggingThread = std::thread(std::bind(std::mem_fn(&AsyncLogger::LoggingThread), this));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+AsyncLogger::~AsyncLogger()
+{
+    stopRequested.test_and_set();
+    loggingThread.join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+AsyncLogger::unique_ptr AsyncLogger::Create(const ILogger& targetLog)
+{
+    return AsyncLogger::unique_ptr(new AsyncLogger(targetLog));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Delete method
+//----------------------------------------------------------------------------------------------------------------------
+void AsyncLogger::Delete()
+{
+    delete this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Statistics methods
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t AsyncLogger::GetDroppedRecordCount() const
+{
+    return droppedRecordCount.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Severity methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AsyncLogger::IsLogSeverityEnabledInternal(Severity severity) const
+{
+    return targetLog.IsLogSeverityEnabled(severity);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Logging methods
+//----------------------------------------------------------------------------------------------------------------------
+void AsyncLogger::ProcessLogMessage(Severity severity, const wchar_t* message, size_t messageLength) const
+{
+    // Messages which were formatted by the caller still go through the queue, so they stay in order with everything
+    // else.
+    std::string messageUtf8 = WStringToUtf8String(std::wstring(message, messageLength));
+    LogRecord record;
+    BuildLogRecord(record, severity, messageUtf8.data(), messageUtf8.size());
+    PushRecord(record);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Deferred logging methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AsyncLogger::IsDeferredFormattingEnabled() const
+{
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AsyncLogger::ProcessLogRecord(const LogRecord& record) const
+{
+    PushRecord(record);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Queue methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AsyncLogger::PushRecord(const LogRecord& record) const
+{
+    // Claim the next free entry in the queue. If another thread claims the same entry first, we retry at the new write
+    // position. If the entry hasn't been read since the last lap of the queue, the queue is full, and the record is
+    // dropped.
+    size_t writePosition = queueWritePosition.load(std::memory_order_relaxed);
+    QueueEntry* entry;
+    while (true)
+    {
+        entry = &queue[writePosition & (QueueLength - 1)];
+        size_t sequence = entry->sequence.load(std::memory_order_acquire);
+        ptrdiff_t sequenceOffset = (ptrdiff_t)sequence - (ptrdiff_t)writePosition;
+        if (sequenceOffset == 0)
+        {
+            if (queueWritePosition.compare_exchange_weak(writePosition, writePosition + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (sequenceOffset < 0)
+        {
+            droppedRecordCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            writePosition = queueWritePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Copy the record into the entry, skipping the unused portion of the text buffer, and mark it as ready to read.
+    std::memcpy((void*)&entry->record, &record, offsetof(LogRecord, text) + record.textSize);
+    entry->sequence.store(writePosition + 1, std::memory_order_release);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool AsyncLogger::ProcessNextRecord()
+{
+    // Check if the next entry in the queue has been filled
+    QueueEntry& entry = queue[queueReadPosition & (QueueLength - 1)];
+    if (entry.sequence.load(std::memory_order_acquire) != (queueReadPosition + 1))
+    {
+        return false;
+    }
+
+    // Format the message and pass it on to the target logger, then hand the entry back to the writers.
+    std::wstring messageResolved = ResolveLogRecord(entry.record);
+    Severity severity = entry.record.severity;
+    entry.sequence.store(queueReadPosition + QueueLength, std::memory_order_release);
+    ++queueReadPosition;
+    targetLog.Log(severity, messageResolved);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Logging thread methods
+//----------------------------------------------------------------------------------------------------------------------
+void AsyncLogger::LoggingThread()
+{
+    while (true)
+    {
+        // Drain the queue. We check for a stop request before we start, so that every message logged before we were
+        // asked to stop is written out.
+        bool stopping = stopRequested.test();
+        bool processedRecord = false;
+        while (ProcessNextRecord())
+        {
+            processedRecord = true;
+        }
+
+        // Report any messages we had to drop since we last checked
+        uint64_t currentDroppedRecordCount = droppedRecordCount.load(std::memory_order_relaxed);
+        if (currentDroppedRecordCount != reportedDroppedRecordCount)
+        {
+            targetLog.Warning("LoggingThread(): {0} log messages were dropped because the log queue was full", currentDroppedRecordCount - reportedDroppedRecordCount);
+            reportedDroppedRecordCount = currentDroppedRecordCount;
+        }
+
+        // Wait for more messages to arrive if the queue was empty
+        if (stopping)
+        {
+            break;
+        }
+        if (!processedRecord)
+        {
+            std::this_thread::sleep_for(PollInterval);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "ILogger.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Forwards log messages to another logger from a background thread, so that threads which can't afford to wait on
+// message formatting or console output, such as the USB transfer and sample processing threads, only pay for copying a
+// compact record of the message into a queue. Format strings and argument values are captured unformatted, and are
+// only resolved to text on the logging thread. The queue is a fixed size lock-free ring which any thread can write to.
+// If the queue is full, messages are dropped rather than blocking the caller, and the number of dropped messages is
+// reported once space becomes available again.
+class AsyncLogger final : public ILogger
+{
+public:
+    // Nested types
+    typedef std::unique_ptr<AsyncLogger, ILogger::Deleter> unique_ptr;
+
+    // Constants
+    static const size_t QueueLength = 4096;
+    static constexpr std::chrono::milliseconds PollInterval = std::chrono::milliseconds(10);
+
+public:
+    // Constructors
+    static AsyncLogger::unique_ptr Create(const ILogger& targetLog);
+
+    // Delete method
+    void Delete() override;
+
+    // Statistics methods
+    uint64_t GetDroppedRecordCount() const;
+
+protected:
+    // Severity methods
+    bool IsLogSeverityEnabledInternal(Severity severity) const override;
+
+    // Logging methods
+    void ProcessLogMessage(Severity severity, const wchar_t* message, size_t messageLength) const override;
+
+    // Deferred logging methods
+    bool IsDeferredFormattingEnabled() const override;
+    void ProcessLogRecord(const LogRecord& record) const override;
+
+private:
+    // Nested types
+    struct QueueEntry
+    {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+private:
+    // Constructors
+    AsyncLogger(const ILogger& targetLog);
+    ~AsyncLogger();
+
+    // Queue methods
+    bool PushRecord(const LogRecord& record) const;
+    bool ProcessNextRecord();
+
+    // Logging thread methods
+    void LoggingThread();
+
+private:
+    const ILogger& targetLog;
+    std::unique_ptr<QueueEntry[]> queue;
+    std::thread loggingThread;
+    std::atomic_flag stopRequested;
+
+    // The queue positions are kept on separate cache lines, since the write position is shared by every thread which
+    // logs messages, while the read position is only used by the logging thread.
+    alignas(64) mutable std::atomic<size_t> queueWritePosition = 0;
+    alignas(64) size_t queueReadPosition = 0;
+    uint64_t reportedDroppedRecordCount = 0;
+    alignas(64) mutable std::atomic<uint64_t> droppedRecordCount = 0;
+};
@@ -0,0 +1,26 @@
+#include "AudioAlignmentIndex.h"
+#include "ByteOrder.h"
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Serialization methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioAlignmentIndex::BuildHeader(uint8_t* buffer, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t audioSampleRate)
+{
+    memset(buffer, 0, HeaderSizeInBytes);
+    memcpy(buffer, "DDAUDIDX", 8);
+    WriteLE32(buffer + 8, FormatVersion);
+    WriteLE32(buffer + 12, samplesPerFrame);
+    WriteLE32(buffer + 16, counterValuesPerFrame);
+    WriteLE32(buffer + 20, audioSampleRate);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioAlignmentIndex::BuildRecord(uint8_t* buffer, RecordType recordType, uint32_t frameCount, uint64_t audioSampleIndex, uint64_t rfSampleOffset, uint64_t frameCounter)
+{
+    WriteLE32(buffer + 0, (uint32_t)recordType);
+    WriteLE32(buffer + 4, frameCount);
+    WriteLE64(buffer + 8, audioSampleIndex);
+    WriteLE64(buffer + 16, rfSampleOffset);
+    WriteLE64(buffer + 24, frameCounter);
+}
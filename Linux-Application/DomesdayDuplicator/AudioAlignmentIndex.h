@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Builds the contents of an audio alignment index file, which records where every audio sample in the captured audio
+// files came from in the RF sample stream. Each audio sample is carried in one 512-sample RF frame, so the mapping is
+// described by a series of segments, each covering a run of consecutive frames. Within a segment, audio sample
+// (audioSampleIndex + n) was taken from the frame starting at RF sample (rfSampleOffset + (n * 512)), which carries the
+// frame counter value (frameCounter + (n * 58)). Frames which were lost before reaching the audio files are recorded
+// with gap records, so downstream tools can realign the audio against the RF data without cross-correlation.
+//
+// All values are little-endian. The file begins with a 32-byte header:
+//   0   char[8]  Magic "DDAUDIDX"
+//   8   uint32   Format version (1)
+//   12  uint32   RF samples per frame (512)
+//   16  uint32   Frame counter increments per frame (58)
+//   20  uint32   Audio sample rate
+//   24  uint64   Reserved (0)
+// This is followed by any number of 32-byte records:
+//   0   uint32   Record type (1 = segment, 2 = gap, 3 = discontinuity)
+//   4   uint32   Frame count
+//   8   uint64   Audio sample index
+//   16  uint64   RF sample offset
+//   24  uint64   Frame counter (48 bits)
+// For a segment, the fields describe the first frame in the segment. A gap or discontinuity record precedes the segment
+// where the audio resumes, and shares its audio sample index and RF sample offset, while its frame counter is the value
+// which was expected next. For a gap, the frame count is the number of frames missing from the audio. A discontinuity
+// is a jump in the frame counter which can't be explained by missing frames, such as after the frame sync was lost and
+// reacquired, and has a frame count of zero. The RF sample offset counts samples from the start of the capture, before
+// any decimation is applied by the capture format.
+class AudioAlignmentIndex
+{
+public:
+    // Enumerations
+    enum class RecordType : uint32_t
+    {
+        Segment = 1,
+        Gap = 2,
+        Discontinuity = 3,
+    };
+
+public:
+    // Constants
+    static const size_t HeaderSizeInBytes = 32;
+    static const size_t RecordSizeInBytes = 32;
+    static const uint32_t FormatVersion = 1;
+
+public:
+    // Serialization methods
+    static void BuildHeader(uint8_t* buffer, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t audioSampleRate);
+    static void BuildRecord(uint8_t* buffer, RecordType recordType, uint32_t frameCount, uint64_t audioSampleIndex, uint64_t rfSampleOffset, uint64_t frameCounter);
+};
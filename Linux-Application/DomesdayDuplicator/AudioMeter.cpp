@@ -0,0 +1,173 @@
+#include "AudioMeter.h"
+#include "AudioResampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Setup methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioMeter::Initialize(size_t newChannelCount, uint16_t newBitsPerSample, uint16_t significantBits)
+{
+    // Validate the requested format
+    if ((newChannelCount == 0) || ((newBitsPerSample != 16) && (newBitsPerSample != 24)) || (significantBits == 0) || (significantBits > newBitsPerSample))
+    {
+        return false;
+    }
+    channelCount = newChannelCount;
+    bitsPerSample = newBitsPerSample;
+    bytesPerSample = newBitsPerSample / 8;
+
+    // Samples which have been scaled up from a lower resolution converter are measured at their original resolution,
+    // so that the reported sample values and clip points match what the converter actually produced.
+    sampleShift = newBitsPerSample - significantBits;
+    maxPossibleSampleValue = (int32_t)((1u << (significantBits - 1)) - 1);
+    minPossibleSampleValue = -maxPossibleSampleValue - 1;
+
+    // Design the interpolation filter. This is a Kaiser-windowed sinc lowpass filter with its cutoff at the Nyquist
+    // frequency of the input, at four times the input rate. The filter is centered on a coefficient which lines up with
+    // an input sample, so the first phase simply reproduces the input and only the remaining phases need to be
+    // evaluated. Each phase is stored in reverse order and normalized to unity gain, as in AudioResampler.
+    const double kaiserBeta = 6.0;
+    const size_t prototypeLength = OversampleFactor * TapsPerPhase;
+    const double prototypeCenter = (double)((TapsPerPhase / 2) * OversampleFactor);
+    const double kaiserScale = 1.0 / AudioResampler::BesselI0(kaiserBeta);
+    std::vector<double> prototype(prototypeLength);
+    for (size_t i = 0; i < prototypeLength; ++i)
+    {
+        double time = (i - prototypeCenter) / (double)OversampleFactor;
+        double sinc = (time == 0.0) ? 1.0 : (std::sin(std::numbers::pi * time) / (std::numbers::pi * time));
+        double windowPosition = (i - prototypeCenter) / prototypeCenter;
+        double window = AudioResampler::BesselI0(kaiserBeta * std::sqrt(std::max(0.0, 1.0 - (windowPosition * windowPosition)))) * kaiserScale;
+        prototype[i] = sinc * window;
+    }
+    phaseCoefficients.assign(OversampleFactor * TapsPerPhase, 0.0f);
+    for (size_t phase = 0; phase < OversampleFactor; ++phase)
+    {
+        double phaseSum = 0.0;
+        for (size_t tap = 0; tap < TapsPerPhase; ++tap)
+        {
+            phaseSum += prototype[phase + (tap * OversampleFactor)];
+        }
+        for (size_t tap = 0; tap < TapsPerPhase; ++tap)
+        {
+            phaseCoefficients[(phase * TapsPerPhase) + (TapsPerPhase - 1 - tap)] = (float)(prototype[phase + (tap * OversampleFactor)] / phaseSum);
+        }
+    }
+
+    // Start from silence
+    channelInput.assign(channelCount, std::vector<float>(TapsPerPhase - 1, 0.0f));
+    channelLevels.assign(channelCount, ChannelLevels());
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioMeter::GetChannelCount() const
+{
+    return channelCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int32_t AudioMeter::GetMinPossibleSampleValue() const
+{
+    return minPossibleSampleValue;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int32_t AudioMeter::GetMaxPossibleSampleValue() const
+{
+    return maxPossibleSampleValue;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Measurement methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioMeter::Process(const uint8_t* frameData, size_t frameCount)
+{
+    const double fullScale = (double)maxPossibleSampleValue;
+    for (size_t channel = 0; channel < channelCount; ++channel)
+    {
+        // Gather the simple statistics for this channel, and append the samples to the interpolator history.
+        std::vector<float>& input = channelInput[channel];
+        int32_t minValue = maxPossibleSampleValue;
+        int32_t maxValue = minPossibleSampleValue;
+        size_t clippedMinCount = 0;
+        size_t clippedMaxCount = 0;
+        int64_t sumSquares = 0;
+        const uint8_t* sampleData = frameData + (channel * bytesPerSample);
+        const size_t frameSizeInBytes = channelCount * bytesPerSample;
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            int32_t sample;
+            if (bitsPerSample == 16)
+            {
+                sample = (int16_t)((uint16_t)sampleData[0] | ((uint16_t)sampleData[1] << 8));
+            }
+            else
+            {
+                sample = (int32_t)(((uint32_t)sampleData[0] << 8) | ((uint32_t)sampleData[1] << 16) | ((uint32_t)sampleData[2] << 24)) >> 8;
+            }
+            sample >>= sampleShift;
+            sampleData += frameSizeInBytes;
+
+            minValue = std::min(minValue, sample);
+            maxValue = std::max(maxValue, sample);
+            clippedMinCount += (sample == minPossibleSampleValue) ? 1 : 0;
+            clippedMaxCount += (sample == maxPossibleSampleValue) ? 1 : 0;
+            sumSquares += (int64_t)sample * (int64_t)sample;
+            input.push_back((float)sample);
+        }
+
+        // Find the largest interpolated value between the samples. The first phase reproduces the input samples
+        // themselves, which are already covered by the sample peak.
+        float maxInterpolatedValue = 0.0f;
+        size_t outputCount = input.size() - (TapsPerPhase - 1);
+        for (size_t i = 0; i < outputCount; ++i)
+        {
+            for (size_t phase = 1; phase < OversampleFactor; ++phase)
+            {
+                maxInterpolatedValue = std::max(maxInterpolatedValue, std::abs(FilterPhase(phaseCoefficients.data() + (phase * TapsPerPhase), input.data() + i)));
+            }
+        }
+        input.erase(input.begin(), input.begin() + outputCount);
+
+        // Publish the levels for this block
+        ChannelLevels& levels = channelLevels[channel];
+        levels.minSampleValue = minValue;
+        levels.maxSampleValue = maxValue;
+        levels.clippedMinSampleCount = clippedMinCount;
+        levels.clippedMaxSampleCount = clippedMaxCount;
+        if (frameCount > 0)
+        {
+            levels.peak = std::max(std::abs((double)minValue), std::abs((double)maxValue)) / fullScale;
+            levels.rms = std::sqrt((double)sumSquares / (double)frameCount) / fullScale;
+            levels.truePeak = std::max(levels.peak, (double)maxInterpolatedValue / fullScale);
+        }
+        else
+        {
+            levels = ChannelLevels();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+const AudioMeter::ChannelLevels& AudioMeter::GetChannelLevels(size_t channel) const
+{
+    return channelLevels[channel];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float AudioMeter::FilterPhase(const float* coefficients, const float* input) const
+{
+    // Accumulate into several independent sums, so the compiler is free to vectorize the loop.
+    const size_t laneCount = 4;
+    float sums[laneCount] = {};
+    for (size_t tap = 0; tap < TapsPerPhase; tap += laneCount)
+    {
+        for (size_t lane = 0; lane < laneCount; ++lane)
+        {
+            sums[lane] += coefficients[tap + lane] * input[tap + lane];
+        }
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
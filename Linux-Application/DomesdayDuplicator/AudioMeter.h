@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Measures the level of each channel of a block of interleaved PCM audio. For every block the sample range, clip
+// counts, sample peak and RMS level are gathered in local accumulators in a single pass, and the true (inter-sample)
+// peak is estimated by upsampling the signal by a factor of four with a short polyphase FIR interpolator, in the manner
+// of ITU-R BS.1770. The interpolator history is carried between blocks, so a peak that falls across a block boundary is
+// still seen. Levels are normalized so that a full scale sample has a level of 1.
+class AudioMeter
+{
+public:
+    // Structures
+    struct ChannelLevels
+    {
+        int32_t minSampleValue = 0;
+        int32_t maxSampleValue = 0;
+        size_t clippedMinSampleCount = 0;
+        size_t clippedMaxSampleCount = 0;
+        double peak = 0.0;
+        double rms = 0.0;
+        double truePeak = 0.0;
+    };
+
+public:
+    // Constants
+    static const size_t OversampleFactor = 4;
+    static const size_t TapsPerPhase = 12;
+
+public:
+    // Setup methods
+    bool Initialize(size_t channelCount, uint16_t bitsPerSample, uint16_t significantBits);
+    size_t GetChannelCount() const;
+    int32_t GetMinPossibleSampleValue() const;
+    int32_t GetMaxPossibleSampleValue() const;
+
+    // Measurement methods
+    void Process(const uint8_t* frameData, size_t frameCount);
+    const ChannelLevels& GetChannelLevels(size_t channel) const;
+
+private:
+    // Measurement methods
+    float FilterPhase(const float* coefficients, const float* input) const;
+
+private:
+    size_t channelCount = 0;
+    uint16_t bitsPerSample = 0;
+    size_t bytesPerSample = 0;
+    unsigned int sampleShift = 0;
+    int32_t minPossibleSampleValue = 0;
+    int32_t maxPossibleSampleValue = 0;
+    std::vector<float> phaseCoefficients;
+    std::vector<std::vector<float>> channelInput;
+    std::vector<ChannelLevels> channelLevels;
+};
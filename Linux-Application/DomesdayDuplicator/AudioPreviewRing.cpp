@@ -0,0 +1,149 @@
+#include "AudioPreviewRing.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Allocation methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewRing::Allocate(size_t newFrameCapacity, size_t newBytesPerFrame)
+{
+    Release();
+    buffer.reset(new (std::nothrow) uint8_t[newFrameCapacity * newBytesPerFrame]);
+    if (!buffer)
+    {
+        return false;
+    }
+    frameCapacity = newFrameCapacity;
+    bytesPerFrame = newBytesPerFrame;
+    writePosition = 0;
+    readPosition = 0;
+    droppedFrameCount = 0;
+    framesAvailable.clear();
+    interruptRequested.clear();
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewRing::Release()
+{
+    buffer.reset();
+    frameCapacity = 0;
+    bytesPerFrame = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Status methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioPreviewRing::GetFrameCapacity() const
+{
+    return frameCapacity;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioPreviewRing::GetBytesPerFrame() const
+{
+    return bytesPerFrame;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioPreviewRing::GetAvailableFrameCount() const
+{
+    // Load the read position first, so the count can never appear negative if a push and consume both occur between
+    // the two loads.
+    uint64_t currentReadPosition = readPosition;
+    uint64_t currentWritePosition = writePosition;
+    return (size_t)(currentWritePosition - currentReadPosition);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t AudioPreviewRing::GetDroppedFrameCount() const
+{
+    return droppedFrameCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Producer methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioPreviewRing::Push(const uint8_t* frameData, size_t frameCount)
+{
+    // Take as many frames as there's currently space for, and drop the rest. We never wait for the consumer here.
+    uint64_t currentWritePosition = writePosition;
+    size_t freeFrameCount = frameCapacity - (size_t)(currentWritePosition - readPosition);
+    size_t acceptedFrameCount = std::min(frameCount, freeFrameCount);
+    if (acceptedFrameCount < frameCount)
+    {
+        droppedFrameCount += (frameCount - acceptedFrameCount);
+    }
+    if (acceptedFrameCount == 0)
+    {
+        return 0;
+    }
+
+    // Copy the frames into the ring, wrapping around to the start of the buffer if required
+    size_t writeFrameOffset = (size_t)(currentWritePosition % frameCapacity);
+    size_t firstPartFrameCount = std::min(acceptedFrameCount, frameCapacity - writeFrameOffset);
+    memcpy(buffer.get() + (writeFrameOffset * bytesPerFrame), frameData, firstPartFrameCount * bytesPerFrame);
+    memcpy(buffer.get(), frameData + (firstPartFrameCount * bytesPerFrame), (acceptedFrameCount - firstPartFrameCount) * bytesPerFrame);
+
+    // Publish the frames to the consumer
+    writePosition = currentWritePosition + acceptedFrameCount;
+    framesAvailable.test_and_set();
+    framesAvailable.notify_all();
+    return acceptedFrameCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Consumer methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewRing::WaitForFrames()
+{
+    // Note that we clear the frames available flag before checking the write position, so that a push which occurs
+    // after our check is guaranteed to wake us.
+    while (true)
+    {
+        framesAvailable.clear();
+        if (interruptRequested.test())
+        {
+            return false;
+        }
+        if (GetAvailableFrameCount() > 0)
+        {
+            return true;
+        }
+        framesAvailable.wait(false);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewRing::Interrupt()
+{
+    interruptRequested.test_and_set();
+    framesAvailable.test_and_set();
+    framesAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t AudioPreviewRing::Peek(const uint8_t*& frameData, size_t maxFrameCount) const
+{
+    // Return the frames up to the end of the buffer. Any frames which have wrapped around to the start are returned by
+    // the next call.
+    uint64_t currentReadPosition = readPosition;
+    size_t readFrameOffset = (size_t)(currentReadPosition % frameCapacity);
+    size_t contiguousFrameCount = std::min((size_t)(writePosition - currentReadPosition), frameCapacity - readFrameOffset);
+    frameData = buffer.get() + (readFrameOffset * bytesPerFrame);
+    return std::min(contiguousFrameCount, maxFrameCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewRing::Consume(size_t frameCount)
+{
+    readPosition += frameCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewRing::Discard(size_t frameCount)
+{
+    readPosition += frameCount;
+    droppedFrameCount += frameCount;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A small single-producer, single-consumer ring of fixed-size audio frames, used to pass decoded audio to a live
+// preview without ever holding up the capture. Unlike StagingBuffer, the producer never waits for space. Frames which
+// don't fit are dropped and counted, so a consumer which falls behind only loses preview audio. The consumer may also
+// discard frames it considers too old, to keep the preview latency bounded.
+class AudioPreviewRing
+{
+public:
+    // Allocation methods
+    bool Allocate(size_t frameCapacity, size_t bytesPerFrame);
+    void Release();
+
+    // Status methods
+    size_t GetFrameCapacity() const;
+    size_t GetBytesPerFrame() const;
+    size_t GetAvailableFrameCount() const;
+    uint64_t GetDroppedFrameCount() const;
+
+    // Producer methods
+    size_t Push(const uint8_t* frameData, size_t frameCount);
+
+    // Consumer methods
+    bool WaitForFrames();
+    void Interrupt();
+    size_t Peek(const uint8_t*& frameData, size_t maxFrameCount) const;
+    void Consume(size_t frameCount);
+    void Discard(size_t frameCount);
+
+private:
+    std::unique_ptr<uint8_t[]> buffer;
+    size_t frameCapacity = 0;
+    size_t bytesPerFrame = 0;
+    std::atomic<uint64_t> writePosition = 0;
+    std::atomic<uint64_t> readPosition = 0;
+    std::atomic<uint64_t> droppedFrameCount = 0;
+    std::atomic_flag framesAvailable;
+    std::atomic_flag interruptRequested;
+};
@@ -0,0 +1,297 @@
+#include "AudioPreviewStream.h"
+#include "WavHeader.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <functional>
+#include <system_error>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+AudioPreviewStream::AudioPreviewStream(const ILogger& log)
+:log(log)
+{ }
+
+//----------------------------------------------------------------------------------------------------------------------
+AudioPreviewStream::~AudioPreviewStream()
+{
+    Stop();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Logging methods
+//----------------------------------------------------------------------------------------------------------------------
+const ILogger& AudioPreviewStream::Log() const
+{
+    return log;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Stream methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewStream::Start(const std::filesystem::path& path, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample)
+{
+    Stop();
+#ifdef _WIN32
+    Log().Error("Start(): Audio preview streams are not supported on this platform, requested path {0}", path);
+    return false;
+#else
+    // Allocate the ring which carries audio from the capture to the stream thread
+    size_t ringFrameCount = (size_t)(((uint64_t)sampleRate * RingDuration.count()) / 1000);
+    if (!ring.Allocate(ringFrameCount, (size_t)channelCount * (bitsPerSample / 8)))
+    {
+        Log().Error("Start(): Failed to allocate the audio preview ring");
+        return false;
+    }
+    streamPath = path;
+    streamChannelCount = channelCount;
+    streamSampleRate = sampleRate;
+    streamBitsPerSample = bitsPerSample;
+
+    // Decide how the audio will be delivered. An existing named pipe is written to directly, otherwise we listen for
+    // connections on a socket at the target path. We'll replace a stale socket left behind by a previous capture, but
+    // we won't remove anything else which is in the way.
+    std::error_code errorCode;
+    std::filesystem::file_status pathStatus = std::filesystem::status(path, errorCode);
+    useNamedPipe = std::filesystem::is_fifo(pathStatus);
+    if (!useNamedPipe)
+    {
+        if (std::filesystem::is_socket(pathStatus))
+        {
+            std::filesystem::remove(path, errorCode);
+        }
+        else if (std::filesystem::exists(pathStatus))
+        {
+            Log().Error("Start(): Audio preview path {0} already exists, and isn't a named pipe or socket", path);
+            ring.Release();
+            return false;
+        }
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::string pathString = path.string();
+        if (pathString.size() >= sizeof(address.sun_path))
+        {
+            Log().Error("Start(): Audio preview path {0} is too long for a socket", path);
+            ring.Release();
+            return false;
+        }
+        memcpy(address.sun_path, pathString.c_str(), pathString.size() + 1);
+        listenerFileDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if ((listenerFileDescriptor < 0) || (bind(listenerFileDescriptor, (const sockaddr*)&address, sizeof(address)) != 0) || (listen(listenerFileDescriptor, 1) != 0))
+        {
+            Log().Error("Start(): Failed to create audio preview socket at path {0} with error {1}", path, strerror(errno));
+            CloseListener();
+            ring.Release();
+            return false;
+        }
+    }
+
+    // Start the stream thread
+    stopRequested.clear();
+    consumerConnected = false;
+    streamRunning = true;
+    streamThread = std::thread(std::bind(std::mem_fn(&AudioPreviewStream::StreamThread), this));
+    Log().Info("Start(): Audio preview available from {0} {1}", useNamedPipe ? "named pipe" : "socket", path);
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewStream::Stop()
+{
+    if (!streamThread.joinable())
+    {
+        return;
+    }
+    stopRequested.test_and_set();
+    ring.Interrupt();
+    streamThread.join();
+    CloseListener();
+    ring.Release();
+    streamRunning = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewStream::IsRunning() const
+{
+    return streamRunning;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewStream::IsConsumerConnected() const
+{
+    return consumerConnected;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t AudioPreviewStream::GetDroppedFrameCount() const
+{
+    return ring.GetDroppedFrameCount();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Producer methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewStream::Push(const uint8_t* frameData, size_t frameCount)
+{
+    // While nobody is listening, there's no point keeping the audio
+    if (!consumerConnected)
+    {
+        return;
+    }
+    ring.Push(frameData, frameCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Stream methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewStream::StreamThread()
+{
+#ifndef _WIN32
+    // Block SIGPIPE on this thread, so a player closing its end of a named pipe shows up as a write error here, rather
+    // than terminating the application.
+    sigset_t pipeSignalSet;
+    sigemptyset(&pipeSignalSet);
+    sigaddset(&pipeSignalSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignalSet, nullptr);
+
+    const size_t maxLatencyFrameCount = (size_t)(((uint64_t)streamSampleRate * MaxLatency.count()) / 1000);
+    const size_t targetLatencyFrameCount = (size_t)(((uint64_t)streamSampleRate * TargetLatency.count()) / 1000);
+    while (!stopRequested.test())
+    {
+        // Wait for a player to connect
+        int consumerFileDescriptor = WaitForConsumer();
+        if (consumerFileDescriptor < 0)
+        {
+            break;
+        }
+        Log().Info("StreamThread(): Audio preview player connected to {0}", streamPath);
+
+        // Start the player from the current point in the capture
+        ring.Consume(ring.GetAvailableFrameCount());
+        consumerConnected = true;
+        uint8_t header[WavHeader::HeaderSizeInBytes];
+        WavHeader::BuildStream(header, streamChannelCount, streamSampleRate, streamBitsPerSample);
+        bool connected = WriteToConsumer(consumerFileDescriptor, header, sizeof(header));
+
+        // Send the audio to the player as it arrives. If the player has fallen behind, we skip ahead rather than let
+        // the latency build up.
+        while (connected && ring.WaitForFrames())
+        {
+            size_t availableFrameCount = ring.GetAvailableFrameCount();
+            if (availableFrameCount > maxLatencyFrameCount)
+            {
+                ring.Discard(availableFrameCount - targetLatencyFrameCount);
+            }
+            const uint8_t* frameData;
+            size_t frameCount = ring.Peek(frameData, targetLatencyFrameCount);
+            connected = WriteToConsumer(consumerFileDescriptor, frameData, frameCount * ring.GetBytesPerFrame());
+            if (connected)
+            {
+                ring.Consume(frameCount);
+            }
+        }
+        consumerConnected = false;
+        close(consumerFileDescriptor);
+
+        // Clear any SIGPIPE raised by the write which found the player had gone
+        timespec noWait = {};
+        while (sigtimedwait(&pipeSignalSet, nullptr, &noWait) > 0)
+        { }
+        Log().Info("StreamThread(): Audio preview player disconnected from {0}", streamPath);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+int AudioPreviewStream::WaitForConsumer()
+{
+#ifdef _WIN32
+    return -1;
+#else
+    while (!stopRequested.test())
+    {
+        if (useNamedPipe)
+        {
+            // Opening a pipe for writing without blocking fails until a reader has it open, so we simply retry
+            int fileDescriptor = open(streamPath.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+            if (fileDescriptor >= 0)
+            {
+                return fileDescriptor;
+            }
+            std::this_thread::sleep_for(PollInterval);
+        }
+        else
+        {
+            pollfd listenerPoll = { listenerFileDescriptor, POLLIN, 0 };
+            if (poll(&listenerPoll, 1, (int)PollInterval.count()) > 0)
+            {
+                int fileDescriptor = accept4(listenerFileDescriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fileDescriptor >= 0)
+                {
+                    return fileDescriptor;
+                }
+            }
+        }
+    }
+    return -1;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioPreviewStream::WriteToConsumer(int fileDescriptor, const uint8_t* data, size_t sizeInBytes)
+{
+#ifdef _WIN32
+    return false;
+#else
+    // Write the data without blocking, so that we can still notice a stop request while the player isn't reading
+    while (sizeInBytes > 0)
+    {
+        if (stopRequested.test())
+        {
+            return false;
+        }
+        pollfd consumerPoll = { fileDescriptor, POLLOUT, 0 };
+        if (poll(&consumerPoll, 1, (int)PollInterval.count()) <= 0)
+        {
+            continue;
+        }
+        ssize_t writtenSize = useNamedPipe ? write(fileDescriptor, data, sizeInBytes) : send(fileDescriptor, data, sizeInBytes, MSG_NOSIGNAL);
+        if (writtenSize < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+            {
+                continue;
+            }
+            return false;
+        }
+        data += writtenSize;
+        sizeInBytes -= (size_t)writtenSize;
+    }
+    return true;
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioPreviewStream::CloseListener()
+{
+#ifndef _WIN32
+    if (listenerFileDescriptor >= 0)
+    {
+        close(listenerFileDescriptor);
+        listenerFileDescriptor = -1;
+        std::error_code errorCode;
+        std::filesystem::remove(streamPath, errorCode);
+    }
+#endif
+}
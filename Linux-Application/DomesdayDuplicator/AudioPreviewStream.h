@@ -0,0 +1,66 @@
+#pragma once
+#include "ILogger.h"
+#include "AudioPreviewRing.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+
+// Streams live audio from a capture to a local player, such as aplay or ffplay, through a named pipe or a UNIX domain
+// socket. If the target path is an existing named pipe, the audio is written to it whenever a player has it open for
+// reading. Otherwise, a socket is created at the path, and the audio is sent to each player which connects to it in
+// turn. Every connection begins with a WAV header describing the stream, followed by the audio from the point it
+// connected. Audio is passed to the stream through an AudioPreviewRing, so a slow or stalled player can never hold up
+// the capture. Instead, frames are dropped, and the oldest audio is discarded whenever the backlog grows beyond the
+// maximum latency.
+class AudioPreviewStream
+{
+public:
+    // Constants
+    static constexpr std::chrono::milliseconds MaxLatency = std::chrono::milliseconds(80);
+    static constexpr std::chrono::milliseconds TargetLatency = std::chrono::milliseconds(40);
+    static constexpr std::chrono::milliseconds RingDuration = std::chrono::milliseconds(500);
+    static constexpr std::chrono::milliseconds PollInterval = std::chrono::milliseconds(100);
+
+public:
+    // Constructors
+    AudioPreviewStream(const ILogger& log);
+    ~AudioPreviewStream();
+
+    // Stream methods
+    bool Start(const std::filesystem::path& path, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample);
+    void Stop();
+    bool IsRunning() const;
+    bool IsConsumerConnected() const;
+    uint64_t GetDroppedFrameCount() const;
+
+    // Producer methods
+    void Push(const uint8_t* frameData, size_t frameCount);
+
+protected:
+    // Logging methods
+    const ILogger& Log() const;
+
+private:
+    // Stream methods
+    void StreamThread();
+    int WaitForConsumer();
+    bool WriteToConsumer(int fileDescriptor, const uint8_t* data, size_t sizeInBytes);
+    void CloseListener();
+
+private:
+    const ILogger& log;
+    std::filesystem::path streamPath;
+    bool useNamedPipe = false;
+    int listenerFileDescriptor = -1;
+    uint16_t streamChannelCount = 0;
+    uint32_t streamSampleRate = 0;
+    uint16_t streamBitsPerSample = 0;
+    AudioPreviewRing ring;
+    std::thread streamThread;
+    std::atomic<bool> streamRunning = false;
+    std::atomic<bool> consumerConnected = false;
+    std::atomic_flag stopRequested;
+};
@@ -0,0 +1,207 @@
+#include "AudioResampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Setup methods
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioResampler::Initialize(uint32_t newInputSampleRate, uint32_t newOutputSampleRate, size_t newChannelCount, uint16_t newBitsPerSample)
+{
+    // Validate the requested format
+    if ((newInputSampleRate == 0) || (newOutputSampleRate == 0) || (newChannelCount == 0) || ((newBitsPerSample != 16) && (newBitsPerSample != 24)))
+    {
+        return false;
+    }
+    inputSampleRate = newInputSampleRate;
+    outputSampleRate = newOutputSampleRate;
+    channelCount = newChannelCount;
+    bitsPerSample = newBitsPerSample;
+    bytesPerSample = newBitsPerSample / 8;
+
+    // Reduce the rate change to the smallest exact ratio. For 78125Hz to 48000Hz this is 384/625, and for 78125Hz to
+    // 44100Hz it's 1764/3125.
+    uint32_t divisor = std::gcd(inputSampleRate, outputSampleRate);
+    upsampleFactor = outputSampleRate / divisor;
+    downsampleFactor = inputSampleRate / divisor;
+
+    // Design the prototype lowpass filter at the upsampled rate. The filter is centered on a coefficient which lines up
+    // with an input sample, so it delays the signal by an exact number of input samples. The cutoff sits a little below
+    // the Nyquist frequency of the lower of the two rates, so the transition band is mostly complete before anything
+    // can alias. A Kaiser window with a beta of 8 gives around 80dB of stopband attenuation.
+    const double kaiserBeta = 8.0;
+    const double cutoffRatio = (0.5 * 0.92 * std::min(inputSampleRate, outputSampleRate)) / inputSampleRate;
+    const size_t prototypeLength = upsampleFactor * TapsPerPhase;
+    const double prototypeCenter = (double)((TapsPerPhase / 2) * upsampleFactor);
+    const double kaiserScale = 1.0 / BesselI0(kaiserBeta);
+    std::vector<double> prototype(prototypeLength);
+    for (size_t i = 0; i < prototypeLength; ++i)
+    {
+        // Evaluate the sinc function in units of input samples
+        double time = (i - prototypeCenter) / (double)upsampleFactor;
+        double sincArgument = 2.0 * cutoffRatio * time;
+        double sinc = (sincArgument == 0.0) ? 1.0 : (std::sin(std::numbers::pi * sincArgument) / (std::numbers::pi * sincArgument));
+        double windowPosition = (i - prototypeCenter) / prototypeCenter;
+        double window = BesselI0(kaiserBeta * std::sqrt(std::max(0.0, 1.0 - (windowPosition * windowPosition)))) * kaiserScale;
+        prototype[i] = 2.0 * cutoffRatio * sinc * window;
+    }
+
+    // Split the prototype into its phases. Each phase is stored in reverse order, so it can be applied with a forward
+    // dot product over the input history, and normalized to unity gain so no phase adds a DC ripple to the output.
+    phaseCoefficients.assign(upsampleFactor * TapsPerPhase, 0.0f);
+    for (size_t phase = 0; phase < upsampleFactor; ++phase)
+    {
+        double phaseSum = 0.0;
+        for (size_t tap = 0; tap < TapsPerPhase; ++tap)
+        {
+            phaseSum += prototype[phase + (tap * upsampleFactor)];
+        }
+        for (size_t tap = 0; tap < TapsPerPhase; ++tap)
+        {
+            phaseCoefficients[(phase * TapsPerPhase) + (TapsPerPhase - 1 - tap)] = (float)(prototype[phase + (tap * upsampleFactor)] / phaseSum);
+        }
+    }
+
+    // Prime the input history with just under half a filter of silence. The center of the filter sits half a filter
+    // length behind the newest input sample it covers, so this offsets the delay of the filter and keeps the output
+    // aligned in time with the input.
+    channelInput.assign(channelCount, std::vector<float>((TapsPerPhase / 2) - 1, 0.0f));
+    inputIndex = 0;
+    currentPhase = 0;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t AudioResampler::GetInputSampleRate() const
+{
+    return inputSampleRate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t AudioResampler::GetOutputSampleRate() const
+{
+    return outputSampleRate;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Processing methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioResampler::Process(const uint8_t* frameData, size_t frameCount, std::vector<uint8_t>& outputData)
+{
+    // Split the interleaved input into each channel
+    for (size_t frame = 0; frame < frameCount; ++frame)
+    {
+        for (size_t channel = 0; channel < channelCount; ++channel)
+        {
+            AppendInputSample(channel, frameData);
+            frameData += bytesPerSample;
+        }
+    }
+
+    // Generate as much output as the input now allows
+    outputData.clear();
+    GenerateOutput(outputData);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioResampler::Flush(std::vector<uint8_t>& outputData)
+{
+    // Feed in enough silence to bring the last real input sample up to the center of the filter
+    for (auto& input : channelInput)
+    {
+        input.insert(input.end(), (TapsPerPhase / 2) + 1, 0.0f);
+    }
+    outputData.clear();
+    GenerateOutput(outputData);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioResampler::AppendInputSample(size_t channel, const uint8_t* sampleData)
+{
+    int32_t sample;
+    if (bitsPerSample == 16)
+    {
+        sample = (int16_t)((uint16_t)sampleData[0] | ((uint16_t)sampleData[1] << 8));
+    }
+    else
+    {
+        sample = (int32_t)(((uint32_t)sampleData[0] << 8) | ((uint32_t)sampleData[1] << 16) | ((uint32_t)sampleData[2] << 24)) >> 8;
+    }
+    channelInput[channel].push_back((float)sample);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioResampler::GenerateOutput(std::vector<uint8_t>& outputData)
+{
+    // Calculate each output frame for which we have a full filter length of input
+    const float maxValue = (bitsPerSample == 16) ? 32767.0f : 8388607.0f;
+    const float minValue = -maxValue - 1.0f;
+    size_t inputLength = channelInput[0].size();
+    while ((inputIndex + TapsPerPhase) <= inputLength)
+    {
+        const float* coefficients = phaseCoefficients.data() + (currentPhase * TapsPerPhase);
+        for (size_t channel = 0; channel < channelCount; ++channel)
+        {
+            // Apply the filter phase, and pack the result into the output at the same bit depth as the input
+            float value = std::clamp(std::nearbyint(FilterPhase(coefficients, channelInput[channel].data() + inputIndex)), minValue, maxValue);
+            uint32_t sample = (uint32_t)(int32_t)value;
+            for (size_t i = 0; i < bytesPerSample; ++i)
+            {
+                outputData.push_back((uint8_t)((sample >> (i * 8)) & 0xFF));
+            }
+        }
+
+        // Step forward by the downsampling factor in the upsampled domain
+        currentPhase += downsampleFactor;
+        inputIndex += currentPhase / upsampleFactor;
+        currentPhase %= upsampleFactor;
+    }
+
+    // Discard any input which no future output frame will need
+    size_t consumedLength = std::min(inputIndex, inputLength);
+    for (auto& input : channelInput)
+    {
+        input.erase(input.begin(), input.begin() + consumedLength);
+    }
+    inputIndex -= consumedLength;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+float AudioResampler::FilterPhase(const float* coefficients, const float* input) const
+{
+    // Accumulate into several independent sums. Without this, the compiler is required to preserve the exact order of
+    // the floating point additions, which prevents it from vectorizing the loop.
+    const size_t laneCount = 8;
+    float sums[laneCount] = {};
+    for (size_t tap = 0; tap < TapsPerPhase; tap += laneCount)
+    {
+        for (size_t lane = 0; lane < laneCount; ++lane)
+        {
+            sums[lane] += coefficients[tap + lane] * input[tap + lane];
+        }
+    }
+    return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Filter design methods
+//----------------------------------------------------------------------------------------------------------------------
+double AudioResampler::BesselI0(double x)
+{
+    // Evaluate the zeroth order modified Bessel function of the first kind by its power series, which converges quickly
+    // for the range of values used in Kaiser window design.
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+    for (int k = 1; k < 64; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < (sum * 1e-12))
+        {
+            break;
+        }
+    }
+    return sum;
+}
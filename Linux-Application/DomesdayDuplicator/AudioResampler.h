@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Converts interleaved PCM audio between sample rates using a polyphase FIR filter. The rate change is reduced to an
+// exact ratio of integers L/M, and a single Kaiser-windowed sinc lowpass filter is designed for the virtual signal
+// upsampled by L. Only the L sub-filters ("phases") of that prototype which line up with real input samples are ever
+// evaluated, so each output sample costs one short dot product per channel. Coefficients for each phase are stored
+// contiguously, and channels are held in separate buffers, so the inner loop runs over contiguous memory and can be
+// vectorized by the compiler. The resampler is stateful, and can be fed audio in blocks of any size.
+class AudioResampler
+{
+public:
+    // Constants
+    static const size_t TapsPerPhase = 128;
+
+public:
+    // Setup methods
+    bool Initialize(uint32_t inputSampleRate, uint32_t outputSampleRate, size_t channelCount, uint16_t bitsPerSample);
+    uint32_t GetInputSampleRate() const;
+    uint32_t GetOutputSampleRate() const;
+
+    // Processing methods
+    void Process(const uint8_t* frameData, size_t frameCount, std::vector<uint8_t>& outputData);
+    void Flush(std::vector<uint8_t>& outputData);
+
+    // Filter design methods
+    static double BesselI0(double x);
+
+private:
+    // Processing methods
+    void AppendInputSample(size_t channel, const uint8_t* sampleData);
+    void GenerateOutput(std::vector<uint8_t>& outputData);
+    float FilterPhase(const float* coefficients, const float* input) const;
+
+private:
+    uint32_t inputSampleRate = 0;
+    uint32_t outputSampleRate = 0;
+    size_t channelCount = 0;
+    uint16_t bitsPerSample = 0;
+    size_t bytesPerSample = 0;
+    size_t upsampleFactor = 1;
+    size_t downsampleFactor = 1;
+    std::vector<float> phaseCoefficients;
+    std::vector<std::vector<float>> channelInput;
+    size_t inputIndex = 0;
+    size_t currentPhase = 0;
+};
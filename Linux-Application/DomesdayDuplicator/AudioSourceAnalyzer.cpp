@@ -0,0 +1,297 @@
+#include "AudioSourceAnalyzer.h"
+#include "AudioResampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Setup methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioSourceAnalyzer::Initialize(uint32_t newSampleRate, size_t newWindowSampleCount, bool newProduceMergedOutput)
+{
+    sampleRate = newSampleRate;
+    windowSampleCount = newWindowSampleCount;
+    produceMergedOutput = newProduceMergedOutput;
+
+    // Design the highpass filter used to isolate the noise above the audio band. This is built from a Kaiser-windowed
+    // sinc lowpass filter by spectral inversion, which requires an odd number of taps so the filter has a center tap.
+    const double kaiserBeta = 6.0;
+    const double nyquistFrequency = (double)sampleRate / 2.0;
+    const double cutoffFrequency = std::min(HighpassCutoffFrequency, nyquistFrequency * 0.8);
+    const double normalizedCutoff = cutoffFrequency / (double)sampleRate;
+    const double filterCenter = (double)(FilterTapCount / 2);
+    const double kaiserScale = 1.0 / AudioResampler::BesselI0(kaiserBeta);
+    highpassCoefficients.assign(FilterTapCount, 0.0f);
+    for (size_t i = 0; i < FilterTapCount; ++i)
+    {
+        double time = (double)i - filterCenter;
+        double sinc = (time == 0.0) ? 1.0 : (std::sin(2.0 * std::numbers::pi * normalizedCutoff * time) / (2.0 * std::numbers::pi * normalizedCutoff * time));
+        double windowPosition = time / filterCenter;
+        double window = AudioResampler::BesselI0(kaiserBeta * std::sqrt(std::max(0.0, 1.0 - (windowPosition * windowPosition)))) * kaiserScale;
+        highpassCoefficients[i] = (float)(-2.0 * normalizedCutoff * sinc * window);
+    }
+    highpassCoefficients[FilterTapCount / 2] += 1.0f;
+    noiseBandFraction = (nyquistFrequency - cutoffFrequency) / nyquistFrequency;
+
+    // Reset the window state
+    windowFirstSampleIndex = 0;
+    windowFillCount = 0;
+    for (size_t channel = 0; channel < 2; ++channel)
+    {
+        adc128s022Samples[channel].clear();
+        adc128s022Samples[channel].reserve(windowSampleCount);
+        pcm1802Samples[channel].clear();
+        pcm1802Samples[channel].reserve(windowSampleCount);
+        adc128s022History[channel].assign(FilterTapCount - 1, 0.0f);
+        pcm1802History[channel].assign(FilterTapCount - 1, 0.0f);
+    }
+    adc128s022ClippedCount = {};
+    pcm1802ClippedCount = {};
+    windowFrameData16.clear();
+    windowFrameData24.clear();
+    if (produceMergedOutput)
+    {
+        windowFrameData16.reserve(windowSampleCount * 4);
+        windowFrameData24.reserve(windowSampleCount * 6);
+    }
+    selectedSourceValid = false;
+    completedWindowResults.clear();
+    completedMergedFrameData.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Analysis methods
+//----------------------------------------------------------------------------------------------------------------------
+void AudioSourceAnalyzer::Process(const uint8_t* frameData16, const uint8_t* frameData24, size_t frameCount)
+{
+    // The ADC128S022 samples are 12-bit values which were scaled up to 16 bits, so they clip at 2047 * 16 rather than
+    // the 16-bit maximum.
+    const int32_t adc128s022MinValue = -2048 * 16;
+    const int32_t adc128s022MaxValue = 2047 * 16;
+    const int32_t pcm1802MinValue = -(1 << 23);
+    const int32_t pcm1802MaxValue = (1 << 23) - 1;
+    size_t frameIndex = 0;
+    while (frameIndex < frameCount)
+    {
+        size_t windowFrameCount = std::min(frameCount - frameIndex, windowSampleCount - windowFillCount);
+        for (size_t frame = frameIndex; frame < (frameIndex + windowFrameCount); ++frame)
+        {
+            for (size_t channel = 0; channel < 2; ++channel)
+            {
+                const uint8_t* sample16 = frameData16 + (frame * 4) + (channel * 2);
+                int32_t adc128s022Value = (int16_t)((uint16_t)sample16[0] | ((uint16_t)sample16[1] << 8));
+                adc128s022Samples[channel].push_back((float)adc128s022Value / 32768.0f);
+                adc128s022ClippedCount[channel] += ((adc128s022Value == adc128s022MinValue) || (adc128s022Value == adc128s022MaxValue)) ? 1 : 0;
+
+                const uint8_t* sample24 = frameData24 + (frame * 6) + (channel * 3);
+                int32_t pcm1802Value = (int32_t)(((uint32_t)sample24[0] << 8) | ((uint32_t)sample24[1] << 16) | ((uint32_t)sample24[2] << 24)) >> 8;
+                pcm1802Samples[channel].push_back((float)pcm1802Value / 8388608.0f);
+                pcm1802ClippedCount[channel] += ((pcm1802Value == pcm1802MinValue) || (pcm1802Value == pcm1802MaxValue)) ? 1 : 0;
+            }
+        }
+        if (produceMergedOutput)
+        {
+            windowFrameData16.insert(windowFrameData16.end(), frameData16 + (frameIndex * 4), frameData16 + ((frameIndex + windowFrameCount) * 4));
+            windowFrameData24.insert(windowFrameData24.end(), frameData24 + (frameIndex * 6), frameData24 + ((frameIndex + windowFrameCount) * 6));
+        }
+        windowFillCount += windowFrameCount;
+        frameIndex += windowFrameCount;
+
+        // Analyze the window once it's full
+        if (windowFillCount == windowSampleCount)
+        {
+            AnalyzeWindow();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioSourceAnalyzer::Flush()
+{
+    // Analyze whatever is left in the final partial window
+    if (windowFillCount > 0)
+    {
+        AnalyzeWindow();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioSourceAnalyzer::TakeResults(std::vector<WindowResult>& windowResults, std::vector<uint8_t>& mergedFrameData)
+{
+    windowResults.clear();
+    windowResults.swap(completedWindowResults);
+    mergedFrameData.clear();
+    mergedFrameData.swap(completedMergedFrameData);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void AudioSourceAnalyzer::AnalyzeWindow()
+{
+    // Measure each converter and the agreement between them
+    WindowResult result;
+    result.firstSampleIndex = windowFirstSampleIndex;
+    result.sampleCount = windowFillCount;
+    for (size_t channel = 0; channel < 2; ++channel)
+    {
+        result.adc128s022[channel] = MeasureChannel(adc128s022History[channel], adc128s022Samples[channel], adc128s022ClippedCount[channel]);
+        result.pcm1802[channel] = MeasureChannel(pcm1802History[channel], pcm1802Samples[channel], pcm1802ClippedCount[channel]);
+        result.correlation[channel] = MeasureCorrelation(adc128s022Samples[channel], pcm1802Samples[channel]);
+    }
+
+    // Decide which converter was healthier in this window. Where there's nothing to choose between them, we prefer the
+    // PCM1802 for its greater resolution. The selection for the merged output only changes with a clear margin.
+    result.preferredSource = IsHealthier(result.adc128s022, result.pcm1802, 0.0) ? Source::Adc128s022 : Source::Pcm1802;
+    if (!selectedSourceValid)
+    {
+        selectedSource = result.preferredSource;
+        selectedSourceValid = true;
+    }
+    else if (selectedSource == Source::Pcm1802)
+    {
+        selectedSource = IsHealthier(result.adc128s022, result.pcm1802, SwitchMarginDb) ? Source::Adc128s022 : Source::Pcm1802;
+    }
+    else
+    {
+        selectedSource = IsHealthier(result.pcm1802, result.adc128s022, SwitchMarginDb) ? Source::Pcm1802 : Source::Adc128s022;
+    }
+    result.selectedSource = selectedSource;
+    completedWindowResults.push_back(result);
+
+    // Append the selected converter's audio to the merged output, as 24-bit samples
+    if (produceMergedOutput)
+    {
+        if (selectedSource == Source::Pcm1802)
+        {
+            completedMergedFrameData.insert(completedMergedFrameData.end(), windowFrameData24.begin(), windowFrameData24.end());
+        }
+        else
+        {
+            for (size_t i = 0; i < windowFrameData16.size(); i += 2)
+            {
+                completedMergedFrameData.push_back(0);
+                completedMergedFrameData.push_back(windowFrameData16[i]);
+                completedMergedFrameData.push_back(windowFrameData16[i + 1]);
+            }
+        }
+    }
+
+    // Start the next window
+    windowFirstSampleIndex += windowFillCount;
+    windowFillCount = 0;
+    for (size_t channel = 0; channel < 2; ++channel)
+    {
+        adc128s022Samples[channel].clear();
+        pcm1802Samples[channel].clear();
+    }
+    adc128s022ClippedCount = {};
+    pcm1802ClippedCount = {};
+    windowFrameData16.clear();
+    windowFrameData24.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+AudioSourceAnalyzer::ChannelMetrics AudioSourceAnalyzer::MeasureChannel(std::vector<float>& history, const std::vector<float>& samples, size_t clippedSampleCount)
+{
+    ChannelMetrics metrics;
+    metrics.clippedSampleCount = clippedSampleCount;
+    if (samples.empty())
+    {
+        return metrics;
+    }
+
+    // Measure the total power of the signal, excluding any DC offset
+    double sum = 0.0;
+    for (float sample : samples)
+    {
+        sum += sample;
+    }
+    double mean = sum / (double)samples.size();
+    double totalPower = 0.0;
+    for (float sample : samples)
+    {
+        totalPower += ((double)sample - mean) * ((double)sample - mean);
+    }
+    totalPower /= (double)samples.size();
+
+    // Measure the power above the audio band. The filter runs over the tail of the previous window followed by this
+    // one, so there's no discontinuity at the window boundary.
+    history.insert(history.end(), samples.begin(), samples.end());
+    double highpassPower = 0.0;
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const float* input = history.data() + i;
+        float output = 0.0f;
+        for (size_t tap = 0; tap < FilterTapCount; ++tap)
+        {
+            output += highpassCoefficients[tap] * input[tap];
+        }
+        highpassPower += (double)output * (double)output;
+    }
+    highpassPower /= (double)samples.size();
+    history.erase(history.begin(), history.end() - (FilterTapCount - 1));
+
+    // Estimate the noise across the whole band from the noise above the audio band, and compare it with the rest
+    double noisePower = highpassPower / noiseBandFraction;
+    double signalPower = std::max(totalPower - noisePower, 0.0);
+    if (noisePower <= 0.0)
+    {
+        metrics.snrDb = (signalPower > 0.0) ? MaxSnrDb : 0.0;
+    }
+    else
+    {
+        metrics.snrDb = std::clamp(10.0 * std::log10(std::max(signalPower, 1e-30) / noisePower), -MaxSnrDb, MaxSnrDb);
+    }
+    return metrics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+double AudioSourceAnalyzer::MeasureCorrelation(const std::vector<float>& first, const std::vector<float>& second)
+{
+    // Calculate the Pearson correlation coefficient between the two converters
+    size_t sampleCount = std::min(first.size(), second.size());
+    if (sampleCount == 0)
+    {
+        return 0.0;
+    }
+    double firstSum = 0.0;
+    double secondSum = 0.0;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        firstSum += first[i];
+        secondSum += second[i];
+    }
+    double firstMean = firstSum / (double)sampleCount;
+    double secondMean = secondSum / (double)sampleCount;
+    double covariance = 0.0;
+    double firstVariance = 0.0;
+    double secondVariance = 0.0;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        double firstDeviation = (double)first[i] - firstMean;
+        double secondDeviation = (double)second[i] - secondMean;
+        covariance += firstDeviation * secondDeviation;
+        firstVariance += firstDeviation * firstDeviation;
+        secondVariance += secondDeviation * secondDeviation;
+    }
+    if ((firstVariance <= 0.0) || (secondVariance <= 0.0))
+    {
+        return 0.0;
+    }
+    return covariance / std::sqrt(firstVariance * secondVariance);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool AudioSourceAnalyzer::IsHealthier(const std::array<ChannelMetrics, 2>& first, const std::array<ChannelMetrics, 2>& second, double marginDb)
+{
+    // Clipping outweighs noise, so the converter which clipped less is always the healthier one. Otherwise, we compare
+    // the SNR of the worse channel from each converter.
+    size_t firstClippedCount = first[0].clippedSampleCount + first[1].clippedSampleCount;
+    size_t secondClippedCount = second[0].clippedSampleCount + second[1].clippedSampleCount;
+    if (firstClippedCount != secondClippedCount)
+    {
+        return (firstClippedCount < secondClippedCount);
+    }
+    double firstSnrDb = std::min(first[0].snrDb, first[1].snrDb);
+    double secondSnrDb = std::min(second[0].snrDb, second[1].snrDb);
+    return (firstSnrDb > (secondSnrDb + marginDb));
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compares the audio captured by the ADC128S022 and PCM1802 converters when both are recording the same signal. The
+// audio is divided into fixed windows, and for each window and channel we estimate the SNR and count the clipped
+// samples from each converter, and measure the correlation between the two. Since the source material has no content
+// above 20kHz, the noise floor is estimated from the power remaining after a highpass filter with its cutoff above the
+// audio band, scaled up to cover the whole band on the assumption that the noise is white. The SNR is then the ratio of
+// the remaining power to that noise estimate.
+//
+// Each window records which converter was the healthier one: the one with fewer clipped samples, or failing that, the
+// one with the better SNR on its worse channel. A merged 24-bit stereo stream can also be produced, taking each window
+// from a selected converter. The selection only moves to the other converter when it's clipping less, or its SNR is
+// better by a clear margin, so that the merged output doesn't flip back and forth between two similar sources. No gain
+// or delay matching is applied between the converters, so a switch may be audible.
+class AudioSourceAnalyzer
+{
+public:
+    // Enumerations
+    enum class Source
+    {
+        Adc128s022,
+        Pcm1802,
+    };
+
+public:
+    // Structures
+    struct ChannelMetrics
+    {
+        double snrDb = 0.0;
+        size_t clippedSampleCount = 0;
+    };
+    struct WindowResult
+    {
+        uint64_t firstSampleIndex = 0;
+        size_t sampleCount = 0;
+        std::array<ChannelMetrics, 2> adc128s022;
+        std::array<ChannelMetrics, 2> pcm1802;
+        std::array<double, 2> correlation = {};
+        Source preferredSource = Source::Pcm1802;
+        Source selectedSource = Source::Pcm1802;
+    };
+
+public:
+    // Constants
+    static const size_t FilterTapCount = 63;
+    static constexpr double HighpassCutoffFrequency = 28000.0;
+    static constexpr double MaxSnrDb = 144.0;
+    static constexpr double SwitchMarginDb = 6.0;
+
+public:
+    // Setup methods
+    void Initialize(uint32_t sampleRate, size_t windowSampleCount, bool produceMergedOutput);
+
+    // Analysis methods
+    void Process(const uint8_t* frameData16, const uint8_t* frameData24, size_t frameCount);
+    void Flush();
+    void TakeResults(std::vector<WindowResult>& windowResults, std::vector<uint8_t>& mergedFrameData);
+
+private:
+    // Analysis methods
+    void AnalyzeWindow();
+    ChannelMetrics MeasureChannel(std::vector<float>& history, const std::vector<float>& samples, size_t clippedSampleCount);
+    static double MeasureCorrelation(const std::vector<float>& first, const std::vector<float>& second);
+    static bool IsHealthier(const std::array<ChannelMetrics, 2>& first, const std::array<ChannelMetrics, 2>& second, double marginDb);
+
+private:
+    uint32_t sampleRate = 0;
+    size_t windowSampleCount = 0;
+    bool produceMergedOutput = false;
+    std::vector<float> highpassCoefficients;
+    double noiseBandFraction = 0.0;
+
+    // Window state. The samples are held normalized to full scale, with one vector per converter and channel.
+    uint64_t windowFirstSampleIndex = 0;
+    size_t windowFillCount = 0;
+    std::array<std::vector<float>, 2> adc128s022Samples;
+    std::array<std::vector<float>, 2> pcm1802Samples;
+    std::array<size_t, 2> adc128s022ClippedCount = {};
+    std::array<size_t, 2> pcm1802ClippedCount = {};
+    std::array<std::vector<float>, 2> adc128s022History;
+    std::array<std::vector<float>, 2> pcm1802History;
+    std::vector<uint8_t> windowFrameData16;
+    std::vector<uint8_t> windowFrameData24;
+    bool selectedSourceValid = false;
+    Source selectedSource = Source::Pcm1802;
+
+    // Completed results waiting to be collected
+    std::vector<WindowResult> completedWindowResults;
+    std::vector<uint8_t> completedMergedFrameData;
+};
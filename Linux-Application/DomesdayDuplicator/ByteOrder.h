@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+
+// Little-endian serialization helpers, used by the binary file formats the capture writes and reads. Values are stored
+// a byte at a time, so the buffer doesn't need to be aligned, and the result doesn't depend on the host byte order.
+inline void WriteLE16(uint8_t* buffer, uint16_t value);
+inline void WriteLE32(uint8_t* buffer, uint32_t value);
+inline void WriteLE64(uint8_t* buffer, uint64_t value);
+inline uint16_t ReadLE16(const uint8_t* buffer);
+inline uint32_t ReadLE32(const uint8_t* buffer);
+inline uint64_t ReadLE64(const uint8_t* buffer);
+
+#include "ByteOrder.inl"
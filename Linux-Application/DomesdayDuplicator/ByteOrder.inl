@@ -0,0 +1,38 @@
+//----------------------------------------------------------------------------------------------------------------------
+inline void WriteLE16(uint8_t* buffer, uint16_t value)
+{
+    buffer[0] = (uint8_t)(value & 0xFF);
+    buffer[1] = (uint8_t)((value >> 8) & 0xFF);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+inline void WriteLE32(uint8_t* buffer, uint32_t value)
+{
+    WriteLE16(buffer, (uint16_t)(value & 0xFFFF));
+    WriteLE16(buffer + 2, (uint16_t)(value >> 16));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+inline void WriteLE64(uint8_t* buffer, uint64_t value)
+{
+    WriteLE32(buffer, (uint32_t)(value & 0xFFFFFFFF));
+    WriteLE32(buffer + 4, (uint32_t)(value >> 32));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+inline uint16_t ReadLE16(const uint8_t* buffer)
+{
+    return (uint16_t)buffer[0] | (uint16_t)((uint16_t)buffer[1] << 8);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+inline uint32_t ReadLE32(const uint8_t* buffer)
+{
+    return (uint32_t)ReadLE16(buffer) | ((uint32_t)ReadLE16(buffer + 2) << 16);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+inline uint64_t ReadLE64(const uint8_t* buffer)
+{
+    return (uint64_t)ReadLE32(buffer) | ((uint64_t)ReadLE32(buffer + 4) << 32);
+}
@@ -0,0 +1,183 @@
+#include "CaptureContainer.h"
+#include "ByteOrder.h"
+#include <array>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Checksum methods
+//----------------------------------------------------------------------------------------------------------------------
+uint32_t CaptureContainer::Crc32c(const uint8_t* data, size_t sizeInBytes, uint32_t previousCrc)
+{
+    // Build the lookup tables for the reflected Castagnoli polynomial once, on first use. We use the "slicing-by-8"
+    // technique, where each additional table advances the CRC over one further byte of zeros. This lets us process 8
+    // bytes per step with independent table lookups, which is several times faster than a single table, and fast
+    // enough to keep up with full rate capture data without relying on CPU-specific instructions.
+    static const std::array<std::array<uint32_t, 256>, 8> crcTables = []()
+    {
+        const uint32_t polynomial = 0x82F63B78;
+        std::array<std::array<uint32_t, 256>, 8> tables = {};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t entry = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                entry = (entry & 1) ? ((entry >> 1) ^ polynomial) : (entry >> 1);
+            }
+            tables[0][i] = entry;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (size_t table = 1; table < 8; ++table)
+            {
+                tables[table][i] = (tables[table - 1][i] >> 8) ^ tables[0][tables[table - 1][i] & 0xFF];
+            }
+        }
+        return tables;
+    }();
+
+    // Calculate the CRC, continuing on from the previous value if one was supplied
+    uint32_t crc = ~previousCrc;
+    while (sizeInBytes >= 8)
+    {
+        uint32_t low = crc ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+        uint32_t high = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+        crc = crcTables[7][low & 0xFF] ^ crcTables[6][(low >> 8) & 0xFF] ^ crcTables[5][(low >> 16) & 0xFF] ^ crcTables[4][low >> 24] ^
+              crcTables[3][high & 0xFF] ^ crcTables[2][(high >> 8) & 0xFF] ^ crcTables[1][(high >> 16) & 0xFF] ^ crcTables[0][high >> 24];
+        data += 8;
+        sizeInBytes -= 8;
+    }
+    while (sizeInBytes > 0)
+    {
+        crc = crcTables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        ++data;
+        --sizeInBytes;
+    }
+    return ~crc;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Block methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t CaptureContainer::PackedPayloadSizeInBytes(size_t sampleCount)
+{
+    // Every 4 10-bit samples are packed into 5 bytes
+    return (sampleCount / 4) * 5;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CaptureContainer::WriteBlockHeader(uint8_t* buffer, const BlockHeader& header)
+{
+    WriteLE32(buffer + 0, BlockMagic);
+    buffer[4] = header.version;
+    buffer[5] = (uint8_t)header.sampleFormat;
+    WriteLE16(buffer + 6, header.flags);
+    WriteLE32(buffer + 8, header.blockIndex);
+    WriteLE16(buffer + 12, header.frameOffset);
+    WriteLE16(buffer + 14, 0);
+    WriteLE64(buffer + 16, header.sequenceCounter);
+    WriteLE32(buffer + 24, header.sampleCount);
+    WriteLE32(buffer + 28, header.payloadSizeInBytes);
+    WriteLE32(buffer + 32, header.payloadCrc);
+    WriteLE32(buffer + 36, Crc32c(buffer, 36));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool CaptureContainer::ReadBlockHeader(const uint8_t* buffer, BlockHeader& header)
+{
+    // Ensure this looks like a block header, and that the header itself hasn't been damaged.
+    if ((ReadLE32(buffer + 0) != BlockMagic) || (ReadLE32(buffer + 36) != Crc32c(buffer, 36)))
+    {
+        return false;
+    }
+
+    // Decode the header fields
+    header.version = buffer[4];
+    header.sampleFormat = (SampleFormat)buffer[5];
+    header.flags = ReadLE16(buffer + 6);
+    header.blockIndex = ReadLE32(buffer + 8);
+    header.frameOffset = ReadLE16(buffer + 12);
+    header.sequenceCounter = ReadLE64(buffer + 16);
+    header.sampleCount = ReadLE32(buffer + 24);
+    header.payloadSizeInBytes = ReadLE32(buffer + 28);
+    header.payloadCrc = ReadLE32(buffer + 32);
+    return (header.version == FormatVersion) && (header.sampleFormat == SampleFormat::Unsigned10BitPacked) && (header.payloadSizeInBytes == PackedPayloadSizeInBytes(header.sampleCount));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+CaptureContainer::IndexEntry CaptureContainer::MakeIndexEntry(const BlockHeader& header, uint64_t fileOffset, uint64_t firstSampleIndex)
+{
+    IndexEntry entry;
+    entry.fileOffset = fileOffset;
+    entry.firstSampleIndex = firstSampleIndex;
+    entry.sequenceCounter = header.sequenceCounter;
+    entry.sampleCount = header.sampleCount;
+    entry.frameOffset = header.frameOffset;
+    entry.flags = header.flags;
+    return entry;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Trailer methods
+//----------------------------------------------------------------------------------------------------------------------
+void CaptureContainer::BuildTrailer(const std::vector<IndexEntry>& index, uint64_t indexOffset, std::vector<uint8_t>& trailer)
+{
+    // Serialize each index entry
+    size_t indexSizeInBytes = index.size() * IndexEntrySizeInBytes;
+    trailer.assign(indexSizeInBytes + FooterSizeInBytes, 0);
+    uint8_t* writePointer = trailer.data();
+    for (const IndexEntry& entry : index)
+    {
+        WriteLE64(writePointer + 0, entry.fileOffset);
+        WriteLE64(writePointer + 8, entry.firstSampleIndex);
+        WriteLE64(writePointer + 16, entry.sequenceCounter);
+        WriteLE32(writePointer + 24, entry.sampleCount);
+        WriteLE16(writePointer + 28, entry.frameOffset);
+        WriteLE16(writePointer + 30, entry.flags);
+        writePointer += IndexEntrySizeInBytes;
+    }
+
+    // Append the footer, which allows a reader to locate the index from the end of the file
+    WriteLE64(writePointer + 0, FooterMagic);
+    WriteLE64(writePointer + 8, indexOffset);
+    WriteLE64(writePointer + 16, index.size());
+    WriteLE32(writePointer + 24, Crc32c(trailer.data(), indexSizeInBytes));
+    WriteLE32(writePointer + 28, Crc32c(writePointer, 28));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool CaptureContainer::ReadFooter(const uint8_t* buffer, Footer& footer)
+{
+    if ((ReadLE64(buffer + 0) != FooterMagic) || (ReadLE32(buffer + 28) != Crc32c(buffer, 28)))
+    {
+        return false;
+    }
+    footer.indexOffset = ReadLE64(buffer + 8);
+    footer.entryCount = ReadLE64(buffer + 16);
+    footer.indexCrc = ReadLE32(buffer + 24);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool CaptureContainer::ReadIndex(const uint8_t* buffer, const Footer& footer, std::vector<IndexEntry>& index)
+{
+    // Ensure the index is intact before decoding it
+    size_t indexSizeInBytes = (size_t)footer.entryCount * IndexEntrySizeInBytes;
+    if (Crc32c(buffer, indexSizeInBytes) != footer.indexCrc)
+    {
+        return false;
+    }
+
+    // Decode each index entry
+    index.resize((size_t)footer.entryCount);
+    const uint8_t* readPointer = buffer;
+    for (IndexEntry& entry : index)
+    {
+        entry.fileOffset = ReadLE64(readPointer + 0);
+        entry.firstSampleIndex = ReadLE64(readPointer + 8);
+        entry.sequenceCounter = ReadLE64(readPointer + 16);
+        entry.sampleCount = ReadLE32(readPointer + 24);
+        entry.frameOffset = ReadLE16(readPointer + 28);
+        entry.flags = ReadLE16(readPointer + 30);
+        readPointer += IndexEntrySizeInBytes;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The capture container is a block-structured wrapper around packed 10-bit sample data. The file is made up of a
+// sequence of variable-length blocks, each consisting of a header followed by a payload of packed 10-bit samples, using
+// the same packing as a raw .lds file. A block normally holds one disk buffer of samples, but its length depends on the
+// capture settings, and grows by any samples inserted to fill gaps, so readers must not assume a fixed stride. Blocks
+// are located through the index, or by following the payload size in each block header. Each block header records the
+// sequence counter state for the first sample in the block, along with a CRC32C of the payload, allowing damaged or
+// missing regions to be detected and the data to be realigned without reference to any other part of the file. An
+// index of all blocks is appended at the end of the file when the capture completes, followed by a fixed-size footer
+// which locates the index. A file which was not closed cleanly can still be recovered by walking the blocks
+// sequentially from the start of the file.
+class CaptureContainer
+{
+public:
+    // Constants
+    static const uint32_t BlockMagic = 0x42434444;              // "DDCB"
+    static const uint64_t FooterMagic = 0x3158444943444444ULL;  // "DDDCIDX1"
+    static const uint8_t FormatVersion = 1;
+    static const size_t BlockHeaderSizeInBytes = 40;
+    static const size_t IndexEntrySizeInBytes = 32;
+    static const size_t FooterSizeInBytes = 32;
+
+    // Enumerations
+    enum class SampleFormat : uint8_t
+    {
+        Unsigned10BitPacked = 1,
+    };
+    enum BlockFlags : uint16_t
+    {
+        SequenceCounterValid = 0x0001,
+    };
+
+    // Structures
+    struct BlockHeader
+    {
+        uint8_t version = FormatVersion;
+        SampleFormat sampleFormat = SampleFormat::Unsigned10BitPacked;
+        uint16_t flags = 0;
+        uint32_t blockIndex = 0;
+        uint16_t frameOffset = 0;
+        uint64_t sequenceCounter = 0;
+        uint32_t sampleCount = 0;
+        uint32_t payloadSizeInBytes = 0;
+        uint32_t payloadCrc = 0;
+    };
+    struct IndexEntry
+    {
+        uint64_t fileOffset = 0;
+        uint64_t firstSampleIndex = 0;
+        uint64_t sequenceCounter = 0;
+        uint32_t sampleCount = 0;
+        uint16_t frameOffset = 0;
+        uint16_t flags = 0;
+    };
+    struct Footer
+    {
+        uint64_t indexOffset = 0;
+        uint64_t entryCount = 0;
+        uint32_t indexCrc = 0;
+    };
+
+public:
+    // Checksum methods
+    static uint32_t Crc32c(const uint8_t* data, size_t sizeInBytes, uint32_t previousCrc = 0);
+
+    // Block methods
+    static size_t PackedPayloadSizeInBytes(size_t sampleCount);
+    static void WriteBlockHeader(uint8_t* buffer, const BlockHeader& header);
+    static bool ReadBlockHeader(const uint8_t* buffer, BlockHeader& header);
+    static IndexEntry MakeIndexEntry(const BlockHeader& header, uint64_t fileOffset, uint64_t firstSampleIndex);
+
+    // Trailer methods
+    static void BuildTrailer(const std::vector<IndexEntry>& index, uint64_t indexOffset, std::vector<uint8_t>& trailer);
+    static bool ReadFooter(const uint8_t* buffer, Footer& footer);
+    static bool ReadIndex(const uint8_t* buffer, const Footer& footer, std::vector<IndexEntry>& index);
+};
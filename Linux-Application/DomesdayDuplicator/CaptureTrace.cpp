@@ -0,0 +1,179 @@
+#include "CaptureTrace.h"
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Static members
+//----------------------------------------------------------------------------------------------------------------------
+thread_local const CaptureTrace* CaptureTrace::currentThreadTrace = nullptr;
+thread_local uint64_t CaptureTrace::currentThreadGeneration = 0;
+thread_local CaptureTrace::ThreadRing* CaptureTrace::currentThreadRing = nullptr;
+
+//----------------------------------------------------------------------------------------------------------------------
+// Setup methods
+//----------------------------------------------------------------------------------------------------------------------
+void CaptureTrace::Start()
+{
+    std::unique_lock<std::mutex> lock(threadRingMutex);
+    threadRings.clear();
+    ++generation;
+    startTime = std::chrono::steady_clock::now();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void CaptureTrace::RegisterThread(const std::string& threadName)
+{
+    // Allocate the ring for this thread, and touch every page of it now, so that recording events never causes a page
+    // fault part way through the capture.
+    std::unique_ptr<ThreadRing> ring(new ThreadRing());
+    ring->threadName = threadName;
+    ring->records.reset(new EventRecord[ThreadRingRecordCount]);
+    memset(ring->records.get(), 0, sizeof(EventRecord) * ThreadRingRecordCount);
+
+    std::unique_lock<std::mutex> lock(threadRingMutex);
+    currentThreadTrace = this;
+    currentThreadGeneration = generation;
+    currentThreadRing = ring.get();
+    threadRings.push_back(std::move(ring));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Recording methods
+//----------------------------------------------------------------------------------------------------------------------
+void CaptureTrace::Record(Event event, Phase phase, uint32_t argument) const
+{
+    // Events from threads which haven't been registered with the current run of this trace are ignored. Since each ring
+    // has a single writer, we can claim the next slot without a read-modify-write.
+    if ((currentThreadTrace != this) || (currentThreadGeneration != generation))
+    {
+        return;
+    }
+    ThreadRing& ring = *currentThreadRing;
+    uint64_t writeIndex = ring.writeCount.load(std::memory_order_relaxed);
+    EventRecord& record = ring.records[(size_t)(writeIndex % ThreadRingRecordCount)];
+    record.timestampInNanoseconds = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    record.argument = argument;
+    record.event = event;
+    record.phase = phase;
+    ring.writeCount.store(writeIndex + 1, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Output methods
+//----------------------------------------------------------------------------------------------------------------------
+bool CaptureTrace::WriteChromeTrace(const std::filesystem::path& filePath) const
+{
+    // Open the output file
+    std::ofstream outputFile(filePath, std::ios::out | std::ios::trunc);
+    if (!outputFile.is_open())
+    {
+        return false;
+    }
+
+    // Write the events from each thread ring, oldest first. Each thread is given a name in the trace viewer through a
+    // metadata event. If a ring has wrapped, its oldest events may be the end of a stage whose beginning has been
+    // overwritten, so we drop end events until they can be matched with a beginning.
+    std::unique_lock<std::mutex> lock(threadRingMutex);
+    uint64_t droppedEventCount = 0;
+    bool firstEntry = true;
+    outputFile << std::fixed << std::setprecision(3);
+    outputFile << "{\"traceEvents\":[\n";
+    for (size_t threadIndex = 0; threadIndex < threadRings.size(); ++threadIndex)
+    {
+        const ThreadRing& ring = *threadRings[threadIndex];
+        size_t threadId = threadIndex + 1;
+        outputFile << (firstEntry ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":\"" << ring.threadName << "\"}}";
+        firstEntry = false;
+
+        uint64_t writeCount = ring.writeCount.load(std::memory_order_acquire);
+        uint64_t firstIndex = (writeCount > ThreadRingRecordCount) ? (writeCount - ThreadRingRecordCount) : 0;
+        droppedEventCount += firstIndex;
+        size_t openScopeCount = 0;
+        for (uint64_t i = firstIndex; i < writeCount; ++i)
+        {
+            const EventRecord& record = ring.records[(size_t)(i % ThreadRingRecordCount)];
+            const char* phaseCode = "i";
+            if (record.phase == Phase::Begin)
+            {
+                phaseCode = "B";
+                ++openScopeCount;
+            }
+            else if (record.phase == Phase::End)
+            {
+                if (openScopeCount == 0)
+                {
+                    continue;
+                }
+                phaseCode = "E";
+                --openScopeCount;
+            }
+            outputFile << ",\n{\"name\":\"" << GetEventName(record.event) << "\",\"cat\":\"" << GetEventCategory(record.event)
+                       << "\",\"ph\":\"" << phaseCode << "\"" << ((record.phase == Phase::Instant) ? ",\"s\":\"t\"" : "")
+                       << ",\"ts\":" << ((double)record.timestampInNanoseconds / 1000.0)
+                       << ",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"value\":" << record.argument << "}}";
+        }
+    }
+    outputFile << "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"droppedEventCount\":" << droppedEventCount << "}}\n";
+    return outputFile.good();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+const char* CaptureTrace::GetEventName(Event event)
+{
+    switch (event)
+    {
+    case Event::UsbTransferSubmit:
+        return "UsbTransferSubmit";
+    case Event::UsbTransferComplete:
+        return "UsbTransferComplete";
+    case Event::DiskBufferFull:
+        return "DiskBufferFull";
+    case Event::ProcessBuffer:
+        return "ProcessBuffer";
+    case Event::ProcessSequence:
+        return "ProcessSequence";
+    case Event::ProcessVerify:
+        return "ProcessVerify";
+    case Event::ProcessConvert:
+        return "ProcessConvert";
+    case Event::ProcessAudio:
+        return "ProcessAudio";
+    case Event::WriteCapture:
+        return "WriteCapture";
+    case Event::WriteStaging:
+        return "WriteStaging";
+    case Event::WriteAdditionalOutput:
+        return "WriteAdditionalOutput";
+    case Event::WriteAudio:
+        return "WriteAudio";
+    case Event::BufferRelease:
+        return "BufferRelease";
+    }
+    return "Unknown";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+const char* CaptureTrace::GetEventCategory(Event event)
+{
+    switch (event)
+    {
+    case Event::UsbTransferSubmit:
+    case Event::UsbTransferComplete:
+    case Event::DiskBufferFull:
+        return "usb";
+    case Event::ProcessBuffer:
+    case Event::ProcessSequence:
+    case Event::ProcessVerify:
+    case Event::ProcessConvert:
+    case Event::ProcessAudio:
+        return "cpu";
+    case Event::WriteCapture:
+    case Event::WriteStaging:
+    case Event::WriteAdditionalOutput:
+    case Event::WriteAudio:
+    case Event::BufferRelease:
+        return "disk";
+    }
+    return "unknown";
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Trace points are only compiled in when DDD_CAPTURE_TRACE is defined as nonzero, which is controlled by the
+// DDD_CAPTURE_TRACE build option. Otherwise the trace macros below expand to nothing, and their arguments aren't
+// evaluated.
+#ifndef DDD_CAPTURE_TRACE
+#define DDD_CAPTURE_TRACE 0
+#endif
+
+// Records timestamped events from the capture pipeline threads, so the time taken by each stage can be examined after a
+// capture, and saved in the Chrome trace event format for viewing in chrome://tracing or Perfetto. Each thread records
+// into its own fixed size ring, with no locking or allocation once the thread has been registered. When a ring is full
+// the oldest events are overwritten, so a long capture keeps the most recent history for each thread. The rings are
+// only read back after every recording thread has stopped.
+class CaptureTrace
+{
+public:
+    // Enumerations
+    enum class Event : uint8_t
+    {
+        UsbTransferSubmit,
+        UsbTransferComplete,
+        DiskBufferFull,
+        ProcessBuffer,
+        ProcessSequence,
+        ProcessVerify,
+        ProcessConvert,
+        ProcessAudio,
+        WriteCapture,
+        WriteStaging,
+        WriteAdditionalOutput,
+        WriteAudio,
+        BufferRelease,
+    };
+    enum class Phase : uint8_t
+    {
+        Begin,
+        End,
+        Instant,
+    };
+
+public:
+    // Nested types
+    class Scope
+    {
+    public:
+        inline Scope(const CaptureTrace& trace, Event event, uint32_t argument);
+        inline ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const CaptureTrace& trace;
+        Event event;
+        uint32_t argument;
+    };
+
+public:
+    // Constants
+    static const size_t ThreadRingRecordCount = 64 * 1024;
+    static constexpr bool Enabled = (DDD_CAPTURE_TRACE != 0);
+
+public:
+    // Setup methods
+    void Start();
+    void RegisterThread(const std::string& threadName);
+
+    // Recording methods
+    void Record(Event event, Phase phase, uint32_t argument) const;
+
+    // Output methods
+    bool WriteChromeTrace(const std::filesystem::path& filePath) const;
+    static const char* GetEventName(Event event);
+    static const char* GetEventCategory(Event event);
+
+private:
+    // Structures
+    struct EventRecord
+    {
+        uint64_t timestampInNanoseconds;
+        uint32_t argument;
+        Event event;
+        Phase phase;
+    };
+    struct ThreadRing
+    {
+        std::string threadName;
+        std::unique_ptr<EventRecord[]> records;
+        alignas(64) std::atomic<uint64_t> writeCount = 0;
+    };
+
+private:
+    // The ring the current thread records into. The owning trace and its generation are held alongside, so a thread
+    // which was registered with an earlier run of a trace doesn't record into a ring which has since been released.
+    static thread_local const CaptureTrace* currentThreadTrace;
+    static thread_local uint64_t currentThreadGeneration;
+    static thread_local ThreadRing* currentThreadRing;
+
+private:
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t generation = 0;
+    mutable std::mutex threadRingMutex;
+    std::vector<std::unique_ptr<ThreadRing>> threadRings;
+};
+
+#include "CaptureTrace.inl"
+
+// Trace macros. Each trace point names an Event value, and passes an argument to identify the buffer or transfer it
+// relates to.
+#if DDD_CAPTURE_TRACE
+#define CAPTURE_TRACE_CONCAT_INNER(a, b) a##b
+#define CAPTURE_TRACE_CONCAT(a, b) CAPTURE_TRACE_CONCAT_INNER(a, b)
+#define CAPTURE_TRACE_REGISTER_THREAD(trace, threadName) (trace).RegisterThread(threadName)
+#define CAPTURE_TRACE_SCOPE(trace, eventName, argument) CaptureTrace::Scope CAPTURE_TRACE_CONCAT(captureTraceScope, __LINE__)((trace), CaptureTrace::Event::eventName, (uint32_t)(argument))
+#define CAPTURE_TRACE_INSTANT(trace, eventName, argument) (trace).Record(CaptureTrace::Event::eventName, CaptureTrace::Phase::Instant, (uint32_t)(argument))
+#else
+#define CAPTURE_TRACE_REGISTER_THREAD(trace, threadName) ((void)0)
+#define CAPTURE_TRACE_SCOPE(trace, eventName, argument) ((void)0)
+#define CAPTURE_TRACE_INSTANT(trace, eventName, argument) ((void)0)
+#endif
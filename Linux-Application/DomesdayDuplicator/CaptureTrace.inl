@@ -0,0 +1,14 @@
+//----------------------------------------------------------------------------------------------------------------------
+// Scope methods
+//----------------------------------------------------------------------------------------------------------------------
+CaptureTrace::Scope::Scope(const CaptureTrace& trace, Event event, uint32_t argument)
+:trace(trace), event(event), argument(argument)
+{
+    trace.Record(event, Phase::Begin, argument);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+CaptureTrace::Scope::~Scope()
+{
+    trace.Record(event, Phase::End, argument);
+}
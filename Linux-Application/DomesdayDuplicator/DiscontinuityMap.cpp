@@ -0,0 +1,48 @@
+#include "DiscontinuityMap.h"
+#include "ByteOrder.h"
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Serialization methods
+//----------------------------------------------------------------------------------------------------------------------
+void DiscontinuityMap::BuildHeader(uint8_t* buffer, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t samplesPerCounterValue, uint64_t recordCount, uint64_t droppedRecordCount)
+{
+    memset(buffer, 0, HeaderSizeInBytes);
+    memcpy(buffer, "DDSYNMAP", 8);
+    WriteLE32(buffer + 8, FormatVersion);
+    WriteLE32(buffer + 12, samplesPerFrame);
+    WriteLE32(buffer + 16, counterValuesPerFrame);
+    WriteLE32(buffer + 20, samplesPerCounterValue);
+    WriteLE64(buffer + 24, recordCount);
+    WriteLE64(buffer + 32, droppedRecordCount);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void DiscontinuityMap::BuildRecord(uint8_t* buffer, const Record& record)
+{
+    WriteLE32(buffer + 0, (uint32_t)record.recordType);
+    WriteLE32(buffer + 4, record.droppedRecordCount);
+    WriteLE64(buffer + 8, record.sampleOffset);
+    WriteLE64(buffer + 16, record.outputByteOffset);
+    WriteLE64(buffer + 24, record.expectedCounter);
+    WriteLE64(buffer + 32, record.actualCounter);
+    WriteLE64(buffer + 40, record.skippedSampleCount);
+    WriteLE64(buffer + 48, record.timestampInMicroseconds);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Counter methods
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t DiscontinuityMap::GetMissingSampleCount(uint64_t expectedCounter, uint64_t actualCounter, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t samplesPerCounterValue)
+{
+    // The frame counter is 48 bits wide, and only advances through the counter region of each frame. Whole frames which
+    // were skipped account for every sample in the frame, and any remaining counter values account for a single
+    // counter block each. A counter which appears to have gone backwards can't be explained by missing samples.
+    const uint64_t counterMask = 0xFFFFFFFFFFFFULL;
+    uint64_t counterDelta = (actualCounter - expectedCounter) & counterMask;
+    if (counterDelta > (counterMask >> 1))
+    {
+        return 0;
+    }
+    return ((counterDelta / counterValuesPerFrame) * samplesPerFrame) + ((counterDelta % counterValuesPerFrame) * samplesPerCounterValue);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Builds the contents of a discontinuity map file, which records every point in a capture where the sequence markers
+// in the sample stream showed that data was damaged or lost, so downstream tools can go straight to the affected
+// regions rather than scanning the whole capture for them. Records are appended to the file as the events occur, and
+// the header is rewritten after each group of records, so the map remains usable if the capture doesn't end cleanly.
+//
+// All values are little-endian. The file begins with a 48-byte header:
+//   0   char[8]  Magic "DDSYNMAP"
+//   8   uint32   Format version (2)
+//   12  uint32   RF samples per frame (512)
+//   16  uint32   Frame counter increments per frame (58)
+//   20  uint32   RF samples per frame counter increment (8)
+//   24  uint64   Record count
+//   32  uint64   Dropped record count
+//   40  uint64   Reserved (0)
+// This is followed by the given number of 56-byte records, in the order the events occurred:
+//   0   uint32   Record type (1 = sync loss, 2 = counter mismatch, 3 = records dropped)
+//   4   uint32   Dropped record count (records dropped only, otherwise 0)
+//   8   uint64   RF sample offset
+//   16  uint64   Output byte offset
+//   24  uint64   Expected frame counter (48 bits)
+//   32  uint64   Actual frame counter (48 bits)
+//   40  uint64   Skipped sample count
+//   48  uint64   Timestamp in microseconds
+// The RF sample offset counts samples received from the start of the capture, before any decimation is applied by the
+// capture format, and the output byte offset is the position in the main capture file of the packed group holding that
+// sample, which also accounts for any samples inserted by gap filling.
+// The timestamp is the time since the capture started when the event was detected. For a sync loss, the offsets give
+// the frame where the sync pattern was missing, the expected counter is the value expected next at that point, and the
+// actual counter is the value at the frame where sync was reacquired, or all ones if it never was. The skipped sample
+// count is the number of samples written to the output between the two points, which can't be trusted. For a counter
+// mismatch, the offsets give the counter block which didn't match, and the skipped sample count is the number of
+// samples missing from the output, estimated from the difference between the counters, or zero if the counter went
+// backwards. If events occurred faster than they could be written, the records which didn't fit are dropped, and a
+// records dropped record is written in their place once there's room. This gives the number of records which were
+// dropped, the offsets, expected counter and timestamp of the first of them, the actual counter of the last of them,
+// and the total of their skipped sample counts. The dropped record count in the header is the total for the capture.
+class DiscontinuityMap
+{
+public:
+    // Enumerations
+    enum class RecordType : uint32_t
+    {
+        SyncLoss = 1,
+        CounterMismatch = 2,
+        RecordsDropped = 3,
+    };
+
+public:
+    // Structures
+    struct Record
+    {
+        RecordType recordType = RecordType::SyncLoss;
+        uint64_t sampleOffset = 0;
+        uint64_t outputByteOffset = 0;
+        uint64_t expectedCounter = 0;
+        uint64_t actualCounter = 0;
+        uint64_t skippedSampleCount = 0;
+        uint64_t timestampInMicroseconds = 0;
+        uint32_t droppedRecordCount = 0;
+    };
+
+public:
+    // Constants
+    static const size_t HeaderSizeInBytes = 48;
+    static const size_t RecordSizeInBytes = 56;
+    static const uint32_t FormatVersion = 2;
+    static const uint64_t CounterNotReacquired = ~(uint64_t)0;
+
+public:
+    // Serialization methods
+    static void BuildHeader(uint8_t* buffer, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t samplesPerCounterValue, uint64_t recordCount, uint64_t droppedRecordCount);
+    static void BuildRecord(uint8_t* buffer, const Record& record);
+
+    // Counter methods
+    static uint64_t GetMissingSampleCount(uint64_t expectedCounter, uint64_t actualCounter, uint32_t samplesPerFrame, uint32_t counterValuesPerFrame, uint32_t samplesPerCounterValue);
+};
@@ -0,0 +1,279 @@
+#include "DiskBenchmark.h"
+#include "FileUtilities.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <system_error>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+DiskBenchmark::DiskBenchmark(const ILogger& log)
+:log(log)
+{
+    // Fill the write buffer with pseudo-random data. This ensures filesystems which perform compression or
+    // deduplication can't write our test data any faster than they could write real sample data.
+    writeBuffer.resize(WriteSizeInBytes);
+    uint32_t state = 0x2545F491;
+    for (uint8_t& entry : writeBuffer)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        entry = (uint8_t)state;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+DiskBenchmark::~DiskBenchmark()
+{
+    Cancel();
+    if (benchmarkThread.joinable())
+    {
+        benchmarkThread.join();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Logging methods
+//----------------------------------------------------------------------------------------------------------------------
+const ILogger& DiskBenchmark::Log() const
+{
+    return log;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Benchmark methods
+//----------------------------------------------------------------------------------------------------------------------
+void DiskBenchmark::Start(const std::filesystem::path& directory, bool useWriteThrough)
+{
+    // Stop any benchmark already in progress, and discard the previous result.
+    Cancel();
+    if (benchmarkThread.joinable())
+    {
+        benchmarkThread.join();
+    }
+    {
+        std::unique_lock<std::mutex> lock(resultMutex);
+        benchmarkResult.reset();
+    }
+
+    // Start the benchmark thread
+    cancelRequested.clear();
+    benchmarkRunning = true;
+    benchmarkThread = std::thread(std::bind(std::mem_fn(&DiskBenchmark::BenchmarkThread), this, directory, useWriteThrough));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void DiskBenchmark::Cancel()
+{
+    // Note that we don't wait for the benchmark thread to finish here, so this is safe to call from the UI thread. The
+    // thread stops at the end of its current write, and skips the final flush to disk. It's joined when the next
+    // benchmark starts, or when we're destroyed.
+    cancelRequested.test_and_set();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool DiskBenchmark::IsRunning() const
+{
+    return benchmarkRunning;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::optional<DiskBenchmark::Result> DiskBenchmark::GetResult() const
+{
+    std::unique_lock<std::mutex> lock(resultMutex);
+    return benchmarkResult;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void DiskBenchmark::BenchmarkThread(std::filesystem::path directory, bool useWriteThrough)
+{
+    // Ensure there's plenty of free space on the target volume. We don't want to be the reason a capture runs out of
+    // space, and nearly full volumes aren't representative of their normal write performance anyway.
+    std::error_code errorCode;
+    std::filesystem::space_info spaceInfo = std::filesystem::space(directory, errorCode);
+    if (errorCode || (spaceInfo.available < (MaxTotalSizeInBytes * 4)))
+    {
+        Log().Warning("BenchmarkThread(): Skipping disk benchmark of {0}, as there is insufficient free space", directory);
+        benchmarkRunning = false;
+        return;
+    }
+
+    // Run the benchmark, and remove the test file afterwards whether it succeeded or not.
+    std::filesystem::path filePath = directory / ".DomesdayDuplicatorDiskBenchmark.tmp";
+    Result result;
+    result.directory = directory;
+    result.usedWriteThrough = useWriteThrough;
+    bool benchmarkSucceeded = RunBenchmark(filePath, useWriteThrough, result);
+    std::filesystem::remove(filePath, errorCode);
+    if (benchmarkSucceeded)
+    {
+        Log().Info("BenchmarkThread(): Disk benchmark of {0} wrote {1} bytes at {2} MB/s, p99 write latency {3}us, max write latency {4}us", directory, result.totalSizeInBytes, result.throughputInBytesPerSecond / (1000.0 * 1000.0), result.p99WriteLatency.count(), result.maxWriteLatency.count());
+        std::unique_lock<std::mutex> lock(resultMutex);
+        benchmarkResult = result;
+    }
+    benchmarkRunning = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool DiskBenchmark::RunBenchmark(const std::filesystem::path& filePath, bool useWriteThrough, Result& result)
+{
+    // Create the test file using the same method the capture process will use for the output file. When write-through
+    // is in use, the capture appends to the file with overlapped IO, so we open the file the same way here.
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    std::array<OVERLAPPED, OverlappedWriteCount> overlappedWrites = {};
+    std::array<std::chrono::steady_clock::time_point, OverlappedWriteCount> overlappedWriteStartTimes;
+    std::array<bool, OverlappedWriteCount> overlappedWriteInProgress = {};
+    std::shared_ptr<void> eventHandleDeallocator(nullptr, [&](void*)
+        {
+            for (OVERLAPPED& overlappedWrite : overlappedWrites)
+            {
+                if (overlappedWrite.hEvent != NULL)
+                {
+                    CloseHandle(overlappedWrite.hEvent);
+                }
+            }
+        });
+    if (useWriteThrough)
+    {
+        fileHandle = CreateFileW(filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_WRITE_THROUGH | FILE_FLAG_OVERLAPPED, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            DWORD lastError = GetLastError();
+            Log().Error("RunBenchmark(): CreateFileW returned {0} with error code {1}.", fileHandle, lastError);
+            return false;
+        }
+        for (OVERLAPPED& overlappedWrite : overlappedWrites)
+        {
+            overlappedWrite.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        }
+    }
+#else
+    (void)useWriteThrough;
+#endif
+    std::ofstream outputFile;
+#ifdef _WIN32
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+#endif
+        outputFile.rdbuf()->pubsetbuf(0, 0);
+        outputFile.open(filePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!outputFile.is_open())
+        {
+            Log().Error("RunBenchmark(): Failed to create the test file at path {0}", filePath);
+            return false;
+        }
+#ifdef _WIN32
+    }
+#endif
+
+    // Write sequential blocks to the file until we reach our time or size limit, timing each write individually. With
+    // overlapped IO, the time for each write runs from when it was queued until it completes, and like the capture
+    // process, we queue the next write before waiting for an earlier one to complete.
+    std::vector<std::chrono::microseconds> writeLatencies;
+    writeLatencies.reserve((size_t)(MaxTotalSizeInBytes / WriteSizeInBytes));
+    auto startTime = std::chrono::steady_clock::now();
+    bool writeFailed = false;
+#ifdef _WIN32
+    auto completeOverlappedWrite = [&](size_t writeIndex)
+        {
+            DWORD bytesTransferred = 0;
+            BOOL getOverlappedResultReturn = GetOverlappedResult(fileHandle, &overlappedWrites[writeIndex], &bytesTransferred, TRUE);
+            overlappedWriteInProgress[writeIndex] = false;
+            if ((getOverlappedResultReturn == 0) || (bytesTransferred != (DWORD)writeBuffer.size()))
+            {
+                DWORD lastError = GetLastError();
+                Log().Error("RunBenchmark(): GetOverlappedResult failed with error code {0}.", lastError);
+                return false;
+            }
+            writeLatencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - overlappedWriteStartTimes[writeIndex]));
+            return true;
+        };
+    size_t overlappedWriteIndex = 0;
+#endif
+    while ((result.totalSizeInBytes < MaxTotalSizeInBytes) && ((std::chrono::steady_clock::now() - startTime) < MaxDuration) && !cancelRequested.test())
+    {
+#ifdef _WIN32
+        if (fileHandle != INVALID_HANDLE_VALUE)
+        {
+            // Wait for the last write issued from this slot to complete, then queue the next write in its place,
+            // appending to the end of the file.
+            if (overlappedWriteInProgress[overlappedWriteIndex] && !completeOverlappedWrite(overlappedWriteIndex))
+            {
+                writeFailed = true;
+                break;
+            }
+            OVERLAPPED& overlappedWrite = overlappedWrites[overlappedWriteIndex];
+            overlappedWrite.Offset = 0xFFFFFFFF;
+            overlappedWrite.OffsetHigh = 0xFFFFFFFF;
+            overlappedWriteStartTimes[overlappedWriteIndex] = std::chrono::steady_clock::now();
+            BOOL writeFileReturn = WriteFile(fileHandle, writeBuffer.data(), (DWORD)writeBuffer.size(), NULL, &overlappedWrite);
+            DWORD lastError = GetLastError();
+            if ((writeFileReturn == 0) && (lastError != ERROR_IO_PENDING))
+            {
+                Log().Error("RunBenchmark(): WriteFile returned {0} with error code {1}.", writeFileReturn, lastError);
+                writeFailed = true;
+                break;
+            }
+            overlappedWriteInProgress[overlappedWriteIndex] = true;
+            overlappedWriteIndex = (overlappedWriteIndex + 1) % OverlappedWriteCount;
+            result.totalSizeInBytes += writeBuffer.size();
+            continue;
+        }
+#endif
+        auto writeStartTime = std::chrono::steady_clock::now();
+        outputFile.write((const char*)writeBuffer.data(), writeBuffer.size());
+        if (!outputFile.good())
+        {
+            Log().Error("RunBenchmark(): Failed to write to the test file");
+            writeFailed = true;
+            break;
+        }
+        writeLatencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStartTime));
+        result.totalSizeInBytes += writeBuffer.size();
+    }
+
+    // Wait for any overlapped writes still in progress, then close the file, and force any data still held in the OS
+    // cache out to the disk. A few seconds of writes can easily fit entirely in the cache, while a real capture will
+    // quickly exhaust it, so the time taken to flush is included in the throughput figure to give the rate the volume
+    // can actually sustain. If we've been cancelled, we skip the flush, so a capture starting on the same volume isn't
+    // held up behind it.
+#ifdef _WIN32
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        for (size_t i = 0; i < OverlappedWriteCount; ++i)
+        {
+            if (overlappedWriteInProgress[i] && !completeOverlappedWrite(i))
+            {
+                writeFailed = true;
+            }
+        }
+        CloseHandle(fileHandle);
+    }
+#endif
+    if (outputFile.is_open())
+    {
+        outputFile.close();
+    }
+    if (writeFailed || cancelRequested.test() || writeLatencies.empty() || !FlushFileToDisk(filePath, Log()))
+    {
+        return false;
+    }
+    auto elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime);
+
+    // Calculate the results
+    result.writeCount = writeLatencies.size();
+    result.throughputInBytesPerSecond = (double)result.totalSizeInBytes / std::max(elapsedTime.count(), 0.001);
+    std::sort(writeLatencies.begin(), writeLatencies.end());
+    result.p99WriteLatency = writeLatencies[((writeLatencies.size() - 1) * 99) / 100];
+    result.maxWriteLatency = writeLatencies.back();
+    return true;
+}
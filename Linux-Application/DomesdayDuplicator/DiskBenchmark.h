@@ -0,0 +1,68 @@
+#pragma once
+#include "ILogger.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Measures how well a target volume can sustain capture traffic, by writing a short burst of sequential appends to a
+// temporary file in the target directory using the same file access method as a real capture. Each write is the same
+// size as a capture disk buffer, and is individually timed so that stalls can be detected as well as the overall
+// throughput. The benchmark writes a significant amount of data, so it's only run when explicitly requested. It runs
+// on its own thread, and can be cancelled at any time without waiting for it to stop.
+class DiskBenchmark
+{
+public:
+    // Structures
+    struct Result
+    {
+        std::filesystem::path directory;
+        bool usedWriteThrough = false;
+        uint64_t totalSizeInBytes = 0;
+        size_t writeCount = 0;
+        double throughputInBytesPerSecond = 0.0;
+        std::chrono::microseconds p99WriteLatency = {};
+        std::chrono::microseconds maxWriteLatency = {};
+    };
+
+public:
+    // Constants
+    static const size_t WriteSizeInBytes = 2 * 1024 * 1024;
+    static const uint64_t MaxTotalSizeInBytes = 512 * 1024 * 1024;
+    static constexpr std::chrono::seconds MaxDuration = std::chrono::seconds(3);
+    static const size_t OverlappedWriteCount = 2;
+
+public:
+    // Constructors
+    DiskBenchmark(const ILogger& log);
+    ~DiskBenchmark();
+
+    // Benchmark methods
+    void Start(const std::filesystem::path& directory, bool useWriteThrough);
+    void Cancel();
+    bool IsRunning() const;
+    std::optional<Result> GetResult() const;
+
+protected:
+    // Logging methods
+    const ILogger& Log() const;
+
+private:
+    // Benchmark methods
+    void BenchmarkThread(std::filesystem::path directory, bool useWriteThrough);
+    bool RunBenchmark(const std::filesystem::path& filePath, bool useWriteThrough, Result& result);
+
+private:
+    const ILogger& log;
+    std::thread benchmarkThread;
+    std::atomic<bool> benchmarkRunning = false;
+    std::atomic_flag cancelRequested;
+    mutable std::mutex resultMutex;
+    std::optional<Result> benchmarkResult;
+    std::vector<uint8_t> writeBuffer;
+};
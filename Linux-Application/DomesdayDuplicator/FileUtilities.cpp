@@ -0,0 +1,38 @@
+#include "FileUtilities.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+bool FlushFileToDisk(const std::filesystem::path& filePath, const ILogger& log)
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW(filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        DWORD lastError = GetLastError();
+        log.Error("FlushFileToDisk(): CreateFileW returned {0} with error code {1}.", fileHandle, lastError);
+        return false;
+    }
+    bool flushSucceeded = FlushFileBuffers(fileHandle);
+    CloseHandle(fileHandle);
+#else
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        log.Error("FlushFileToDisk(): Failed to open the file at path {0}", filePath);
+        return false;
+    }
+    bool flushSucceeded = (fsync(fileDescriptor) == 0);
+    close(fileDescriptor);
+#endif
+    if (!flushSucceeded)
+    {
+        log.Error("FlushFileToDisk(): Failed to flush the file at path {0}", filePath);
+    }
+    return flushSucceeded;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "ILogger.h"
+#include <filesystem>
+
+// Forces any data for the target file held in the OS cache out to the disk. A separate handle to the file is opened
+// for this, as the standard library streams don't expose their underlying handle.
+bool FlushFileToDisk(const std::filesystem::path& filePath, const ILogger& log);
@@ -0,0 +1,123 @@
+#include "Histogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Writer methods
+//----------------------------------------------------------------------------------------------------------------------
+void Histogram::Reset()
+{
+    for (auto& bucketCount : bucketCounts)
+    {
+        bucketCount.store(0, std::memory_order_relaxed);
+    }
+    minValue.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void Histogram::Record(uint64_t value)
+{
+    // Since we're the only writer, each value can be updated with a plain load and store
+    auto& bucketCount = bucketCounts[GetBucketIndex(value)];
+    bucketCount.store(bucketCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value < minValue.load(std::memory_order_relaxed))
+    {
+        minValue.store(value, std::memory_order_relaxed);
+    }
+    if (value > maxValue.load(std::memory_order_relaxed))
+    {
+        maxValue.store(value, std::memory_order_relaxed);
+    }
+    sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Reader methods
+//----------------------------------------------------------------------------------------------------------------------
+Histogram::Snapshot Histogram::GetSnapshot() const
+{
+    // Take the total count from the buckets we actually read, so the percentiles are calculated from a consistent set of
+    // counts even if values are being recorded as we go.
+    Snapshot snapshot;
+    snapshot.sum = sum.load(std::memory_order_acquire);
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        snapshot.bucketCounts[i] = bucketCounts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.bucketCounts[i];
+    }
+    if (snapshot.count > 0)
+    {
+        snapshot.minValue = minValue.load(std::memory_order_relaxed);
+        snapshot.maxValue = maxValue.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t Histogram::Snapshot::GetPercentile(double percentile) const
+{
+    // Find the bucket holding the requested rank, and report the upper bound of that bucket, limited to the range of
+    // values actually recorded.
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t targetRank = (uint64_t)std::ceil((std::clamp(percentile, 0.0, 100.0) / 100.0) * (double)count);
+    targetRank = std::max(targetRank, (uint64_t)1);
+    uint64_t cumulativeCount = 0;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        cumulativeCount += bucketCounts[i];
+        if (cumulativeCount >= targetRank)
+        {
+            return std::clamp(GetBucketUpperBound(i), minValue, maxValue);
+        }
+    }
+    return maxValue;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+double Histogram::Snapshot::GetMean() const
+{
+    return (count > 0) ? ((double)sum / (double)count) : 0.0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Bucket methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t Histogram::GetBucketIndex(uint64_t value)
+{
+    if (value < SubBucketCount)
+    {
+        return (size_t)value;
+    }
+    size_t highestBit = (size_t)std::bit_width(value) - 1;
+    size_t shift = highestBit - SubBucketBits;
+    return ((shift + 1) * SubBucketCount) + (size_t)((value >> shift) & (SubBucketCount - 1));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t Histogram::GetBucketLowerBound(size_t bucketIndex)
+{
+    if (bucketIndex < SubBucketCount)
+    {
+        return (uint64_t)bucketIndex;
+    }
+    size_t shift = (bucketIndex / SubBucketCount) - 1;
+    return (uint64_t)(SubBucketCount + (bucketIndex % SubBucketCount)) << shift;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t Histogram::GetBucketUpperBound(size_t bucketIndex)
+{
+    if (bucketIndex < SubBucketCount)
+    {
+        return (uint64_t)bucketIndex;
+    }
+    size_t shift = (bucketIndex / SubBucketCount) - 1;
+    return GetBucketLowerBound(bucketIndex) + (((uint64_t)1 << shift) - 1);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Counts occurrences of non-negative integer values, such as latencies or queue depths, so their distribution can be
+// examined while a capture is running and afterwards. Values below SubBucketCount each get their own bucket. Above that,
+// each power of two range is divided into SubBucketCount equal buckets, so any value can be recorded in a fixed amount
+// of memory, and percentiles are reported to within 1/SubBucketCount of the true value. Values are recorded by a single
+// writer thread, without any read-modify-write operations, and any thread can take a snapshot at any time. A snapshot
+// taken while values are being recorded may miss the most recent values, but is otherwise consistent.
+class alignas(64) Histogram
+{
+public:
+    // Constants
+    static const size_t SubBucketBits = 3;
+    static const size_t SubBucketCount = (size_t)1 << SubBucketBits;
+    static const size_t BucketCount = ((64 - SubBucketBits) + 1) * SubBucketCount;
+
+public:
+    // Structures
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t minValue = 0;
+        uint64_t maxValue = 0;
+        uint64_t sum = 0;
+        std::array<uint64_t, BucketCount> bucketCounts = {};
+
+        uint64_t GetPercentile(double percentile) const;
+        double GetMean() const;
+    };
+
+public:
+    // Writer methods
+    void Reset();
+    void Record(uint64_t value);
+
+    // Reader methods
+    Snapshot GetSnapshot() const;
+
+    // Bucket methods
+    static size_t GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketLowerBound(size_t bucketIndex);
+    static uint64_t GetBucketUpperBound(size_t bucketIndex);
+
+private:
+    std::array<std::atomic<uint64_t>, BucketCount> bucketCounts = {};
+    std::atomic<uint64_t> minValue = 0;
+    std::atomic<uint64_t> maxValue = 0;
+    std::atomic<uint64_t> sum = 0;
+};
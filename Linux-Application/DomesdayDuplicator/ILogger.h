@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <type_traits>
 
@@ -43,6 +45,42 @@ public:
         }
     };
 
+    // A log message captured before formatting, for loggers which defer formatting to another thread. Arguments which
+    // are plain numbers are stored as raw values, and text arguments are copied as UTF-8 into the text buffer after the
+    // format string. Arguments of any other type are resolved to text when the record is built. Text which doesn't fit
+    // in the buffer is truncated.
+    struct LogRecordArg
+    {
+        enum class Type : uint8_t
+        {
+            Signed,
+            Unsigned,
+            Float,
+            Text,
+        };
+        Type type;
+        uint16_t textOffset;
+        uint16_t textLength;
+        union
+        {
+            int64_t signedValue;
+            uint64_t unsignedValue;
+            double floatValue;
+        };
+    };
+    struct LogRecord
+    {
+        static const size_t MaxArgCount = 8;
+        static const size_t TextBufferSize = 512;
+        Severity severity;
+        bool isFormatString;
+        uint8_t argCount;
+        uint16_t formatStringLength;
+        uint16_t textSize;
+        LogRecordArg args[MaxArgCount];
+        char text[TextBufferSize];
+    };
+
 public:
     // Delete method
     virtual void Delete() = 0;
@@ -143,6 +181,12 @@ protected:
     // Logging methods
     virtual void ProcessLogMessage(Severity severity, const wchar_t* message, size_t messageLength) const = 0;
 
+    // Deferred logging methods
+    inline virtual bool IsDeferredFormattingEnabled() const;
+    inline virtual void ProcessLogRecord(const LogRecord& record) const;
+    inline std::wstring ResolveLogRecord(const LogRecord& record) const;
+    inline static void BuildLogRecord(LogRecord& record, Severity severity, const char* message, size_t messageLength);
+
     // String conversion methods
     inline static std::wstring Utf8StringToWString(const std::string& stringUtf8);
     inline static std::string WStringToUtf8String(const std::wstring& wideString);
@@ -192,6 +236,13 @@ private:
     void ResolveArgs(std::wstring* argAsString, T&& arg) const;
     template<class T, class... Args>
     void ResolveArgs(std::wstring* argAsString, T&& arg, Args&&... args) const;
+
+    // Deferred logging methods
+    template<class... Args>
+    bool TryLogDeferred(Severity severity, const char* formatString, size_t formatStringLength, Args&&... args) const;
+    template<class T>
+    static void AppendLogRecordArg(LogRecord& record, T&& arg);
+    inline static void AppendLogRecordText(LogRecord& record, const char* text, size_t textLength, uint16_t& textOffset, uint16_t& textLengthStored);
 };
 
 #include "ILogger.inl"
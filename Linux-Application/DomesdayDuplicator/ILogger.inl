@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <cassert>
 #include <cstring>
@@ -364,6 +365,15 @@ void ILogger::LogInternal(Severity severity, const char* message) const
         return;
     }
 
+    // If this logger defers formatting, hand over the message as it stands.
+    if (IsDeferredFormattingEnabled())
+    {
+        LogRecord record;
+        BuildLogRecord(record, severity, message, std::strlen(message));
+        ProcessLogRecord(record);
+        return;
+    }
+
     // Process the log message
     std::wstring messageConverted = Utf8StringToWString(message);
     ProcessLogMessage(severity, messageConverted.data(), messageConverted.size());
@@ -392,6 +402,15 @@ void ILogger::LogInternal(Severity severity, const std::string& message) const
         return;
     }
 
+    // If this logger defers formatting, hand over the message as it stands.
+    if (IsDeferredFormattingEnabled())
+    {
+        LogRecord record;
+        BuildLogRecord(record, severity, message.data(), message.size());
+        ProcessLogRecord(record);
+        return;
+    }
+
     // Process the log message
     std::wstring messageConverted = Utf8StringToWString(message);
     ProcessLogMessage(severity, messageConverted.data(), messageConverted.size());
@@ -420,6 +439,12 @@ void ILogger::LogInternal(Severity severity, const char* formatString, Args&&...
         return;
     }
 
+    // If this logger defers formatting, hand over the format string and raw argument values.
+    if (TryLogDeferred(severity, formatString, std::strlen(formatString), args...))
+    {
+        return;
+    }
+
     // Convert all supplied arguments to a string representation
     const size_t argCount = sizeof...(Args);
     std::wstring argsResolved[argCount];
@@ -465,6 +490,12 @@ void ILogger::LogInternal(Severity severity, const std::string& formatString, Ar
         return;
     }
 
+    // If this logger defers formatting, hand over the format string and raw argument values.
+    if (TryLogDeferred(severity, formatString.data(), formatString.size(), args...))
+    {
+        return;
+    }
+
     // Convert all supplied arguments to a string representation
     const size_t argCount = sizeof...(Args);
     std::wstring argsResolved[argCount];
@@ -569,6 +600,84 @@ void ILogger::ResolveArgs(std::wstring* argAsString, T&& arg, Args&&... args) co
     ResolveArgs(argAsString, std::forward<Args>(args)...);
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Deferred logging methods
+//----------------------------------------------------------------------------------------------------------------------
+template<class... Args>
+bool ILogger::TryLogDeferred(Severity severity, const char* formatString, size_t formatStringLength, Args&&... args) const
+{
+    // Messages with more arguments than a record can hold are always formatted on the calling thread
+    if constexpr (sizeof...(Args) > LogRecord::MaxArgCount)
+    {
+        return false;
+    }
+    else
+    {
+        if (!IsDeferredFormattingEnabled())
+        {
+            return false;
+        }
+        LogRecord record;
+        BuildLogRecord(record, severity, formatString, formatStringLength);
+        record.isFormatString = true;
+        (AppendLogRecordArg(record, std::forward<Args>(args)), ...);
+        ProcessLogRecord(record);
+        return true;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+template<class T>
+void ILogger::AppendLogRecordArg(LogRecord& record, T&& arg)
+{
+    // Numbers are stored as raw values, and strings are copied as they stand. Characters are deliberately excluded from
+    // the integer types here, as they're written as text rather than numbers. Anything else is resolved to text now,
+    // since we can't assume the argument will still be around when the record is formatted.
+    typedef typename std::remove_cv<typename std::remove_reference<T>::type>::type ArgType;
+    typedef typename std::decay<T>::type DecayedArgType;
+    constexpr bool isCharacter = std::is_same<ArgType, char>::value || std::is_same<ArgType, signed char>::value || std::is_same<ArgType, unsigned char>::value || std::is_same<ArgType, wchar_t>::value || std::is_same<ArgType, char8_t>::value || std::is_same<ArgType, char16_t>::value || std::is_same<ArgType, char32_t>::value;
+    LogRecordArg& recordArg = record.args[record.argCount++];
+    if constexpr (std::is_enum<ArgType>::value || std::is_same<ArgType, bool>::value)
+    {
+        recordArg.type = LogRecordArg::Type::Unsigned;
+        recordArg.unsignedValue = (unsigned int)arg;
+    }
+    else if constexpr (std::is_integral<ArgType>::value && !isCharacter && std::is_signed<ArgType>::value)
+    {
+        recordArg.type = LogRecordArg::Type::Signed;
+        recordArg.signedValue = (int64_t)arg;
+    }
+    else if constexpr (std::is_integral<ArgType>::value && !isCharacter)
+    {
+        recordArg.type = LogRecordArg::Type::Unsigned;
+        recordArg.unsignedValue = (uint64_t)arg;
+    }
+    else if constexpr (std::is_floating_point<ArgType>::value)
+    {
+        recordArg.type = LogRecordArg::Type::Float;
+        recordArg.floatValue = (double)arg;
+    }
+    else if constexpr (std::is_same<ArgType, std::string>::value)
+    {
+        recordArg.type = LogRecordArg::Type::Text;
+        AppendLogRecordText(record, arg.data(), arg.size(), recordArg.textOffset, recordArg.textLength);
+    }
+    else if constexpr (std::is_same<DecayedArgType, const char*>::value || std::is_same<DecayedArgType, char*>::value)
+    {
+        const char* text = arg;
+        recordArg.type = LogRecordArg::Type::Text;
+        AppendLogRecordText(record, text, (text != nullptr) ? std::strlen(text) : 0, recordArg.textOffset, recordArg.textLength);
+    }
+    else
+    {
+        std::wstring argResolved;
+        ArgResolver<ArgType>::ResolveArg(arg, argResolved);
+        std::string argResolvedUtf8 = WStringToUtf8String(argResolved);
+        recordArg.type = LogRecordArg::Type::Text;
+        AppendLogRecordText(record, argResolvedUtf8.data(), argResolvedUtf8.size(), recordArg.textOffset, recordArg.textLength);
+    }
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // String conversion methods
 //----------------------------------------------------------------------------------------------------------------------
@@ -802,6 +911,79 @@ void ILogger::ArgResolver<std::wstring, false, false>::ResolveArg(const std::wst
     argResolved = arg;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Deferred logging methods
+//----------------------------------------------------------------------------------------------------------------------
+bool ILogger::IsDeferredFormattingEnabled() const
+{
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ILogger::ProcessLogRecord(const LogRecord& record) const
+{
+    std::wstring messageResolved = ResolveLogRecord(record);
+    ProcessLogMessage(record.severity, messageResolved.data(), messageResolved.size());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::wstring ILogger::ResolveLogRecord(const LogRecord& record) const
+{
+    // If the record holds a complete message, we just need to convert it.
+    std::wstring formatStringConverted = Utf8StringToWString(std::string(record.text, record.formatStringLength));
+    if (!record.isFormatString)
+    {
+        return formatStringConverted;
+    }
+
+    // Convert all stored arguments to a string representation, the same way they would have been resolved if the
+    // message had been formatted when it was logged.
+    std::wstring argsResolved[LogRecord::MaxArgCount];
+    for (size_t i = 0; i < record.argCount; ++i)
+    {
+        const LogRecordArg& recordArg = record.args[i];
+        switch (recordArg.type)
+        {
+        case LogRecordArg::Type::Signed:
+            ArgResolver<int64_t>::ResolveArg(recordArg.signedValue, argsResolved[i]);
+            break;
+        case LogRecordArg::Type::Unsigned:
+            ArgResolver<uint64_t>::ResolveArg(recordArg.unsignedValue, argsResolved[i]);
+            break;
+        case LogRecordArg::Type::Float:
+            ArgResolver<double>::ResolveArg(recordArg.floatValue, argsResolved[i]);
+            break;
+        case LogRecordArg::Type::Text:
+            argsResolved[i] = Utf8StringToWString(std::string(record.text + recordArg.textOffset, recordArg.textLength));
+            break;
+        }
+    }
+
+    // Resolve the format string and argument values down to a single string
+    return ResolveFormatString(formatStringConverted, record.argCount, argsResolved);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ILogger::BuildLogRecord(LogRecord& record, Severity severity, const char* message, size_t messageLength)
+{
+    record.severity = severity;
+    record.isFormatString = false;
+    record.argCount = 0;
+    record.textSize = 0;
+    uint16_t messageOffset;
+    AppendLogRecordText(record, message, messageLength, messageOffset, record.formatStringLength);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ILogger::AppendLogRecordText(LogRecord& record, const char* text, size_t textLength, uint16_t& textOffset, uint16_t& textLengthStored)
+{
+    size_t copyLength = std::min(textLength, LogRecord::TextBufferSize - record.textSize);
+    std::memcpy(record.text + record.textSize, text, copyLength);
+    textOffset = record.textSize;
+    textLengthStored = (uint16_t)copyLength;
+    record.textSize += (uint16_t)copyLength;
+}
+
 //----------------------------------------------------------------------------------------
 // Enumeration operators
 //----------------------------------------------------------------------------------------
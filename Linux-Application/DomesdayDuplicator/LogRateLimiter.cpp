@@ -0,0 +1,91 @@
+#include "LogRateLimiter.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+LogRateLimiter::LogRateLimiter(ILogger::Severity severity, const char* messageSiteName, size_t maxMessageCountPerInterval, std::chrono::steady_clock::duration interval)
+:severity(severity), messageSiteName(messageSiteName), maxMessageCountPerInterval(maxMessageCountPerInterval), interval(interval)
+{ }
+
+//----------------------------------------------------------------------------------------------------------------------
+// Rate limiting methods
+//----------------------------------------------------------------------------------------------------------------------
+void LogRateLimiter::Reset()
+{
+    intervalStarted = false;
+    intervalMessageCount = 0;
+    pendingSuppressedCount = 0;
+    occurrenceCount = 0;
+    suppressedCount = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool LogRateLimiter::ShouldLog(const ILogger& log)
+{
+    // Start a new interval if the last one has ended, reporting anything we suppressed during it first, so the summary
+    // appears ahead of the next message which gets through.
+    ++occurrenceCount;
+    std::chrono::steady_clock::time_point currentTime = std::chrono::steady_clock::now();
+    if (!intervalStarted || ((currentTime - intervalStartTime) >= interval))
+    {
+        LogSuppressedMessageSummary(log);
+        intervalStarted = true;
+        intervalStartTime = currentTime;
+        intervalMessageCount = 0;
+    }
+
+    // Allow the message through if we're still within the limit for this interval
+    if (intervalMessageCount < maxMessageCountPerInterval)
+    {
+        ++intervalMessageCount;
+        return true;
+    }
+    ++pendingSuppressedCount;
+    ++suppressedCount;
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void LogRateLimiter::Update(const ILogger& log)
+{
+    // If messages were suppressed in an interval which has since ended, report them now rather than waiting for the next
+    // occurrence, which may never come.
+    if ((pendingSuppressedCount == 0) || ((std::chrono::steady_clock::now() - intervalStartTime) < interval))
+    {
+        return;
+    }
+    LogSuppressedMessageSummary(log);
+    intervalStarted = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void LogRateLimiter::Flush(const ILogger& log)
+{
+    LogSuppressedMessageSummary(log);
+    intervalStarted = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void LogRateLimiter::LogSuppressedMessageSummary(const ILogger& log)
+{
+    if (pendingSuppressedCount == 0)
+    {
+        return;
+    }
+    log.Log(severity, "{0}: suppressed {1} similar messages", messageSiteName, pendingSuppressedCount);
+    pendingSuppressedCount = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Statistics methods
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t LogRateLimiter::GetOccurrenceCount() const
+{
+    return occurrenceCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t LogRateLimiter::GetSuppressedCount() const
+{
+    return suppressedCount;
+}
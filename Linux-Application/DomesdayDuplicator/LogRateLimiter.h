@@ -0,0 +1,48 @@
+#pragma once
+#include "ILogger.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Limits how often a repetitive log message is written, so a capture which fails the same way many times a second
+// doesn't flood the log, or spend its time formatting messages. Each limiter covers a single message site. Up to a set
+// number of occurrences are logged in each interval, after which further occurrences are only counted, and a single
+// line reporting how many similar messages were suppressed is logged once the interval has ended. A limiter isn't
+// thread safe, and should only be used by the thread which owns the message site.
+class LogRateLimiter
+{
+public:
+    // Constants
+    static const size_t DefaultMaxMessageCountPerInterval = 5;
+    static constexpr std::chrono::milliseconds DefaultInterval = std::chrono::milliseconds(1000);
+
+public:
+    // Constructors
+    LogRateLimiter(ILogger::Severity severity, const char* messageSiteName, size_t maxMessageCountPerInterval = DefaultMaxMessageCountPerInterval, std::chrono::steady_clock::duration interval = DefaultInterval);
+
+    // Rate limiting methods
+    void Reset();
+    bool ShouldLog(const ILogger& log);
+    void Update(const ILogger& log);
+    void Flush(const ILogger& log);
+
+    // Statistics methods
+    uint64_t GetOccurrenceCount() const;
+    uint64_t GetSuppressedCount() const;
+
+private:
+    // Rate limiting methods
+    void LogSuppressedMessageSummary(const ILogger& log);
+
+private:
+    ILogger::Severity severity;
+    const char* messageSiteName;
+    size_t maxMessageCountPerInterval;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point intervalStartTime;
+    bool intervalStarted = false;
+    size_t intervalMessageCount = 0;
+    uint64_t pendingSuppressedCount = 0;
+    uint64_t occurrenceCount = 0;
+    uint64_t suppressedCount = 0;
+};
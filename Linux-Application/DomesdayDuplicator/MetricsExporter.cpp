@@ -0,0 +1,336 @@
+#include "MetricsExporter.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <system_error>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+MetricsExporter::MetricsExporter(const ILogger& log)
+:log(log)
+{ }
+
+//----------------------------------------------------------------------------------------------------------------------
+MetricsExporter::~MetricsExporter()
+{
+    Stop();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Logging methods
+//----------------------------------------------------------------------------------------------------------------------
+const ILogger& MetricsExporter::Log() const
+{
+    return log;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Export methods
+//----------------------------------------------------------------------------------------------------------------------
+bool MetricsExporter::Start(const std::filesystem::path& path)
+{
+    Stop();
+    exportPath = path;
+    useMetricsFile = (path.extension() == MetricsFileExtension);
+    if (!useMetricsFile)
+    {
+#ifdef _WIN32
+        Log().Error("Start(): Metrics sockets are not supported on this platform, use a path ending in {0} instead of {1}", MetricsFileExtension, path);
+        return false;
+#else
+        // Create the socket at the target path. We'll replace a stale socket left behind by a previous run, but we
+        // won't remove anything else which is in the way.
+        std::error_code errorCode;
+        std::filesystem::file_status pathStatus = std::filesystem::status(path, errorCode);
+        if (std::filesystem::is_socket(pathStatus))
+        {
+            std::filesystem::remove(path, errorCode);
+        }
+        else if (std::filesystem::exists(pathStatus))
+        {
+            Log().Error("Start(): Metrics path {0} already exists, and isn't a socket", path);
+            return false;
+        }
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::string pathString = path.string();
+        if (pathString.size() >= sizeof(address.sun_path))
+        {
+            Log().Error("Start(): Metrics path {0} is too long for a socket", path);
+            return false;
+        }
+        memcpy(address.sun_path, pathString.c_str(), pathString.size() + 1);
+        listenerFileDescriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if ((listenerFileDescriptor < 0) || (bind(listenerFileDescriptor, (const sockaddr*)&address, sizeof(address)) != 0) || (listen(listenerFileDescriptor, 4) != 0))
+        {
+            Log().Error("Start(): Failed to create metrics socket at path {0} with error {1}", path, strerror(errno));
+            CloseListener();
+            return false;
+        }
+#endif
+    }
+
+    // Start the export thread
+    stopRequested.clear();
+    exportRunning = true;
+    exportThread = std::thread(std::bind(std::mem_fn(&MetricsExporter::ExportThread), this));
+    Log().Info("Start(): Metrics available from {0} {1}", useMetricsFile ? "file" : "socket", path);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::Stop()
+{
+    if (!exportThread.joinable())
+    {
+        return;
+    }
+    stopRequested.test_and_set();
+    exportThread.join();
+    CloseListener();
+    exportRunning = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool MetricsExporter::IsRunning() const
+{
+    return exportRunning;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::filesystem::path MetricsExporter::GetPath() const
+{
+    return exportPath;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::Publish(std::string metricsText)
+{
+    std::unique_lock<std::mutex> lock(metricsMutex);
+    publishedMetricsText = std::move(metricsText);
+    ++publishedMetricsGeneration;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::ExportThread()
+{
+    uint64_t writtenMetricsGeneration = 0;
+    bool lastWriteFailed = false;
+    while (!stopRequested.test())
+    {
+        if (!useMetricsFile)
+        {
+            ServeSocketClients();
+            continue;
+        }
+
+        // Rewrite the metrics file whenever new metrics have been published. We only report a failure to write the
+        // file when it first occurs, so a missing directory doesn't fill the log.
+        std::string metricsText;
+        uint64_t metricsGeneration;
+        {
+            std::unique_lock<std::mutex> lock(metricsMutex);
+            metricsGeneration = publishedMetricsGeneration;
+            if (metricsGeneration != writtenMetricsGeneration)
+            {
+                metricsText = publishedMetricsText;
+            }
+        }
+        if (metricsGeneration != writtenMetricsGeneration)
+        {
+            bool writeFailed = !WriteMetricsFile(metricsText);
+            if (writeFailed && !lastWriteFailed)
+            {
+                Log().Warning("ExportThread(): Failed to write metrics file {0}", exportPath);
+            }
+            lastWriteFailed = writeFailed;
+            writtenMetricsGeneration = metricsGeneration;
+        }
+        std::this_thread::sleep_for(PollInterval);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool MetricsExporter::WriteMetricsFile(const std::string& metricsText)
+{
+    // Write the metrics to a temporary file alongside the target, then rename it over the target, so a reader never
+    // sees a partially written file.
+    std::filesystem::path temporaryPath = exportPath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream metricsFile(temporaryPath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!metricsFile.is_open())
+        {
+            return false;
+        }
+        metricsFile.write(metricsText.data(), (std::streamsize)metricsText.size());
+        if (!metricsFile.good())
+        {
+            return false;
+        }
+    }
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryPath, exportPath, errorCode);
+    return !errorCode;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::ServeSocketClients()
+{
+#ifndef _WIN32
+    // Wait for a client to connect
+    pollfd listenerPoll = { listenerFileDescriptor, POLLIN, 0 };
+    if (poll(&listenerPoll, 1, (int)PollInterval.count()) <= 0)
+    {
+        return;
+    }
+    int clientFileDescriptor = accept4(listenerFileDescriptor, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (clientFileDescriptor < 0)
+    {
+        return;
+    }
+
+    // Send the current metrics to the client and close the connection. We write without blocking, and give up on a
+    // client which stops reading, so one stalled client can't stop the metrics being served to others.
+    std::string metricsText;
+    {
+        std::unique_lock<std::mutex> lock(metricsMutex);
+        metricsText = publishedMetricsText;
+    }
+    const char* data = metricsText.data();
+    size_t remainingSizeInBytes = metricsText.size();
+    while ((remainingSizeInBytes > 0) && !stopRequested.test())
+    {
+        pollfd clientPoll = { clientFileDescriptor, POLLOUT, 0 };
+        if (poll(&clientPoll, 1, (int)PollInterval.count()) <= 0)
+        {
+            break;
+        }
+        ssize_t writtenSize = send(clientFileDescriptor, data, remainingSizeInBytes, MSG_NOSIGNAL);
+        if (writtenSize < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+            {
+                continue;
+            }
+            break;
+        }
+        data += writtenSize;
+        remainingSizeInBytes -= (size_t)writtenSize;
+    }
+    close(clientFileDescriptor);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::CloseListener()
+{
+#ifndef _WIN32
+    if (listenerFileDescriptor >= 0)
+    {
+        close(listenerFileDescriptor);
+        listenerFileDescriptor = -1;
+        std::error_code errorCode;
+        std::filesystem::remove(exportPath, errorCode);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Formatting methods
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::AppendCounter(std::string& metricsText, const std::string& name, const std::string& help, double value)
+{
+    AppendHeader(metricsText, name, help, "counter");
+    metricsText += MetricNamePrefix + name + " " + FormatValue(value) + "\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::AppendGauge(std::string& metricsText, const std::string& name, const std::string& help, double value)
+{
+    AppendHeader(metricsText, name, help, "gauge");
+    metricsText += MetricNamePrefix + name + " " + FormatValue(value) + "\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Append a gauge with a constant value of 1, which carries its information in a label
+void MetricsExporter::AppendInfo(std::string& metricsText, const std::string& name, const std::string& help, const std::string& labelName, const std::string& labelValue)
+{
+    std::string escapedLabelValue;
+    for (char character : labelValue)
+    {
+        if ((character == '\\') || (character == '"'))
+        {
+            escapedLabelValue += '\\';
+        }
+        escapedLabelValue += (character == '\n') ? std::string("\\n") : std::string(1, character);
+    }
+    AppendHeader(metricsText, name, help, "gauge");
+    metricsText += MetricNamePrefix + name + "{" + labelName + "=\"" + escapedLabelValue + "\"} 1\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::AppendHistogram(std::string& metricsText, const std::string& name, const std::string& help, const Histogram::Snapshot& snapshot, double valueScale)
+{
+    // Prometheus histogram buckets are cumulative, and each is labelled with its inclusive upper bound. To keep the
+    // number of series down, we merge our buckets so that each power of two range is reported as a single bucket, and
+    // report every bucket up to the highest one which has been used. This keeps the set of buckets the same from one
+    // scrape to the next, other than growing as larger values are recorded.
+    AppendHeader(metricsText, name, help, "histogram");
+    std::string fullName = MetricNamePrefix + name;
+    size_t usedBucketCount = Histogram::BucketCount;
+    while ((usedBucketCount > 0) && (snapshot.bucketCounts[usedBucketCount - 1] == 0))
+    {
+        --usedBucketCount;
+    }
+    uint64_t cumulativeCount = 0;
+    for (size_t i = 0; i < usedBucketCount; ++i)
+    {
+        cumulativeCount += snapshot.bucketCounts[i];
+        bool lastBucketInRange = (i < Histogram::SubBucketCount) || ((i % Histogram::SubBucketCount) == (Histogram::SubBucketCount - 1));
+        if (lastBucketInRange || (i == (usedBucketCount - 1)))
+        {
+            size_t reportedBucketIndex = (i < Histogram::SubBucketCount) ? i : (i | (Histogram::SubBucketCount - 1));
+            double upperBound = (double)Histogram::GetBucketUpperBound(reportedBucketIndex) * valueScale;
+            metricsText += fullName + "_bucket{le=\"" + FormatValue(upperBound) + "\"} " + std::to_string(cumulativeCount) + "\n";
+        }
+    }
+    metricsText += fullName + "_bucket{le=\"+Inf\"} " + std::to_string(snapshot.count) + "\n";
+    metricsText += fullName + "_sum " + FormatValue((double)snapshot.sum * valueScale) + "\n";
+    metricsText += fullName + "_count " + std::to_string(snapshot.count) + "\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void MetricsExporter::AppendHeader(std::string& metricsText, const std::string& name, const std::string& help, const char* type)
+{
+    metricsText += "# HELP " + (MetricNamePrefix + name) + " " + help + "\n";
+    metricsText += "# TYPE " + (MetricNamePrefix + name) + " " + type + "\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string MetricsExporter::FormatValue(double value)
+{
+    if (std::isnan(value))
+    {
+        return "NaN";
+    }
+    if (std::isinf(value))
+    {
+        return (value > 0) ? "+Inf" : "-Inf";
+    }
+    std::ostringstream valueStream;
+    valueStream.precision(15);
+    valueStream << value;
+    return valueStream.str();
+}
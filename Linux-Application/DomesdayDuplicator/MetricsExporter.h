@@ -0,0 +1,73 @@
+#pragma once
+#include "ILogger.h"
+#include "Histogram.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Exports live capture metrics in the Prometheus text exposition format, so capture machines can be monitored by an
+// external scraper. If the target path has a ".prom" extension, the metrics are written to that file, which is
+// atomically replaced each time new metrics are published, in the form the node exporter textfile collector expects.
+// Otherwise, a UNIX domain socket is created at the path, and the current metrics are sent to each client which
+// connects to it, after which the connection is closed. Metrics are formatted by the caller from the published capture
+// statistics, and handed over as a complete block of text, so the exporter thread never touches the capture itself.
+class MetricsExporter
+{
+public:
+    // Constants
+    static constexpr std::chrono::milliseconds PollInterval = std::chrono::milliseconds(100);
+    static constexpr const char* MetricNamePrefix = "domesday_duplicator_";
+    static constexpr const char* MetricsFileExtension = ".prom";
+
+public:
+    // Constructors
+    MetricsExporter(const ILogger& log);
+    ~MetricsExporter();
+
+    // Export methods
+    bool Start(const std::filesystem::path& path);
+    void Stop();
+    bool IsRunning() const;
+    std::filesystem::path GetPath() const;
+    void Publish(std::string metricsText);
+
+    // Formatting methods
+    static void AppendCounter(std::string& metricsText, const std::string& name, const std::string& help, double value);
+    static void AppendGauge(std::string& metricsText, const std::string& name, const std::string& help, double value);
+    static void AppendInfo(std::string& metricsText, const std::string& name, const std::string& help, const std::string& labelName, const std::string& labelValue);
+    static void AppendHistogram(std::string& metricsText, const std::string& name, const std::string& help, const Histogram::Snapshot& snapshot, double valueScale);
+
+protected:
+    // Logging methods
+    const ILogger& Log() const;
+
+private:
+    // Export methods
+    void ExportThread();
+    bool WriteMetricsFile(const std::string& metricsText);
+    void ServeSocketClients();
+    void CloseListener();
+
+    // Formatting methods
+    static void AppendHeader(std::string& metricsText, const std::string& name, const std::string& help, const char* type);
+    static std::string FormatValue(double value);
+
+private:
+    const ILogger& log;
+    std::filesystem::path exportPath;
+    bool useMetricsFile = false;
+    int listenerFileDescriptor = -1;
+    std::thread exportThread;
+    std::atomic<bool> exportRunning = false;
+    std::atomic_flag stopRequested;
+
+    // The most recently published metrics, and a count of how many times they've been published, so the export thread
+    // can tell when the metrics file needs to be rewritten.
+    mutable std::mutex metricsMutex;
+    std::string publishedMetricsText;
+    uint64_t publishedMetricsGeneration = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// Publishes a value from a single writer thread to any number of reader threads, without locking. The writer never
+// waits for the readers. Instead, a sequence number is odd while an update is in progress, and a reader retries if it
+// was odd or changed while the value was being copied, so readers always see the whole of one published value. The
+// value is held as a series of atomic words, so a reader copying it while the writer is updating it is well defined.
+// Values are converted to and from their object representation with std::bit_cast, so types with default member
+// initializers can be published without copying raw bytes over a non-trivial object.
+template<class T>
+class SeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable");
+
+public:
+    // Constructors
+    SeqLock()
+    {
+        Store(T());
+    }
+
+    // Writer methods
+    void Store(const T& value)
+    {
+        std::array<uint64_t, WordCount> valueWords = {};
+        ValueBytes valueBytes = std::bit_cast<ValueBytes>(value);
+        memcpy(valueWords.data(), valueBytes.data(), sizeof(T));
+        uint64_t currentSequence = sequence.load(std::memory_order_relaxed);
+        sequence.store(currentSequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WordCount; ++i)
+        {
+            words[i].store(valueWords[i], std::memory_order_relaxed);
+        }
+        sequence.store(currentSequence + 2, std::memory_order_release);
+    }
+
+    // Reader methods
+    T Load() const
+    {
+        std::array<uint64_t, WordCount> valueWords;
+        while (true)
+        {
+            uint64_t sequenceBefore = sequence.load(std::memory_order_acquire);
+            if ((sequenceBefore % 2) == 0)
+            {
+                for (size_t i = 0; i < WordCount; ++i)
+                {
+                    valueWords[i] = words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == sequenceBefore)
+                {
+                    break;
+                }
+            }
+            std::this_thread::yield();
+        }
+        ValueBytes valueBytes;
+        memcpy(valueBytes.data(), valueWords.data(), sizeof(T));
+        return std::bit_cast<T>(valueBytes);
+    }
+
+private:
+    typedef std::array<unsigned char, sizeof(T)> ValueBytes;
+    static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    alignas(64) std::atomic<uint64_t> sequence = 0;
+    std::array<std::atomic<uint64_t>, WordCount> words = {};
+};
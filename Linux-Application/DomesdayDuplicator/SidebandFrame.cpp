@@ -0,0 +1,157 @@
+#include "SidebandFrame.h"
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIDEBAND_FRAME_USE_SSE2
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// Decoding methods
+//----------------------------------------------------------------------------------------------------------------------
+bool SidebandFrame::IsFrameStart(const uint8_t* buffer, size_t byteOffset)
+{
+    for (size_t chunk = 0; chunk < 4; ++chunk)
+    {
+        if (ExtractSyncPattern(buffer, byteOffset + ((SyncStart + (chunk * 8)) * 2)) != SyncPattern[chunk])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Extract 48-bit sync pattern from 8 samples (6 bits per sample from top 6 bits)
+uint64_t SidebandFrame::ExtractSyncPattern(const uint8_t* buffer, size_t byteOffset)
+{
+    uint64_t pattern = 0;
+    for (size_t i = 0; i < 8; i++) {
+        size_t offset = byteOffset + i * 2;
+        uint8_t bits6 = (buffer[offset + 1] >> 2) & 0x3F;
+        pattern |= ((uint64_t)bits6 << (i * 6));
+    }
+    return pattern;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Extract 48-bit counter value from 8 samples (6 bits per sample from top 6 bits)
+uint64_t SidebandFrame::Extract48BitCounter(const uint8_t* buffer, size_t byteOffset)
+{
+    uint64_t counter = 0;
+    for (size_t i = 0; i < 8; i++) {
+        size_t offset = byteOffset + i * 2;
+        uint8_t bits6 = (buffer[offset + 1] >> 2) & 0x3F;
+        counter |= ((uint64_t)bits6 << (i * 6));
+    }
+    return counter;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Extract 12-bit audio value from two consecutive samples (6 bits each from top 6 bits)
+uint16_t SidebandFrame::Extract12BitAudio(const uint8_t* buffer, size_t byteOffset, size_t sampleIndex)
+{
+    size_t offset1 = byteOffset + sampleIndex * 2;
+    size_t offset2 = byteOffset + (sampleIndex + 1) * 2;
+    uint8_t high6 = (buffer[offset1 + 1] >> 2) & 0x3F;
+    uint8_t low6 = (buffer[offset2 + 1] >> 2) & 0x3F;
+    return ((uint16_t)high6 << 6) | (uint16_t)low6;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Extract 24-bit audio value from four consecutive samples (6 bits each from top 6 bits, most significant first)
+uint32_t SidebandFrame::Extract24BitTop6x4(const uint8_t* buffer, size_t byteOffset)
+{
+    uint8_t s0 = (buffer[byteOffset + 1] >> 2) & 0x3F;
+    uint8_t s1 = (buffer[byteOffset + 3] >> 2) & 0x3F;
+    uint8_t s2 = (buffer[byteOffset + 5] >> 2) & 0x3F;
+    uint8_t s3 = (buffer[byteOffset + 7] >> 2) & 0x3F;
+    return ((uint32_t)s0 << 18) | ((uint32_t)s1 << 12) | ((uint32_t)s2 << 6) | (uint32_t)s3;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Batch decoding methods
+//----------------------------------------------------------------------------------------------------------------------
+// Decode the ADC128S022 audio from a run of audio field blocks into packed 16-bit stereo frames. Each 12-bit sample is
+// converted from unsigned to signed and scaled up to the full 16-bit range.
+void SidebandFrame::DecodeAdc128s022Audio(const uint8_t* audioFieldBlocks, size_t frameCount, uint8_t* frameData)
+{
+    size_t frameIndex = 0;
+#ifdef SIDEBAND_FRAME_USE_SSE2
+    // Four frames are decoded at once here. The top 6 bits of each sample word are shifted down, then each pair of
+    // fields is combined into a 12-bit value with a single multiply-add, giving the left and right samples for each
+    // frame in adjacent 32-bit lanes. These are offset, scaled, and packed down to 16 bits in the output order.
+    const __m128i fieldWeights = _mm_set1_epi32((1 << 16) | 64);
+    const __m128i midScale = _mm_set1_epi32(2048);
+    for (; (frameIndex + 4) <= frameCount; frameIndex += 4)
+    {
+        const uint8_t* blocks = audioFieldBlocks + (frameIndex * AudioFieldBlockSizeInBytes);
+        __m128i fields01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)blocks), _mm_loadl_epi64((const __m128i*)(blocks + AudioFieldBlockSizeInBytes)));
+        __m128i fields23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(blocks + (AudioFieldBlockSizeInBytes * 2))), _mm_loadl_epi64((const __m128i*)(blocks + (AudioFieldBlockSizeInBytes * 3))));
+        __m128i samples01 = _mm_madd_epi16(_mm_srli_epi16(fields01, 10), fieldWeights);
+        __m128i samples23 = _mm_madd_epi16(_mm_srli_epi16(fields23, 10), fieldWeights);
+        samples01 = _mm_slli_epi32(_mm_sub_epi32(samples01, midScale), 4);
+        samples23 = _mm_slli_epi32(_mm_sub_epi32(samples23, midScale), 4);
+        _mm_storeu_si128((__m128i*)(frameData + (frameIndex * 4)), _mm_packs_epi32(samples01, samples23));
+    }
+#endif
+    for (; frameIndex < frameCount; ++frameIndex)
+    {
+        const uint8_t* block = audioFieldBlocks + (frameIndex * AudioFieldBlockSizeInBytes);
+        uint16_t left16 = (uint16_t)(int16_t)(((int16_t)Extract12BitAudio(block, 0, 0) - 2048) * 16);
+        uint16_t right16 = (uint16_t)(int16_t)(((int16_t)Extract12BitAudio(block, 0, 2) - 2048) * 16);
+        uint8_t* framePointer = frameData + (frameIndex * 4);
+        framePointer[0] = (uint8_t)(left16 & 0xFF);
+        framePointer[1] = (uint8_t)(left16 >> 8);
+        framePointer[2] = (uint8_t)(right16 & 0xFF);
+        framePointer[3] = (uint8_t)(right16 >> 8);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Decode the PCM1802 audio from a run of audio field blocks into packed 24-bit stereo frames. The samples are carried
+// as 24-bit two's complement values already, so they're written out unchanged.
+void SidebandFrame::DecodePcm1802Audio(const uint8_t* audioFieldBlocks, size_t frameCount, uint8_t* frameData)
+{
+    const size_t pcm1802BlockOffset = (Pcm1802Start - Adc128Start) * 2;
+    size_t frameIndex = 0;
+#ifdef SIDEBAND_FRAME_USE_SSE2
+    // Four frames are decoded at once here. The 6-bit fields are combined into 12-bit halves with one multiply-add,
+    // then packed back down and combined into 24-bit samples with another. Each pair of left and right samples is then
+    // squeezed together into 6 bytes, and the 12 bytes from each pair of frames are stored with a single write. The
+    // second write runs 4 bytes past the last of the four frames, so we only take this path while there's at least one
+    // more frame to follow, which overwrites those bytes.
+    const __m128i fieldWeights = _mm_set1_epi32((1 << 16) | 64);
+    const __m128i halfWeights = _mm_set1_epi32((1 << 16) | 4096);
+    const __m128i lowSampleMask = _mm_set_epi32(0, -1, 0, -1);
+    for (; (frameIndex + 5) <= frameCount; frameIndex += 4)
+    {
+        const uint8_t* blocks = audioFieldBlocks + (frameIndex * AudioFieldBlockSizeInBytes) + pcm1802BlockOffset;
+        __m128i halves[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            __m128i fields = _mm_loadu_si128((const __m128i*)(blocks + (i * AudioFieldBlockSizeInBytes)));
+            halves[i] = _mm_madd_epi16(_mm_srli_epi16(fields, 10), fieldWeights);
+        }
+        uint8_t* framePointer = frameData + (frameIndex * 6);
+        for (size_t i = 0; i < 4; i += 2)
+        {
+            __m128i samples = _mm_madd_epi16(_mm_packs_epi32(halves[i], halves[i + 1]), halfWeights);
+            __m128i framePairs = _mm_or_si128(_mm_and_si128(samples, lowSampleMask), _mm_slli_epi64(_mm_srli_epi64(samples, 32), 24));
+            __m128i packedFrames = _mm_or_si128(_mm_move_epi64(framePairs), _mm_slli_si128(_mm_unpackhi_epi64(framePairs, _mm_setzero_si128()), 6));
+            _mm_storeu_si128((__m128i*)(framePointer + (i * 6)), packedFrames);
+        }
+    }
+#endif
+    for (; frameIndex < frameCount; ++frameIndex)
+    {
+        const uint8_t* block = audioFieldBlocks + (frameIndex * AudioFieldBlockSizeInBytes);
+        uint32_t pcmLeft = Extract24BitTop6x4(block, pcm1802BlockOffset);
+        uint32_t pcmRight = Extract24BitTop6x4(block, pcm1802BlockOffset + 8);
+        uint8_t* framePointer = frameData + (frameIndex * 6);
+        framePointer[0] = (uint8_t)(pcmLeft & 0xFF);
+        framePointer[1] = (uint8_t)((pcmLeft >> 8) & 0xFF);
+        framePointer[2] = (uint8_t)((pcmLeft >> 16) & 0xFF);
+        framePointer[3] = (uint8_t)(pcmRight & 0xFF);
+        framePointer[4] = (uint8_t)((pcmRight >> 8) & 0xFF);
+        framePointer[5] = (uint8_t)((pcmRight >> 16) & 0xFF);
+    }
+}
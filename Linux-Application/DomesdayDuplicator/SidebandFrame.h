@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Describes the frame structure the device uses to carry sideband data in the top 6 bits of each 16-bit sample word,
+// alongside the 10-bit RF sample in the bottom bits. The sideband is divided into 512-sample frames, each starting
+// with a 192-bit sync pattern, followed by the ADC128S022 and PCM1802 audio samples for the frame, and a 48-bit
+// counter which advances once for every 8 samples for the remainder of the frame. This matches dataGenerator.v in the
+// FPGA firmware.
+class SidebandFrame
+{
+public:
+    // Constants
+    static const size_t SamplesPerFrame = 512;
+    static const size_t SyncStart = 0;
+    static const size_t SyncSampleCount = 32;
+    static const size_t Adc128Start = 32;
+    static const size_t Pcm1802Start = 38;
+    static const size_t CounterStart = 48;
+    static const size_t CounterSamplesPerValue = 8;
+    static const uint64_t CounterValuesPerFrame = (SamplesPerFrame - CounterStart) / CounterSamplesPerValue;
+    static const uint64_t CounterMask = 0xFFFFFFFFFFFFULL;
+
+    // Each frame carries one stereo sample from each audio ADC, so at 40MSPS the audio is sampled at 40MHz / 512
+    static const uint32_t AudioSampleRate = 78125;
+
+    // The sideband fields which are decoded from each frame all lie within this many samples of the frame start
+    static const size_t DecodedSampleCount = CounterStart + CounterSamplesPerValue;
+
+    // The audio fields of each frame span the samples from the ADC128S022 audio up to the counter. The batch audio
+    // decoders take these samples from each frame, copied back to back into a single buffer of audio field blocks.
+    static const size_t AudioFieldSampleCount = CounterStart - Adc128Start;
+    static const size_t AudioFieldBlockSizeInBytes = AudioFieldSampleCount * 2;
+
+    // The 192-bit sync pattern, split into the 48-bit values carried by each group of 8 samples. The pattern in the
+    // firmware is 192'hDDDF20251015DDDF20251015DDDF20251016FEDCBA987654, with the rightmost group sent first.
+    static constexpr uint64_t SyncPattern[4] = {
+        0xFEDCBA987654ULL,
+        0xDDDF20251016ULL,
+        0xDDDF20251015ULL,
+        0xDDDF20251015ULL,
+    };
+
+public:
+    // Decoding methods
+    static bool IsFrameStart(const uint8_t* buffer, size_t byteOffset);
+    static uint64_t ExtractSyncPattern(const uint8_t* buffer, size_t byteOffset);
+    static uint64_t Extract48BitCounter(const uint8_t* buffer, size_t byteOffset);
+    static uint16_t Extract12BitAudio(const uint8_t* buffer, size_t byteOffset, size_t sampleIndex);
+    static uint32_t Extract24BitTop6x4(const uint8_t* buffer, size_t byteOffset);
+
+    // Batch decoding methods
+    static void DecodeAdc128s022Audio(const uint8_t* audioFieldBlocks, size_t frameCount, uint8_t* frameData);
+    static void DecodePcm1802Audio(const uint8_t* audioFieldBlocks, size_t frameCount, uint8_t* frameData);
+};
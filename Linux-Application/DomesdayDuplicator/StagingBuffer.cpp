@@ -0,0 +1,231 @@
+#include "StagingBuffer.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+StagingBuffer::~StagingBuffer()
+{
+    Release();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Allocation methods
+//----------------------------------------------------------------------------------------------------------------------
+bool StagingBuffer::Allocate(size_t newCapacityInBytes)
+{
+    // Allocate the ring storage. We map the memory directly from the OS rather than using the heap, so that the pages
+    // start out zeroed and untouched, and can be faulted in without writing to them.
+    Release();
+#ifdef _WIN32
+    void* allocation = VirtualAlloc(NULL, newCapacityInBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (allocation == NULL)
+    {
+        return false;
+    }
+#else
+    void* allocation = mmap(nullptr, newCapacityInBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (allocation == MAP_FAILED)
+    {
+        return false;
+    }
+#endif
+    buffer = (uint8_t*)allocation;
+    capacityInBytes = newCapacityInBytes;
+
+    // Reset the ring state
+    writePosition = 0;
+    readPosition = 0;
+    peakOccupancyInBytes = 0;
+    dataAvailable.clear();
+    spaceAvailable.clear();
+    finishRequested.clear();
+    abortRequested.clear();
+
+    // Fault in every page of the buffer on a background thread, so the memory is really backed before the producer
+    // reaches it, rather than having page faults occur on the processing thread part way through the capture. This is
+    // done with MADV_POPULATE_WRITE, which never alters the contents of the pages, so it's safe for the ring to be in
+    // use while it runs. On Windows, the commit charge for the whole buffer is taken by VirtualAlloc above, so the memory
+    // is guaranteed to be available, and the only cost of a first touch is a soft fault.
+#ifdef MADV_POPULATE_WRITE
+    prefaultStopRequested.clear();
+    prefaultThread = std::thread(std::bind(std::mem_fn(&StagingBuffer::PrefaultThread), this));
+#endif
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StagingBuffer::Release()
+{
+    // Stop the prefault thread if it's still running
+    if (prefaultThread.joinable())
+    {
+        prefaultStopRequested.test_and_set();
+        prefaultThread.join();
+    }
+
+    // Return the ring storage to the OS
+    if (buffer != nullptr)
+    {
+#ifdef _WIN32
+        VirtualFree(buffer, 0, MEM_RELEASE);
+#else
+        munmap(buffer, capacityInBytes);
+#endif
+        buffer = nullptr;
+    }
+    capacityInBytes = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Status methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t StagingBuffer::GetCapacityInBytes() const
+{
+    return capacityInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t StagingBuffer::GetOccupancyInBytes() const
+{
+    // Load the read position first, so the occupancy can never appear negative if a push and consume both occur
+    // between the two loads.
+    uint64_t currentReadPosition = readPosition;
+    uint64_t currentWritePosition = writePosition;
+    return (size_t)(currentWritePosition - currentReadPosition);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t StagingBuffer::GetPeakOccupancyInBytes() const
+{
+    return peakOccupancyInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Producer methods
+//----------------------------------------------------------------------------------------------------------------------
+bool StagingBuffer::Push(const uint8_t* data, size_t sizeInBytes)
+{
+    // Ensure this data could ever fit in the buffer
+    if (sizeInBytes > capacityInBytes)
+    {
+        return false;
+    }
+
+    // Wait for enough space to become available. Note that we clear the space available flag before checking the read
+    // position, so that a consume which occurs after our check is guaranteed to wake us.
+    uint64_t currentWritePosition = writePosition;
+    while (true)
+    {
+        spaceAvailable.clear();
+        if (abortRequested.test())
+        {
+            return false;
+        }
+        if ((capacityInBytes - (size_t)(currentWritePosition - readPosition)) >= sizeInBytes)
+        {
+            break;
+        }
+        spaceAvailable.wait(false);
+    }
+
+    // Copy the data into the ring, wrapping around to the start of the buffer if required
+    size_t writeOffset = (size_t)(currentWritePosition % capacityInBytes);
+    size_t firstPartSizeInBytes = std::min(sizeInBytes, capacityInBytes - writeOffset);
+    memcpy(buffer + writeOffset, data, firstPartSizeInBytes);
+    memcpy(buffer, data + firstPartSizeInBytes, sizeInBytes - firstPartSizeInBytes);
+
+    // Publish the data to the consumer
+    writePosition = currentWritePosition + sizeInBytes;
+    dataAvailable.test_and_set();
+    dataAvailable.notify_all();
+
+    // Track the high water mark of the buffer
+    peakOccupancyInBytes = std::max(peakOccupancyInBytes.load(), GetOccupancyInBytes());
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StagingBuffer::Finish()
+{
+    finishRequested.test_and_set();
+    dataAvailable.test_and_set();
+    dataAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StagingBuffer::Abort()
+{
+    abortRequested.test_and_set();
+    spaceAvailable.test_and_set();
+    spaceAvailable.notify_all();
+    dataAvailable.test_and_set();
+    dataAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Consumer methods
+//----------------------------------------------------------------------------------------------------------------------
+bool StagingBuffer::Peek(const uint8_t*& data, size_t& sizeInBytes, size_t maxSizeInBytes)
+{
+    // Wait for data to become available. Once the producer has finished, we keep returning data until the ring has been
+    // drained, but if the transfer has been aborted we stop immediately.
+    while (true)
+    {
+        dataAvailable.clear();
+        if (abortRequested.test())
+        {
+            return false;
+        }
+        uint64_t currentReadPosition = readPosition;
+        uint64_t currentWritePosition = writePosition;
+        if (currentWritePosition != currentReadPosition)
+        {
+            // Return the largest contiguous run of data we can, up to the requested limit
+            size_t readOffset = (size_t)(currentReadPosition % capacityInBytes);
+            sizeInBytes = std::min({ (size_t)(currentWritePosition - currentReadPosition), capacityInBytes - readOffset, maxSizeInBytes });
+            data = buffer + readOffset;
+            return true;
+        }
+        if (finishRequested.test())
+        {
+            return false;
+        }
+        dataAvailable.wait(false);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StagingBuffer::Consume(size_t sizeInBytes)
+{
+    readPosition += sizeInBytes;
+    spaceAvailable.test_and_set();
+    spaceAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Prefault thread methods
+//----------------------------------------------------------------------------------------------------------------------
+void StagingBuffer::PrefaultThread()
+{
+    // Populate the buffer a chunk at a time, so a release of the buffer doesn't have to wait for the whole buffer to be
+    // faulted in. If the kernel can't populate a range, we leave the remaining pages to be faulted in on first use.
+#ifdef MADV_POPULATE_WRITE
+    size_t bufferSizeInBytes = capacityInBytes;
+    for (size_t offset = 0; (offset < bufferSizeInBytes) && !prefaultStopRequested.test(); offset += PrefaultChunkSizeInBytes)
+    {
+        if (madvise(buffer + offset, std::min(PrefaultChunkSizeInBytes, bufferSizeInBytes - offset), MADV_POPULATE_WRITE) != 0)
+        {
+            break;
+        }
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// A large single-producer, single-consumer byte ring used to stage converted capture data in memory ahead of the
+// output file. The producer appends data with Push, blocking only if the ring is completely full, while the consumer
+// drains it in contiguous pieces with Peek and Consume at whatever rate the target disk can sustain. This allows short
+// or moderate periods where the disk falls behind the capture rate to be absorbed without losing data. The storage is
+// committed when it's allocated, but its pages are faulted in by a background thread, so that allocating a buffer of
+// several gigabytes doesn't stall the calling thread while the memory is touched.
+class StagingBuffer
+{
+public:
+    // Constants
+    static const size_t PrefaultChunkSizeInBytes = 64 * 1024 * 1024;
+
+public:
+    // Constructors
+    ~StagingBuffer();
+
+    // Allocation methods
+    bool Allocate(size_t capacityInBytes);
+    void Release();
+    bool IsAllocated() const;
+
+    // Status methods
+    size_t GetCapacityInBytes() const;
+    size_t GetOccupancyInBytes() const;
+    size_t GetPeakOccupancyInBytes() const;
+
+    // Producer methods
+    bool Push(const uint8_t* data, size_t sizeInBytes);
+    void Finish();
+    void Abort();
+
+    // Consumer methods
+    bool Peek(const uint8_t*& data, size_t& sizeInBytes, size_t maxSizeInBytes);
+    void Consume(size_t sizeInBytes);
+
+private:
+    // Prefault thread methods
+    void PrefaultThread();
+
+private:
+    uint8_t* buffer = nullptr;
+    std::atomic<size_t> capacityInBytes = 0;
+    std::atomic<uint64_t> writePosition = 0;
+    std::atomic<uint64_t> readPosition = 0;
+    std::atomic<size_t> peakOccupancyInBytes = 0;
+    std::atomic_flag dataAvailable;
+    std::atomic_flag spaceAvailable;
+    std::atomic_flag finishRequested;
+    std::atomic_flag abortRequested;
+    std::thread prefaultThread;
+    std::atomic_flag prefaultStopRequested;
+};
@@ -0,0 +1,222 @@
+#include "StreamHasher.h"
+#include "ByteOrder.h"
+#include "CaptureContainer.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    const uint64_t XxHashPrime1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t XxHashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t XxHashPrime3 = 0x165667B19E3779F9ULL;
+    const uint64_t XxHashPrime4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t XxHashPrime5 = 0x27D4EB2F165667C5ULL;
+
+    inline uint64_t RotateLeft64(uint64_t value, int count)
+    {
+        return (value << count) | (value >> (64 - count));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Constructors
+//----------------------------------------------------------------------------------------------------------------------
+StreamHasher::StreamHasher()
+{
+    Reset(Algorithm::None);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Hash methods
+//----------------------------------------------------------------------------------------------------------------------
+void StreamHasher::Reset(Algorithm newAlgorithm)
+{
+    algorithm = newAlgorithm;
+    totalSizeInBytes = 0;
+    crc = 0;
+    accumulators[0] = XxHashPrime1 + XxHashPrime2;
+    accumulators[1] = XxHashPrime2;
+    accumulators[2] = 0;
+    accumulators[3] = 0 - XxHashPrime1;
+    pendingSizeInBytes = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void StreamHasher::Update(const uint8_t* data, size_t sizeInBytes)
+{
+    switch (algorithm)
+    {
+    case Algorithm::None:
+        break;
+    case Algorithm::Crc32c:
+        crc = CaptureContainer::Crc32c(data, sizeInBytes, crc);
+        break;
+    case Algorithm::XxHash64:
+        XxHash64Update(data, sizeInBytes);
+        break;
+    }
+    totalSizeInBytes += sizeInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+StreamHasher::Algorithm StreamHasher::GetAlgorithm() const
+{
+    return algorithm;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string StreamHasher::GetAlgorithmName() const
+{
+    switch (algorithm)
+    {
+    case Algorithm::Crc32c:
+        return "crc32c";
+    case Algorithm::XxHash64:
+        return "xxh64";
+    default:
+        return "none";
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string StreamHasher::GetDigestString() const
+{
+    std::ostringstream digestString;
+    digestString << std::hex << std::setfill('0');
+    switch (algorithm)
+    {
+    case Algorithm::Crc32c:
+        digestString << std::setw(8) << crc;
+        break;
+    case Algorithm::XxHash64:
+        digestString << std::setw(16) << XxHash64Digest();
+        break;
+    default:
+        break;
+    }
+    return digestString.str();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t StreamHasher::GetTotalSizeInBytes() const
+{
+    return totalSizeInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// XXH64 methods
+//----------------------------------------------------------------------------------------------------------------------
+void StreamHasher::XxHash64Update(const uint8_t* data, size_t sizeInBytes)
+{
+    // If we have a partial stripe left over from the last update, try and complete it first.
+    if (pendingSizeInBytes > 0)
+    {
+        size_t bytesToCopy = std::min(sizeof(pendingData) - pendingSizeInBytes, sizeInBytes);
+        memcpy(pendingData + pendingSizeInBytes, data, bytesToCopy);
+        pendingSizeInBytes += bytesToCopy;
+        data += bytesToCopy;
+        sizeInBytes -= bytesToCopy;
+        if (pendingSizeInBytes < sizeof(pendingData))
+        {
+            return;
+        }
+        for (size_t i = 0; i < 4; ++i)
+        {
+            accumulators[i] = XxHash64Round(accumulators[i], ReadLE64(pendingData + (i * 8)));
+        }
+        pendingSizeInBytes = 0;
+    }
+
+    // Consume all complete 32-byte stripes directly from the input
+    uint64_t v1 = accumulators[0];
+    uint64_t v2 = accumulators[1];
+    uint64_t v3 = accumulators[2];
+    uint64_t v4 = accumulators[3];
+    while (sizeInBytes >= 32)
+    {
+        v1 = XxHash64Round(v1, ReadLE64(data + 0));
+        v2 = XxHash64Round(v2, ReadLE64(data + 8));
+        v3 = XxHash64Round(v3, ReadLE64(data + 16));
+        v4 = XxHash64Round(v4, ReadLE64(data + 24));
+        data += 32;
+        sizeInBytes -= 32;
+    }
+    accumulators[0] = v1;
+    accumulators[1] = v2;
+    accumulators[2] = v3;
+    accumulators[3] = v4;
+
+    // Retain any remaining data for the next update
+    memcpy(pendingData, data, sizeInBytes);
+    pendingSizeInBytes = sizeInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t StreamHasher::XxHash64Digest() const
+{
+    // Combine the accumulators, or start from the seed if the stream was too short to fill a stripe.
+    uint64_t hash;
+    if (totalSizeInBytes >= 32)
+    {
+        hash = RotateLeft64(accumulators[0], 1) + RotateLeft64(accumulators[1], 7) + RotateLeft64(accumulators[2], 12) + RotateLeft64(accumulators[3], 18);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            hash = XxHash64MergeRound(hash, accumulators[i]);
+        }
+    }
+    else
+    {
+        hash = XxHashPrime5;
+    }
+    hash += totalSizeInBytes;
+
+    // Mix in the remaining data
+    const uint8_t* data = pendingData;
+    size_t remainingSizeInBytes = pendingSizeInBytes;
+    while (remainingSizeInBytes >= 8)
+    {
+        hash ^= XxHash64Round(0, ReadLE64(data));
+        hash = (RotateLeft64(hash, 27) * XxHashPrime1) + XxHashPrime4;
+        data += 8;
+        remainingSizeInBytes -= 8;
+    }
+    if (remainingSizeInBytes >= 4)
+    {
+        hash ^= (uint64_t)ReadLE32(data) * XxHashPrime1;
+        hash = (RotateLeft64(hash, 23) * XxHashPrime2) + XxHashPrime3;
+        data += 4;
+        remainingSizeInBytes -= 4;
+    }
+    while (remainingSizeInBytes > 0)
+    {
+        hash ^= (uint64_t)(*data) * XxHashPrime5;
+        hash = RotateLeft64(hash, 11) * XxHashPrime1;
+        ++data;
+        --remainingSizeInBytes;
+    }
+
+    // Perform the final avalanche
+    hash ^= hash >> 33;
+    hash *= XxHashPrime2;
+    hash ^= hash >> 29;
+    hash *= XxHashPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t StreamHasher::XxHash64Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * XxHashPrime2;
+    accumulator = RotateLeft64(accumulator, 31);
+    return accumulator * XxHashPrime1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t StreamHasher::XxHash64MergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= XxHash64Round(0, value);
+    return (accumulator * XxHashPrime1) + XxHashPrime4;
+}
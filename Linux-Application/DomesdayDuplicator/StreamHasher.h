@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Incrementally computes an integrity hash over a stream of bytes, so an output file can be hashed as it's written
+// rather than read back again afterwards. Data can be supplied in arbitrarily sized pieces, and the resulting digest
+// is the same as hashing the entire stream in a single pass.
+class StreamHasher
+{
+public:
+    // Enumerations
+    enum class Algorithm
+    {
+        None,
+        Crc32c,
+        XxHash64,
+    };
+
+public:
+    // Constructors
+    StreamHasher();
+
+    // Hash methods
+    void Reset(Algorithm algorithm);
+    void Update(const uint8_t* data, size_t sizeInBytes);
+    Algorithm GetAlgorithm() const;
+    std::string GetAlgorithmName() const;
+    std::string GetDigestString() const;
+    uint64_t GetTotalSizeInBytes() const;
+
+private:
+    // XXH64 methods
+    void XxHash64Update(const uint8_t* data, size_t sizeInBytes);
+    uint64_t XxHash64Digest() const;
+    static uint64_t XxHash64Round(uint64_t accumulator, uint64_t input);
+    static uint64_t XxHash64MergeRound(uint64_t accumulator, uint64_t value);
+
+private:
+    Algorithm algorithm = Algorithm::None;
+    uint64_t totalSizeInBytes = 0;
+
+    // CRC32C state
+    uint32_t crc = 0;
+
+    // XXH64 state
+    uint64_t accumulators[4] = {};
+    uint8_t pendingData[32] = {};
+    size_t pendingSizeInBytes = 0;
+};
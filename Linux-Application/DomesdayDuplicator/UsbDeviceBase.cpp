@@ -1,22 +1,27 @@
 
 #include "UsbDeviceBase.h"
+#include "FileUtilities.h"
 #ifdef _WIN32
 #include <memoryapi.h>
 #else
 #include <sched.h>
+#include <pthread.h>
 #include <sys/mman.h>
+#include <time.h>
 #endif
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <functional>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 //----------------------------------------------------------------------------------------------------------------------
 // Constructors
 //----------------------------------------------------------------------------------------------------------------------
 UsbDeviceBase::UsbDeviceBase(const ILogger& log)
-:log(log)
+:log(log), audioPreviewStream(log)
 { }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -47,6 +52,14 @@ const ILogger& UsbDeviceBase::Log() const
     return log;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Trace methods
+//----------------------------------------------------------------------------------------------------------------------
+CaptureTrace& UsbDeviceBase::Trace()
+{
+    return captureTrace;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Device methods
 //----------------------------------------------------------------------------------------------------------------------
@@ -65,7 +78,7 @@ void UsbDeviceBase::SendConfigurationCommand(const std::string& preferredDeviceP
 //----------------------------------------------------------------------------------------------------------------------
 // Capture methods
 //----------------------------------------------------------------------------------------------------------------------
-bool UsbDeviceBase::StartCapture(const std::filesystem::path& filePath, CaptureFormat format, AudioSource audioSource, const std::string& preferredDevicePath, bool isTestMode, bool useSmallUsbTransfers, bool useAsyncFileIo, size_t usbTransferQueueSizeInBytes, size_t diskBufferQueueSizeInBytes, bool stopOnDroppedSamples)
+bool UsbDeviceBase::StartCapture(const CaptureSettings& settings)
 {
     // If we're already performing a capture, abort any further processing.
     if (transferInProgress)
@@ -74,24 +87,85 @@ bool UsbDeviceBase::StartCapture(const std::filesystem::path& filePath, CaptureF
         return false;
     }
 
+    // Ensure the requested additional output formats can be produced alongside the main output. Capture containers
+    // carry per-capture index state, so they can only be written as the main output.
+    for (size_t i = 0; i < settings.additionalFormats.size(); ++i)
+    {
+        CaptureFormat additionalFormat = settings.additionalFormats[i];
+        bool isDuplicate = (additionalFormat == settings.format) || (std::find(settings.additionalFormats.begin(), settings.additionalFormats.begin() + i, additionalFormat) != (settings.additionalFormats.begin() + i));
+        if (isDuplicate || (additionalFormat == CaptureFormat::Unsigned10BitBlocked))
+        {
+            Log().Error("StartCapture(): Additional output format {0} is duplicated or not supported as an additional output", GetCaptureFormatName(additionalFormat));
+            captureResult = TransferResult::ProgramError;
+            return false;
+        }
+    }
+
     // Attempt to connect to the target device
-    if (!ConnectToDevice(preferredDevicePath))
+    if (!ConnectToDevice(settings.preferredDevicePath))
     {
         Log().Error("StartCapture(): Failed to connect to the target device");
         captureResult = TransferResult::ConnectionFailure;
         return false;
     }
 
-    // Flag whether we should be using asynchronous IO (Windows only)
+    // If we fail to start the capture from here on, disconnect from the device, and close and release everything we've
+    // set up for it. This is disarmed once the capture thread has been started.
+    bool captureStarted = false;
+#ifdef _WIN32
+    windowsCaptureOutputFileHandle = INVALID_HANDLE_VALUE;
+#endif
+    std::shared_ptr<void> scopedStartFailureHandler(nullptr, [&](void*)
+    {
+        if (captureStarted)
+        {
+            return;
+        }
+        if (audioBestOutputFile.is_open()) audioBestOutputFile.close();
+        resampledAudioOutputs.clear();
+        if (audioAlignmentOutputFile.is_open()) audioAlignmentOutputFile.close();
+        if (audioOutputFile.is_open()) audioOutputFile.close();
+        if (audio24OutputFile.is_open()) audio24OutputFile.close();
+        CloseAdditionalOutputFiles();
+        additionalOutputs.clear();
+        if (captureOutputFile.is_open()) captureOutputFile.close();
+#ifdef _WIN32
+        if (windowsCaptureOutputFileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(windowsCaptureOutputFileHandle);
+            windowsCaptureOutputFileHandle = INVALID_HANDLE_VALUE;
+        }
+#endif
+        stagingBuffer.Release();
+        DisconnectFromDevice();
+    });
+
+    // If a staging buffer has been requested, allocate it now. We do this before creating any output files, as this is
+    // the step most likely to fail for a large buffer.
+    useStagingBuffer = (settings.stagingBufferSizeInBytes > 0);
+    stagingBuffer.Release();
+    if (useStagingBuffer)
+    {
+        if (!stagingBuffer.Allocate(settings.stagingBufferSizeInBytes))
+        {
+            Log().Error("StartCapture(): Failed to allocate a staging buffer of {0} bytes", settings.stagingBufferSizeInBytes);
+            captureResult = TransferResult::MemoryAllocationFailure;
+            return false;
+        }
+        Log().Info("StartCapture(): Allocated a staging buffer of {0} bytes", settings.stagingBufferSizeInBytes);
+    }
+
+    // Flag whether we should be using asynchronous IO (Windows only). When a staging buffer is in use, the output file is
+    // written sequentially by the flush thread, so overlapped IO is of no benefit.
 #ifdef _WIN32
-    useWindowsOverlappedFileIo = useAsyncFileIo;
+    useWindowsOverlappedFileIo = settings.useAsyncFileIo && !useStagingBuffer;
 #endif
 
     // Attempt to create/open the output file
 #ifdef _WIN32
     if (useWindowsOverlappedFileIo)
     {
-        windowsCaptureOutputFileHandle = CreateFileW(filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_WRITE_THROUGH | FILE_FLAG_OVERLAPPED, NULL);
+        windowsCaptureOutputFileHandle = CreateFileW(settings.filePath.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_WRITE_THROUGH | FILE_FLAG_OVERLAPPED, NULL);
         if (windowsCaptureOutputFileHandle == INVALID_HANDLE_VALUE)
         {
             DWORD lastError = GetLastError();
@@ -105,10 +179,10 @@ bool UsbDeviceBase::StartCapture(const std::filesystem::path& filePath, CaptureF
 #endif
         captureOutputFile.clear();
         captureOutputFile.rdbuf()->pubsetbuf(0, 0);
-        captureOutputFile.open(filePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        captureOutputFile.open(settings.filePath, std::ios::out | std::ios::trunc | std::ios::binary);
         if (!captureOutputFile.is_open())
         {
-            Log().Error("StartCapture(): Failed to create the output file at path {0}", filePath);
+            Log().Error("StartCapture(): Failed to create the output file at path {0}", settings.filePath);
             captureResult = TransferResult::FileCreationError;
             return false;
         }
@@ -116,53 +190,157 @@ bool UsbDeviceBase::StartCapture(const std::filesystem::path& filePath, CaptureF
     }
 #endif
 
-    // Create 16-bit raw audio file for ADC128s022 if requested
-    // Format: headerless PCM, 16-bit signed LE, stereo, 78125 Hz
-    if (audioSource == AudioSource::Adc128s022 || audioSource == AudioSource::Both)
+    // Create the files for any additional output formats. These are written alongside the main output file, with the
+    // same name and the file extension for their format.
+    additionalOutputs.clear();
+    for (CaptureFormat additionalFormat : settings.additionalFormats)
+    {
+        std::unique_ptr<AdditionalOutput> output(new AdditionalOutput());
+        output->format = additionalFormat;
+        output->filePath = settings.filePath;
+        output->filePath.replace_extension(GetCaptureFormatFileExtension(additionalFormat));
+        output->outputFile.rdbuf()->pubsetbuf(0, 0);
+        output->outputFile.open(output->filePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!output->outputFile.is_open())
+        {
+            Log().Error("StartCapture(): Failed to create the additional output file at path {0}", output->filePath);
+            captureResult = TransferResult::FileCreationError;
+            return false;
+        }
+        Log().Info("StartCapture(): Additional {0} output file created: {1}", GetCaptureFormatName(additionalFormat), output->filePath.string());
+        additionalOutputs.push_back(std::move(output));
+    }
+
+    // Create 16-bit WAV audio file for ADC128s022 if requested
+    // Format: PCM, 16-bit signed LE, stereo, 78125 Hz. The header is written with a zero data length here, and updated
+    // with the real length when the file is finalized.
+    if (settings.audioSource == AudioSource::Adc128s022 || settings.audioSource == AudioSource::Both)
     {
-        audioFilePath = filePath;
+        audioFilePath = settings.filePath;
         audioFilePath.replace_extension("");
-        audioFilePath += "_audio_integrated_adc.s16";
+        audioFilePath += "_audio_integrated_adc.wav";
 
         audioOutputFile.clear();
         audioOutputFile.open(audioFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
-        if (!audioOutputFile.is_open())
+        if (!audioOutputFile.is_open() || !WriteAudioWavHeader(audioOutputFile, AudioSampleRate, 16, 0))
         {
             Log().Error("StartCapture(): Failed to create audio output file at path {0}", audioFilePath);
             captureResult = TransferResult::FileCreationError;
-            captureOutputFile.close();
             return false;
         }
 
-        Log().Info("StartCapture(): 16-bit raw audio file created: {0}", audioFilePath.string());
+        Log().Info("StartCapture(): 16-bit WAV audio file created: {0}", audioFilePath.string());
     }
 
-    // Create 24-bit raw audio file for PCM1802 if requested
-    // Format: headerless PCM, 24-bit signed LE, stereo, 78125 Hz
-    if (audioSource == AudioSource::Pcm1802 || audioSource == AudioSource::Both)
+    // Create 24-bit WAV audio file for PCM1802 if requested
+    // Format: PCM, 24-bit signed LE, stereo, 78125 Hz
+    if (settings.audioSource == AudioSource::Pcm1802 || settings.audioSource == AudioSource::Both)
     {
-        audio24FilePath = filePath;
+        audio24FilePath = settings.filePath;
         audio24FilePath.replace_extension("");
-        audio24FilePath += "_audio_external_adc.s24";
+        audio24FilePath += "_audio_external_adc.wav";
 
         audio24OutputFile.clear();
         audio24OutputFile.open(audio24FilePath, std::ios::out | std::ios::trunc | std::ios::binary);
-        if (!audio24OutputFile.is_open())
+        if (!audio24OutputFile.is_open() || !WriteAudioWavHeader(audio24OutputFile, AudioSampleRate, 24, 0))
         {
             Log().Error("StartCapture(): Failed to create 24-bit audio output file at path {0}", audio24FilePath);
             captureResult = TransferResult::FileCreationError;
-            if (audioOutputFile.is_open()) audioOutputFile.close();
-            captureOutputFile.close();
             return false;
         }
 
-        Log().Info("StartCapture(): 24-bit raw audio file created: {0}", audio24FilePath.string());
+        Log().Info("StartCapture(): 24-bit WAV audio file created: {0}", audio24FilePath.string());
+    }
+
+    // Create the audio alignment index, which maps each audio sample back to the RF frame it was taken from
+    audioAlignmentFilePath.clear();
+    if (settings.audioSource != AudioSource::None)
+    {
+        audioAlignmentFilePath = settings.filePath;
+        audioAlignmentFilePath.replace_extension("");
+        audioAlignmentFilePath += "_audio_alignment.bin";
+
+        uint8_t header[AudioAlignmentIndex::HeaderSizeInBytes];
+        AudioAlignmentIndex::BuildHeader(header, (uint32_t)SidebandFrame::SamplesPerFrame, (uint32_t)SidebandFrame::CounterValuesPerFrame, AudioSampleRate);
+        audioAlignmentOutputFile.clear();
+        audioAlignmentOutputFile.open(audioAlignmentFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!audioAlignmentOutputFile.is_open() || !audioAlignmentOutputFile.write((const char*)header, sizeof(header)).good())
+        {
+            Log().Error("StartCapture(): Failed to create audio alignment index at path {0}", audioAlignmentFilePath);
+            captureResult = TransferResult::FileCreationError;
+            return false;
+        }
+        Log().Info("StartCapture(): Audio alignment index created: {0}", audioAlignmentFilePath.string());
+    }
+
+    // Create a resampled copy of each audio stream at each requested sample rate. These are written alongside the
+    // native rate audio files, with the sample rate appended to the file name.
+    resampledAudioOutputs.clear();
+    for (uint32_t resampleRate : settings.audioResampleRates)
+    {
+        for (uint16_t bitsPerSample : { (uint16_t)16, (uint16_t)24 })
+        {
+            const std::ofstream& nativeOutputFile = (bitsPerSample == 16) ? audioOutputFile : audio24OutputFile;
+            if (!nativeOutputFile.is_open())
+            {
+                continue;
+            }
+            std::unique_ptr<ResampledAudioOutput> output(new ResampledAudioOutput());
+            output->bitsPerSample = bitsPerSample;
+            output->filePath = (bitsPerSample == 16) ? audioFilePath : audio24FilePath;
+            output->filePath.replace_extension("");
+            output->filePath += "_" + std::to_string(resampleRate) + ".wav";
+            if (!output->resampler.Initialize(AudioSampleRate, resampleRate, 2, bitsPerSample))
+            {
+                Log().Error("StartCapture(): Unsupported audio resampling rate {0}", resampleRate);
+                captureResult = TransferResult::ProgramError;
+                return false;
+            }
+            output->outputFile.open(output->filePath, std::ios::out | std::ios::trunc | std::ios::binary);
+            if (!output->outputFile.is_open() || !WriteAudioWavHeader(output->outputFile, resampleRate, bitsPerSample, 0))
+            {
+                Log().Error("StartCapture(): Failed to create resampled audio output file at path {0}", output->filePath);
+                captureResult = TransferResult::FileCreationError;
+                return false;
+            }
+            Log().Info("StartCapture(): {0}-bit {1}Hz resampled WAV audio file created: {2}", bitsPerSample, resampleRate, output->filePath.string());
+            resampledAudioOutputs.push_back(std::move(output));
+        }
+    }
+
+    // When both converters are recording, compare them as the capture runs. If requested, the analyzer also merges the
+    // healthier converter in each window into a single 24-bit audio file.
+    audioSourceAnalysisEnabled = (settings.audioSource == AudioSource::Both);
+    audioBestFilePath.clear();
+    audioBestFileSizeWrittenInBytes = 0;
+    audioBestWriteFailed.clear();
+    if (audioSourceAnalysisEnabled)
+    {
+        audioSourceAnalyzer.Initialize(AudioSampleRate, AudioSourceAnalysisWindowFrameCount, settings.writeBestAudio);
+        std::unique_lock<std::mutex> lock(audioSourceAnalysisMutex);
+        audioSourceAnalysisResults.clear();
+    }
+    if (audioSourceAnalysisEnabled && settings.writeBestAudio)
+    {
+        audioBestFilePath = settings.filePath;
+        audioBestFilePath.replace_extension("");
+        audioBestFilePath += "_audio_best.wav";
+
+        audioBestOutputFile.clear();
+        audioBestOutputFile.open(audioBestFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!audioBestOutputFile.is_open() || !WriteAudioWavHeader(audioBestOutputFile, AudioSampleRate, 24, 0))
+        {
+            Log().Error("StartCapture(): Failed to create best source audio output file at path {0}", audioBestFilePath);
+            captureResult = TransferResult::FileCreationError;
+            return false;
+        }
+        Log().Info("StartCapture(): Best source WAV audio file created: {0}", audioBestFilePath.string());
     }
 
     // Calculate the optimal read buffer size and number of disk buffers, and initialize the structures. We use an
     // unusual case of wrapping an array new into a unique_ptr rather than std::vector here, as we have an atomic_flag
     // member in the structure which can't be moved.
-    CalculateDesiredBufferCountAndSize(useSmallUsbTransfers, usbTransferQueueSizeInBytes, diskBufferQueueSizeInBytes, totalDiskBufferEntryCount, diskBufferSizeInBytes);
+    CalculateDesiredBufferCountAndSize(settings.useSmallUsbTransfers, settings.usbTransferQueueSizeInBytes, settings.diskBufferQueueSizeInBytes, totalDiskBufferEntryCount, diskBufferSizeInBytes);
     diskBufferEntries.reset(new DiskBufferEntry[totalDiskBufferEntryCount]);
     for (size_t i = 0; i < totalDiskBufferEntryCount; ++i)
     {
@@ -179,89 +357,238 @@ bool UsbDeviceBase::StartCapture(const std::filesystem::path& filePath, CaptureF
 #endif
     }
 
+    // If any output keeps the raw sample words with their sideband data intact, allocate a buffer to hold a copy of
+    // each disk buffer before the sideband is stripped.
+    rawSampleBufferRequired = (settings.format == CaptureFormat::Unsigned16BitRaw) || (std::find(settings.additionalFormats.begin(), settings.additionalFormats.end(), CaptureFormat::Unsigned16BitRaw) != settings.additionalFormats.end());
+    rawSampleBuffer.clear();
+    if (rawSampleBufferRequired)
+    {
+        rawSampleBuffer.resize(diskBufferSizeInBytes);
+    }
+
     // Record the capture settings
-    captureFilePath = filePath;
-    captureFormat = format;
-    captureAudioSource = audioSource;
-    captureIsTestMode = isTestMode;
-    captureStopOnDroppedSamples = stopOnDroppedSamples;
+    captureFilePath = settings.filePath;
+    captureFormat = settings.format;
+    captureAudioSource = settings.audioSource;
+    captureIsTestMode = settings.isTestMode;
+    captureStopOnDroppedSamples = settings.stopOnDroppedSamples;
+    captureGapFillMode = settings.gapFillMode;
+    if (settings.gapFillMode != GapFillMode::None)
+    {
+        Log().Info("StartCapture(): Gap filling enabled, mode: {0}", GetGapFillModeName(settings.gapFillMode));
+        if ((settings.format == CaptureFormat::Unsigned16BitRaw) || (std::find(settings.additionalFormats.begin(), settings.additionalFormats.end(), CaptureFormat::Unsigned16BitRaw) != settings.additionalFormats.end()))
+        {
+            Log().Info("StartCapture(): Gaps will not be filled in the raw 16-bit output, to preserve its sideband frame structure");
+        }
+    }
     
     // Log the audio source configuration
-    if (audioSource == AudioSource::None)
+    if (settings.audioSource == AudioSource::None)
     {
         Log().Info("StartCapture(): Audio source: None - no audio files will be created");
     }
-    else if (audioSource == AudioSource::Adc128s022)
+    else if (settings.audioSource == AudioSource::Adc128s022)
     {
         Log().Info("StartCapture(): Audio source: ADC128s022 (12-bit integrated ADC)");
     }
-    else if (audioSource == AudioSource::Pcm1802)
+    else if (settings.audioSource == AudioSource::Pcm1802)
     {
         Log().Info("StartCapture(): Audio source: PCM1802 (24-bit external ADC)");
     }
-    else if (audioSource == AudioSource::Both)
+    else if (settings.audioSource == AudioSource::Both)
     {
         Log().Info("StartCapture(): Audio source: Both ADCs (12-bit + 24-bit)");
     }
-    currentUsbTransferQueueSizeInBytes = usbTransferQueueSizeInBytes;
-    currentUseSmallUsbTransfers = useSmallUsbTransfers;
+    currentUsbTransferQueueSizeInBytes = settings.usbTransferQueueSizeInBytes;
+    currentUseSmallUsbTransfers = settings.useSmallUsbTransfers;
 
-    // Initialize capture status
+    // Initialize capture status. The capture start time is the reference for the discontinuity record timestamps, so
+    // it's set here, before any of the capture threads are started.
     transferInProgress = true;
     captureResult = TransferResult::Running;
-    transferCount = 0;
-    transferBufferWrittenCount = 0;
-    transferFileSizeWrittenInBytes = 0;
-    processedSampleCount = 0;
-    minSampleValue = std::numeric_limits<decltype(minSampleValue.load())>::max();
-    maxSampleValue = 0;
-    clippedMinSampleCount = 0;
-    clippedMaxSampleCount = 0;
-    recentMinSampleValue = std::numeric_limits<decltype(recentMinSampleValue.load())>::max();
-    recentMaxSampleValue = 0;
-    recentClippedMinSampleCount = 0;
-    recentClippedMaxSampleCount = 0;
+    captureStartTime = std::chrono::steady_clock::now();
+    usbTransferCounters.transferCount = 0;
+    usbTransferCounters.transferredSizeInBytes = 0;
+    processingCounters.diskBufferWrittenCount = 0;
+    processingCounters.fileSizeWrittenInBytes = 0;
+    stagingFlushCounters.fileSizeWrittenInBytes = 0;
+    usbTransferCounters.diskBufferFilledCount = 0;
+    diskBufferQueueDepthHistogram.Reset();
+    usbCompletionIntervalHistogram.Reset();
+    writeLatencyHistogram.Reset();
+    lastTransferCompletionTimeValid = false;
+    {
+        std::unique_lock<std::mutex> lock(throughputSampleMutex);
+        throughputSamples.clear();
+        throughputSamples.reserve(24 * 60 * 60);
+    }
+    rfStatistics = {};
+    rfStatistics.minSampleValue = std::numeric_limits<decltype(rfStatistics.minSampleValue)>::max();
+    rfStatistics.recentMinSampleValue = std::numeric_limits<decltype(rfStatistics.recentMinSampleValue)>::max();
+    publishedRfStatistics.Store(rfStatistics);
+    for (LogRateLimiter* logRateLimiter : GetProcessingLogRateLimiters())
+    {
+        logRateLimiter->Reset();
+    }
     captureThreadStopRequested.clear();
     captureThreadRunning.test_and_set();
     captureThreadRunning.notify_all();
 
+    // Initialize our capture container state. We reserve enough index entries up front for a few hours of capture,
+    // so the index doesn't need to be reallocated on the processing thread under normal use.
+    captureContainerIndex.clear();
+    if (settings.format == CaptureFormat::Unsigned10BitBlocked)
+    {
+        const size_t initialIndexDurationInSeconds = 4 * 60 * 60;
+        const size_t bytesPerSecond = 40 * 1000 * 1000 * 2;
+        captureContainerIndex.reserve((initialIndexDurationInSeconds * bytesPerSecond) / diskBufferSizeInBytes);
+    }
+    captureContainerNextBlockOffset = 0;
+    captureContainerNextSampleIndex = 0;
+
+    // Initialize our integrity hash state
+    captureHashAlgorithm = settings.hashAlgorithm;
+    captureOutputHasher.Reset(settings.hashAlgorithm);
+    audioDataHasher.Reset(settings.hashAlgorithm);
+    audio24DataHasher.Reset(settings.hashAlgorithm);
+    for (auto& output : additionalOutputs)
+    {
+        output->outputHasher.Reset(settings.hashAlgorithm);
+    }
+
     // Initialize our sequence/test data check state
     sequenceState = SequenceState::Sync;
     savedSequenceCounter = 0;
+    bufferStartSampleOffset = 0;
     expectedNextTestDataValue.reset();
     testDataMax.reset();
-    syncLossCount = 0;
+
+    // Create the discontinuity map file, and write its header. Records are appended to it by the discontinuity writer
+    // thread during the capture. The map is only a diagnostic aid, so if it can't be created, the capture carries on
+    // without it.
+    discontinuityMapFilePath = settings.filePath;
+    discontinuityMapFilePath.replace_extension("");
+    discontinuityMapFilePath += "_discontinuities.bin";
+    if (!discontinuityRecordQueue)
+    {
+        discontinuityRecordQueue.reset(new DiscontinuityMap::Record[DiscontinuityRecordQueueLength]);
+    }
+    processingCounters.discontinuityRecordWritePosition = 0;
+    processingCounters.discontinuityDroppedRecordCount = 0;
+    discontinuityWriterCounters.discontinuityRecordReadPosition = 0;
+    discontinuityWriterCounters.discontinuityRecordCount = 0;
+    pendingDroppedDiscontinuityRecord.reset();
+    pendingSyncLossRecord.reset();
+    if (discontinuityMapFile.is_open()) discontinuityMapFile.close();
+    discontinuityMapFile.open(discontinuityMapFilePath, std::ios::out | std::ios::trunc | std::ios::binary);
+    discontinuityMapEnabled = discontinuityMapFile.is_open() && WriteDiscontinuityMapHeader();
+    if (!discontinuityMapEnabled)
+    {
+        Log().Error("StartCapture(): Failed to create the discontinuity map file at path {0}", discontinuityMapFilePath.string());
+        if (discontinuityMapFile.is_open()) discontinuityMapFile.close();
+    }
+
+    // Initialize the gap filling state. A fill can be recorded at the start of each frame in a disk buffer, and the
+    // fill samples are generated in fixed size chunks as each output is converted.
+    bufferGapFills.clear();
+    gapFillSampleBuffer.clear();
+    if (settings.gapFillMode != GapFillMode::None)
+    {
+        bufferGapFills.reserve(((diskBufferSizeInBytes / 2) / 512) + 1);
+        gapFillSampleBuffer.resize(GapFillChunkSampleCount * 2);
+    }
+    gapFillExpectedFrameValid = false;
+    gapFillExpectedFrameCounter = 0;
+    gapFillExpectedFrameSampleOffset = 0;
+    gapFillPreviousSampleValue = 0;
 
     // Initialize audio capture state
     audioSyncLocked = false;
     audioFrameCount = 0;
     audioFileSizeWrittenInBytes = 0;
     audioFrameOffset = 0;
-    audioLeftBuffer.clear();
-    audioRightBuffer.clear();
-    audioLeftBuffer.reserve(2048);
-    audioRightBuffer.reserve(2048);
     audio24FrameCount = 0;
     audio24FileSizeWrittenInBytes = 0;
-    audio24LeftBuffer.clear();
-    audio24RightBuffer.clear();
-    audio24LeftBuffer.reserve(2048);
-    audio24RightBuffer.reserve(2048);
+    captureSyncAudioHeaders = settings.syncAudioHeaders;
+    lastAudioHeaderSyncTime = std::chrono::steady_clock::now();
+
+    // Initialize the audio pipeline. Each batch is sized up front to hold every frame a disk buffer could contain, so
+    // the processing thread never needs to allocate memory while decoding audio. A batch normally holds a single
+    // segment of consecutive frames, and only needs more after the frame sync has been lost and reacquired.
+    size_t maxAudioFramesPerBatch = (diskBufferSizeInBytes / (2 * 512)) + 1;
+    audioBatchQueue.reset();
+    if (settings.audioSource != AudioSource::None)
+    {
+        audioBatchQueue.reset(new AudioBatch[AudioBatchQueueLength]);
+        for (size_t i = 0; i < AudioBatchQueueLength; ++i)
+        {
+            audioBatchQueue[i].frameData.reserve(maxAudioFramesPerBatch * 4);
+            audioBatchQueue[i].frame24Data.reserve(maxAudioFramesPerBatch * 6);
+            audioBatchQueue[i].segments.reserve(MaxAudioBatchSegmentCount);
+        }
+        audioOverflowBatch.frameData.reserve(maxAudioFramesPerBatch * 4);
+        audioOverflowBatch.frame24Data.reserve(maxAudioFramesPerBatch * 6);
+        audioOverflowBatch.segments.reserve(MaxAudioBatchSegmentCount);
+        audioFieldBlocks.resize(maxAudioFramesPerBatch * SidebandFrame::AudioFieldBlockSizeInBytes);
+    }
+    audioAlignmentSampleIndex = 0;
+    processingCounters.audioBatchWritePosition = 0;
+    processingCounters.audioDroppedFrameCount = 0;
+    processingCounters.audioSegmentOverflowFrameCount = 0;
+    audioWriterCounters.audioBatchReadPosition = 0;
+    audioMissingFrameCount = 0;
+    audioFilledFrameCount = 0;
+    audioWriteFailed.clear();
     
     // Initialize audio statistics
-    audioMinSampleValue = std::numeric_limits<int32_t>::max();
-    audioMaxSampleValue = std::numeric_limits<int32_t>::min();
-    audioClippedMinSampleCount = 0;
-    audioClippedMaxSampleCount = 0;
-    audioRecentMinSampleValue = std::numeric_limits<int32_t>::max();
-    audioRecentMaxSampleValue = std::numeric_limits<int32_t>::min();
-    audioRecentClippedMinSampleCount = 0;
-    audioRecentClippedMaxSampleCount = 0;
-    audioMeanAmplitude = 0.0;
+    audioStatistics = {};
+    audioStatistics.minSampleValue = std::numeric_limits<int32_t>::max();
+    audioStatistics.maxSampleValue = std::numeric_limits<int32_t>::min();
+    audioStatistics.recentMinSampleValue = std::numeric_limits<int32_t>::max();
+    audioStatistics.recentMaxSampleValue = std::numeric_limits<int32_t>::min();
+    publishedAudioStatistics.Store(audioStatistics);
+    audioLevels = {};
+    publishedAudioLevels.Store(audioLevels);
+
+    // Set up the audio level meters. The 12-bit samples from the ADC128S022 are stored scaled up to 16 bits, but they're
+    // measured at their original resolution. The PCM1802 is the primary source when both are enabled, with the
+    // ADC128S022 measured by the secondary meter.
+    if (settings.audioSource != AudioSource::None)
+    {
+        bool usePcm1802 = (settings.audioSource != AudioSource::Adc128s022);
+        audioMeter.Initialize(2, usePcm1802 ? 24 : 16, usePcm1802 ? 24 : 12);
+    }
+    if (settings.audioSource == AudioSource::Both)
+    {
+        audioSecondaryMeter.Initialize(2, 16, 12);
+    }
+
+    // Start the live audio preview if requested. This carries the same audio the level meter measures. The preview is
+    // only a monitoring aid, so if it can't be started, the capture carries on without it.
+    if ((settings.audioSource != AudioSource::None) && !settings.audioPreviewPath.empty())
+    {
+        bool usePcm1802 = (settings.audioSource != AudioSource::Adc128s022);
+        if (!audioPreviewStream.Start(settings.audioPreviewPath, 2, AudioSampleRate, usePcm1802 ? 24 : 16))
+        {
+            Log().Warning("StartCapture(): Failed to start the audio preview at path {0}, continuing without it", settings.audioPreviewPath);
+        }
+    }
+
+    // Start recording the pipeline trace, if the trace points are compiled in. The trace is written out alongside the
+    // capture when it's stopped.
+    captureTraceFilePath.clear();
+    if (CaptureTrace::Enabled)
+    {
+        captureTraceFilePath = settings.filePath;
+        captureTraceFilePath.replace_extension("");
+        captureTraceFilePath += "_capture_trace.json";
+        captureTrace.Start();
+    }
 
     // Spin up a thread to handle the execution of the capture process from here on
     std::thread captureThread(std::bind(std::mem_fn(&UsbDeviceBase::CaptureThread), this));
     captureThread.detach();
+    captureStarted = true;
     return true;
 }
 
@@ -280,6 +607,19 @@ void UsbDeviceBase::StopCapture()
     captureThreadStopRequested.notify_all();
     captureThreadRunning.wait(true);
 
+    // Write out the pipeline trace, now that every thread which records into it has stopped
+    if (!captureTraceFilePath.empty())
+    {
+        if (captureTrace.WriteChromeTrace(captureTraceFilePath))
+        {
+            Log().Info("StopCapture(): Capture trace written: {0}", captureTraceFilePath.string());
+        }
+        else
+        {
+            Log().Error("StopCapture(): Failed to write the capture trace to {0}", captureTraceFilePath.string());
+        }
+    }
+
     // Release our memory holding the disk buffers
 #ifdef _WIN32
     if (useWindowsOverlappedFileIo)
@@ -293,6 +633,12 @@ void UsbDeviceBase::StopCapture()
 #endif
     diskBufferEntries.reset();
 
+    // If we're writing a capture container, append the block index to the end of the file
+    if (captureFormat == CaptureFormat::Unsigned10BitBlocked)
+    {
+        WriteCaptureContainerTrailer();
+    }
+
     // Close the output file
 #ifdef _WIN32
     if (useWindowsOverlappedFileIo)
@@ -311,6 +657,17 @@ void UsbDeviceBase::StopCapture()
 #ifdef _WIN32
     }
 #endif
+    CloseAdditionalOutputFiles();
+
+    // Release the staging buffer
+    stagingBuffer.Release();
+
+    // Stop the live audio preview
+    if (audioPreviewStream.IsRunning())
+    {
+        Log().Info("StopCapture(): Audio preview stopped, {0} frames were dropped", audioPreviewStream.GetDroppedFrameCount());
+        audioPreviewStream.Stop();
+    }
 
     // Finalize and close the audio WAV file
     if (audioOutputFile.is_open())
@@ -324,6 +681,27 @@ void UsbDeviceBase::StopCapture()
         FinalizeAudio24WavFile();
     }
 
+    // Finalize and close any resampled audio WAV files
+    FinalizeResampledAudioFiles();
+
+    // Complete the audio source analysis, and finalize and close the best source audio WAV file
+    if (audioSourceAnalysisEnabled)
+    {
+        audioSourceAnalyzer.Flush();
+        CollectAudioSourceAnalysis();
+    }
+    if (audioBestOutputFile.is_open())
+    {
+        FinalizeAudioBestWavFile();
+    }
+
+    // Close the audio alignment index
+    if (audioAlignmentOutputFile.is_open())
+    {
+        audioAlignmentOutputFile.close();
+        Log().Info("StopCapture(): Audio alignment index closed: {0}", audioAlignmentFilePath.string());
+    }
+
     // Disconnect from the target device
     DisconnectFromDevice();
 
@@ -335,25 +713,29 @@ void UsbDeviceBase::StopCapture()
 //----------------------------------------------------------------------------------------------------------------------
 void UsbDeviceBase::CaptureThread()
 {
-    // Determine how large our conversion buffers need to be based on the disk buffer size and the capture format
-    size_t requiredConversionBufferSize = 0;
-    switch (captureFormat)
+    // Allocate our conversion buffers, for the main output and each additional output
+    size_t requiredConversionBufferSize = GetConversionBufferSizeInBytes(captureFormat);
+    for (size_t i = 0; i < conversionBufferCount; ++i)
     {
-    case CaptureFormat::Signed16Bit:
-        requiredConversionBufferSize = diskBufferSizeInBytes;
-        break;
-    case CaptureFormat::Unsigned10Bit:
-        requiredConversionBufferSize = (diskBufferSizeInBytes / 8) * 5;
-        break;
-    case CaptureFormat::Unsigned10Bit4to1Decimation:
-        requiredConversionBufferSize = (diskBufferSizeInBytes / (8 * 4)) * 5;
-        break;
+        conversionBuffers[i].resize(requiredConversionBufferSize);
+    }
+    for (auto& output : additionalOutputs)
+    {
+        output->conversionBuffer.resize(GetConversionBufferSizeInBytes(output->format));
     }
 
-    // Allocate our conversion buffers
-    for (size_t i = 0; i < conversionBufferCount; ++i)
+    // Allocate the work queue for each additional output. Each entry holds a full copy of a disk buffer, along with
+    // room for every gap fill which can be recorded in it, so the processing thread never allocates when it submits
+    // work. The writer threads generate their own fill samples, as they convert in parallel with each other.
+    for (auto& output : additionalOutputs)
     {
-        conversionBuffers[i].resize(requiredConversionBufferSize);
+        output->workQueue.reset(new AdditionalOutputWork[AdditionalOutputQueueLength]);
+        for (size_t i = 0; i < AdditionalOutputQueueLength; ++i)
+        {
+            output->workQueue[i].sampleData.resize(diskBufferSizeInBytes);
+            output->workQueue[i].gapFills.reserve(bufferGapFills.capacity());
+        }
+        output->gapFillSampleBuffer.resize(gapFillSampleBuffer.size());
     }
 
     // Lock all the critical structures into physical memory. This stops these buffers getting paged out, which could
@@ -362,6 +744,13 @@ void UsbDeviceBase::CaptureThread()
     {
         LockMemoryBufferIntoPhysicalMemory(conversionBuffers[i].data(), conversionBuffers[i].size());
     }
+    for (auto& output : additionalOutputs)
+    {
+        for (size_t i = 0; i < AdditionalOutputQueueLength; ++i)
+        {
+            LockMemoryBufferIntoPhysicalMemory(output->workQueue[i].sampleData.data(), output->workQueue[i].sampleData.size());
+        }
+    }
     for (size_t i = 0; i < totalDiskBufferEntryCount; ++i)
     {
         DiskBufferEntry& entry = diskBufferEntries[i];
@@ -388,14 +777,79 @@ void UsbDeviceBase::CaptureThread()
     usbTransferResult = TransferResult::Running;
     processingResult = TransferResult::Running;
 
+    // Start a worker thread to hash data after it's written, if integrity hashes have been requested. This work is
+    // kept off the processing thread, so it doesn't add to the time taken to process each disk buffer.
+    std::thread hashingThread;
+    hashWorkPending.clear();
+    hashingStopRequested.clear();
+    if (captureHashAlgorithm != StreamHasher::Algorithm::None)
+    {
+        hashingThread = std::thread(std::bind(std::mem_fn(&UsbDeviceBase::HashingThread), this));
+    }
+
+    // Start a worker thread to drain the staging buffer to the output file, if one is in use
+    std::thread stagingFlushThread;
+    stagingFlushFailed.clear();
+    if (useStagingBuffer)
+    {
+        stagingFlushThread = std::thread(std::bind(std::mem_fn(&UsbDeviceBase::StagingFlushThread), this));
+    }
+
+    // Start a writer thread for each additional output format, so a write to one output doesn't hold up the others.
+    additionalOutputStopRequested.clear();
+    for (auto& output : additionalOutputs)
+    {
+        output->workWritePosition = 0;
+        output->workReadPosition = 0;
+        output->droppedBufferCount = 0;
+        output->workAvailable.clear();
+        output->writeFailed.clear();
+        output->writerThread = std::thread(std::bind(std::mem_fn(&UsbDeviceBase::AdditionalOutputWriterThread), this, std::ref(*output)));
+    }
+
+    // Start a worker thread to write decoded audio to the audio output files, if audio is being captured. This keeps
+    // audio file writes off the processing thread entirely, so a slow or failed audio write can't hold up the RF data.
+    std::thread audioWriterThread;
+    audioBatchAvailable.clear();
+    audioWriterStopRequested.clear();
+    if (captureAudioSource != AudioSource::None)
+    {
+        audioWriterThread = std::thread(std::bind(std::mem_fn(&UsbDeviceBase::AudioWriterThread), this));
+    }
+
+    // Start a worker thread to append discontinuity records to the map file as they're found, so the map is written as
+    // the capture progresses rather than only once it's stopped.
+    std::thread discontinuityWriterThread;
+    discontinuityRecordAvailable.clear();
+    discontinuityWriterStopRequested.clear();
+    discontinuityWriteFailed.clear();
+    if (discontinuityMapEnabled)
+    {
+        discontinuityWriterThread = std::thread(std::bind(std::mem_fn(&UsbDeviceBase::DiscontinuityWriterThread), this));
+    }
+
     // Start a worker thread to process data after it's read
     std::thread processingThread(std::bind(std::mem_fn(&UsbDeviceBase::ProcessingThread), this));
 
     // Start a worker thread to transfer data from the USB device
     std::thread usbTransferThread(std::bind(std::mem_fn(&UsbDeviceBase::UsbTransferThread), this));
 
-    // Run transfer continously until we're signalled to stop for some reason
-    captureThreadStopRequested.wait(false);
+    // Run transfer continously until we're signalled to stop for some reason. While we wait, we sample the throughput
+    // of the capture once a second, so dropouts can be correlated with the state of the pipeline afterwards.
+    ThroughputTotals throughputTotals;
+    throughputTotals.sampleTime = std::chrono::steady_clock::now();
+    throughputTotals.processingCpuTime = GetThreadCpuTime(processingThread);
+    auto nextThroughputSampleTime = throughputTotals.sampleTime + ThroughputSampleInterval;
+    while (!captureThreadStopRequested.test())
+    {
+        std::this_thread::sleep_for(ThroughputSamplePollInterval);
+        auto currentTime = std::chrono::steady_clock::now();
+        if (currentTime >= nextThroughputSampleTime)
+        {
+            RecordThroughputSample(throughputTotals, processingThread);
+            nextThroughputSampleTime = std::max(nextThroughputSampleTime + ThroughputSampleInterval, currentTime);
+        }
+    }
 
     // Wind up the capture process, latching the appropriate result if an error has occurred.
     TransferResult result = TransferResult::ProgramError;
@@ -510,6 +964,60 @@ void UsbDeviceBase::CaptureThread()
     // Wait for our spawned threads to terminate
     usbTransferThread.join();
     processingThread.join();
+    if (hashingThread.joinable())
+    {
+        hashingStopRequested.test_and_set();
+        hashWorkPending.test_and_set();
+        hashWorkPending.notify_all();
+        hashingThread.join();
+    }
+    additionalOutputStopRequested.test_and_set();
+    for (auto& output : additionalOutputs)
+    {
+        output->workAvailable.test_and_set();
+        output->workAvailable.notify_all();
+        output->writerThread.join();
+    }
+    if (audioWriterThread.joinable())
+    {
+        audioWriterStopRequested.test_and_set();
+        audioBatchAvailable.test_and_set();
+        audioBatchAvailable.notify_all();
+        audioWriterThread.join();
+    }
+    if (discontinuityWriterThread.joinable())
+    {
+        discontinuityWriterStopRequested.test_and_set();
+        discontinuityRecordAvailable.test_and_set();
+        discontinuityRecordAvailable.notify_all();
+        discontinuityWriterThread.join();
+    }
+
+    // Complete the discontinuity map, now that the processing thread has stopped adding to it
+    if (discontinuityMapEnabled)
+    {
+        if (FinishDiscontinuityMap())
+        {
+            Log().Info("CaptureThread(): Discontinuity map written with {0} records: {1}", discontinuityWriterCounters.discontinuityRecordCount.load(), discontinuityMapFilePath.string());
+        }
+        else
+        {
+            Log().Error("CaptureThread(): Failed to write the discontinuity map to {0}", discontinuityMapFilePath.string());
+        }
+    }
+
+    // Wait for any data remaining in the staging buffer to be written to the output file. If the flush failed, and no
+    // other error occurred first, report the failure as the result of this capture.
+    if (stagingFlushThread.joinable())
+    {
+        stagingBuffer.Finish();
+        stagingFlushThread.join();
+        if (stagingFlushFailed.test() && !errorCodeLatched)
+        {
+            result = TransferResult::FileWriteError;
+            errorCodeLatched = true;
+        }
+    }
 
     // Set the result of this transfer process
     if (!errorCodeLatched)
@@ -529,6 +1037,13 @@ void UsbDeviceBase::CaptureThread()
     {
         UnlockMemoryBuffer(conversionBuffers[i].data(), conversionBuffers[i].size());
     }
+    for (auto& output : additionalOutputs)
+    {
+        for (size_t i = 0; i < AdditionalOutputQueueLength; ++i)
+        {
+            UnlockMemoryBuffer(output->workQueue[i].sampleData.data(), output->workQueue[i].sampleData.size());
+        }
+    }
     for (size_t i = 0; i < totalDiskBufferEntryCount; ++i)
     {
         DiskBufferEntry& entry = diskBufferEntries[i];
@@ -555,165 +1070,189 @@ UsbDeviceBase::TransferResult UsbDeviceBase::GetTransferResult() const
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetNumberOfTransfers() const
-{
-    return transferCount;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetNumberOfDiskBuffersWritten() const
-{
-    return transferBufferWrittenCount;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetFileSizeWrittenInBytes() const
-{
-    return transferFileSizeWrittenInBytes;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetProcessedSampleCount() const
-{
-    return processedSampleCount;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetMinSampleValue() const
-{
-    return minSampleValue;
-}
-
-//----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetMaxSampleValue() const
+std::string UsbDeviceBase::GetTransferResultName(TransferResult result)
 {
-    return maxSampleValue;
+    switch (result)
+    {
+    case TransferResult::Running:
+        return "running";
+    case TransferResult::Success:
+        return "success";
+    case TransferResult::FileCreationError:
+        return "fileCreationError";
+    case TransferResult::BufferUnderflow:
+        return "bufferUnderflow";
+    case TransferResult::ConnectionFailure:
+        return "connectionFailure";
+    case TransferResult::UsbMemoryLimit:
+        return "usbMemoryLimit";
+    case TransferResult::UsbTransferFailure:
+        return "usbTransferFailure";
+    case TransferResult::FileWriteError:
+        return "fileWriteError";
+    case TransferResult::SequenceMismatch:
+        return "sequenceMismatch";
+    case TransferResult::VerificationError:
+        return "verificationError";
+    case TransferResult::ProgramError:
+        return "programError";
+    case TransferResult::ForcedAbort:
+        return "forcedAbort";
+    case TransferResult::MemoryAllocationFailure:
+        return "memoryAllocationFailure";
+    }
+    return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+UsbDeviceBase::CaptureFormat UsbDeviceBase::GetCaptureFormat() const
+{
+    return captureFormat;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetClippedMinSampleCount() const
+bool UsbDeviceBase::GetTransferHadSequenceNumbers() const
 {
-    return clippedMinSampleCount;
+    return (sequenceState != SequenceState::Disabled);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetClippedMaxSampleCount() const
+UsbDeviceBase::CaptureStatsSnapshot UsbDeviceBase::GetStatsSnapshot() const
 {
-    return clippedMaxSampleCount;
+    CaptureStatsSnapshot snapshot;
+    snapshot.transferCount = usbTransferCounters.transferCount;
+    snapshot.diskBufferWrittenCount = processingCounters.diskBufferWrittenCount;
+    snapshot.fileSizeWrittenInBytes = processingCounters.fileSizeWrittenInBytes + stagingFlushCounters.fileSizeWrittenInBytes;
+    snapshot.audioDroppedFrameCount = processingCounters.audioDroppedFrameCount;
+    snapshot.audioSegmentOverflowFrameCount = processingCounters.audioSegmentOverflowFrameCount;
+    snapshot.rf = publishedRfStatistics.Load();
+    snapshot.audio = publishedAudioStatistics.Load();
+    return snapshot;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetRecentMinSampleValue() const
+UsbDeviceBase::PipelineHistograms UsbDeviceBase::GetPipelineHistograms() const
 {
-    return recentMinSampleValue;
+    PipelineHistograms histograms;
+    histograms.diskBufferCount = totalDiskBufferEntryCount;
+    histograms.diskBufferQueueDepth = diskBufferQueueDepthHistogram.GetSnapshot();
+    histograms.usbCompletionIntervalInMicroseconds = usbCompletionIntervalHistogram.GetSnapshot();
+    histograms.writeLatencyInMicroseconds = writeLatencyHistogram.GetSnapshot();
+    histograms.minFreeDiskBufferCount = totalDiskBufferEntryCount - std::min((size_t)histograms.diskBufferQueueDepth.maxValue, totalDiskBufferEntryCount);
+    return histograms;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetRecentMaxSampleValue() const
+std::vector<UsbDeviceBase::ThroughputSample> UsbDeviceBase::GetThroughputSamples() const
 {
-    return recentMaxSampleValue;
+    std::unique_lock<std::mutex> lock(throughputSampleMutex);
+    return throughputSamples;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetRecentClippedMinSampleCount() const
+std::filesystem::path UsbDeviceBase::GetDiscontinuityMapFilePath() const
 {
-    return recentClippedMinSampleCount;
+    return discontinuityMapFilePath;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetRecentClippedMaxSampleCount() const
+// Note that the count is only updated by the discontinuity writer thread, as each record is appended to the map file
+// during the capture. It's an atomic counter, so it can be read from any thread while the capture is running, giving
+// the number of records written so far.
+size_t UsbDeviceBase::GetDiscontinuityRecordCount() const
 {
-    return recentClippedMaxSampleCount;
+    return (size_t)discontinuityWriterCounters.discontinuityRecordCount.load();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-bool UsbDeviceBase::GetTransferHadSequenceNumbers() const
+size_t UsbDeviceBase::GetDiscontinuityDroppedRecordCount() const
 {
-    return (sequenceState != SequenceState::Disabled);
+    return (size_t)processingCounters.discontinuityDroppedRecordCount.load();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetSyncLossCount() const
+bool UsbDeviceBase::GetAudioWriteFailed() const
 {
-    return syncLossCount;
+    return audioWriteFailed.test();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioFrameCount() const
+std::filesystem::path UsbDeviceBase::GetAudioAlignmentFilePath() const
 {
-    return audioFrameCount;
+    return audioAlignmentFilePath;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioFileSizeWrittenInBytes() const
+bool UsbDeviceBase::GetAudioPreviewConnected() const
 {
-    return audioFileSizeWrittenInBytes;
+    return audioPreviewStream.IsConsumerConnected();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudio24FrameCount() const
+uint64_t UsbDeviceBase::GetAudioPreviewDroppedFrameCount() const
 {
-    return audio24FrameCount;
+    return audioPreviewStream.GetDroppedFrameCount();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudio24FileSizeWrittenInBytes() const
+size_t UsbDeviceBase::GetResampledAudioOutputCount() const
 {
-    return audio24FileSizeWrittenInBytes;
+    return resampledAudioOutputs.size();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UsbDeviceBase::GetAudioMinSampleValue() const
+uint32_t UsbDeviceBase::GetResampledAudioOutputSampleRate(size_t outputIndex) const
 {
-    return audioMinSampleValue;
+    return resampledAudioOutputs[outputIndex]->resampler.GetOutputSampleRate();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UsbDeviceBase::GetAudioMaxSampleValue() const
+std::filesystem::path UsbDeviceBase::GetResampledAudioOutputFilePath(size_t outputIndex) const
 {
-    return audioMaxSampleValue;
+    return resampledAudioOutputs[outputIndex]->filePath;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioClippedMinSampleCount() const
+size_t UsbDeviceBase::GetResampledAudioOutputFileSizeWrittenInBytes(size_t outputIndex) const
 {
-    return audioClippedMinSampleCount;
+    return resampledAudioOutputs[outputIndex]->fileSizeWrittenInBytes;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioClippedMaxSampleCount() const
+bool UsbDeviceBase::GetResampledAudioOutputComplete(size_t outputIndex) const
 {
-    return audioClippedMaxSampleCount;
+    return !audioWriteFailed.test() && !resampledAudioOutputs[outputIndex]->writeFailed.test();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UsbDeviceBase::GetAudioRecentMinSampleValue() const
+bool UsbDeviceBase::GetAudioSourceAnalysisEnabled() const
 {
-    return audioRecentMinSampleValue;
+    return audioSourceAnalysisEnabled;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-int32_t UsbDeviceBase::GetAudioRecentMaxSampleValue() const
+std::vector<AudioSourceAnalyzer::WindowResult> UsbDeviceBase::GetAudioSourceAnalysis() const
 {
-    return audioRecentMaxSampleValue;
+    std::unique_lock<std::mutex> lock(audioSourceAnalysisMutex);
+    return audioSourceAnalysisResults;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioRecentClippedMinSampleCount() const
+std::filesystem::path UsbDeviceBase::GetAudioBestFilePath() const
 {
-    return audioRecentClippedMinSampleCount;
+    return audioBestFilePath;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-size_t UsbDeviceBase::GetAudioRecentClippedMaxSampleCount() const
+size_t UsbDeviceBase::GetAudioBestFileSizeWrittenInBytes() const
 {
-    return audioRecentClippedMaxSampleCount;
+    return audioBestFileSizeWrittenInBytes;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-double UsbDeviceBase::GetAudioMeanAmplitude() const
+UsbDeviceBase::AudioLevels UsbDeviceBase::GetAudioLevels() const
 {
-    return audioMeanAmplitude;
+    return publishedAudioLevels.Load();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -780,9 +1319,77 @@ void UsbDeviceBase::SetProcessingFinished(TransferResult result)
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-void UsbDeviceBase::AddCompletedTransferCount(size_t incrementCount)
+void UsbDeviceBase::AddCompletedTransferCount(size_t incrementCount, size_t transferSizeInBytes)
+{
+    AddToOwnedCounter(usbTransferCounters.transferCount, incrementCount);
+    AddToOwnedCounter(usbTransferCounters.transferredSizeInBytes, (uint64_t)(incrementCount * transferSizeInBytes));
+
+    // Record the time since the previous transfer completed
+    auto completionTime = std::chrono::steady_clock::now();
+    if (lastTransferCompletionTimeValid)
+    {
+        usbCompletionIntervalHistogram.Record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(completionTime - lastTransferCompletionTime).count());
+    }
+    lastTransferCompletionTime = completionTime;
+    lastTransferCompletionTimeValid = true;
+
+    // Record how many disk buffers are currently waiting to be processed. We count the buffers filled here against the
+    // buffers released by the processing thread, rather than inspecting the buffers themselves, so we don't touch cache
+    // lines the processing thread is writing to.
+    size_t filledCount = usbTransferCounters.diskBufferFilledCount.load(std::memory_order_relaxed);
+    size_t releasedCount = processingCounters.diskBufferWrittenCount.load(std::memory_order_acquire);
+    diskBufferQueueDepthHistogram.Record((filledCount > releasedCount) ? (filledCount - releasedCount) : 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::RecordDiskBufferFilled([[maybe_unused]] size_t diskBufferIndex)
+{
+    CAPTURE_TRACE_INSTANT(captureTrace, DiskBufferFull, diskBufferIndex);
+    AddToOwnedCounter<size_t>(usbTransferCounters.diskBufferFilledCount, 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::RecordThroughputSample(ThroughputTotals& previousTotals, std::thread& processingThread)
 {
-    transferCount += incrementCount;
+    // Take the current totals for the capture. Each of these only ever increases over the course of a capture, so the
+    // activity over the interval is the difference from the totals at the previous sample.
+    ThroughputTotals currentTotals;
+    currentTotals.sampleTime = std::chrono::steady_clock::now();
+    currentTotals.transferredSizeInBytes = usbTransferCounters.transferredSizeInBytes;
+    currentTotals.writtenSizeInBytes = processingCounters.fileSizeWrittenInBytes + stagingFlushCounters.fileSizeWrittenInBytes;
+    currentTotals.syncLossCount = publishedRfStatistics.Load().syncLossCount;
+    currentTotals.processingCpuTime = std::max(GetThreadCpuTime(processingThread), previousTotals.processingCpuTime);
+    currentTotals.diskBufferQueueDepth = diskBufferQueueDepthHistogram.GetSnapshot();
+
+    // Find the deepest the disk buffer queue got over the interval. This is the highest histogram bucket which has
+    // been added to since the previous sample, limited to the deepest value ever recorded. If no transfers completed in
+    // the interval, nothing will have been recorded, so we also take the current depth of the queue into account.
+    size_t filledCount = usbTransferCounters.diskBufferFilledCount.load(std::memory_order_relaxed);
+    size_t releasedCount = processingCounters.diskBufferWrittenCount.load(std::memory_order_relaxed);
+    size_t maxQueueDepth = (filledCount > releasedCount) ? (filledCount - releasedCount) : 0;
+    for (size_t i = Histogram::BucketCount; i > 0; --i)
+    {
+        if (currentTotals.diskBufferQueueDepth.bucketCounts[i - 1] > previousTotals.diskBufferQueueDepth.bucketCounts[i - 1])
+        {
+            uint64_t bucketMaxValue = std::min(Histogram::GetBucketUpperBound(i - 1), currentTotals.diskBufferQueueDepth.maxValue);
+            maxQueueDepth = std::max(maxQueueDepth, (size_t)bucketMaxValue);
+            break;
+        }
+    }
+
+    // Record the activity over the interval
+    ThroughputSample sample;
+    sample.sampleTime = currentTotals.sampleTime;
+    sample.transferredSizeInBytes = currentTotals.transferredSizeInBytes - previousTotals.transferredSizeInBytes;
+    sample.writtenSizeInBytes = currentTotals.writtenSizeInBytes - previousTotals.writtenSizeInBytes;
+    sample.syncLossCount = currentTotals.syncLossCount - previousTotals.syncLossCount;
+    sample.minFreeDiskBufferCount = totalDiskBufferEntryCount - std::min(maxQueueDepth, totalDiskBufferEntryCount);
+    sample.processingCpuTime = std::chrono::duration_cast<std::chrono::microseconds>(currentTotals.processingCpuTime - previousTotals.processingCpuTime);
+    {
+        std::unique_lock<std::mutex> lock(throughputSampleMutex);
+        throughputSamples.push_back(sample);
+    }
+    previousTotals = std::move(currentTotals);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -790,6 +1397,8 @@ void UsbDeviceBase::AddCompletedTransferCount(size_t incrementCount)
 //----------------------------------------------------------------------------------------------------------------------
 void UsbDeviceBase::ProcessingThread()
 {
+    CAPTURE_TRACE_REGISTER_THREAD(captureTrace, "Processing");
+
     ThreadPriorityRestoreInfo priorityRestoreInfo = {};
     bool boostedThreadPriority = SetCurrentThreadRealtimePriority(priorityRestoreInfo);
     std::shared_ptr<void> currentThreadPriorityReducer;
@@ -842,6 +1451,23 @@ void UsbDeviceBase::ProcessingThread()
             {
                 continue;
             }
+            CAPTURE_TRACE_SCOPE(captureTrace, ProcessBuffer, currentDiskBuffer);
+
+            // Wait for any hashing of the previous buffer to complete, since the conversion buffer it reads from is
+            // about to be overwritten.
+            WaitForHashWork();
+
+            // Latch the sequence counter state at the start of this buffer, so it can be recorded in the block header
+            // if we're writing a capture container.
+            uint64_t bufferStartSequenceCounter = savedSequenceCounter;
+            size_t bufferStartFrameOffset = audioFrameOffset;
+            bool bufferStartSequenceValid = (sequenceState == SequenceState::Running);
+
+            // Keep a copy of the raw sample data if any output needs the sideband intact
+            if (rawSampleBufferRequired)
+            {
+                memcpy(rawSampleBuffer.data(), bufferEntry.readBuffer.data(), diskBufferSizeInBytes);
+            }
 
             // Verify and strip the sequence markers from the sample data, and update our sample metrics.
             uint16_t minValue = std::numeric_limits<uint16_t>::max();
@@ -851,19 +1477,26 @@ void UsbDeviceBase::ProcessingThread()
             size_t maxClippedCount = 0;
             if (!ProcessSequenceMarkersAndUpdateSampleMetrics(currentDiskBuffer, samplesProcessedForBuffer, minValue, maxValue, minClippedCount, maxClippedCount))
             {
+                UpdateProcessingLogRateLimiters();
+                publishedRfStatistics.Store(rfStatistics);
                 SetProcessingFinished(TransferResult::SequenceMismatch);
                 processingFailure = true;
                 continue;
             }
-            minSampleValue = std::min(minSampleValue.load(), minValue);
-            maxSampleValue = std::max(maxSampleValue.load(), maxValue);
-            clippedMinSampleCount += minClippedCount;
-            clippedMaxSampleCount += maxClippedCount;
-            recentMinSampleValue = minValue;
-            recentMaxSampleValue = maxValue;
-            recentClippedMinSampleCount = minClippedCount;
-            recentClippedMaxSampleCount = maxClippedCount;
-            processedSampleCount += samplesProcessedForBuffer;
+
+            // Publish the statistics for this buffer all at once, so readers always see a consistent set of values
+            ++rfStatistics.updateCount;
+            rfStatistics.minSampleValue = std::min(rfStatistics.minSampleValue, minValue);
+            rfStatistics.maxSampleValue = std::max(rfStatistics.maxSampleValue, maxValue);
+            rfStatistics.clippedMinSampleCount += minClippedCount;
+            rfStatistics.clippedMaxSampleCount += maxClippedCount;
+            rfStatistics.recentMinSampleValue = minValue;
+            rfStatistics.recentMaxSampleValue = maxValue;
+            rfStatistics.recentClippedMinSampleCount = minClippedCount;
+            rfStatistics.recentClippedMaxSampleCount = maxClippedCount;
+            rfStatistics.processedSampleCount += samplesProcessedForBuffer;
+            UpdateProcessingLogRateLimiters();
+            publishedRfStatistics.Store(rfStatistics);
 
             // If a buffer sample has been requested, capture it now.
             if (bufferSampleRequestPending.test() && (bufferSamplingRequestedLengthInBytes <= diskBufferSizeInBytes))
@@ -890,8 +1523,21 @@ void UsbDeviceBase::ProcessingThread()
                 processingFailure = true;
                 continue;
             }
+            if (captureFormat == CaptureFormat::Unsigned10BitBlocked)
+            {
+                WriteCaptureContainerBlockHeader(currentConversionBuffer, bufferStartSequenceCounter, bufferStartFrameOffset, bufferStartSequenceValid);
+            }
+
+            // Pass the converted data to the hashing thread. This runs in parallel with the file write below, and the
+            // wait for the next disk buffer to fill.
+            SubmitHashWork(currentConversionBuffer);
+
+            // Hand a copy of the disk buffer to each additional output, to be converted and written by its own writer
+            // thread.
+            SubmitAdditionalOutputWork(currentDiskBuffer);
 
             // Write the data to the output file
+            CAPTURE_TRACE_SCOPE(captureTrace, WriteCapture, currentDiskBuffer);
 #ifdef _WIN32
             if (useWindowsOverlappedFileIo)
             {
@@ -912,24 +1558,44 @@ void UsbDeviceBase::ProcessingThread()
             else
             {
 #endif
-                // Perform the file write in a blocking operation
-                captureOutputFile.write((const char*)currentConversionBuffer.data(), currentConversionBuffer.size());
-                if (!captureOutputFile.good())
+                // Either append the data to the staging buffer, or perform the file write in a blocking operation.
+                if (useStagingBuffer)
                 {
-                    Log().Error("ProcessingThread(): An error occurred when writing to the output file");
-                    SetProcessingFinished(TransferResult::FileWriteError);
-                    processingFailure = true;
-                    continue;
+                    if (!stagingBuffer.Push(currentConversionBuffer.data(), currentConversionBuffer.size()))
+                    {
+                        Log().Error("ProcessingThread(): The staging buffer was aborted due to an output file error");
+                        SetProcessingFinished(TransferResult::FileWriteError);
+                        processingFailure = true;
+                        continue;
+                    }
+                }
+                else
+                {
+                    auto writeStartTime = std::chrono::steady_clock::now();
+                    captureOutputFile.write((const char*)currentConversionBuffer.data(), currentConversionBuffer.size());
+                    writeLatencyHistogram.Record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStartTime).count());
+                    if (!captureOutputFile.good())
+                    {
+                        Log().Error("ProcessingThread(): An error occurred when writing to the output file");
+                        SetProcessingFinished(TransferResult::FileWriteError);
+                        processingFailure = true;
+                        continue;
+                    }
                 }
 
                 // Mark the disk buffer as empty, notifying the USB transfer thread in case it's blocking waiting for this
                 // buffer to be free.
                 bufferEntry.isDiskBufferFull.clear();
                 bufferEntry.isDiskBufferFull.notify_all();
+                CAPTURE_TRACE_INSTANT(captureTrace, BufferRelease, currentDiskBuffer);
 
-                // Add the totals from this buffer to the transfer statistics
-                ++transferBufferWrittenCount;
-                transferFileSizeWrittenInBytes += currentConversionBuffer.size();
+                // Add the totals from this buffer to the transfer statistics. If we're using a staging buffer, the file
+                // size is updated by the flush thread as the data actually reaches the disk.
+                AddToOwnedCounter<size_t>(processingCounters.diskBufferWrittenCount, 1);
+                if (!useStagingBuffer)
+                {
+                    AddToOwnedCounter(processingCounters.fileSizeWrittenInBytes, currentConversionBuffer.size());
+                }
 #ifdef _WIN32
             }
 #endif
@@ -949,8 +1615,11 @@ void UsbDeviceBase::ProcessingThread()
             if (lastBufferEntry.diskWriteInProgress)
             {
                 // Block to check the result of the previous disk write operation
+                CAPTURE_TRACE_SCOPE(captureTrace, WriteCapture, lastBufferIndex);
                 DWORD bytesTransferred = 0;
+                auto writeWaitStartTime = std::chrono::steady_clock::now();
                 BOOL getOverlappedResultReturn = GetOverlappedResult(windowsCaptureOutputFileHandle, &lastBufferEntry.diskWriteOverlappedBuffer, &bytesTransferred, TRUE);
+                writeLatencyHistogram.Record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeWaitStartTime).count());
                 if (getOverlappedResultReturn == 0)
                 {
                     DWORD lastError = GetLastError();
@@ -976,10 +1645,11 @@ void UsbDeviceBase::ProcessingThread()
                 lastBufferEntry.diskWriteInProgress = false;
                 lastBufferEntry.isDiskBufferFull.clear();
                 lastBufferEntry.isDiskBufferFull.notify_all();
+                CAPTURE_TRACE_INSTANT(captureTrace, BufferRelease, lastBufferIndex);
 
                 // Add the totals from this last buffer to the transfer statistics
-                ++transferBufferWrittenCount;
-                transferFileSizeWrittenInBytes += lastConversionBuffer.size();
+                AddToOwnedCounter<size_t>(processingCounters.diskBufferWrittenCount, 1);
+                AddToOwnedCounter(processingCounters.fileSizeWrittenInBytes, lastConversionBuffer.size());
             }
         }
 #endif
@@ -994,6 +1664,12 @@ void UsbDeviceBase::ProcessingThread()
 #endif
     }
 
+    // Ensure the hashing thread has finished with our buffers before we return
+    WaitForHashWork();
+
+    // Report any repeated messages which were suppressed towards the end of the capture
+    FlushProcessingLogRateLimiters();
+
     // If we're using overlapped file IO and a processing failure occurred, cancel any IO operations still in progress
     // on the output file.
 #ifdef _WIN32
@@ -1020,48 +1696,42 @@ void UsbDeviceBase::ProcessingThread()
 bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBufferIndex, size_t& processedSampleCount, uint16_t& minValue, uint16_t& maxValue, size_t& minClippedCount, size_t& maxClippedCount)
 {
     // If sequence checking has already failed, return false immediately.
+    CAPTURE_TRACE_SCOPE(captureTrace, ProcessSequence, diskBufferIndex);
     if (sequenceState == SequenceState::Failed)
     {
         return false;
     }
 
-    // Frame structure constants (matches dataGenerator.v)
-    const size_t SAMPLES_PER_FRAME = 512;
-    const size_t BYTES_PER_FRAME = SAMPLES_PER_FRAME * 2;
-    
-    // 192-bit sync pattern (32 samples, firmware revision 20251015)
-    // Pattern from Verilog: 192'hDDDF20251015DDDF20251015DDDF20251016FEDCBA987654
-    // Note: Verilog ordering is MSB-first, so we reverse for extraction
-    const uint64_t SYNC_PATTERN[4] = {
-        0xFEDCBA987654ULL,  // Samples 0-7   (bits [47:0] - rightmost in Verilog)
-        0xDDDF20251016ULL,  // Samples 8-15  (bits [95:48])
-        0xDDDF20251015ULL,  // Samples 16-23 (bits [143:96])
-        0xDDDF20251015ULL   // Samples 24-31 (bits [191:144] - leftmost in Verilog)
-    };
-    const size_t SYNC_SAMPLES = 32;
-    const size_t ADC128_START = 32;
-    const size_t PCM1802_START = 38;
-    const size_t COUNTER_START = 48;
-    const size_t COUNTER_SAMPLES_PER_VALUE = 8;
-    
     const uint16_t minPossibleSampleValue = 0;
     const uint16_t maxPossibleSampleValue = 0b1111111111;
 
     uint8_t* diskBuffer = diskBufferEntries[diskBufferIndex].readBuffer.data();
     uint64_t expectedCounter = savedSequenceCounter;
     size_t bufferSampleCount = diskBufferSizeInBytes / 2;
-
-    // Clear audio buffers at start of processing
-    audioLeftBuffer.clear();
-    audioRightBuffer.clear();
-    audio24LeftBuffer.clear();
-    audio24RightBuffer.clear();
-    
-    // Reset recent audio statistics for this buffer
-    audioRecentMinSampleValue = std::numeric_limits<int32_t>::max();
-    audioRecentMaxSampleValue = std::numeric_limits<int32_t>::min();
-    audioRecentClippedMinSampleCount = 0;
-    audioRecentClippedMaxSampleCount = 0;
+    bufferGapFills.clear();
+
+    // Obtain a batch to decode this buffer's audio into, and size it for the most frames this disk buffer could
+    // contain. The audio fields of each frame are gathered as the buffer is processed, then decoded together at the
+    // end, directly into the batch in the form they're written to the output file, and the batch is trimmed to the
+    // number of frames actually decoded. Capacity for this was reserved when the capture started. If the audio writer
+    // has fallen so far behind that no batch is free, we decode into a scratch batch which is then discarded, so that
+    // audio can never hold up the RF data.
+    AudioBatch* audioBatch = nullptr;
+    bool audioBatchQueued = false;
+    if (captureAudioSource != AudioSource::None)
+    {
+        audioBatch = AcquireAudioBatch();
+        audioBatchQueued = (audioBatch != nullptr);
+        if (!audioBatchQueued)
+        {
+            audioBatch = &audioOverflowBatch;
+        }
+        const size_t maxAudioFrameCount = (bufferSampleCount / SidebandFrame::SamplesPerFrame) + 1;
+        audioBatch->frameCount = 0;
+        audioBatch->segments.clear();
+        audioBatch->frameData.resize((captureAudioSource != AudioSource::Pcm1802) ? (maxAudioFrameCount * 4) : 0);
+        audioBatch->frame24Data.resize((captureAudioSource != AudioSource::Adc128s022) ? (maxAudioFrameCount * 6) : 0);
+    }
 
     // Process samples, with ability to re-sync if sync is lost
     size_t sampleIndex = 0;
@@ -1070,8 +1740,11 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
         // If we need to sync, search for the sync pattern from current position
         if (sequenceState == SequenceState::Sync)
         {
-            Log().Info("ProcessSequenceMarkersAndUpdateSampleMetrics(): Searching for 192-bit sync pattern from sample {0}...", sampleIndex);
-            
+            if (syncSearchLogLimiter.ShouldLog(Log()))
+            {
+                Log().Info("ProcessSequenceMarkersAndUpdateSampleMetrics(): Searching for 192-bit sync pattern from sample {0}...", sampleIndex);
+            }
+            
             // Search through the buffer sample by sample to find the sync pattern
             bool syncFound = false;
             size_t searchLimit = (bufferSampleCount >= 512) ? (bufferSampleCount - 512) : 0;
@@ -1083,7 +1756,7 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
                 for (size_t chunk = 0; chunk < 4 && patternMatches; chunk++)
                 {
                     uint64_t extracted = ExtractSyncPattern(diskBuffer, (searchSample + chunk * 8) * 2);
-                    if (extracted != SYNC_PATTERN[chunk])
+                    if (extracted != SidebandFrame::SyncPattern[chunk])
                     {
                         patternMatches = false;
                     }
@@ -1096,15 +1769,22 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
                     syncFound = true;
                     
                     // Extract first counter value from samples 48-55 of this frame
-                    size_t firstCounterSample = searchSample + COUNTER_START;
+                    size_t firstCounterSample = searchSample + SidebandFrame::CounterStart;
                     uint64_t counterValue = Extract48BitCounter(diskBuffer, firstCounterSample * 2);
                     
-                    Log().Info("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync locked at sample {0} (byte {1}), counter = 0x{2:X}", 
-                        searchSample, searchSample * 2, counterValue);
+                    if (syncLockedLogLimiter.ShouldLog(Log()))
+                    {
+                        Log().Info("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync locked at sample {0} (byte {1}), counter = 0x{2:X}",
+                            searchSample, searchSample * 2, counterValue);
+                    }
                     
                     sequenceState = SequenceState::Running;
                     audioSyncLocked = true;
                     audioFrameOffset = 0;
+                    if (pendingSyncLossRecord)
+                    {
+                        CompleteSyncLossRecord(bufferStartSampleOffset + searchSample, counterValue);
+                    }
                     expectedCounter = counterValue;
                     break;
                 }
@@ -1113,26 +1793,29 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
             // If no sync found by end of search, wait for next buffer
             if (!syncFound)
             {
-                Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern not found in remainder of buffer, will retry on next buffer");
+                if (syncNotFoundLogLimiter.ShouldLog(Log()))
+                {
+                    Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern not found in remainder of buffer, will retry on next buffer");
+                }
                 break;  // Exit and wait for next buffer
             }
         }
 
         size_t samplesLeftInBuffer = bufferSampleCount - sampleIndex;
-        size_t samplesLeftInFrame = SAMPLES_PER_FRAME - audioFrameOffset;
+        size_t samplesLeftInFrame = SidebandFrame::SamplesPerFrame - audioFrameOffset;
         size_t samplesToProcess = std::min(samplesLeftInBuffer, samplesLeftInFrame);
         
         // If we're at the start of a frame (offset 0), validate sync pattern and extract audio
         if (audioFrameOffset == 0)
         {
             // Validate 192-bit sync pattern - must be present at start of every frame
-            if (samplesLeftInBuffer >= COUNTER_START + COUNTER_SAMPLES_PER_VALUE)
+            if (samplesLeftInBuffer >= SidebandFrame::CounterStart + SidebandFrame::CounterSamplesPerValue)
             {
                 bool syncValid = true;
                 for (size_t chunk = 0; chunk < 4 && syncValid; chunk++)
                 {
                     uint64_t extracted = ExtractSyncPattern(diskBuffer, (sampleIndex + chunk * 8) * 2);
-                    if (extracted != SYNC_PATTERN[chunk])
+                    if (extracted != SidebandFrame::SyncPattern[chunk])
                     {
                         syncValid = false;
                     }
@@ -1140,13 +1823,17 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
                 
                 if (!syncValid)
                 {
-                    Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern lost at sample {0}, searching for resync...",
-                        sampleIndex);
-                    ++syncLossCount;
+                    if (syncLostLogLimiter.ShouldLog(Log()))
+                    {
+                        Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern lost at sample {0}, searching for resync...",
+                            sampleIndex);
+                    }
+                    ++rfStatistics.syncLossCount;
+                    pendingSyncLossRecord = MakeDiscontinuityRecord(DiscontinuityMap::RecordType::SyncLoss, bufferStartSampleOffset + sampleIndex, expectedCounter, DiscontinuityMap::CounterNotReacquired, 0);
                     if (captureStopOnDroppedSamples)
                     {
                         sequenceState = SequenceState::Failed;
-                        return false;
+                return false;
                     }
                     // Search for next sync pattern from current position
                     sequenceState = SequenceState::Sync;
@@ -1155,124 +1842,87 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
                     continue;
                 }
             }
+
+            // If we're filling gaps, check this frame follows on from the last one we saw, and record a fill ahead of
+            // it for any samples which were lost in between.
+            if ((captureGapFillMode != GapFillMode::None) && (samplesLeftInBuffer >= SidebandFrame::CounterStart + SidebandFrame::CounterSamplesPerValue))
+            {
+                uint64_t frameCounter = Extract48BitCounter(diskBuffer, (sampleIndex + SidebandFrame::CounterStart) * 2);
+                uint64_t frameSampleOffset = bufferStartSampleOffset + sampleIndex;
+                if (gapFillExpectedFrameValid && (frameCounter != gapFillExpectedFrameCounter))
+                {
+                    AddGapFill(sampleIndex, frameSampleOffset, frameCounter, diskBuffer);
+                }
+                gapFillExpectedFrameValid = true;
+                gapFillExpectedFrameCounter = (frameCounter + SidebandFrame::CounterValuesPerFrame) & SidebandFrame::CounterMask;
+                gapFillExpectedFrameSampleOffset = frameSampleOffset + SidebandFrame::SamplesPerFrame;
+            }
             
             // Extract audio data from frame (only if the audio source is enabled)
-            if (samplesLeftInBuffer >= COUNTER_START + COUNTER_SAMPLES_PER_VALUE)
+            if ((audioBatch != nullptr) && (samplesLeftInBuffer >= SidebandFrame::CounterStart + SidebandFrame::CounterSamplesPerValue))
             {
-                // ADC128 12-bit audio at samples 32-35 (only extract if needed)
-                if (captureAudioSource == AudioSource::Adc128s022 || captureAudioSource == AudioSource::Both)
+                // Record which RF frame this audio frame came from, so the audio writer can keep the audio aligned
+                // against the RF data. A new segment is only started when this frame doesn't directly follow the
+                // previous one, either in the sample stream or in the frame counter sequence.
+                uint64_t frameCounter = Extract48BitCounter(diskBuffer, (sampleIndex + SidebandFrame::CounterStart) * 2);
+                uint64_t frameSampleOffset = bufferStartSampleOffset + sampleIndex;
+                bool startNewSegment = audioBatch->segments.empty();
+                if (!startNewSegment)
                 {
-                    size_t adc128Offset = sampleIndex + ADC128_START;
-                    uint16_t audioLeftUnsigned = Extract12BitAudio(diskBuffer, adc128Offset * 2, 0);
-                    uint16_t audioRightUnsigned = Extract12BitAudio(diskBuffer, adc128Offset * 2, 2);
-                    
-                    // Convert from unsigned (0-4095) to signed, centered at 2048
-                    int16_t audioLeft = (int16_t)audioLeftUnsigned - 2048;
-                    int16_t audioRight = (int16_t)audioRightUnsigned - 2048;
-                    
-                    // Store audio samples in buffer
-                    audioLeftBuffer.push_back(audioLeft);
-                    audioRightBuffer.push_back(audioRight);
-                    
-                    // Update audio statistics (only if ADC128s022 is the sole source, or if Both and PCM1802 isn't preferred)
-                    if (captureAudioSource == AudioSource::Adc128s022)
-                    {
-                        // For 12-bit audio: min is -2048, max is +2047
-                        const int32_t minPossible = -2048;
-                        const int32_t maxPossible = 2047;
-                        
-                        audioRecentMinSampleValue = std::min(audioRecentMinSampleValue.load(), (int32_t)audioLeft);
-                        audioRecentMinSampleValue = std::min(audioRecentMinSampleValue.load(), (int32_t)audioRight);
-                        audioRecentMaxSampleValue = std::max(audioRecentMaxSampleValue.load(), (int32_t)audioLeft);
-                        audioRecentMaxSampleValue = std::max(audioRecentMaxSampleValue.load(), (int32_t)audioRight);
-                        
-                        audioMinSampleValue = std::min(audioMinSampleValue.load(), (int32_t)audioLeft);
-                        audioMinSampleValue = std::min(audioMinSampleValue.load(), (int32_t)audioRight);
-                        audioMaxSampleValue = std::max(audioMaxSampleValue.load(), (int32_t)audioLeft);
-                        audioMaxSampleValue = std::max(audioMaxSampleValue.load(), (int32_t)audioRight);
-                        
-                        if (audioLeft == minPossible) ++audioClippedMinSampleCount;
-                        if (audioRight == minPossible) ++audioClippedMinSampleCount;
-                        if (audioLeft == maxPossible) ++audioClippedMaxSampleCount;
-                        if (audioRight == maxPossible) ++audioClippedMaxSampleCount;
-                        
-                        if (audioLeft == minPossible) ++audioRecentClippedMinSampleCount;
-                        if (audioRight == minPossible) ++audioRecentClippedMinSampleCount;
-                        if (audioLeft == maxPossible) ++audioRecentClippedMaxSampleCount;
-                        if (audioRight == maxPossible) ++audioRecentClippedMaxSampleCount;
-                    }
+                    const AudioBatchSegment& segment = audioBatch->segments.back();
+                    uint64_t segmentFrameCount = audioBatch->frameCount - segment.firstFrameIndex;
+                    startNewSegment = (frameCounter != ((segment.frameCounter + (segmentFrameCount * SidebandFrame::CounterValuesPerFrame)) & SidebandFrame::CounterMask)) || (frameSampleOffset != (segment.rfSampleOffset + (segmentFrameCount * SidebandFrame::SamplesPerFrame)));
                 }
-
-                // PCM1802 24-bit at samples 38-41 (left) and 42-45 (right) (only extract if needed)
-                if (captureAudioSource == AudioSource::Pcm1802 || captureAudioSource == AudioSource::Both)
+                if (startNewSegment && (audioBatch->segments.size() >= MaxAudioBatchSegmentCount))
                 {
-                    uint32_t pcmLeft = Extract24BitTop6x4(diskBuffer, (sampleIndex + PCM1802_START) * 2);
-                    uint32_t pcmRight = Extract24BitTop6x4(diskBuffer, (sampleIndex + PCM1802_START + 4) * 2);
-                    
-                    // Mask to ensure we only have 24 bits
-                    pcmLeft &= 0xFFFFFF;
-                    pcmRight &= 0xFFFFFF;
-                    
-                    // PCM1802 outputs 24-bit two's-complement. Sign-extend bit 23.
-                    int32_t pcmLeftSigned = (pcmLeft & 0x800000) ? (int32_t)(pcmLeft | 0xFF000000) : (int32_t)pcmLeft;
-                    int32_t pcmRightSigned = (pcmRight & 0x800000) ? (int32_t)(pcmRight | 0xFF000000) : (int32_t)pcmRight;
-                    
-                    audio24LeftBuffer.push_back(pcmLeftSigned);
-                    audio24RightBuffer.push_back(pcmRightSigned);
-                    
-                    // Update audio statistics (PCM1802 is preferred when Both is enabled)
-                    if (captureAudioSource == AudioSource::Pcm1802 || captureAudioSource == AudioSource::Both)
+                    // The batch has no room for another segment, so this frame is dropped. The audio writer sees the
+                    // missing frames as a gap in the frame counter at the start of the next batch.
+                    AddToOwnedCounter<size_t>(processingCounters.audioSegmentOverflowFrameCount, 1);
+                }
+                else
+                {
+                    if (startNewSegment)
                     {
-                        // For 24-bit audio: min is -8388608 (0x800000), max is 8388607 (0x7FFFFF)
-                        const int32_t minPossible = -8388608;
-                        const int32_t maxPossible = 8388607;
-                        
-                        audioRecentMinSampleValue = std::min(audioRecentMinSampleValue.load(), pcmLeftSigned);
-                        audioRecentMinSampleValue = std::min(audioRecentMinSampleValue.load(), pcmRightSigned);
-                        audioRecentMaxSampleValue = std::max(audioRecentMaxSampleValue.load(), pcmLeftSigned);
-                        audioRecentMaxSampleValue = std::max(audioRecentMaxSampleValue.load(), pcmRightSigned);
-                        
-                        audioMinSampleValue = std::min(audioMinSampleValue.load(), pcmLeftSigned);
-                        audioMinSampleValue = std::min(audioMinSampleValue.load(), pcmRightSigned);
-                        audioMaxSampleValue = std::max(audioMaxSampleValue.load(), pcmLeftSigned);
-                        audioMaxSampleValue = std::max(audioMaxSampleValue.load(), pcmRightSigned);
-                        
-                        if (pcmLeftSigned == minPossible) ++audioClippedMinSampleCount;
-                        if (pcmRightSigned == minPossible) ++audioClippedMinSampleCount;
-                        if (pcmLeftSigned == maxPossible) ++audioClippedMaxSampleCount;
-                        if (pcmRightSigned == maxPossible) ++audioClippedMaxSampleCount;
-                        
-                        if (pcmLeftSigned == minPossible) ++audioRecentClippedMinSampleCount;
-                        if (pcmRightSigned == minPossible) ++audioRecentClippedMinSampleCount;
-                        if (pcmLeftSigned == maxPossible) ++audioRecentClippedMaxSampleCount;
-                        if (pcmRightSigned == maxPossible) ++audioRecentClippedMaxSampleCount;
+                        audioBatch->segments.push_back({ audioBatch->frameCount, frameCounter, frameSampleOffset });
                     }
+
+                    // Gather the audio fields for this frame, before the sideband bits are stripped from the buffer
+                    // below. They're decoded along with the rest of the frames in this buffer once we've finished with
+                    // it.
+                    memcpy(audioFieldBlocks.data() + (audioBatch->frameCount * SidebandFrame::AudioFieldBlockSizeInBytes), diskBuffer + ((sampleIndex + SidebandFrame::Adc128Start) * 2), SidebandFrame::AudioFieldBlockSizeInBytes);
+                    ++audioBatch->frameCount;
                 }
             }
         }
         
         // Verify counter values in counter region (samples 48-511 of each frame)
         // Counter increments every 8 samples, so verify at the start of each 8-sample block
-        if (audioFrameOffset >= COUNTER_START && audioFrameOffset < SAMPLES_PER_FRAME)
+        if (audioFrameOffset >= SidebandFrame::CounterStart && audioFrameOffset < SidebandFrame::SamplesPerFrame)
         {
-            size_t offsetInCounterRegion = audioFrameOffset - COUNTER_START;
+            size_t offsetInCounterRegion = audioFrameOffset - SidebandFrame::CounterStart;
             
             // Check if we're at the start of an 8-sample counter block
-            if ((offsetInCounterRegion % COUNTER_SAMPLES_PER_VALUE) == 0)
+            if ((offsetInCounterRegion % SidebandFrame::CounterSamplesPerValue) == 0)
             {
                 // Verify we have enough samples left in buffer
-                if (samplesLeftInBuffer >= COUNTER_SAMPLES_PER_VALUE)
+                if (samplesLeftInBuffer >= SidebandFrame::CounterSamplesPerValue)
                 {
                     uint64_t actualCounter = Extract48BitCounter(diskBuffer, sampleIndex * 2);
                     
                     if (actualCounter != expectedCounter)
                     {
-                        Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Counter mismatch at sample {0} (frame offset {1})! Expected 0x{2:X} but got 0x{3:X}",
-                            sampleIndex, audioFrameOffset, expectedCounter, actualCounter);
+                        if (counterMismatchLogLimiter.ShouldLog(Log()))
+                        {
+                            Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Counter mismatch at sample {0} (frame offset {1})! Expected 0x{2:X} but got 0x{3:X}",
+                                sampleIndex, audioFrameOffset, expectedCounter, actualCounter);
+                        }
+                        ++rfStatistics.counterMismatchCount;
+                        uint64_t missingSampleCount = DiscontinuityMap::GetMissingSampleCount(expectedCounter, actualCounter, (uint32_t)SidebandFrame::SamplesPerFrame, (uint32_t)SidebandFrame::CounterValuesPerFrame, (uint32_t)SidebandFrame::CounterSamplesPerValue);
+                        AddDiscontinuityRecord(MakeDiscontinuityRecord(DiscontinuityMap::RecordType::CounterMismatch, bufferStartSampleOffset + sampleIndex, expectedCounter, actualCounter, missingSampleCount));
                         if (captureStopOnDroppedSamples)
                         {
                             sequenceState = SequenceState::Failed;
-                            return false;
+                return false;
                         }
                         // Update expected counter to continue from actual value
                         expectedCounter = actualCounter;
@@ -1282,333 +1932,1563 @@ bool UsbDeviceBase::ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBuff
                     expectedCounter++;
                 }
             }
-        }
-        
-        // Update RF sample metrics for all processed samples
-        for (size_t i = 0; i < samplesToProcess; i++)
-        {
-            size_t byteOffset = (sampleIndex + i) * 2;
-            
-            // Strip the top 6 bits
-            diskBuffer[byteOffset + 1] &= 0x03;
-            
-            // Extract RF data (lower 10 bits)
-            uint16_t rfSample = (uint16_t)diskBuffer[byteOffset] |
-                               ((uint16_t)diskBuffer[byteOffset + 1] << 8);
-            
-            // Update min/max values
-            minValue = std::min(minValue, rfSample);
-            maxValue = std::max(maxValue, rfSample);
-            
-            // Check for clipping
-            if (rfSample == minPossibleSampleValue) {
-                ++minClippedCount;
-            } else if (rfSample == maxPossibleSampleValue) {
-                ++maxClippedCount;
+        }
+        
+        // Update RF sample metrics for all processed samples
+        for (size_t i = 0; i < samplesToProcess; i++)
+        {
+            size_t byteOffset = (sampleIndex + i) * 2;
+            
+            // Strip the top 6 bits
+            diskBuffer[byteOffset + 1] &= 0x03;
+            
+            // Extract RF data (lower 10 bits)
+            uint16_t rfSample = (uint16_t)diskBuffer[byteOffset] |
+                               ((uint16_t)diskBuffer[byteOffset + 1] << 8);
+            
+            // Update min/max values
+            minValue = std::min(minValue, rfSample);
+            maxValue = std::max(maxValue, rfSample);
+            
+            // Check for clipping
+            if (rfSample == minPossibleSampleValue) {
+                ++minClippedCount;
+            } else if (rfSample == maxPossibleSampleValue) {
+                ++maxClippedCount;
+            }
+        }
+        
+        sampleIndex += samplesToProcess;
+        audioFrameOffset += samplesToProcess;
+        processedSampleCount += samplesToProcess;
+        
+        // Reset frame offset when we complete a frame
+        if (audioFrameOffset >= SidebandFrame::SamplesPerFrame)
+        {
+            audioFrameOffset = 0;
+        }
+    }
+
+    // Decode the audio from each ADC which is enabled, and hand it over to the audio writer thread. If there was no
+    // space in the queue for it, the audio for this buffer is lost, but the RF capture carries on unaffected.
+    if (audioBatch != nullptr)
+    {
+        CAPTURE_TRACE_SCOPE(captureTrace, ProcessAudio, diskBufferIndex);
+        if (!audioBatch->frameData.empty())
+        {
+            SidebandFrame::DecodeAdc128s022Audio(audioFieldBlocks.data(), audioBatch->frameCount, audioBatch->frameData.data());
+        }
+        if (!audioBatch->frame24Data.empty())
+        {
+            SidebandFrame::DecodePcm1802Audio(audioFieldBlocks.data(), audioBatch->frameCount, audioBatch->frame24Data.data());
+        }
+        audioBatch->frameData.resize((audioBatch->frameData.empty() ? 0 : audioBatch->frameCount * 4));
+        audioBatch->frame24Data.resize((audioBatch->frame24Data.empty() ? 0 : audioBatch->frameCount * 6));
+        if (audioBatchQueued)
+        {
+            PublishAudioBatch();
+        }
+        else if (audioBatch->frameCount > 0)
+        {
+            if (processingCounters.audioDroppedFrameCount.load(std::memory_order_relaxed) == 0)
+            {
+                Log().Warning("ProcessSequenceMarkersAndUpdateSampleMetrics(): Audio writer has fallen behind, audio frames are being dropped");
+            }
+            AddToOwnedCounter(processingCounters.audioDroppedFrameCount, audioBatch->frameCount);
+        }
+    }
+
+    // Save the expected counter value for the next buffer, and the last sample value for interpolating a fill at the
+    // start of it.
+    savedSequenceCounter = expectedCounter;
+    gapFillPreviousSampleValue = ((uint16_t)diskBuffer[(bufferSampleCount * 2) - 2] | ((uint16_t)diskBuffer[(bufferSampleCount * 2) - 1] << 8)) & 0x03FF;
+    bufferStartSampleOffset += bufferSampleCount;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::VerifyTestSequence(size_t diskBufferIndex)
+{
+    // Retrieve the stored expected next sample value. If we haven't processed a buffer in this capture yet,
+    // latch the first sample value as the expected value so we can start from here.
+    CAPTURE_TRACE_SCOPE(captureTrace, ProcessVerify, diskBufferIndex);
+    DiskBufferEntry& bufferEntry = diskBufferEntries[diskBufferIndex];
+    uint16_t expectedValue = expectedNextTestDataValue.value_or((uint16_t)bufferEntry.readBuffer[0] | (uint16_t)((uint16_t)bufferEntry.readBuffer[1] << 8));
+
+    // Verify each sample in the buffer matches our expected sequence progression
+    const uint8_t* readBufferPointer = bufferEntry.readBuffer.data();
+    for (size_t i = 0; i < bufferEntry.readBuffer.size(); i += 2)
+    {
+        // Get the original 10-bit unsigned value from the disk data buffer
+        uint16_t actualValue = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
+        readBufferPointer += 2;
+
+        // If the actual value doesn't match our expected value, but this is the first time the test sequence
+        // has wrapped around to 0, check if this appears to be the wrap point for the sequence, and latch it.
+        // Valid wrapp points are either 1021 (newer FPGA firmware) or 1024 (older FPGA firmware).
+        if (!testDataMax.has_value() && (expectedValue != actualValue) && (actualValue == 0) && ((expectedValue == 1021) || (expectedValue == 1024)))
+        {
+            testDataMax = expectedValue;
+            expectedValue = 1;
+            continue;
+        }
+
+        // If the expected value differs from the actual value, log an error.
+        if (expectedValue != actualValue)
+        {
+            // Data error
+            Log().Error("VerifyTestSequence(): Data error in test data verification! Expecting {0} but got {1}", expectedValue, actualValue);
+            return false;
+        }
+
+        // Calculate the value we expect to find for the next sample
+        ++expectedValue;
+        if (testDataMax.has_value() && (expectedValue == testDataMax))
+        {
+            expectedValue = 0;
+        }
+    }
+
+    // Store the next expected sample value so we can check against the next buffer
+    expectedNextTestDataValue = expectedValue;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::ConvertRawSampleData(size_t diskBufferIndex, CaptureFormat captureFormat, std::vector<uint8_t>& outputBuffer)
+{
+    CAPTURE_TRACE_SCOPE(captureTrace, ProcessConvert, diskBufferIndex);
+    const DiskBufferEntry& bufferEntry = diskBufferEntries[diskBufferIndex];
+
+    // The raw 16-bit format is taken from the copy of the sample data made before the sideband was stripped from the
+    // disk buffer, with the sideband data intact.
+    const uint8_t* sampleData = (captureFormat == CaptureFormat::Unsigned16BitRaw) ? rawSampleBuffer.data() : bufferEntry.readBuffer.data();
+    return ConvertSampleData(sampleData, bufferEntry.readBuffer.size() / 2, bufferGapFills, captureFormat, gapFillSampleBuffer, outputBuffer);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::ConvertSampleData(const uint8_t* sampleData, size_t sampleCount, const std::vector<GapFill>& gapFills, CaptureFormat captureFormat, std::vector<uint8_t>& fillSampleBuffer, std::vector<uint8_t>& outputBuffer) const
+{
+    // Size the output for the samples in this buffer, along with any samples being inserted to fill gaps. If we're
+    // writing a capture container, leave space for the block header at the start of the buffer. It's filled in once
+    // the payload is complete.
+    outputBuffer.resize(GetConversionBufferSizeInBytes(captureFormat) + GetConvertedSizeInBytes(captureFormat, GetTotalGapFillSampleCount(captureFormat, gapFills)));
+    uint8_t* writeBufferPointer = outputBuffer.data();
+    if (captureFormat == CaptureFormat::Unsigned10BitBlocked)
+    {
+        writeBufferPointer += CaptureContainer::BlockHeaderSizeInBytes;
+    }
+
+    // Convert the samples, inserting each fill at the point in the buffer it was recorded at. In the packed formats,
+    // each fill is moved back to the start of the group holding that point, so each run of samples can be converted
+    // independently. The raw format is never filled.
+    size_t alignmentSampleCount = GetGapFillAlignmentSampleCount(captureFormat);
+    size_t convertedSampleCount = 0;
+    for (const GapFill& gapFill : gapFills)
+    {
+        if (alignmentSampleCount == 0)
+        {
+            break;
+        }
+        size_t fillSampleIndex = gapFill.sampleIndex - (gapFill.sampleIndex % alignmentSampleCount);
+        size_t fillSampleCount = GetGapFillSampleCount(captureFormat, gapFill);
+        size_t runSampleCount = fillSampleIndex - convertedSampleCount;
+        if (!ConvertSamples(sampleData + (convertedSampleCount * 2), runSampleCount, captureFormat, writeBufferPointer))
+        {
+            return false;
+        }
+        writeBufferPointer += GetConvertedSizeInBytes(captureFormat, runSampleCount);
+        convertedSampleCount = fillSampleIndex;
+        for (size_t fillOffset = 0; fillOffset < fillSampleCount; fillOffset += GapFillChunkSampleCount)
+        {
+            size_t chunkSampleCount = std::min(GapFillChunkSampleCount, fillSampleCount - fillOffset);
+            BuildGapFillSamples(gapFill, fillSampleCount, fillOffset, chunkSampleCount, fillSampleBuffer.data());
+            if (!ConvertSamples(fillSampleBuffer.data(), chunkSampleCount, captureFormat, writeBufferPointer))
+            {
+                return false;
+            }
+            writeBufferPointer += GetConvertedSizeInBytes(captureFormat, chunkSampleCount);
+        }
+    }
+    return ConvertSamples(sampleData + (convertedSampleCount * 2), sampleCount - convertedSampleCount, captureFormat, writeBufferPointer);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::ConvertSamples(const uint8_t* sampleData, size_t sampleCount, CaptureFormat captureFormat, uint8_t* outputData) const
+{
+    // Convert the data to the required format
+    const uint8_t* readBufferPointer = sampleData;
+    size_t readBufferSizeInBytes = sampleCount * 2;
+    uint8_t* writeBufferPointer = outputData;
+    if (captureFormat == CaptureFormat::Signed16Bit)
+    {
+        // Translate the data in the disk buffer to scaled 16-bit signed data
+        for (size_t i = 0; i < readBufferSizeInBytes; i += 2)
+        {
+            // Get the original 10-bit unsigned value from the disk data buffer
+            uint16_t originalValue = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
+            readBufferPointer += 2;
+
+            // Sign and scale the data to 16-bits. Technically a line like this would use the entire 16-bit range:
+            //uint16_t signedValue = ((uint16_t)((int16_t)originalValue - 0x0200) << 6) | ((originalValue >> 4) & 0x003F);
+            // In our case here however, that would not be preferred, since we can't restore the lost 6 bits of
+            // precision, and where we guess wrong we'd create very slight frequency distortions. It's better to leave
+            // the data as 10-bit and just shift it up, which doesn't technically preserve the relative mplitude of the
+            // signal, but we don't care about the overall amplitude in this case, it's the frequency we care about.
+            uint16_t signedValue = (uint16_t)((int16_t)originalValue - 0x0200) << 6;
+            writeBufferPointer[0] = (uint8_t)((uint16_t)signedValue & 0x00FF);
+            writeBufferPointer[1] = (uint8_t)(((uint16_t)signedValue & 0xFF00) >> 8);
+            writeBufferPointer += 2;
+        }
+    }
+    else if ((captureFormat == CaptureFormat::Unsigned10Bit) || (captureFormat == CaptureFormat::Unsigned10BitBlocked))
+    {
+        // Translate the data in the disk buffer to unsigned 10-bit packed data
+        for (size_t i = 0; i < readBufferSizeInBytes; i += 8)
+        {
+            // Get the original 4 10-bit words
+            uint16_t originalWords[4];
+            originalWords[0] = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
+            originalWords[1] = (uint16_t)readBufferPointer[2] | ((uint16_t)readBufferPointer[3] << 8);
+            originalWords[2] = (uint16_t)readBufferPointer[4] | ((uint16_t)readBufferPointer[5] << 8);
+            originalWords[3] = (uint16_t)readBufferPointer[6] | ((uint16_t)readBufferPointer[7] << 8);
+            readBufferPointer += 8;
+
+            // Convert into 5 bytes of packed 10-bit data
+            writeBufferPointer[0] = (uint8_t)((originalWords[0] & 0x03FC) >> 2);
+            writeBufferPointer[1] = (uint8_t)((originalWords[0] & 0x0003) << 6) | (uint8_t)((originalWords[1] & 0x03F0) >> 4);
+            writeBufferPointer[2] = (uint8_t)((originalWords[1] & 0x000F) << 4) | (uint8_t)((originalWords[2] & 0x03C0) >> 6);
+            writeBufferPointer[3] = (uint8_t)((originalWords[2] & 0x003F) << 2) | (uint8_t)((originalWords[3] & 0x0300) >> 8);
+            writeBufferPointer[4] = (uint8_t)((originalWords[3] & 0x00FF));
+            writeBufferPointer += 5;
+        }
+    }
+    else if (captureFormat == CaptureFormat::Unsigned10Bit4to1Decimation)
+    {
+        // Translate the data in the disk buffer to unsigned 10-bit packed data with 4:1 decimation
+        for (size_t i = 0; i < readBufferSizeInBytes; i += (8 * 4))
+        {
+            // Get the original 4 10-bit words
+            uint16_t originalWords[4];
+            originalWords[0] = (uint16_t)readBufferPointer[0 + 0] | ((uint16_t)readBufferPointer[1 + 0] << 8);
+            originalWords[1] = (uint16_t)readBufferPointer[2 + 4] | ((uint16_t)readBufferPointer[3 + 4] << 8);
+            originalWords[2] = (uint16_t)readBufferPointer[4 + 8] | ((uint16_t)readBufferPointer[5 + 8] << 8);
+            originalWords[3] = (uint16_t)readBufferPointer[6 + 12] | ((uint16_t)readBufferPointer[7 + 12] << 8);
+            readBufferPointer += 8 * 4;
+
+            // Convert into 5 bytes of packed 10-bit data
+            writeBufferPointer[0] = (uint8_t)((originalWords[0] & 0x03FC) >> 2);
+            writeBufferPointer[1] = (uint8_t)((originalWords[0] & 0x0003) << 6) | (uint8_t)((originalWords[1] & 0x03F0) >> 4);
+            writeBufferPointer[2] = (uint8_t)((originalWords[1] & 0x000F) << 4) | (uint8_t)((originalWords[2] & 0x03C0) >> 6);
+            writeBufferPointer[3] = (uint8_t)((originalWords[2] & 0x003F) << 2) | (uint8_t)((originalWords[3] & 0x0300) >> 8);
+            writeBufferPointer[4] = (uint8_t)((originalWords[3] & 0x00FF));
+            writeBufferPointer += 5;
+        }
+    }
+    else if (captureFormat == CaptureFormat::Unsigned16BitRaw)
+    {
+        // Copy the raw sample words, including the sideband data in the top 6 bits
+        memcpy(writeBufferPointer, readBufferPointer, readBufferSizeInBytes);
+    }
+    else
+    {
+        Log().Error("ConvertSamples(): Unknown capture format {0} specified", captureFormat);
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetConversionBufferSizeInBytes(CaptureFormat captureFormat) const
+{
+    // Determine how large a conversion buffer needs to be based on the disk buffer size and the capture format
+    size_t headerSizeInBytes = (captureFormat == CaptureFormat::Unsigned10BitBlocked) ? CaptureContainer::BlockHeaderSizeInBytes : 0;
+    return headerSizeInBytes + GetConvertedSizeInBytes(captureFormat, diskBufferSizeInBytes / 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetConvertedSizeInBytes(CaptureFormat captureFormat, size_t sampleCount)
+{
+    switch (captureFormat)
+    {
+    case CaptureFormat::Signed16Bit:
+        return sampleCount * 2;
+    case CaptureFormat::Unsigned10Bit:
+        return (sampleCount / 4) * 5;
+    case CaptureFormat::Unsigned10Bit4to1Decimation:
+        return (sampleCount / (4 * 4)) * 5;
+    case CaptureFormat::Unsigned10BitBlocked:
+        return CaptureContainer::PackedPayloadSizeInBytes(sampleCount);
+    case CaptureFormat::Unsigned16BitRaw:
+        return sampleCount * 2;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t UsbDeviceBase::GetOutputByteOffset(CaptureFormat captureFormat, uint64_t outputSampleOffset) const
+{
+    // Find the position of this sample in the output file, counting any samples inserted to fill gaps. Packed formats
+    // store groups of samples together, in which case this is the offset of the group holding the sample. A capture
+    // container is made up of variable size blocks, so the offset is found from the block currently being built.
+    switch (captureFormat)
+    {
+    case CaptureFormat::Signed16Bit:
+    case CaptureFormat::Unsigned16BitRaw:
+        return outputSampleOffset * 2;
+    case CaptureFormat::Unsigned10Bit:
+        return (outputSampleOffset / 4) * 5;
+    case CaptureFormat::Unsigned10Bit4to1Decimation:
+        return (outputSampleOffset / (4 * 4)) * 5;
+    case CaptureFormat::Unsigned10BitBlocked:
+        return captureContainerNextBlockOffset + CaptureContainer::BlockHeaderSizeInBytes + (((outputSampleOffset - captureContainerNextSampleIndex) / 4) * 5);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Gap filling methods
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::AddGapFill(size_t sampleIndex, uint64_t frameSampleOffset, uint64_t frameCounter, const uint8_t* sampleData)
+{
+    // Work out how many samples the frame counter says lie between the frame we expected and this one, and compare it
+    // against the number we actually received over that span. Anything received while sync was lost is kept in the
+    // output, so only the difference needs to be filled. A counter which went backwards, or a gap too large to be the
+    // result of dropped samples, can't be filled.
+    const uint32_t samplesPerFrame = (uint32_t)SidebandFrame::SamplesPerFrame;
+    const uint32_t samplesPerCounterValue = (uint32_t)SidebandFrame::CounterSamplesPerValue;
+    const uint32_t counterValuesPerFrame = (uint32_t)SidebandFrame::CounterValuesPerFrame;
+    uint64_t elapsedSampleCount = DiscontinuityMap::GetMissingSampleCount(gapFillExpectedFrameCounter, frameCounter, samplesPerFrame, counterValuesPerFrame, samplesPerCounterValue);
+    int64_t missingSampleCount = (int64_t)elapsedSampleCount - ((int64_t)frameSampleOffset - (int64_t)gapFillExpectedFrameSampleOffset);
+    if (missingSampleCount == 0)
+    {
+        return;
+    }
+    if ((missingSampleCount < 0) || ((uint64_t)missingSampleCount > MaxGapFillSampleCount))
+    {
+        if (gapNotFilledLogLimiter.ShouldLog(Log()))
+        {
+            Log().Warning("AddGapFill(): Frame counter jumped from 0x{0:X} to 0x{1:X} at sample {2}, which can't be filled, the output timeline is no longer aligned", gapFillExpectedFrameCounter, frameCounter, frameSampleOffset);
+        }
+        return;
+    }
+
+    // Record a fill of exactly the missing samples at the start of this frame. Any adjustment needed to suit the format
+    // of each output is made when the buffer is converted.
+    GapFill gapFill;
+    gapFill.sampleIndex = sampleIndex;
+    gapFill.sampleCount = (size_t)missingSampleCount;
+    gapFill.nextSampleValue = ((uint16_t)sampleData[gapFill.sampleIndex * 2] | ((uint16_t)sampleData[(gapFill.sampleIndex * 2) + 1] << 8)) & 0x03FF;
+    gapFill.previousSampleValue = gapFillPreviousSampleValue;
+    if (gapFill.sampleIndex > 0)
+    {
+        gapFill.previousSampleValue = ((uint16_t)sampleData[(gapFill.sampleIndex * 2) - 2] | ((uint16_t)sampleData[(gapFill.sampleIndex * 2) - 1] << 8)) & 0x03FF;
+    }
+    rfStatistics.filledSampleCount += gapFill.sampleCount;
+    gapFill.endFilledSampleCount = rfStatistics.filledSampleCount;
+    bufferGapFills.push_back(gapFill);
+    if (gapFilledLogLimiter.ShouldLog(Log()))
+    {
+        Log().Warning("AddGapFill(): Frame counter jumped from 0x{0:X} to 0x{1:X} at sample {2}, inserted {3} samples to fill the gap", gapFillExpectedFrameCounter, frameCounter, frameSampleOffset, gapFill.sampleCount);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetGapFillAlignmentSampleCount(CaptureFormat captureFormat)
+{
+    // The 10-bit packed formats store samples in groups, which a fill can't be inserted into the middle of. The raw
+    // format is never filled, as inserted samples would break up the 512-sample frames which carry the sideband data,
+    // which tools demultiplexing the sideband rely on. Every other format is filled exactly.
+    switch (captureFormat)
+    {
+    case CaptureFormat::Signed16Bit:
+        return 1;
+    case CaptureFormat::Unsigned10Bit:
+    case CaptureFormat::Unsigned10BitBlocked:
+        return 4;
+    case CaptureFormat::Unsigned10Bit4to1Decimation:
+        return 4 * 4;
+    case CaptureFormat::Unsigned16BitRaw:
+        return 0;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+uint64_t UsbDeviceBase::GetAlignedGapFillSampleCount(CaptureFormat captureFormat, uint64_t filledSampleCount)
+{
+    // Find how many samples have been inserted into an output in the target format, given the total number of samples
+    // filled in the capture. The total is rounded to the nearest whole group of samples rather than each fill, so the
+    // rounding error never builds up over the course of the capture.
+    size_t alignmentSampleCount = GetGapFillAlignmentSampleCount(captureFormat);
+    if (alignmentSampleCount == 0)
+    {
+        return 0;
+    }
+    return ((filledSampleCount + (alignmentSampleCount / 2)) / alignmentSampleCount) * alignmentSampleCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetGapFillSampleCount(CaptureFormat captureFormat, const GapFill& gapFill)
+{
+    return (size_t)(GetAlignedGapFillSampleCount(captureFormat, gapFill.endFilledSampleCount) - GetAlignedGapFillSampleCount(captureFormat, gapFill.endFilledSampleCount - gapFill.sampleCount));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetTotalGapFillSampleCount(CaptureFormat captureFormat, const std::vector<GapFill>& gapFills)
+{
+    if (gapFills.empty())
+    {
+        return 0;
+    }
+    uint64_t startFilledSampleCount = gapFills.front().endFilledSampleCount - gapFills.front().sampleCount;
+    return (size_t)(GetAlignedGapFillSampleCount(captureFormat, gapFills.back().endFilledSampleCount) - GetAlignedGapFillSampleCount(captureFormat, startFilledSampleCount));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::BuildGapFillSamples(const GapFill& gapFill, size_t fillSampleCount, size_t fillOffset, size_t sampleCount, uint8_t* outputData) const
+{
+    // Generate the requested part of the fill as 10-bit samples, in the same form as the stripped disk buffer data
+    uint8_t* writeBufferPointer = outputData;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        uint16_t sampleValue = 0;
+        if (captureGapFillMode == GapFillMode::MidScale)
+        {
+            sampleValue = 0x0200;
+        }
+        else if (captureGapFillMode == GapFillMode::Interpolate)
+        {
+            // Step linearly from the last sample before the gap to the first sample after it
+            int64_t valueDelta = (int64_t)gapFill.nextSampleValue - (int64_t)gapFill.previousSampleValue;
+            sampleValue = (uint16_t)((int64_t)gapFill.previousSampleValue + ((valueDelta * (int64_t)(fillOffset + i + 1)) / (int64_t)(fillSampleCount + 1)));
+        }
+        writeBufferPointer[0] = (uint8_t)(sampleValue & 0x00FF);
+        writeBufferPointer[1] = (uint8_t)((sampleValue & 0xFF00) >> 8);
+        writeBufferPointer += 2;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Discontinuity map methods
+//----------------------------------------------------------------------------------------------------------------------
+DiscontinuityMap::Record UsbDeviceBase::MakeDiscontinuityRecord(DiscontinuityMap::RecordType recordType, uint64_t sampleOffset, uint64_t expectedCounter, uint64_t actualCounter, uint64_t skippedSampleCount) const
+{
+    DiscontinuityMap::Record record;
+    record.recordType = recordType;
+    record.sampleOffset = sampleOffset;
+    record.outputByteOffset = GetOutputByteOffset(captureFormat, sampleOffset + GetAlignedGapFillSampleCount(captureFormat, rfStatistics.filledSampleCount));
+    record.expectedCounter = expectedCounter;
+    record.actualCounter = actualCounter;
+    record.skippedSampleCount = skippedSampleCount;
+    record.timestampInMicroseconds = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - captureStartTime).count();
+    return record;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::AddDiscontinuityRecord(const DiscontinuityMap::Record& record)
+{
+    // If records have been dropped since the last one was queued, try and queue a record marking where they were first.
+    // If there's still no room, this record is dropped as well.
+    if (!discontinuityMapEnabled)
+    {
+        return;
+    }
+    if (pendingDroppedDiscontinuityRecord)
+    {
+        if (!QueueDiscontinuityRecord(*pendingDroppedDiscontinuityRecord))
+        {
+            AddDroppedDiscontinuityRecord(record);
+            return;
+        }
+        pendingDroppedDiscontinuityRecord.reset();
+    }
+    if (!QueueDiscontinuityRecord(record))
+    {
+        AddDroppedDiscontinuityRecord(record);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::QueueDiscontinuityRecord(const DiscontinuityMap::Record& record)
+{
+    // Add the record to the queue for the discontinuity writer thread, if there's room. We never wait for the writer
+    // here.
+    uint64_t currentWritePosition = processingCounters.discontinuityRecordWritePosition.load(std::memory_order_relaxed);
+    if ((currentWritePosition - discontinuityWriterCounters.discontinuityRecordReadPosition.load(std::memory_order_acquire)) >= DiscontinuityRecordQueueLength)
+    {
+        return false;
+    }
+    discontinuityRecordQueue[(size_t)(currentWritePosition % DiscontinuityRecordQueueLength)] = record;
+    AddToOwnedCounter<uint64_t>(processingCounters.discontinuityRecordWritePosition, 1);
+    discontinuityRecordAvailable.test_and_set();
+    discontinuityRecordAvailable.notify_all();
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::AddDroppedDiscontinuityRecord(const DiscontinuityMap::Record& record)
+{
+    // Merge this record into the pending records dropped record, starting a new one if required
+    if (processingCounters.discontinuityDroppedRecordCount.load(std::memory_order_relaxed) == 0)
+    {
+        Log().Warning("AddDiscontinuityRecord(): Discontinuity writer has fallen behind, discontinuity records are being dropped");
+    }
+    AddToOwnedCounter<uint64_t>(processingCounters.discontinuityDroppedRecordCount, 1);
+    if (!pendingDroppedDiscontinuityRecord)
+    {
+        pendingDroppedDiscontinuityRecord = record;
+        pendingDroppedDiscontinuityRecord->recordType = DiscontinuityMap::RecordType::RecordsDropped;
+        pendingDroppedDiscontinuityRecord->droppedRecordCount = 1;
+        return;
+    }
+    DiscontinuityMap::Record& droppedRecord = *pendingDroppedDiscontinuityRecord;
+    droppedRecord.actualCounter = record.actualCounter;
+    droppedRecord.skippedSampleCount += record.skippedSampleCount;
+    if (droppedRecord.droppedRecordCount < std::numeric_limits<uint32_t>::max())
+    {
+        ++droppedRecord.droppedRecordCount;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::CompleteSyncLossRecord(uint64_t sampleOffset, uint64_t actualCounter)
+{
+    DiscontinuityMap::Record& record = *pendingSyncLossRecord;
+    record.actualCounter = actualCounter;
+    record.skippedSampleCount = (sampleOffset > record.sampleOffset) ? (sampleOffset - record.sampleOffset) : 0;
+    AddDiscontinuityRecord(record);
+    pendingSyncLossRecord.reset();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::DiscontinuityWriterThread()
+{
+    while (true)
+    {
+        // Wait for records to become available. Note that we clear the record available flag before checking the write
+        // position, so that a record which is queued after our check is guaranteed to wake us. Once we've been asked to
+        // stop, we keep going until every queued record has been written.
+        discontinuityRecordAvailable.clear();
+        if (discontinuityWriterCounters.discontinuityRecordReadPosition.load(std::memory_order_relaxed) == processingCounters.discontinuityRecordWritePosition.load(std::memory_order_acquire))
+        {
+            if (discontinuityWriterStopRequested.test())
+            {
+                break;
+            }
+            discontinuityRecordAvailable.wait(false);
+            continue;
+        }
+
+        // Append the queued records to the map. If a write fails, we stop writing, but keep draining the queue so the
+        // processing thread never sees it full.
+        if (!discontinuityWriteFailed.test() && !WriteQueuedDiscontinuityRecords())
+        {
+            Log().Error("DiscontinuityWriterThread(): Failed to write to the discontinuity map, no further records will be written");
+            discontinuityWriteFailed.test_and_set();
+        }
+        if (discontinuityWriteFailed.test())
+        {
+            discontinuityWriterCounters.discontinuityRecordReadPosition.store(processingCounters.discontinuityRecordWritePosition.load(std::memory_order_acquire), std::memory_order_release);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::WriteQueuedDiscontinuityRecords()
+{
+    // Append every record currently in the queue, returning each to the processing thread as it's written, then update
+    // the header so the file is complete up to this point.
+    uint64_t currentReadPosition = discontinuityWriterCounters.discontinuityRecordReadPosition.load(std::memory_order_relaxed);
+    uint64_t currentWritePosition = processingCounters.discontinuityRecordWritePosition.load(std::memory_order_acquire);
+    while (currentReadPosition != currentWritePosition)
+    {
+        if (!WriteDiscontinuityRecord(discontinuityRecordQueue[(size_t)(currentReadPosition % DiscontinuityRecordQueueLength)]))
+        {
+            return false;
+        }
+        ++currentReadPosition;
+        discontinuityWriterCounters.discontinuityRecordReadPosition.store(currentReadPosition, std::memory_order_release);
+    }
+    return WriteDiscontinuityMapHeader();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::WriteDiscontinuityRecord(const DiscontinuityMap::Record& record)
+{
+    uint8_t recordData[DiscontinuityMap::RecordSizeInBytes];
+    DiscontinuityMap::BuildRecord(recordData, record);
+    discontinuityMapFile.write((const char*)recordData, sizeof(recordData));
+    if (!discontinuityMapFile.good())
+    {
+        return false;
+    }
+    AddToOwnedCounter<uint64_t>(discontinuityWriterCounters.discontinuityRecordCount, 1);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::WriteDiscontinuityMapHeader()
+{
+    // Rewrite the header at the start of the file with the current record counts, and return to the end of the file
+    const uint32_t samplesPerFrame = (uint32_t)SidebandFrame::SamplesPerFrame;
+    const uint32_t samplesPerCounterValue = (uint32_t)SidebandFrame::CounterSamplesPerValue;
+    const uint32_t counterValuesPerFrame = (uint32_t)SidebandFrame::CounterValuesPerFrame;
+    uint8_t header[DiscontinuityMap::HeaderSizeInBytes];
+    DiscontinuityMap::BuildHeader(header, samplesPerFrame, counterValuesPerFrame, samplesPerCounterValue, discontinuityWriterCounters.discontinuityRecordCount.load(std::memory_order_relaxed), processingCounters.discontinuityDroppedRecordCount.load(std::memory_order_relaxed));
+    discontinuityMapFile.seekp(0);
+    discontinuityMapFile.write((const char*)header, sizeof(header));
+    discontinuityMapFile.seekp(0, std::ios::end);
+    return discontinuityMapFile.flush().good();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::FinishDiscontinuityMap()
+{
+    // If sync was lost and never reacquired, the loss runs to the end of the samples we processed. The processing and
+    // discontinuity writer threads have both stopped at this point, so we write any remaining records ourselves, ending
+    // with a record for any which were dropped since the last one was queued.
+    if (pendingSyncLossRecord)
+    {
+        CompleteSyncLossRecord(bufferStartSampleOffset, DiscontinuityMap::CounterNotReacquired);
+    }
+    bool writeSucceeded = !discontinuityWriteFailed.test() && WriteQueuedDiscontinuityRecords();
+    if (writeSucceeded && pendingDroppedDiscontinuityRecord)
+    {
+        writeSucceeded = WriteDiscontinuityRecord(*pendingDroppedDiscontinuityRecord);
+        pendingDroppedDiscontinuityRecord.reset();
+    }
+    writeSucceeded = writeSucceeded && WriteDiscontinuityMapHeader();
+    discontinuityMapFile.close();
+    if (processingCounters.discontinuityDroppedRecordCount > 0)
+    {
+        Log().Warning("FinishDiscontinuityMap(): {0} discontinuity records were dropped because the discontinuity writer fell behind", processingCounters.discontinuityDroppedRecordCount.load());
+    }
+    return writeSucceeded;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Log rate limiting methods
+//----------------------------------------------------------------------------------------------------------------------
+std::array<LogRateLimiter*, 7> UsbDeviceBase::GetProcessingLogRateLimiters()
+{
+    return { &syncSearchLogLimiter, &syncLockedLogLimiter, &syncNotFoundLogLimiter, &syncLostLogLimiter, &counterMismatchLogLimiter, &gapFilledLogLimiter, &gapNotFilledLogLimiter };
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::UpdateProcessingLogRateLimiters()
+{
+    // Report any suppressed messages from intervals which have ended, and total up the suppressed messages so far for
+    // the RF statistics.
+    uint64_t suppressedLogMessageCount = 0;
+    for (LogRateLimiter* logRateLimiter : GetProcessingLogRateLimiters())
+    {
+        logRateLimiter->Update(Log());
+        suppressedLogMessageCount += logRateLimiter->GetSuppressedCount();
+    }
+    rfStatistics.suppressedLogMessageCount = suppressedLogMessageCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::FlushProcessingLogRateLimiters()
+{
+    for (LogRateLimiter* logRateLimiter : GetProcessingLogRateLimiters())
+    {
+        logRateLimiter->Flush(Log());
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Capture container methods
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::WriteCaptureContainerBlockHeader(std::vector<uint8_t>& outputBuffer, uint64_t sequenceCounter, size_t frameOffset, bool sequenceCounterValid)
+{
+    // Build the header for this block. The sequence counter is the next counter value expected from the sample stream
+    // at the first sample in the block, and the frame offset is the position of that sample within its 512-sample
+    // frame. Together these allow a reader to align the block against the original sample stream.
+    CaptureContainer::BlockHeader header;
+    header.flags = (sequenceCounterValid ? CaptureContainer::BlockFlags::SequenceCounterValid : 0);
+    header.blockIndex = (uint32_t)captureContainerIndex.size();
+    header.frameOffset = (uint16_t)frameOffset;
+    header.sequenceCounter = sequenceCounter;
+    header.sampleCount = (uint32_t)((diskBufferSizeInBytes / 2) + GetTotalGapFillSampleCount(captureFormat, bufferGapFills));
+    header.payloadSizeInBytes = (uint32_t)(outputBuffer.size() - CaptureContainer::BlockHeaderSizeInBytes);
+    header.payloadCrc = CaptureContainer::Crc32c(outputBuffer.data() + CaptureContainer::BlockHeaderSizeInBytes, header.payloadSizeInBytes);
+    CaptureContainer::WriteBlockHeader(outputBuffer.data(), header);
+
+    // Record this block in the index for the trailer
+    captureContainerIndex.push_back(CaptureContainer::MakeIndexEntry(header, captureContainerNextBlockOffset, captureContainerNextSampleIndex));
+    captureContainerNextBlockOffset += outputBuffer.size();
+    captureContainerNextSampleIndex += header.sampleCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::WriteCaptureContainerTrailer()
+{
+    // Build the index and footer
+    std::vector<uint8_t> trailer;
+    CaptureContainer::BuildTrailer(captureContainerIndex, captureContainerNextBlockOffset, trailer);
+
+    // Append the trailer to the end of the output file
+#ifdef _WIN32
+    if (useWindowsOverlappedFileIo)
+    {
+        OVERLAPPED trailerOverlapped = {};
+        trailerOverlapped.Offset = 0xFFFFFFFF;
+        trailerOverlapped.OffsetHigh = 0xFFFFFFFF;
+        trailerOverlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        std::shared_ptr<void> eventHandleDeallocator(nullptr, [&](void*) { CloseHandle(trailerOverlapped.hEvent); });
+        BOOL writeFileReturn = WriteFile(windowsCaptureOutputFileHandle, trailer.data(), (DWORD)trailer.size(), NULL, &trailerOverlapped);
+        DWORD lastError = GetLastError();
+        if ((writeFileReturn == 0) && (lastError != ERROR_IO_PENDING))
+        {
+            Log().Error("WriteCaptureContainerTrailer(): WriteFile failed with error code {0}.", lastError);
+            return false;
+        }
+        DWORD bytesTransferred = 0;
+        BOOL getOverlappedResultReturn = GetOverlappedResult(windowsCaptureOutputFileHandle, &trailerOverlapped, &bytesTransferred, TRUE);
+        if ((getOverlappedResultReturn == 0) || (bytesTransferred != trailer.size()))
+        {
+            lastError = GetLastError();
+            Log().Error("WriteCaptureContainerTrailer(): GetOverlappedResult failed with error code {0}.", lastError);
+            return false;
+        }
+    }
+    else
+    {
+#endif
+        captureOutputFile.write((const char*)trailer.data(), trailer.size());
+        if (!captureOutputFile.good())
+        {
+            Log().Error("WriteCaptureContainerTrailer(): An error occurred when writing to the output file");
+            return false;
+        }
+#ifdef _WIN32
+    }
+#endif
+    captureOutputHasher.Update(trailer.data(), trailer.size());
+    Log().Info("WriteCaptureContainerTrailer(): Wrote index of {0} blocks at offset {1}", captureContainerIndex.size(), captureContainerNextBlockOffset);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Additional output methods
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetAdditionalOutputCount() const
+{
+    return additionalOutputs.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+UsbDeviceBase::CaptureFormat UsbDeviceBase::GetAdditionalOutputFormat(size_t outputIndex) const
+{
+    return additionalOutputs[outputIndex]->format;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::filesystem::path UsbDeviceBase::GetAdditionalOutputFilePath(size_t outputIndex) const
+{
+    return additionalOutputs[outputIndex]->filePath;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetAdditionalOutputFileSizeWrittenInBytes(size_t outputIndex) const
+{
+    return additionalOutputs[outputIndex]->fileSizeWrittenInBytes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::GetAdditionalOutputComplete(size_t outputIndex) const
+{
+    return !additionalOutputs[outputIndex]->writeFailed.test();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetAdditionalOutputDroppedBufferCount(size_t outputIndex) const
+{
+    return additionalOutputs[outputIndex]->droppedBufferCount;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetAdditionalOutputFileHash(size_t outputIndex) const
+{
+    return additionalOutputs[outputIndex]->outputHasher.GetDigestString();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetCaptureFormatName(CaptureFormat format)
+{
+    switch (format)
+    {
+    case CaptureFormat::Signed16Bit:
+        return "signed16Bit";
+    case CaptureFormat::Unsigned10Bit:
+        return "unsigned10BitPacked";
+    case CaptureFormat::Unsigned10Bit4to1Decimation:
+        return "unsigned10BitPacked4to1Decimation";
+    case CaptureFormat::Unsigned10BitBlocked:
+        return "unsigned10BitBlocked";
+    case CaptureFormat::Unsigned16BitRaw:
+        return "unsigned16BitRaw";
+    }
+    return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetCaptureFormatFileExtension(CaptureFormat format)
+{
+    switch (format)
+    {
+    case CaptureFormat::Signed16Bit:
+        return ".raw";
+    case CaptureFormat::Unsigned10Bit:
+        return ".lds";
+    case CaptureFormat::Unsigned10Bit4to1Decimation:
+        return ".cds";
+    case CaptureFormat::Unsigned10BitBlocked:
+        return ".ldc";
+    case CaptureFormat::Unsigned16BitRaw:
+        return ".ddr";
+    }
+    return ".bin";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+UsbDeviceBase::GapFillMode UsbDeviceBase::GetGapFillMode() const
+{
+    return captureGapFillMode;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetGapFillModeName(GapFillMode mode)
+{
+    switch (mode)
+    {
+    case GapFillMode::None:
+        return "none";
+    case GapFillMode::Zero:
+        return "zero";
+    case GapFillMode::MidScale:
+        return "midScale";
+    case GapFillMode::Interpolate:
+        return "interpolate";
+    }
+    return "unknown";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::AdditionalOutputWriterThread(AdditionalOutput& output)
+{
+    CAPTURE_TRACE_REGISTER_THREAD(captureTrace, "Additional output " + GetCaptureFormatName(output.format));
+
+    while (true)
+    {
+        // Wait for the next disk buffer to become available. Note that we clear the work available flag before checking
+        // the write position, so that work which is submitted after our check is guaranteed to wake us. Once we've been
+        // asked to stop, we keep going until every queued buffer has been written.
+        output.workAvailable.clear();
+        uint64_t currentReadPosition = output.workReadPosition.load(std::memory_order_relaxed);
+        if (currentReadPosition == output.workWritePosition.load(std::memory_order_acquire))
+        {
+            if (additionalOutputStopRequested.test())
+            {
+                break;
+            }
+            output.workAvailable.wait(false);
+            continue;
+        }
+
+        // Convert the buffer into the format for this output, and write it to the output file. If either step fails,
+        // we flag the output as failed so nothing more is written to it, but the main capture is allowed to continue
+        // unaffected. Queued buffers are still consumed, so the processing thread can see the queue drain.
+        const AdditionalOutputWork& work = output.workQueue[(size_t)(currentReadPosition % AdditionalOutputQueueLength)];
+        if (!output.writeFailed.test())
+        {
+            CAPTURE_TRACE_SCOPE(captureTrace, WriteAdditionalOutput, currentReadPosition);
+            if (!ConvertSampleData(work.sampleData.data(), work.sampleData.size() / 2, work.gapFills, output.format, output.gapFillSampleBuffer, output.conversionBuffer))
+            {
+                Log().Error("AdditionalOutputWriterThread(): Failed to convert the sample data for the output file {0}", output.filePath);
+                output.writeFailed.test_and_set();
+            }
+            else
+            {
+                output.outputFile.write((const char*)output.conversionBuffer.data(), output.conversionBuffer.size());
+                if (!output.outputFile.good())
+                {
+                    Log().Error("AdditionalOutputWriterThread(): An error occurred when writing to the output file {0}", output.filePath);
+                    output.writeFailed.test_and_set();
+                }
+                else
+                {
+                    output.outputHasher.Update(output.conversionBuffer.data(), output.conversionBuffer.size());
+                    AddToOwnedCounter(output.fileSizeWrittenInBytes, output.conversionBuffer.size());
+                }
+            }
+        }
+        output.workReadPosition.store(currentReadPosition + 1, std::memory_order_release);
+    }
+
+    // Report any buffers which didn't make it to the output file
+    if (output.droppedBufferCount > 0)
+    {
+        Log().Warning("AdditionalOutputWriterThread(): {0} disk buffers were not written to the output file {1}", output.droppedBufferCount.load(), output.filePath);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::SubmitAdditionalOutputWork(size_t diskBufferIndex)
+{
+    // Copy the disk buffer into the next free entry in the queue for each output. We never wait for a writer here. If a
+    // writer has fallen so far behind that its queue is full, that output is failed rather than holding up the main
+    // capture, and every buffer it misses from then on is counted.
+    const DiskBufferEntry& bufferEntry = diskBufferEntries[diskBufferIndex];
+    for (auto& output : additionalOutputs)
+    {
+        uint64_t currentWritePosition = output->workWritePosition.load(std::memory_order_relaxed);
+        if (!output->writeFailed.test() && ((currentWritePosition - output->workReadPosition.load(std::memory_order_acquire)) >= AdditionalOutputQueueLength))
+        {
+            Log().Error("SubmitAdditionalOutputWork(): The writer for the output file {0} has fallen behind, no further data will be written to it", output->filePath);
+            output->writeFailed.test_and_set();
+        }
+        if (output->writeFailed.test())
+        {
+            AddToOwnedCounter<size_t>(output->droppedBufferCount, 1);
+            continue;
+        }
+
+        // The raw 16-bit format is taken from the copy of the sample data made before the sideband was stripped from
+        // the disk buffer, with the sideband data intact. The gap fills are copied into storage reserved for them up
+        // front, so this never allocates.
+        AdditionalOutputWork& work = output->workQueue[(size_t)(currentWritePosition % AdditionalOutputQueueLength)];
+        const uint8_t* sampleData = (output->format == CaptureFormat::Unsigned16BitRaw) ? rawSampleBuffer.data() : bufferEntry.readBuffer.data();
+        memcpy(work.sampleData.data(), sampleData, work.sampleData.size());
+        work.gapFills.assign(bufferGapFills.begin(), bufferGapFills.end());
+
+        // Pass the buffer to the writer thread
+        AddToOwnedCounter<uint64_t>(output->workWritePosition, 1);
+        output->workAvailable.test_and_set();
+        output->workAvailable.notify_all();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::CloseAdditionalOutputFiles()
+{
+    for (auto& output : additionalOutputs)
+    {
+        if (output->outputFile.is_open())
+        {
+            output->outputFile.close();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Staging buffer methods
+//----------------------------------------------------------------------------------------------------------------------
+bool UsbDeviceBase::GetStagingBufferEnabled() const
+{
+    return useStagingBuffer;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetStagingBufferSizeInBytes() const
+{
+    return stagingBuffer.GetCapacityInBytes();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetStagingBufferOccupancyInBytes() const
+{
+    return stagingBuffer.GetOccupancyInBytes();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+size_t UsbDeviceBase::GetStagingBufferPeakOccupancyInBytes() const
+{
+    return stagingBuffer.GetPeakOccupancyInBytes();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::StagingFlushThread()
+{
+    CAPTURE_TRACE_REGISTER_THREAD(captureTrace, "Staging flush");
+
+    // Drain the staging buffer to the output file until the processing thread has finished and the buffer is empty. We
+    // write in moderately sized pieces, so the space is handed back to the processing thread promptly, without issuing
+    // an excessive number of small writes.
+    const size_t maxWriteSizeInBytes = 8 * 1024 * 1024;
+    const uint8_t* data = nullptr;
+    size_t sizeInBytes = 0;
+    while (stagingBuffer.Peek(data, sizeInBytes, maxWriteSizeInBytes))
+    {
+        CAPTURE_TRACE_SCOPE(captureTrace, WriteStaging, sizeInBytes);
+        auto writeStartTime = std::chrono::steady_clock::now();
+        captureOutputFile.write((const char*)data, sizeInBytes);
+        writeLatencyHistogram.Record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStartTime).count());
+        if (!captureOutputFile.good())
+        {
+            Log().Error("StagingFlushThread(): An error occurred when writing to the output file");
+            stagingFlushFailed.test_and_set();
+            stagingBuffer.Abort();
+            break;
+        }
+        stagingBuffer.Consume(sizeInBytes);
+        AddToOwnedCounter(stagingFlushCounters.fileSizeWrittenInBytes, sizeInBytes);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Integrity hash methods
+//----------------------------------------------------------------------------------------------------------------------
+StreamHasher::Algorithm UsbDeviceBase::GetHashAlgorithm() const
+{
+    return captureHashAlgorithm;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetHashAlgorithmName() const
+{
+    return captureOutputHasher.GetAlgorithmName();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetFileHash() const
+{
+    return captureOutputHasher.GetDigestString();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetAudioDataHash() const
+{
+    return audioDataHasher.GetDigestString();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+std::string UsbDeviceBase::GetAudio24DataHash() const
+{
+    return audio24DataHasher.GetDigestString();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::HashingThread()
+{
+    while (true)
+    {
+        // Wait for the processing thread to hand us the next set of buffers
+        hashWorkPending.wait(false);
+        if (hashingStopRequested.test())
+        {
+            break;
+        }
+
+        // Hash the capture data exactly as it was written to the output file. Audio data is hashed by the audio
+        // writer thread as it's written.
+        captureOutputHasher.Update(hashWorkCaptureData, hashWorkCaptureSizeInBytes);
+
+        // Flag that we've finished with the buffers
+        hashWorkPending.clear();
+        hashWorkPending.notify_all();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::SubmitHashWork(const std::vector<uint8_t>& captureData)
+{
+    if (captureHashAlgorithm == StreamHasher::Algorithm::None)
+    {
+        return;
+    }
+    hashWorkCaptureData = captureData.data();
+    hashWorkCaptureSizeInBytes = captureData.size();
+    hashWorkPending.test_and_set();
+    hashWorkPending.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::WaitForHashWork()
+{
+    hashWorkPending.wait(true);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Audio pipeline methods
+//----------------------------------------------------------------------------------------------------------------------
+UsbDeviceBase::AudioBatch* UsbDeviceBase::AcquireAudioBatch()
+{
+    // Return the next free batch in the queue, or null if the audio writer still holds every batch. We never wait for
+    // the audio writer here.
+    uint64_t currentWritePosition = processingCounters.audioBatchWritePosition.load(std::memory_order_relaxed);
+    if ((currentWritePosition - audioWriterCounters.audioBatchReadPosition.load(std::memory_order_acquire)) >= AudioBatchQueueLength)
+    {
+        return nullptr;
+    }
+    return &audioBatchQueue[(size_t)(currentWritePosition % AudioBatchQueueLength)];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::PublishAudioBatch()
+{
+    AddToOwnedCounter<uint64_t>(processingCounters.audioBatchWritePosition, 1);
+    audioBatchAvailable.test_and_set();
+    audioBatchAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::AudioWriterThread()
+{
+    CAPTURE_TRACE_REGISTER_THREAD(captureTrace, "Audio writer");
+
+    uint64_t expectedFrameCounter = 0;
+    bool expectedFrameCounterValid = false;
+    while (true)
+    {
+        // Wait for the next batch to become available. Note that we clear the batch available flag before checking the
+        // write position, so that a batch which is published after our check is guaranteed to wake us. Once we've been
+        // asked to stop, we keep going until every queued batch has been written.
+        audioBatchAvailable.clear();
+        uint64_t currentReadPosition = audioWriterCounters.audioBatchReadPosition.load(std::memory_order_relaxed);
+        if (currentReadPosition == processingCounters.audioBatchWritePosition.load(std::memory_order_acquire))
+        {
+            if (audioWriterStopRequested.test())
+            {
+                break;
+            }
+            audioBatchAvailable.wait(false);
+            continue;
+        }
+
+        // Write this batch, and return it to the processing thread.
+        CAPTURE_TRACE_SCOPE(captureTrace, WriteAudio, currentReadPosition);
+        WriteAudioBatch(audioBatchQueue[(size_t)(currentReadPosition % AudioBatchQueueLength)], expectedFrameCounter, expectedFrameCounterValid);
+        audioWriterCounters.audioBatchReadPosition.store(currentReadPosition + 1, std::memory_order_release);
+    }
+
+    // Report any audio which didn't make it to the output files
+    if (processingCounters.audioDroppedFrameCount > 0)
+    {
+        Log().Warning("AudioWriterThread(): {0} audio frames were dropped because the audio writer fell behind", processingCounters.audioDroppedFrameCount.load());
+    }
+    if (processingCounters.audioSegmentOverflowFrameCount > 0)
+    {
+        Log().Warning("AudioWriterThread(): {0} audio frames were dropped because frame sync was lost too often within a disk buffer", processingCounters.audioSegmentOverflowFrameCount.load());
+    }
+    if (audioMissingFrameCount > 0)
+    {
+        Log().Warning("AudioWriterThread(): {0} audio frames were missing from the captured data", audioMissingFrameCount);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::WriteAudioBatch(const AudioBatch& batch, uint64_t& expectedFrameCounter, bool& expectedFrameCounterValid)
+{
+    // The 48-bit frame counter advances once for every 8 samples in the counter region of each 512-sample frame.
+    const uint64_t counterValuesPerFrame = SidebandFrame::CounterValuesPerFrame;
+    const uint64_t counterMask = SidebandFrame::CounterMask;
+    const uint64_t maxPlausibleMissingFrameCount = 78125 * 10;
+    if (batch.frameCount == 0)
+    {
+        return;
+    }
+
+    // Hand the audio to the live preview first, so it isn't held up by the file writes below
+    if (audioPreviewStream.IsRunning())
+    {
+        audioPreviewStream.Push(!batch.frame24Data.empty() ? batch.frame24Data.data() : batch.frameData.data(), batch.frameCount);
+    }
+
+    // Use the frame counter of each segment in this batch to detect any frames which were lost since the previous
+    // segment, and build the alignment index records for the batch. Large or irregular jumps are the result of a resync
+    // rather than a run of dropped frames, so they aren't counted. If we're filling gaps, silence is inserted in place
+    // of the missing frames, so the audio stays aligned with the RF data. Only a batch which needs silence inserted is
+    // copied, starting at its first gap. Every other batch is written directly from the queue.
+    bool fillGaps = (captureGapFillMode != GapFillMode::None);
+    size_t batchFilledFrameCount = 0;
+    audioAlignmentRecordBuffer.clear();
+    for (size_t segmentIndex = 0; segmentIndex < batch.segments.size(); ++segmentIndex)
+    {
+        const AudioBatchSegment& segment = batch.segments[segmentIndex];
+        size_t segmentEndFrameIndex = ((segmentIndex + 1) < batch.segments.size()) ? batch.segments[segmentIndex + 1].firstFrameIndex : batch.frameCount;
+        uint64_t segmentAudioSampleIndex = audioAlignmentSampleIndex + segment.firstFrameIndex + batchFilledFrameCount;
+        if (expectedFrameCounterValid && (segment.frameCounter != expectedFrameCounter))
+        {
+            uint64_t counterDelta = (segment.frameCounter - expectedFrameCounter) & counterMask;
+            if (((counterDelta % counterValuesPerFrame) == 0) && ((counterDelta / counterValuesPerFrame) <= maxPlausibleMissingFrameCount))
+            {
+                size_t missingFrameCount = (size_t)(counterDelta / counterValuesPerFrame);
+                audioMissingFrameCount += missingFrameCount;
+                AddAudioAlignmentRecord(AudioAlignmentIndex::RecordType::Gap, (uint32_t)missingFrameCount, segmentAudioSampleIndex, segment.rfSampleOffset, expectedFrameCounter);
+                if (fillGaps && ((missingFrameCount * 512) <= MaxGapFillSampleCount))
+                {
+                    if (batchFilledFrameCount == 0)
+                    {
+                        audioGapFilledFrameData.assign(batch.frameData.begin(), batch.frameData.begin() + (!batch.frameData.empty() ? (segment.firstFrameIndex * 4) : 0));
+                        audioGapFilled24FrameData.assign(batch.frame24Data.begin(), batch.frame24Data.begin() + (!batch.frame24Data.empty() ? (segment.firstFrameIndex * 6) : 0));
+                    }
+                    audioGapFilledFrameData.resize(audioGapFilledFrameData.size() + (!batch.frameData.empty() ? (missingFrameCount * 4) : 0), 0);
+                    audioGapFilled24FrameData.resize(audioGapFilled24FrameData.size() + (!batch.frame24Data.empty() ? (missingFrameCount * 6) : 0), 0);
+                    batchFilledFrameCount += missingFrameCount;
+                    segmentAudioSampleIndex += missingFrameCount;
+                }
+            }
+            else
+            {
+                Log().Warning("WriteAudioBatch(): Audio frame counter discontinuity, expected 0x{0:X} but got 0x{1:X}", expectedFrameCounter, segment.frameCounter);
+                AddAudioAlignmentRecord(AudioAlignmentIndex::RecordType::Discontinuity, 0, segmentAudioSampleIndex, segment.rfSampleOffset, expectedFrameCounter);
             }
         }
-        
-        sampleIndex += samplesToProcess;
-        audioFrameOffset += samplesToProcess;
-        processedSampleCount += samplesToProcess;
-        
-        // Reset frame offset when we complete a frame
-        if (audioFrameOffset >= SAMPLES_PER_FRAME)
+        AddAudioAlignmentRecord(AudioAlignmentIndex::RecordType::Segment, (uint32_t)(segmentEndFrameIndex - segment.firstFrameIndex), segmentAudioSampleIndex, segment.rfSampleOffset, segment.frameCounter);
+        if (batchFilledFrameCount > 0)
         {
-            audioFrameOffset = 0;
+            if (!batch.frameData.empty())
+            {
+                audioGapFilledFrameData.insert(audioGapFilledFrameData.end(), batch.frameData.begin() + (segment.firstFrameIndex * 4), batch.frameData.begin() + (segmentEndFrameIndex * 4));
+            }
+            if (!batch.frame24Data.empty())
+            {
+                audioGapFilled24FrameData.insert(audioGapFilled24FrameData.end(), batch.frame24Data.begin() + (segment.firstFrameIndex * 6), batch.frame24Data.begin() + (segmentEndFrameIndex * 6));
+            }
         }
+        expectedFrameCounter = (segment.frameCounter + ((segmentEndFrameIndex - segment.firstFrameIndex) * counterValuesPerFrame)) & counterMask;
+        expectedFrameCounterValid = true;
     }
 
-    // Write audio buffers to WAV files if we have data and the corresponding audio source is enabled
-    if (!audioLeftBuffer.empty() && (captureAudioSource == AudioSource::Adc128s022 || captureAudioSource == AudioSource::Both))
+    // Write the frames to the audio output files. If a write fails, we stop writing audio for the remainder of the
+    // capture, but the RF capture is left to continue.
+    const std::vector<uint8_t>& frameData = (batchFilledFrameCount > 0) ? audioGapFilledFrameData : batch.frameData;
+    const std::vector<uint8_t>& frame24Data = (batchFilledFrameCount > 0) ? audioGapFilled24FrameData : batch.frame24Data;
+    size_t writtenFrameCount = batch.frameCount + batchFilledFrameCount;
+    audioFilledFrameCount += batchFilledFrameCount;
+    if (!audioWriteFailed.test())
     {
-        if (!WriteAudioFramesToWav(audioLeftBuffer, audioRightBuffer))
+        if (!frameData.empty())
         {
-            Log().Error("ProcessSequenceMarkersAndUpdateSampleMetrics(): Failed to write audio frames to WAV file");
-            return false;
+            if (!WriteAudioFramesToWav(frameData))
+            {
+                Log().Error("WriteAudioBatch(): Failed to write audio frames to WAV file, audio capture has been stopped");
+                audioWriteFailed.test_and_set();
+                return;
+            }
+            audioDataHasher.Update(frameData.data(), frameData.size());
+            audioFrameCount += writtenFrameCount;
         }
-        audioFrameCount += audioLeftBuffer.size();
-        
-        // Calculate amplitude (RMS) for ADC128s022 if it's the sole source
-        if (captureAudioSource == AudioSource::Adc128s022)
+        if (!frame24Data.empty())
         {
-            double sumSquares = 0.0;
-            for (size_t i = 0; i < audioLeftBuffer.size(); i++)
+            if (!WriteAudio24FramesToWav(frame24Data))
             {
-                sumSquares += (double)audioLeftBuffer[i] * (double)audioLeftBuffer[i];
-                sumSquares += (double)audioRightBuffer[i] * (double)audioRightBuffer[i];
+                Log().Error("WriteAudioBatch(): Failed to write 24-bit audio frames to WAV file, audio capture has been stopped");
+                audioWriteFailed.test_and_set();
+                return;
             }
-            double rms = std::sqrt(sumSquares / (audioLeftBuffer.size() * 2));
-            // Normalize to -1 to +1 range (12-bit max is 2047)
-            audioMeanAmplitude = rms / 2047.0;
+            audio24DataHasher.Update(frame24Data.data(), frame24Data.size());
+            audio24FrameCount += writtenFrameCount;
         }
-    }
-    if (!audio24LeftBuffer.empty() && (captureAudioSource == AudioSource::Pcm1802 || captureAudioSource == AudioSource::Both))
-    {
-        if (!WriteAudio24FramesToWav(audio24LeftBuffer, audio24RightBuffer))
+
+        // Write the alignment records for the frames we've just written
+        audioAlignmentOutputFile.write((const char*)audioAlignmentRecordBuffer.data(), audioAlignmentRecordBuffer.size());
+        if (!audioAlignmentOutputFile.good())
         {
-            Log().Error("ProcessSequenceMarkersAndUpdateSampleMetrics(): Failed to write 24-bit audio frames to WAV file");
-            return false;
+            Log().Error("WriteAudioBatch(): Failed to write to the audio alignment index, audio capture has been stopped");
+            audioWriteFailed.test_and_set();
+            return;
         }
-        audio24FrameCount += audio24LeftBuffer.size();
-        
-        // Calculate amplitude (RMS) for PCM1802 (preferred when Both is enabled)
-        if (captureAudioSource == AudioSource::Pcm1802 || captureAudioSource == AudioSource::Both)
+        audioAlignmentSampleIndex += writtenFrameCount;
+
+        // Produce any resampled outputs from the native rate audio
+        for (auto& output : resampledAudioOutputs)
+        {
+            WriteResampledAudio(*output, (output->bitsPerSample == 16) ? frameData : frame24Data, writtenFrameCount);
+        }
+
+        // If requested, periodically bring the WAV headers up to date and force everything written so far out to the
+        // disk, so that the audio files remain playable up to that point if the capture is interrupted.
+        auto currentTime = std::chrono::steady_clock::now();
+        if (captureSyncAudioHeaders && ((currentTime - lastAudioHeaderSyncTime) >= AudioHeaderSyncInterval))
         {
-            double sumSquares = 0.0;
-            for (size_t i = 0; i < audio24LeftBuffer.size(); i++)
+            lastAudioHeaderSyncTime = currentTime;
+            if (!SyncAudioWavHeaders())
             {
-                sumSquares += (double)audio24LeftBuffer[i] * (double)audio24LeftBuffer[i];
-                sumSquares += (double)audio24RightBuffer[i] * (double)audio24RightBuffer[i];
+                Log().Error("WriteAudioBatch(): Failed to update WAV file headers, audio capture has been stopped");
+                audioWriteFailed.test_and_set();
+                return;
             }
-            double rms = std::sqrt(sumSquares / (audio24LeftBuffer.size() * 2));
-            // Normalize to -1 to +1 range (24-bit max is 8388607)
-            audioMeanAmplitude = rms / 8388607.0;
         }
     }
 
-    // Save the expected counter value for the next buffer
-    savedSequenceCounter = expectedCounter;
-    return true;
+    // Compare the two converters, if both are recording
+    if (audioSourceAnalysisEnabled)
+    {
+        AnalyzeAudioSources(batch);
+    }
+
+    // Measure the levels of this batch. The PCM1802 is the primary source when both sources are enabled.
+    audioMeter.Process(!batch.frame24Data.empty() ? batch.frame24Data.data() : batch.frameData.data(), batch.frameCount);
+    if (captureAudioSource == AudioSource::Both)
+    {
+        audioSecondaryMeter.Process(batch.frameData.data(), batch.frameCount);
+    }
+    UpdateAudioStatistics();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
-bool UsbDeviceBase::VerifyTestSequence(size_t diskBufferIndex)
+void UsbDeviceBase::AddAudioAlignmentRecord(AudioAlignmentIndex::RecordType recordType, uint32_t frameCount, uint64_t audioSampleIndex, uint64_t rfSampleOffset, uint64_t frameCounter)
 {
-    // Retrieve the stored expected next sample value. If we haven't processed a buffer in this capture yet,
-    // latch the first sample value as the expected value so we can start from here.
-    DiskBufferEntry& bufferEntry = diskBufferEntries[diskBufferIndex];
-    uint16_t expectedValue = expectedNextTestDataValue.value_or((uint16_t)bufferEntry.readBuffer[0] | (uint16_t)((uint16_t)bufferEntry.readBuffer[1] << 8));
+    size_t recordOffset = audioAlignmentRecordBuffer.size();
+    audioAlignmentRecordBuffer.resize(recordOffset + AudioAlignmentIndex::RecordSizeInBytes);
+    AudioAlignmentIndex::BuildRecord(audioAlignmentRecordBuffer.data() + recordOffset, recordType, frameCount, audioSampleIndex, rfSampleOffset, frameCounter);
+}
 
-    // Verify each sample in the buffer matches our expected sequence progression
-    const uint8_t* readBufferPointer = bufferEntry.readBuffer.data();
-    for (size_t i = 0; i < bufferEntry.readBuffer.size(); i += 2)
+//----------------------------------------------------------------------------------------------------------------------
+void UsbDeviceBase::UpdateAudioStatistics()
+{
+    // Combine the channel levels for the overall sample statistics
+    int32_t minValue = std::numeric_limits<int32_t>::max();
+    int32_t maxValue = std::numeric_limits<int32_t>::min();
+    size_t clippedMinCount = 0;
+    size_t clippedMaxCount = 0;
+    double sumSquares = 0.0;
+    for (size_t channel = 0; channel < audioMeter.GetChannelCount(); ++channel)
     {
-        // Get the original 10-bit unsigned value from the disk data buffer
-        uint16_t actualValue = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
-        readBufferPointer += 2;
-
-        // If the actual value doesn't match our expected value, but this is the first time the test sequence
-        // has wrapped around to 0, check if this appears to be the wrap point for the sequence, and latch it.
-        // Valid wrapp points are either 1021 (newer FPGA firmware) or 1024 (older FPGA firmware).
-        if (!testDataMax.has_value() && (expectedValue != actualValue) && (actualValue == 0) && ((expectedValue == 1021) || (expectedValue == 1024)))
+        const AudioMeter::ChannelLevels& levels = audioMeter.GetChannelLevels(channel);
+        minValue = std::min(minValue, levels.minSampleValue);
+        maxValue = std::max(maxValue, levels.maxSampleValue);
+        clippedMinCount += levels.clippedMinSampleCount;
+        clippedMaxCount += levels.clippedMaxSampleCount;
+        sumSquares += levels.rms * levels.rms;
+    }
+    ++audioStatistics.updateCount;
+    audioStatistics.frameCount = audioFrameCount;
+    audioStatistics.fileSizeWrittenInBytes = audioFileSizeWrittenInBytes;
+    audioStatistics.frame24Count = audio24FrameCount;
+    audioStatistics.file24SizeWrittenInBytes = audio24FileSizeWrittenInBytes;
+    audioStatistics.missingFrameCount = audioMissingFrameCount;
+    audioStatistics.filledFrameCount = audioFilledFrameCount;
+    audioStatistics.recentMinSampleValue = minValue;
+    audioStatistics.recentMaxSampleValue = maxValue;
+    audioStatistics.recentClippedMinSampleCount = clippedMinCount;
+    audioStatistics.recentClippedMaxSampleCount = clippedMaxCount;
+    audioStatistics.minSampleValue = std::min(audioStatistics.minSampleValue, minValue);
+    audioStatistics.maxSampleValue = std::max(audioStatistics.maxSampleValue, maxValue);
+    audioStatistics.clippedMinSampleCount += clippedMinCount;
+    audioStatistics.clippedMaxSampleCount += clippedMaxCount;
+    audioStatistics.meanAmplitude = std::sqrt(sumSquares / audioMeter.GetChannelCount());
+    publishedAudioStatistics.Store(audioStatistics);
+
+    // Publish the level of each channel
+    ++audioLevels.updateCount;
+    for (size_t channel = 0; channel < audioLevels.channels.size(); ++channel)
+    {
+        const AudioMeter::ChannelLevels& levels = audioMeter.GetChannelLevels(channel);
+        audioLevels.channels[channel].peak = levels.peak;
+        audioLevels.channels[channel].rms = levels.rms;
+        audioLevels.channels[channel].truePeak = levels.truePeak;
+    }
+    audioLevels.secondaryChannelsPresent = (captureAudioSource == AudioSource::Both);
+    if (audioLevels.secondaryChannelsPresent)
+    {
+        for (size_t channel = 0; channel < audioLevels.secondaryChannels.size(); ++channel)
         {
-            testDataMax = expectedValue;
-            expectedValue = 1;
-            continue;
+            const AudioMeter::ChannelLevels& levels = audioSecondaryMeter.GetChannelLevels(channel);
+            audioLevels.secondaryChannels[channel].peak = levels.peak;
+            audioLevels.secondaryChannels[channel].rms = levels.rms;
+            audioLevels.secondaryChannels[channel].truePeak = levels.truePeak;
         }
+    }
+    publishedAudioLevels.Store(audioLevels);
+}
 
-        // If the expected value differs from the actual value, log an error.
-        if (expectedValue != actualValue)
-        {
-            // Data error
-            Log().Error("VerifyTestSequence(): Data error in test data verification! Expecting {0} but got {1}", expectedValue, actualValue);
-            return false;
-        }
+//----------------------------------------------------------------------------------------------------------------------
+// Audio processing methods
+//----------------------------------------------------------------------------------------------------------------------
 
-        // Calculate the value we expect to find for the next sample
-        ++expectedValue;
-        if (testDataMax.has_value() && (expectedValue == testDataMax))
-        {
-            expectedValue = 0;
-        }
-    }
+// The frame decoding itself is shared with the offline tools through SidebandFrame
+uint64_t UsbDeviceBase::ExtractSyncPattern(uint8_t* buffer, size_t byteOffset) const
+{
+    return SidebandFrame::ExtractSyncPattern(buffer, byteOffset);
+}
 
-    // Store the next expected sample value so we can check against the next buffer
-    expectedNextTestDataValue = expectedValue;
-    return true;
+uint64_t UsbDeviceBase::Extract48BitCounter(uint8_t* buffer, size_t byteOffset) const
+{
+    return SidebandFrame::Extract48BitCounter(buffer, byteOffset);
 }
 
-//----------------------------------------------------------------------------------------------------------------------
-bool UsbDeviceBase::ConvertRawSampleData(size_t diskBufferIndex, CaptureFormat captureFormat, std::vector<uint8_t>& outputBuffer) const
+// Write the WAV header at the start of an audio file, leaving the write position where it was
+bool UsbDeviceBase::WriteAudioWavHeader(std::ofstream& outputFile, uint32_t sampleRate, uint16_t bitsPerSample, uint64_t dataSizeInBytes)
 {
-    const DiskBufferEntry& bufferEntry = diskBufferEntries[diskBufferIndex];
-    const uint8_t* readBufferPointer = bufferEntry.readBuffer.data();
-    size_t readBufferSizeInBytes = bufferEntry.readBuffer.size();
+    uint8_t header[WavHeader::HeaderSizeInBytes];
+    WavHeader::Build(header, 2, sampleRate, bitsPerSample, dataSizeInBytes);
+    std::streampos currentPos = outputFile.tellp();
+    outputFile.seekp(0);
+    outputFile.write((const char*)header, sizeof(header));
+    if (currentPos > (std::streampos)sizeof(header))
+    {
+        outputFile.seekp(currentPos);
+    }
+    return outputFile.good();
+}
 
-    // Convert the data to the required format
-    uint8_t* writeBufferPointer = outputBuffer.data();
-    if (captureFormat == CaptureFormat::Signed16Bit)
+// Update the headers of the open audio files to cover the data written so far, and flush them to disk
+bool UsbDeviceBase::SyncAudioWavHeaders()
+{
+    if (audioOutputFile.is_open())
     {
-        // Translate the data in the disk buffer to scaled 16-bit signed data
-        for (size_t i = 0; i < readBufferSizeInBytes; i += 2)
+        if (!WriteAudioWavHeader(audioOutputFile, AudioSampleRate, 16, audioFileSizeWrittenInBytes) || !audioOutputFile.flush().good() || !FlushFileToDisk(audioFilePath, Log()))
         {
-            // Get the original 10-bit unsigned value from the disk data buffer
-            uint16_t originalValue = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
-            readBufferPointer += 2;
-
-            // Sign and scale the data to 16-bits. Technically a line like this would use the entire 16-bit range:
-            //uint16_t signedValue = ((uint16_t)((int16_t)originalValue - 0x0200) << 6) | ((originalValue >> 4) & 0x003F);
-            // In our case here however, that would not be preferred, since we can't restore the lost 6 bits of
-            // precision, and where we guess wrong we'd create very slight frequency distortions. It's better to leave
-            // the data as 10-bit and just shift it up, which doesn't technically preserve the relative mplitude of the
-            // signal, but we don't care about the overall amplitude in this case, it's the frequency we care about.
-            uint16_t signedValue = (uint16_t)((int16_t)originalValue - 0x0200) << 6;
-            writeBufferPointer[0] = (uint8_t)((uint16_t)signedValue & 0x00FF);
-            writeBufferPointer[1] = (uint8_t)(((uint16_t)signedValue & 0xFF00) >> 8);
-            writeBufferPointer += 2;
+            return false;
         }
     }
-    else if (captureFormat == CaptureFormat::Unsigned10Bit)
+    if (audio24OutputFile.is_open())
     {
-        // Translate the data in the disk buffer to unsigned 10-bit packed data
-        for (size_t i = 0; i < readBufferSizeInBytes; i += 8)
+        if (!WriteAudioWavHeader(audio24OutputFile, AudioSampleRate, 24, audio24FileSizeWrittenInBytes) || !audio24OutputFile.flush().good() || !FlushFileToDisk(audio24FilePath, Log()))
         {
-            // Get the original 4 10-bit words
-            uint16_t originalWords[4];
-            originalWords[0] = (uint16_t)readBufferPointer[0] | ((uint16_t)readBufferPointer[1] << 8);
-            originalWords[1] = (uint16_t)readBufferPointer[2] | ((uint16_t)readBufferPointer[3] << 8);
-            originalWords[2] = (uint16_t)readBufferPointer[4] | ((uint16_t)readBufferPointer[5] << 8);
-            originalWords[3] = (uint16_t)readBufferPointer[6] | ((uint16_t)readBufferPointer[7] << 8);
-            readBufferPointer += 8;
-
-            // Convert into 5 bytes of packed 10-bit data
-            writeBufferPointer[0] = (uint8_t)((originalWords[0] & 0x03FC) >> 2);
-            writeBufferPointer[1] = (uint8_t)((originalWords[0] & 0x0003) << 6) | (uint8_t)((originalWords[1] & 0x03F0) >> 4);
-            writeBufferPointer[2] = (uint8_t)((originalWords[1] & 0x000F) << 4) | (uint8_t)((originalWords[2] & 0x03C0) >> 6);
-            writeBufferPointer[3] = (uint8_t)((originalWords[2] & 0x003F) << 2) | (uint8_t)((originalWords[3] & 0x0300) >> 8);
-            writeBufferPointer[4] = (uint8_t)((originalWords[3] & 0x00FF));
-            writeBufferPointer += 5;
+            return false;
         }
     }
-    else if (captureFormat == CaptureFormat::Unsigned10Bit4to1Decimation)
+    if (audioAlignmentOutputFile.is_open())
     {
-        // Translate the data in the disk buffer to unsigned 10-bit packed data with 4:1 decimation
-        for (size_t i = 0; i < readBufferSizeInBytes; i += (8 * 4))
+        if (!audioAlignmentOutputFile.flush().good() || !FlushFileToDisk(audioAlignmentFilePath, Log()))
         {
-            // Get the original 4 10-bit words
-            uint16_t originalWords[4];
-            originalWords[0] = (uint16_t)readBufferPointer[0 + 0] | ((uint16_t)readBufferPointer[1 + 0] << 8);
-            originalWords[1] = (uint16_t)readBufferPointer[2 + 4] | ((uint16_t)readBufferPointer[3 + 4] << 8);
-            originalWords[2] = (uint16_t)readBufferPointer[4 + 8] | ((uint16_t)readBufferPointer[5 + 8] << 8);
-            originalWords[3] = (uint16_t)readBufferPointer[6 + 12] | ((uint16_t)readBufferPointer[7 + 12] << 8);
-            readBufferPointer += 8 * 4;
-
-            // Convert into 5 bytes of packed 10-bit data
-            writeBufferPointer[0] = (uint8_t)((originalWords[0] & 0x03FC) >> 2);
-            writeBufferPointer[1] = (uint8_t)((originalWords[0] & 0x0003) << 6) | (uint8_t)((originalWords[1] & 0x03F0) >> 4);
-            writeBufferPointer[2] = (uint8_t)((originalWords[1] & 0x000F) << 4) | (uint8_t)((originalWords[2] & 0x03C0) >> 6);
-            writeBufferPointer[3] = (uint8_t)((originalWords[2] & 0x003F) << 2) | (uint8_t)((originalWords[3] & 0x0300) >> 8);
-            writeBufferPointer[4] = (uint8_t)((originalWords[3] & 0x00FF));
-            writeBufferPointer += 5;
+            return false;
         }
     }
-    else
+    for (auto& output : resampledAudioOutputs)
     {
-        Log().Error("ConvertRawSampleData(): Unknown capture format {0} specified", captureFormat);
-        return false;
+        if (!output->writeFailed.test())
+        {
+            if (!WriteAudioWavHeader(output->outputFile, output->resampler.GetOutputSampleRate(), output->bitsPerSample, output->fileSizeWrittenInBytes) || !output->outputFile.flush().good() || !FlushFileToDisk(output->filePath, Log()))
+            {
+                return false;
+            }
+        }
+    }
+    if (audioBestOutputFile.is_open() && !audioBestWriteFailed.test())
+    {
+        if (!WriteAudioWavHeader(audioBestOutputFile, AudioSampleRate, 24, audioBestFileSizeWrittenInBytes) || !audioBestOutputFile.flush().good() || !FlushFileToDisk(audioBestFilePath, Log()))
+        {
+            return false;
+        }
     }
     return true;
 }
 
-//----------------------------------------------------------------------------------------------------------------------
-// Audio processing methods
-//----------------------------------------------------------------------------------------------------------------------
-
-// Extract 48-bit sync pattern from samples 0-7 (6 bits per sample from top 6 bits)
-uint64_t UsbDeviceBase::ExtractSyncPattern(uint8_t* buffer, size_t byteOffset) const
+// Resample a batch of audio frames, and write the result to the resampled output file
+void UsbDeviceBase::WriteResampledAudio(ResampledAudioOutput& output, const std::vector<uint8_t>& frameData, size_t frameCount)
 {
-    uint64_t pattern = 0;
-    for (size_t i = 0; i < 8; i++) {
-        size_t offset = byteOffset + i * 2;
-        uint8_t bits6 = (buffer[offset + 1] >> 2) & 0x3F;
-        pattern |= ((uint64_t)bits6 << (i * 6));
+    // If a previous write to this output failed, we've abandoned it, but the other audio outputs carry on.
+    if (output.writeFailed.test())
+    {
+        return;
     }
-    return pattern;
-}
 
-// Extract 12-bit audio value from two consecutive samples (6 bits each from top 6 bits)
-uint16_t UsbDeviceBase::Extract12BitAudio(uint8_t* buffer, size_t byteOffset, size_t sampleIndex) const
-{
-    // Extract 12 bits from 2 samples (6 bits each)
-    size_t offset1 = byteOffset + sampleIndex * 2;
-    size_t offset2 = byteOffset + (sampleIndex + 1) * 2;
-    uint8_t high6 = (buffer[offset1 + 1] >> 2) & 0x3F;
-    uint8_t low6 = (buffer[offset2 + 1] >> 2) & 0x3F;
-    return ((uint16_t)high6 << 6) | (uint16_t)low6;
+    output.resampler.Process(frameData.data(), frameCount, output.outputBuffer);
+    output.outputFile.write((const char*)output.outputBuffer.data(), output.outputBuffer.size());
+    if (!output.outputFile.good())
+    {
+        Log().Error("WriteResampledAudio(): Failed to write to resampled audio file {0}, output has been stopped", output.filePath);
+        output.writeFailed.test_and_set();
+        return;
+    }
+    output.fileSizeWrittenInBytes += output.outputBuffer.size();
 }
 
-// Extract 24-bit from four consecutive samples' top 6 bits
-uint32_t UsbDeviceBase::Extract24BitTop6x4(uint8_t* buffer, size_t byteOffset) const
+// Write out the remaining resampled audio, patch the headers, and close the resampled audio files
+void UsbDeviceBase::FinalizeResampledAudioFiles()
 {
-    uint8_t s0 = (buffer[byteOffset + 1] >> 2) & 0x3F;
-    uint8_t s1 = (buffer[byteOffset + 3] >> 2) & 0x3F;
-    uint8_t s2 = (buffer[byteOffset + 5] >> 2) & 0x3F;
-    uint8_t s3 = (buffer[byteOffset + 7] >> 2) & 0x3F;
-    return ((uint32_t)s0 << 18) | ((uint32_t)s1 << 12) | ((uint32_t)s2 << 6) | (uint32_t)s3;
+    for (auto& output : resampledAudioOutputs)
+    {
+        if (!output->outputFile.is_open())
+        {
+            continue;
+        }
+
+        // Drain the samples still held in the resampler
+        if (!output->writeFailed.test())
+        {
+            output->resampler.Flush(output->outputBuffer);
+            output->outputFile.write((const char*)output->outputBuffer.data(), output->outputBuffer.size());
+            output->fileSizeWrittenInBytes += output->outputBuffer.size();
+        }
+
+        // Patch the header with the final length of the data
+        if (!WriteAudioWavHeader(output->outputFile, output->resampler.GetOutputSampleRate(), output->bitsPerSample, output->fileSizeWrittenInBytes))
+        {
+            Log().Error("FinalizeResampledAudioFiles(): Failed to update the header of {0}", output->filePath);
+        }
+        output->outputFile.close();
+
+        Log().Info("Resampled audio file finalized: {0} ({1} bytes)", output->filePath.string(), output->fileSizeWrittenInBytes.load());
+    }
 }
 
-// Extract 48-bit counter value from 8 consecutive samples (6 bits per sample from top 6 bits)
-uint64_t UsbDeviceBase::Extract48BitCounter(uint8_t* buffer, size_t byteOffset) const
+// Pass a batch of audio frames from both converters to the audio source analyzer, and collect any completed windows
+void UsbDeviceBase::AnalyzeAudioSources(const AudioBatch& batch)
 {
-    uint64_t counter = 0;
-    for (size_t i = 0; i < 8; i++) {
-        size_t offset = byteOffset + i * 2;
-        uint8_t bits6 = (buffer[offset + 1] >> 2) & 0x3F;
-        counter |= ((uint64_t)bits6 << (i * 6));
+    if (batch.frameData.empty() || batch.frame24Data.empty())
+    {
+        return;
     }
-    return counter;
+    audioSourceAnalyzer.Process(batch.frameData.data(), batch.frame24Data.data(), batch.frameCount);
+    CollectAudioSourceAnalysis();
 }
 
-// Write audio frames to WAV file
-bool UsbDeviceBase::WriteAudioFramesToWav(const std::vector<int16_t>& leftSamples, const std::vector<int16_t>& rightSamples)
+// Publish the completed window results from the audio source analyzer, and write out any merged audio
+void UsbDeviceBase::CollectAudioSourceAnalysis()
 {
-    if (!audioOutputFile.is_open()) {
-        return false;
+    audioSourceAnalyzer.TakeResults(audioSourceAnalysisBatchResults, audioBestFrameData);
+    if (!audioSourceAnalysisBatchResults.empty())
+    {
+        std::unique_lock<std::mutex> lock(audioSourceAnalysisMutex);
+        audioSourceAnalysisResults.insert(audioSourceAnalysisResults.end(), audioSourceAnalysisBatchResults.begin(), audioSourceAnalysisBatchResults.end());
     }
 
-    if (leftSamples.size() != rightSamples.size()) {
-        Log().Error("WriteAudioFramesToWav(): Left and right sample counts don't match");
-        return false;
+    // If a previous write to the best source file failed, we've abandoned it, but the other audio outputs carry on.
+    if (!audioBestOutputFile.is_open() || audioBestFrameData.empty() || audioBestWriteFailed.test())
+    {
+        return;
     }
+    audioBestOutputFile.write((const char*)audioBestFrameData.data(), audioBestFrameData.size());
+    if (!audioBestOutputFile.good())
+    {
+        Log().Error("CollectAudioSourceAnalysis(): Failed to write to best source audio file {0}, output has been stopped", audioBestFilePath);
+        audioBestWriteFailed.test_and_set();
+        return;
+    }
+    audioBestFileSizeWrittenInBytes += audioBestFrameData.size();
+}
 
-    // Write audio frames as 16-bit stereo PCM, interleaved
-    for (size_t i = 0; i < leftSamples.size(); i++) {
-        // Scale 12-bit signed (-2048 to +2047) to 16-bit signed (-32768 to +32767)
-        // Multiply by 16 to use full 16-bit range
-        int16_t left16 = leftSamples[i] * 16;
-        int16_t right16 = rightSamples[i] * 16;
-
-        // Write little-endian
-        audioOutputFile.write(reinterpret_cast<const char*>(&left16), 2);
-        audioOutputFile.write(reinterpret_cast<const char*>(&right16), 2);
+// Patch the header of the best source audio file, and close it
+void UsbDeviceBase::FinalizeAudioBestWavFile()
+{
+    if (!WriteAudioWavHeader(audioBestOutputFile, AudioSampleRate, 24, audioBestFileSizeWrittenInBytes))
+    {
+        Log().Error("FinalizeAudioBestWavFile(): Failed to update the header of {0}", audioBestFilePath);
     }
+    audioBestOutputFile.close();
+
+    Log().Info("Best source audio file finalized: {0} ({1} bytes)", audioBestFilePath.string(), audioBestFileSizeWrittenInBytes.load());
+}
 
-    audioFileSizeWrittenInBytes += leftSamples.size() * 4; // 2 channels * 2 bytes per sample
+// Write packed 16-bit stereo frames (interleaved, little-endian) in a single operation
+bool UsbDeviceBase::WriteAudioFramesToWav(const std::vector<uint8_t>& frameData)
+{
+    if (!audioOutputFile.is_open()) {
+        return false;
+    }
 
+    audioOutputFile.write((const char*)frameData.data(), frameData.size());
+    audioFileSizeWrittenInBytes += frameData.size();
     return audioOutputFile.good();
 }
 
-// Write 24-bit stereo frames, interleaved (3 bytes per sample, little-endian)
-bool UsbDeviceBase::WriteAudio24FramesToWav(const std::vector<int32_t>& leftSamples, const std::vector<int32_t>& rightSamples)
+// Write packed 24-bit stereo frames (interleaved, 3 bytes per sample, little-endian) in a single operation
+bool UsbDeviceBase::WriteAudio24FramesToWav(const std::vector<uint8_t>& frameData)
 {
     if (!audio24OutputFile.is_open()) {
         return false;
     }
-    if (leftSamples.size() != rightSamples.size()) {
-        Log().Error("WriteAudio24FramesToWav(): Left and right sample counts don't match");
-        return false;
-    }
-    for (size_t i = 0; i < leftSamples.size(); i++) {
-        int32_t l = leftSamples[i];
-        int32_t r = rightSamples[i];
-        // Clamp to 24-bit signed range and write little-endian 24-bit
-        if (l > 0x7FFFFF) l = 0x7FFFFF; if (l < -0x800000) l = -0x800000;
-        if (r > 0x7FFFFF) r = 0x7FFFFF; if (r < -0x800000) r = -0x800000;
-        uint8_t lb0 = (uint8_t)(l & 0xFF);
-        uint8_t lb1 = (uint8_t)((l >> 8) & 0xFF);
-        uint8_t lb2 = (uint8_t)((l >> 16) & 0xFF);
-        uint8_t rb0 = (uint8_t)(r & 0xFF);
-        uint8_t rb1 = (uint8_t)((r >> 8) & 0xFF);
-        uint8_t rb2 = (uint8_t)((r >> 16) & 0xFF);
-        audio24OutputFile.write((const char*)&lb0, 1);
-        audio24OutputFile.write((const char*)&lb1, 1);
-        audio24OutputFile.write((const char*)&lb2, 1);
-        audio24OutputFile.write((const char*)&rb0, 1);
-        audio24OutputFile.write((const char*)&rb1, 1);
-        audio24OutputFile.write((const char*)&rb2, 1);
-    }
-    audio24FileSizeWrittenInBytes += leftSamples.size() * 6;
+
+    audio24OutputFile.write((const char*)frameData.data(), frameData.size());
+    audio24FileSizeWrittenInBytes += frameData.size();
     return audio24OutputFile.good();
 }
 
@@ -1619,6 +3499,12 @@ bool UsbDeviceBase::FinalizeAudioWavFile()
         return false;
     }
 
+    // Patch the header with the final length of the data
+    if (!WriteAudioWavHeader(audioOutputFile, AudioSampleRate, 16, audioFileSizeWrittenInBytes))
+    {
+        Log().Error("FinalizeAudioWavFile(): Failed to update the header of {0}", audioFilePath);
+    }
+
     audioOutputFile.flush();
     std::streampos currentPos = audioOutputFile.tellp();
     size_t totalFileSize = static_cast<size_t>(currentPos);
@@ -1626,7 +3512,7 @@ bool UsbDeviceBase::FinalizeAudioWavFile()
     audioOutputFile.close();
 
     Log().Info("Audio file finalized: {0} ({1} frames, {2} bytes)",
-        audioFilePath.string(), audioFrameCount.load(), totalFileSize);
+        audioFilePath.string(), audioFrameCount, totalFileSize);
 
     return true;
 }
@@ -1637,6 +3523,12 @@ bool UsbDeviceBase::FinalizeAudio24WavFile()
         return false;
     }
 
+    // Patch the header with the final length of the data
+    if (!WriteAudioWavHeader(audio24OutputFile, AudioSampleRate, 24, audio24FileSizeWrittenInBytes))
+    {
+        Log().Error("FinalizeAudio24WavFile(): Failed to update the header of {0}", audio24FilePath);
+    }
+
     audio24OutputFile.flush();
     std::streampos currentPos = audio24OutputFile.tellp();
     size_t totalFileSize = static_cast<size_t>(currentPos);
@@ -1644,7 +3536,7 @@ bool UsbDeviceBase::FinalizeAudio24WavFile()
     audio24OutputFile.close();
 
     Log().Info("24-bit audio file finalized: {0} ({1} frames, {2} bytes)",
-        audio24FilePath.string(), audio24FrameCount.load(), totalFileSize);
+        audio24FilePath.string(), audio24FrameCount, totalFileSize);
 
     return true;
 }
@@ -1675,6 +3567,43 @@ bool UsbDeviceBase::GetNextBufferSample(std::vector<uint8_t>& bufferSample)
 
 //----------------------------------------------------------------------------------------------------------------------
 // Utility methods
+//----------------------------------------------------------------------------------------------------------------------
+template<class T>
+void UsbDeviceBase::AddToOwnedCounter(std::atomic<T>& counter, T incrementValue)
+{
+    // The calling thread is the only writer of this counter, so there's no need for the locked read-modify-write an
+    // increment would use. The release store ensures anything written before the update is visible to a reader which
+    // observes the new value.
+    counter.store(counter.load(std::memory_order_relaxed) + incrementValue, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Returns the CPU time used so far by the given thread, or zero if it can't be retrieved
+std::chrono::nanoseconds UsbDeviceBase::GetThreadCpuTime(std::thread& thread)
+{
+#ifdef _WIN32
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if (GetThreadTimes((HANDLE)thread.native_handle(), &creationTime, &exitTime, &kernelTime, &userTime) == 0)
+    {
+        return std::chrono::nanoseconds(0);
+    }
+    uint64_t kernelTimeIn100Nanoseconds = ((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+    uint64_t userTimeIn100Nanoseconds = ((uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+    return std::chrono::nanoseconds((kernelTimeIn100Nanoseconds + userTimeIn100Nanoseconds) * 100);
+#else
+    clockid_t threadClockId;
+    timespec threadCpuTime;
+    if ((pthread_getcpuclockid(thread.native_handle(), &threadClockId) != 0) || (clock_gettime(threadClockId, &threadCpuTime) != 0))
+    {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::seconds(threadCpuTime.tv_sec) + std::chrono::nanoseconds(threadCpuTime.tv_nsec);
+#endif
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 bool UsbDeviceBase::LockMemoryBufferIntoPhysicalMemory(void* baseAddress, size_t sizeInBytes)
 {
@@ -1905,4 +3834,4 @@ void UsbDeviceBase::RestoreCurrentThreadPriority(const ThreadPriorityRestoreInfo
         Log().Warning("RestoreCurrentThreadPriority: Unable to restore original scheduling policy");
     }
 }
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,21 @@
 #pragma once
 #include "ILogger.h"
+#include "AudioAlignmentIndex.h"
+#include "AudioMeter.h"
+#include "AudioPreviewStream.h"
+#include "AudioResampler.h"
+#include "AudioSourceAnalyzer.h"
+#include "CaptureContainer.h"
+#include "CaptureTrace.h"
+#include "DiscontinuityMap.h"
+#include "Histogram.h"
+#include "LogRateLimiter.h"
+#include "SeqLock.h"
+#include "SidebandFrame.h"
+#include "StagingBuffer.h"
+#include "StreamHasher.h"
+#include "WavHeader.h"
+#include <array>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
@@ -7,6 +23,7 @@
 #include <fstream>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 #include <atomic>
 #include <chrono>
@@ -24,6 +41,8 @@ public:
         Signed16Bit,
         Unsigned10Bit,
         Unsigned10Bit4to1Decimation,
+        Unsigned10BitBlocked,
+        Unsigned16BitRaw,
     };
     enum class AudioSource
     {
@@ -32,6 +51,13 @@ public:
         Adc128s022,
         Both,
     };
+    enum class GapFillMode
+    {
+        None,
+        Zero,
+        MidScale,
+        Interpolate,
+    };
     enum class TransferResult
     {
         Running,
@@ -46,6 +72,129 @@ public:
         VerificationError,
         ProgramError,
         ForcedAbort,
+        MemoryAllocationFailure,
+    };
+
+public:
+    // Structures
+    struct AudioChannelLevels
+    {
+        double peak = 0.0;
+        double rms = 0.0;
+        double truePeak = 0.0;
+    };
+    // The primary channel levels are for the PCM1802 if it's being captured, otherwise the ADC128S022. When both sources
+    // are being captured, the ADC128S022 is measured as well, and its levels are reported as the secondary channels.
+    struct AudioLevels
+    {
+        uint64_t updateCount = 0;
+        std::array<AudioChannelLevels, 2> channels;
+        bool secondaryChannelsPresent = false;
+        std::array<AudioChannelLevels, 2> secondaryChannels;
+    };
+    struct CaptureStatsSnapshot
+    {
+        // RF sample statistics, published by the processing thread once per disk buffer
+        struct RfStatistics
+        {
+            uint64_t updateCount = 0;
+            size_t processedSampleCount = 0;
+            uint16_t minSampleValue = 0;
+            uint16_t maxSampleValue = 0;
+            size_t clippedMinSampleCount = 0;
+            size_t clippedMaxSampleCount = 0;
+            uint16_t recentMinSampleValue = 0;
+            uint16_t recentMaxSampleValue = 0;
+            size_t recentClippedMinSampleCount = 0;
+            size_t recentClippedMaxSampleCount = 0;
+            size_t syncLossCount = 0;
+            size_t counterMismatchCount = 0;
+            size_t filledSampleCount = 0;
+            uint64_t suppressedLogMessageCount = 0;
+        };
+
+        // Audio statistics, published by the audio writer thread once per batch. The sample statistics are for the
+        // PCM1802 when both sources are enabled, otherwise whichever is enabled.
+        struct AudioStatistics
+        {
+            uint64_t updateCount = 0;
+            size_t frameCount = 0;
+            size_t fileSizeWrittenInBytes = 0;
+            size_t frame24Count = 0;
+            size_t file24SizeWrittenInBytes = 0;
+            size_t missingFrameCount = 0;
+            size_t filledFrameCount = 0;
+            int32_t minSampleValue = 0;
+            int32_t maxSampleValue = 0;
+            size_t clippedMinSampleCount = 0;
+            size_t clippedMaxSampleCount = 0;
+            int32_t recentMinSampleValue = 0;
+            int32_t recentMaxSampleValue = 0;
+            size_t recentClippedMinSampleCount = 0;
+            size_t recentClippedMaxSampleCount = 0;
+            double meanAmplitude = 0.0;
+        };
+
+        // Transfer progress. These are each maintained by a different thread, so they're read individually when the
+        // snapshot is taken.
+        size_t transferCount = 0;
+        size_t diskBufferWrittenCount = 0;
+        size_t fileSizeWrittenInBytes = 0;
+        size_t audioDroppedFrameCount = 0;
+        size_t audioSegmentOverflowFrameCount = 0;
+
+        RfStatistics rf;
+        AudioStatistics audio;
+    };
+    struct PipelineHistograms
+    {
+        // The number of disk buffers, and the fewest which were free at any point in the capture
+        size_t diskBufferCount = 0;
+        size_t minFreeDiskBufferCount = 0;
+
+        // The number of full disk buffers waiting for processing as each USB transfer completes, the time between USB
+        // transfer completions, and the time taken by each write to the capture file.
+        Histogram::Snapshot diskBufferQueueDepth;
+        Histogram::Snapshot usbCompletionIntervalInMicroseconds;
+        Histogram::Snapshot writeLatencyInMicroseconds;
+    };
+    struct CaptureSettings
+    {
+        // The output files, and the device to capture from
+        std::filesystem::path filePath;
+        CaptureFormat format = CaptureFormat::Signed16Bit;
+        std::vector<CaptureFormat> additionalFormats;
+        AudioSource audioSource = AudioSource::None;
+        std::string preferredDevicePath;
+        bool isTestMode = false;
+
+        // Buffering and file IO
+        bool useSmallUsbTransfers = false;
+        bool useAsyncFileIo = false;
+        size_t usbTransferQueueSizeInBytes = 0;
+        size_t diskBufferQueueSizeInBytes = 0;
+        size_t stagingBufferSizeInBytes = 0;
+
+        // Handling of dropped samples, and integrity checking
+        bool stopOnDroppedSamples = false;
+        GapFillMode gapFillMode = GapFillMode::None;
+        StreamHasher::Algorithm hashAlgorithm = StreamHasher::Algorithm::None;
+
+        // Audio outputs
+        bool syncAudioHeaders = false;
+        std::vector<uint32_t> audioResampleRates;
+        std::filesystem::path audioPreviewPath;
+        bool writeBestAudio = false;
+    };
+    struct ThroughputSample
+    {
+        // The time the sample was taken, and the activity of the capture over the interval since the previous sample
+        std::chrono::steady_clock::time_point sampleTime;
+        uint64_t transferredSizeInBytes = 0;
+        uint64_t writtenSizeInBytes = 0;
+        size_t syncLossCount = 0;
+        size_t minFreeDiskBufferCount = 0;
+        std::chrono::microseconds processingCpuTime = {};
     };
 
 public:
@@ -60,41 +209,65 @@ public:
     void SendConfigurationCommand(const std::string& preferredDevicePath, bool testMode);
 
     // Capture methods
-    bool StartCapture(const std::filesystem::path& filePath, CaptureFormat format, AudioSource audioSource, const std::string& preferredDevicePath, bool isTestMode, bool useSmallUsbTransfers, bool useAsyncFileIo, size_t usbTransferQueueSizeInBytes, size_t diskBufferQueueSizeInBytes, bool stopOnDroppedSamples);
+    bool StartCapture(const CaptureSettings& settings);
     void StopCapture();
     bool GetTransferInProgress() const;
     TransferResult GetTransferResult() const;
-    size_t GetNumberOfTransfers() const;
-    size_t GetNumberOfDiskBuffersWritten() const;
-    size_t GetFileSizeWrittenInBytes() const;
-    size_t GetProcessedSampleCount() const;
-    size_t GetMinSampleValue() const;
-    size_t GetMaxSampleValue() const;
-    size_t GetClippedMinSampleCount() const;
-    size_t GetClippedMaxSampleCount() const;
-    size_t GetRecentMinSampleValue() const;
-    size_t GetRecentMaxSampleValue() const;
-    size_t GetRecentClippedMinSampleCount() const;
-    size_t GetRecentClippedMaxSampleCount() const;
+    static std::string GetTransferResultName(TransferResult result);
+    CaptureFormat GetCaptureFormat() const;
     bool GetTransferHadSequenceNumbers() const;
-    size_t GetSyncLossCount() const;
+    CaptureStatsSnapshot GetStatsSnapshot() const;
+    PipelineHistograms GetPipelineHistograms() const;
+    std::vector<ThroughputSample> GetThroughputSamples() const;
+    std::filesystem::path GetDiscontinuityMapFilePath() const;
+    size_t GetDiscontinuityRecordCount() const;
+    size_t GetDiscontinuityDroppedRecordCount() const;
+
+    // Additional output methods
+    size_t GetAdditionalOutputCount() const;
+    CaptureFormat GetAdditionalOutputFormat(size_t outputIndex) const;
+    std::filesystem::path GetAdditionalOutputFilePath(size_t outputIndex) const;
+    size_t GetAdditionalOutputFileSizeWrittenInBytes(size_t outputIndex) const;
+    bool GetAdditionalOutputComplete(size_t outputIndex) const;
+    size_t GetAdditionalOutputDroppedBufferCount(size_t outputIndex) const;
+    std::string GetAdditionalOutputFileHash(size_t outputIndex) const;
+    static std::string GetCaptureFormatName(CaptureFormat format);
+    static std::string GetCaptureFormatFileExtension(CaptureFormat format);
+    GapFillMode GetGapFillMode() const;
+    static std::string GetGapFillModeName(GapFillMode mode);
+
+    // Staging buffer methods
+    bool GetStagingBufferEnabled() const;
+    size_t GetStagingBufferSizeInBytes() const;
+    size_t GetStagingBufferOccupancyInBytes() const;
+    size_t GetStagingBufferPeakOccupancyInBytes() const;
 
     // Audio capture methods
-    size_t GetAudioFrameCount() const;
-    size_t GetAudioFileSizeWrittenInBytes() const;
-    size_t GetAudio24FrameCount() const;
-    size_t GetAudio24FileSizeWrittenInBytes() const;
+    bool GetAudioWriteFailed() const;
+    std::filesystem::path GetAudioAlignmentFilePath() const;
+    bool GetAudioPreviewConnected() const;
+    uint64_t GetAudioPreviewDroppedFrameCount() const;
+    size_t GetResampledAudioOutputCount() const;
+    uint32_t GetResampledAudioOutputSampleRate(size_t outputIndex) const;
+    std::filesystem::path GetResampledAudioOutputFilePath(size_t outputIndex) const;
+    size_t GetResampledAudioOutputFileSizeWrittenInBytes(size_t outputIndex) const;
+    bool GetResampledAudioOutputComplete(size_t outputIndex) const;
+    bool GetAudioSourceAnalysisEnabled() const;
+    std::vector<AudioSourceAnalyzer::WindowResult> GetAudioSourceAnalysis() const;
+    std::filesystem::path GetAudioBestFilePath() const;
+    size_t GetAudioBestFileSizeWrittenInBytes() const;
+
+    // Integrity hash methods
+    StreamHasher::Algorithm GetHashAlgorithm() const;
+    std::string GetHashAlgorithmName() const;
+    std::string GetFileHash() const;
+    // The audio hashes cover the sample data chunk of each wave file only, not the header, as the header isn't final
+    // until the capture ends. The data chunk starts WavHeader::HeaderSizeInBytes into the file.
+    std::string GetAudioDataHash() const;
+    std::string GetAudio24DataHash() const;
     
     // Audio statistics methods
-    int32_t GetAudioMinSampleValue() const;
-    int32_t GetAudioMaxSampleValue() const;
-    size_t GetAudioClippedMinSampleCount() const;
-    size_t GetAudioClippedMaxSampleCount() const;
-    int32_t GetAudioRecentMinSampleValue() const;
-    int32_t GetAudioRecentMaxSampleValue() const;
-    size_t GetAudioRecentClippedMinSampleCount() const;
-    size_t GetAudioRecentClippedMaxSampleCount() const;
-    double GetAudioMeanAmplitude() const;
+    AudioLevels GetAudioLevels() const;
 
     // Buffer sampling methods
     void QueueBufferSampleRequest(size_t requestedSampleLengthInBytes);
@@ -126,6 +299,9 @@ protected:
     // Log methods
     const ILogger& Log() const;
 
+    // Trace methods
+    CaptureTrace& Trace();
+
     // Device methods
     virtual bool DeviceConnected() const = 0;
     virtual bool ConnectToDevice(const std::string& preferredDevicePath) = 0;
@@ -143,7 +319,8 @@ protected:
     size_t GetUsbTransferQueueSizeInBytes() const;
     bool GetUseSmallUsbTransfers() const;
     void SetUsbTransferFinished(TransferResult result);
-    void AddCompletedTransferCount(size_t incrementCount);
+    void AddCompletedTransferCount(size_t incrementCount, size_t transferSizeInBytes);
+    void RecordDiskBufferFilled(size_t diskBufferIndex);
 
     // Utility methods
     bool LockMemoryBufferIntoPhysicalMemory(void* baseAddress, size_t sizeInBytes);
@@ -152,6 +329,16 @@ protected:
     void RestoreCurrentThreadPriority(const ThreadPriorityRestoreInfo& priorityRestoreInfo);
 
 private:
+    // Constants
+    static const uint32_t AudioSampleRate = SidebandFrame::AudioSampleRate;
+    static constexpr std::chrono::seconds AudioHeaderSyncInterval = std::chrono::seconds(10);
+    static const size_t AudioSourceAnalysisWindowFrameCount = AudioSampleRate;
+    static const size_t CacheLineSizeInBytes = 64;
+    static constexpr std::chrono::seconds ThroughputSampleInterval = std::chrono::seconds(1);
+    static constexpr std::chrono::milliseconds ThroughputSamplePollInterval = std::chrono::milliseconds(50);
+    static const size_t MaxGapFillSampleCount = 40 * 1000 * 1000;  // One second of RF samples
+    static const size_t GapFillChunkSampleCount = 64 * 1024;
+
     // Enumerations
     enum class SequenceState
     {
@@ -168,29 +355,188 @@ private:
         int originalPriorityClass;
 #endif
     };
+    struct ResampledAudioOutput
+    {
+        uint16_t bitsPerSample;
+        std::filesystem::path filePath;
+        std::ofstream outputFile;
+        AudioResampler resampler;
+        std::vector<uint8_t> outputBuffer;
+        std::atomic<size_t> fileSizeWrittenInBytes = 0;
+        std::atomic_flag writeFailed;
+    };
+    struct AudioBatchSegment
+    {
+        size_t firstFrameIndex;
+        uint64_t frameCounter;
+        uint64_t rfSampleOffset;
+    };
+    struct GapFill
+    {
+        size_t sampleIndex;
+        size_t sampleCount;
+        uint64_t endFilledSampleCount;  // Total samples filled in the capture, up to and including this fill
+        uint16_t previousSampleValue;
+        uint16_t nextSampleValue;
+    };
+    struct AdditionalOutputWork
+    {
+        std::vector<uint8_t> sampleData;  // Copy of the disk buffer samples, in the form this output is converted from
+        std::vector<GapFill> gapFills;
+    };
+    struct AdditionalOutput
+    {
+        CaptureFormat format;
+        std::filesystem::path filePath;
+        std::ofstream outputFile;
+        std::unique_ptr<AdditionalOutputWork[]> workQueue;
+        std::vector<uint8_t> conversionBuffer;       // Only used by the writer thread
+        std::vector<uint8_t> gapFillSampleBuffer;    // Only used by the writer thread
+        StreamHasher outputHasher;
+        std::thread writerThread;
+        alignas(CacheLineSizeInBytes) std::atomic<uint64_t> workWritePosition = 0;  // Owned by the processing thread
+        std::atomic<size_t> droppedBufferCount = 0;                                 // Owned by the processing thread
+        alignas(CacheLineSizeInBytes) std::atomic<uint64_t> workReadPosition = 0;   // Owned by the writer thread
+        std::atomic<size_t> fileSizeWrittenInBytes = 0;                             // Owned by the writer thread
+        std::atomic_flag workAvailable;
+        std::atomic_flag writeFailed;
+    };
+    struct AudioBatch
+    {
+        size_t frameCount = 0;
+        std::vector<AudioBatchSegment> segments;  // Runs of consecutive RF frames which the audio frames came from
+        std::vector<uint8_t> frameData;    // Interleaved 16-bit little-endian stereo frames from the ADC128S022
+        std::vector<uint8_t> frame24Data;  // Interleaved 24-bit little-endian stereo frames from the PCM1802
+    };
+    struct ThroughputTotals
+    {
+        std::chrono::steady_clock::time_point sampleTime;
+        uint64_t transferredSizeInBytes = 0;
+        uint64_t writtenSizeInBytes = 0;
+        size_t syncLossCount = 0;
+        std::chrono::nanoseconds processingCpuTime = {};
+        Histogram::Snapshot diskBufferQueueDepth;
+    };
+
+    // Counter blocks. Each block is only written by a single thread, and other threads only load from it, so the
+    // writer can update its counters without an atomic read-modify-write. Each block is given its own cache line, so
+    // that one thread updating its counters doesn't evict the counters of another thread from its cache.
+    struct alignas(CacheLineSizeInBytes) UsbTransferCounters
+    {
+        std::atomic<size_t> transferCount = 0;
+        std::atomic<uint64_t> transferredSizeInBytes = 0;
+        std::atomic<size_t> diskBufferFilledCount = 0;
+    };
+    struct alignas(CacheLineSizeInBytes) ProcessingCounters
+    {
+        std::atomic<size_t> diskBufferWrittenCount = 0;
+        std::atomic<size_t> fileSizeWrittenInBytes = 0;  // Only updated when the staging buffer isn't in use
+        std::atomic<uint64_t> audioBatchWritePosition = 0;
+        std::atomic<size_t> audioDroppedFrameCount = 0;
+        std::atomic<size_t> audioSegmentOverflowFrameCount = 0;
+        std::atomic<uint64_t> discontinuityRecordWritePosition = 0;
+        std::atomic<uint64_t> discontinuityDroppedRecordCount = 0;
+    };
+    struct alignas(CacheLineSizeInBytes) StagingFlushCounters
+    {
+        std::atomic<size_t> fileSizeWrittenInBytes = 0;
+    };
+    struct alignas(CacheLineSizeInBytes) AudioWriterCounters
+    {
+        std::atomic<uint64_t> audioBatchReadPosition = 0;
+    };
+    struct alignas(CacheLineSizeInBytes) DiscontinuityWriterCounters
+    {
+        std::atomic<uint64_t> discontinuityRecordReadPosition = 0;
+        std::atomic<uint64_t> discontinuityRecordCount = 0;
+    };
 
 private:
     // Capture methods
     void CaptureThread();
     void SetProcessingFinished(TransferResult result);
+    void RecordThroughputSample(ThroughputTotals& previousTotals, std::thread& processingThread);
 
     // Processing methods
     void ProcessingThread();
     bool ProcessSequenceMarkersAndUpdateSampleMetrics(size_t diskBufferIndex, size_t& processedSampleCount, uint16_t& minValue, uint16_t& maxValue, size_t& minClippedCount, size_t& maxClippedCount);
     bool VerifyTestSequence(size_t diskBufferIndex);
-    bool ConvertRawSampleData(size_t diskBufferIndex, CaptureFormat captureFormat, std::vector<uint8_t>& outputBuffer) const;
+    uint64_t GetOutputByteOffset(CaptureFormat captureFormat, uint64_t outputSampleOffset) const;
+    bool ConvertRawSampleData(size_t diskBufferIndex, CaptureFormat captureFormat, std::vector<uint8_t>& outputBuffer);
+    bool ConvertSampleData(const uint8_t* sampleData, size_t sampleCount, const std::vector<GapFill>& gapFills, CaptureFormat captureFormat, std::vector<uint8_t>& fillSampleBuffer, std::vector<uint8_t>& outputBuffer) const;
+    bool ConvertSamples(const uint8_t* sampleData, size_t sampleCount, CaptureFormat captureFormat, uint8_t* outputData) const;
+    size_t GetConversionBufferSizeInBytes(CaptureFormat captureFormat) const;
+    static size_t GetConvertedSizeInBytes(CaptureFormat captureFormat, size_t sampleCount);
+
+    // Gap filling methods
+    void AddGapFill(size_t sampleIndex, uint64_t frameSampleOffset, uint64_t frameCounter, const uint8_t* sampleData);
+    static size_t GetGapFillAlignmentSampleCount(CaptureFormat captureFormat);
+    static uint64_t GetAlignedGapFillSampleCount(CaptureFormat captureFormat, uint64_t filledSampleCount);
+    static size_t GetGapFillSampleCount(CaptureFormat captureFormat, const GapFill& gapFill);
+    static size_t GetTotalGapFillSampleCount(CaptureFormat captureFormat, const std::vector<GapFill>& gapFills);
+    void BuildGapFillSamples(const GapFill& gapFill, size_t fillSampleCount, size_t fillOffset, size_t sampleCount, uint8_t* outputData) const;
+
+    // Discontinuity map methods
+    DiscontinuityMap::Record MakeDiscontinuityRecord(DiscontinuityMap::RecordType recordType, uint64_t sampleOffset, uint64_t expectedCounter, uint64_t actualCounter, uint64_t skippedSampleCount) const;
+    void AddDiscontinuityRecord(const DiscontinuityMap::Record& record);
+    bool QueueDiscontinuityRecord(const DiscontinuityMap::Record& record);
+    void AddDroppedDiscontinuityRecord(const DiscontinuityMap::Record& record);
+    void CompleteSyncLossRecord(uint64_t sampleOffset, uint64_t actualCounter);
+    void DiscontinuityWriterThread();
+    bool WriteQueuedDiscontinuityRecords();
+    bool WriteDiscontinuityRecord(const DiscontinuityMap::Record& record);
+    bool WriteDiscontinuityMapHeader();
+    bool FinishDiscontinuityMap();
+
+    // Log rate limiting methods
+    std::array<LogRateLimiter*, 7> GetProcessingLogRateLimiters();
+    void UpdateProcessingLogRateLimiters();
+    void FlushProcessingLogRateLimiters();
+
+    // Capture container methods
+    void WriteCaptureContainerBlockHeader(std::vector<uint8_t>& outputBuffer, uint64_t sequenceCounter, size_t frameOffset, bool sequenceCounterValid);
+    bool WriteCaptureContainerTrailer();
+
+    // Additional output methods
+    void AdditionalOutputWriterThread(AdditionalOutput& output);
+    void SubmitAdditionalOutputWork(size_t diskBufferIndex);
+    void CloseAdditionalOutputFiles();
+
+    // Staging buffer methods
+    void StagingFlushThread();
+
+    // Integrity hash methods
+    void HashingThread();
+    void SubmitHashWork(const std::vector<uint8_t>& captureData);
+    void WaitForHashWork();
+
+    // Audio pipeline methods
+    AudioBatch* AcquireAudioBatch();
+    void PublishAudioBatch();
+    void AudioWriterThread();
+    void WriteAudioBatch(const AudioBatch& batch, uint64_t& expectedFrameCounter, bool& expectedFrameCounterValid);
+    void WriteResampledAudio(ResampledAudioOutput& output, const std::vector<uint8_t>& frameData, size_t frameCount);
+    void FinalizeResampledAudioFiles();
+    void AnalyzeAudioSources(const AudioBatch& batch);
+    void CollectAudioSourceAnalysis();
+    void FinalizeAudioBestWavFile();
+    void UpdateAudioStatistics();
+    void AddAudioAlignmentRecord(AudioAlignmentIndex::RecordType recordType, uint32_t frameCount, uint64_t audioSampleIndex, uint64_t rfSampleOffset, uint64_t frameCounter);
 
     // Audio processing methods
     uint64_t ExtractSyncPattern(uint8_t* buffer, size_t byteOffset) const;
     uint64_t Extract48BitCounter(uint8_t* buffer, size_t byteOffset) const;
-    uint16_t Extract12BitAudio(uint8_t* buffer, size_t byteOffset, size_t sampleIndex) const;
-    bool WriteAudioFramesToWav(const std::vector<int16_t>& leftSamples, const std::vector<int16_t>& rightSamples);
+    bool WriteAudioWavHeader(std::ofstream& outputFile, uint32_t sampleRate, uint16_t bitsPerSample, uint64_t dataSizeInBytes);
+    bool SyncAudioWavHeaders();
+    bool WriteAudioFramesToWav(const std::vector<uint8_t>& frameData);
     bool FinalizeAudioWavFile();
-    uint32_t Extract24BitTop6x4(uint8_t* buffer, size_t byteOffset) const;
-    bool WriteAudio24FramesToWav(const std::vector<int32_t>& leftSamples, const std::vector<int32_t>& rightSamples);
+    bool WriteAudio24FramesToWav(const std::vector<uint8_t>& frameData);
     bool FinalizeAudio24WavFile();
 
     // Utility methods
+    template<class T>
+    static void AddToOwnedCounter(std::atomic<T>& counter, T incrementValue);
+    static std::chrono::nanoseconds GetThreadCpuTime(std::thread& thread);
     bool SetCurrentProcessRealtimePriority(ProcessPriorityRestoreInfo& priorityRestoreInfo);
     void RestoreCurrentProcessPriority(const ProcessPriorityRestoreInfo& priorityRestoreInfo);
 
@@ -198,6 +544,10 @@ private:
     // Logging state
     const ILogger& log;
 
+    // Pipeline trace state. Events are only recorded when the trace points are compiled in.
+    CaptureTrace captureTrace;
+    std::filesystem::path captureTraceFilePath;
+
     // Capture settings
     std::filesystem::path captureFilePath;
     CaptureFormat captureFormat;
@@ -212,18 +562,26 @@ private:
     bool transferInProgress = false;
     bool useWindowsOverlappedFileIo = false;
     std::atomic<TransferResult> captureResult = TransferResult::Success;
-    std::atomic<size_t> transferCount = 0;
-    std::atomic<size_t> transferBufferWrittenCount = 0;
-    std::atomic<size_t> transferFileSizeWrittenInBytes = 0;
-    std::atomic<size_t> processedSampleCount = 0;
-    std::atomic<uint16_t> minSampleValue = 0;
-    std::atomic<uint16_t> maxSampleValue = 0;
-    std::atomic<size_t> clippedMinSampleCount = 0;
-    std::atomic<size_t> clippedMaxSampleCount = 0;
-    std::atomic<uint16_t> recentMinSampleValue = 0;
-    std::atomic<uint16_t> recentMaxSampleValue = 0;
-    std::atomic<size_t> recentClippedMinSampleCount = 0;
-    std::atomic<size_t> recentClippedMaxSampleCount = 0;
+    UsbTransferCounters usbTransferCounters;
+    ProcessingCounters processingCounters;
+    StagingFlushCounters stagingFlushCounters;
+
+    // Pipeline timing state. The disk buffer queue depth and USB completion intervals are recorded by the USB transfer
+    // thread as each transfer completes. The write latency is recorded by whichever thread writes to the capture file,
+    // which is the staging flush thread if a staging buffer is in use, otherwise the processing thread.
+    Histogram diskBufferQueueDepthHistogram;
+    Histogram usbCompletionIntervalHistogram;
+    Histogram writeLatencyHistogram;
+    std::chrono::steady_clock::time_point lastTransferCompletionTime;
+    bool lastTransferCompletionTimeValid = false;
+
+    // Throughput sample state. Samples are taken by the capture thread once a second while the capture is running, and
+    // collected under the mutex, so they can be read from any thread.
+    mutable std::mutex throughputSampleMutex;
+    std::vector<ThroughputSample> throughputSamples;
+
+    CaptureStatsSnapshot::RfStatistics rfStatistics;  // Only used by the processing thread
+    SeqLock<CaptureStatsSnapshot::RfStatistics> publishedRfStatistics;
     std::atomic_flag captureThreadRunning;
     std::atomic_flag captureThreadStopRequested;
     std::atomic_flag usbTransferRunning;
@@ -239,6 +597,11 @@ private:
     size_t diskBufferSizeInBytes = 0;
     std::unique_ptr<DiskBufferEntry[]> diskBufferEntries;
 
+    // Raw sample state. When any output keeps the sideband data, a copy of each disk buffer is taken before the
+    // sideband bits are stripped from it.
+    bool rawSampleBufferRequired = false;
+    std::vector<uint8_t> rawSampleBuffer;
+
     // Conversion buffer state
 #ifdef _WIN32
     static const size_t conversionBufferCount = 2;
@@ -254,40 +617,151 @@ private:
     HANDLE windowsCaptureOutputFileHandle;
 #endif
 
+    // Capture container state
+    std::vector<CaptureContainer::IndexEntry> captureContainerIndex;
+    uint64_t captureContainerNextBlockOffset = 0;
+    uint64_t captureContainerNextSampleIndex = 0;
+
+    // Additional output state. Each output is held by pointer, as the structure contains members which can't be moved.
+    // The processing thread passes a copy of each disk buffer to each output through its own single-producer,
+    // single-consumer queue, and the writer thread for that output converts and writes it. The processing thread never
+    // waits for a writer. If an output's queue is full, that output is failed, and the buffers it misses are counted.
+    static const size_t AdditionalOutputQueueLength = 32;
+    std::vector<std::unique_ptr<AdditionalOutput>> additionalOutputs;
+    std::atomic_flag additionalOutputStopRequested;
+
+    // Staging buffer state
+    bool useStagingBuffer = false;
+    StagingBuffer stagingBuffer;
+    std::atomic_flag stagingFlushFailed;
+
+    // Integrity hash state
+    StreamHasher::Algorithm captureHashAlgorithm = StreamHasher::Algorithm::None;
+    StreamHasher captureOutputHasher;
+    StreamHasher audioDataHasher;
+    StreamHasher audio24DataHasher;
+    std::atomic_flag hashWorkPending;
+    std::atomic_flag hashingStopRequested;
+    const uint8_t* hashWorkCaptureData = nullptr;
+    size_t hashWorkCaptureSizeInBytes = 0;
+
     // Audio output file state
     std::filesystem::path audioFilePath;
     std::ofstream audioOutputFile;
-    std::vector<int16_t> audioLeftBuffer;
-    std::vector<int16_t> audioRightBuffer;
-    std::atomic<size_t> audioFrameCount = 0;
-    std::atomic<size_t> audioFileSizeWrittenInBytes = 0;
+    size_t audioFrameCount = 0;
+    size_t audioFileSizeWrittenInBytes = 0;
     bool audioSyncLocked = false;
     size_t audioFrameOffset = 0;  // Tracks sample offset within current 512-sample frame
     // PCM1802 24-bit audio output file state
     std::filesystem::path audio24FilePath;
     std::ofstream audio24OutputFile;
-    std::vector<int32_t> audio24LeftBuffer;
-    std::vector<int32_t> audio24RightBuffer;
-    std::atomic<size_t> audio24FrameCount = 0;
-    std::atomic<size_t> audio24FileSizeWrittenInBytes = 0;
+    size_t audio24FrameCount = 0;
+    size_t audio24FileSizeWrittenInBytes = 0;
+    bool captureSyncAudioHeaders = false;
+    std::chrono::steady_clock::time_point lastAudioHeaderSyncTime;
+
+    // Audio alignment index state. Records are collected for each batch, and written along with the batch audio.
+    std::filesystem::path audioAlignmentFilePath;
+    std::ofstream audioAlignmentOutputFile;
+    std::vector<uint8_t> audioAlignmentRecordBuffer;
+    uint64_t audioAlignmentSampleIndex = 0;
+
+    // Audio pipeline state. Decoded audio is passed from the processing thread to the audio writer thread through a
+    // single-producer, single-consumer ring of batches, one batch per disk buffer. The write position and dropped frame
+    // count are held in the processing thread counters. Each batch has room for a fixed number of segments, which is
+    // only exceeded when frame sync is repeatedly lost within a single disk buffer. Once a batch is full, the remaining
+    // frames from that disk buffer are dropped and counted, rather than allocating on the processing thread.
+    static const size_t AudioBatchQueueLength = 256;
+    static const size_t MaxAudioBatchSegmentCount = 16;
+    std::unique_ptr<AudioBatch[]> audioBatchQueue;
+    AudioBatch audioOverflowBatch;
+    AudioWriterCounters audioWriterCounters;
+    std::atomic_flag audioBatchAvailable;
+    std::atomic_flag audioWriterStopRequested;
+    std::atomic_flag audioWriteFailed;
+    size_t audioMissingFrameCount = 0;
+    size_t audioFilledFrameCount = 0;
+    std::vector<uint8_t> audioGapFilledFrameData;    // Batch audio with silence inserted for missing frames
+    std::vector<uint8_t> audioGapFilled24FrameData;
+    std::vector<uint8_t> audioFieldBlocks;  // Audio fields gathered from each frame of the current disk buffer
+
+    // Resampled audio output state. These outputs are produced by the audio writer thread from the native rate audio.
+    std::vector<std::unique_ptr<ResampledAudioOutput>> resampledAudioOutputs;
     
-    // Audio statistics (uses PCM1802 when both are enabled, otherwise whichever is enabled)
-    std::atomic<int32_t> audioMinSampleValue = 0;
-    std::atomic<int32_t> audioMaxSampleValue = 0;
-    std::atomic<size_t> audioClippedMinSampleCount = 0;
-    std::atomic<size_t> audioClippedMaxSampleCount = 0;
-    std::atomic<int32_t> audioRecentMinSampleValue = 0;
-    std::atomic<int32_t> audioRecentMaxSampleValue = 0;
-    std::atomic<size_t> audioRecentClippedMinSampleCount = 0;
-    std::atomic<size_t> audioRecentClippedMaxSampleCount = 0;
-    std::atomic<double> audioMeanAmplitude = 0.0;
+    // Audio statistics and level state. The meters and statistics are only used by the audio writer thread, which
+    // publishes them after each batch, so they can be read from any thread without locking. The sample statistics are
+    // gathered from the primary meter only.
+    AudioMeter audioMeter;
+    AudioMeter audioSecondaryMeter;
+    CaptureStatsSnapshot::AudioStatistics audioStatistics;
+    SeqLock<CaptureStatsSnapshot::AudioStatistics> publishedAudioStatistics;
+    AudioLevels audioLevels;
+    SeqLock<AudioLevels> publishedAudioLevels;
+
+    // Audio preview state. Audio is passed to the preview stream by the audio writer thread.
+    AudioPreviewStream audioPreviewStream;
+
+    // Audio source analysis state. When both converters are recording, the audio writer thread compares them as each
+    // batch is written. The completed window results are collected under the mutex, so they can be read from any
+    // thread, and the merged output from the analyzer is written to the best source audio file if requested.
+    bool audioSourceAnalysisEnabled = false;
+    AudioSourceAnalyzer audioSourceAnalyzer;
+    mutable std::mutex audioSourceAnalysisMutex;
+    std::vector<AudioSourceAnalyzer::WindowResult> audioSourceAnalysisResults;
+    std::vector<AudioSourceAnalyzer::WindowResult> audioSourceAnalysisBatchResults;
+    std::vector<uint8_t> audioBestFrameData;
+    std::filesystem::path audioBestFilePath;
+    std::ofstream audioBestOutputFile;
+    std::atomic<size_t> audioBestFileSizeWrittenInBytes = 0;
+    std::atomic_flag audioBestWriteFailed;
 
     // Sequence/test data state
     SequenceState sequenceState = SequenceState::Sync;
     uint64_t savedSequenceCounter = 0;  // 48-bit counter value
+    uint64_t bufferStartSampleOffset = 0;  // Offset of the current disk buffer in the captured sample stream
     std::optional<uint16_t> expectedNextTestDataValue;
     std::optional<uint16_t> testDataMax;
-    std::atomic<size_t> syncLossCount = 0;
+
+    // Discontinuity map state. Records are queued by the processing thread, and appended to the map file by the
+    // discontinuity writer thread as they arrive. The processing thread never waits for the writer. If the queue is
+    // full, records are merged into a single pending records dropped record, which is queued ahead of the next record
+    // once there's room. A sync loss is held back until sync is reacquired, so we know how much of the output it
+    // affected.
+    static const size_t DiscontinuityRecordQueueLength = 1024;
+    std::filesystem::path discontinuityMapFilePath;
+    std::ofstream discontinuityMapFile;
+    bool discontinuityMapEnabled = false;
+    std::unique_ptr<DiscontinuityMap::Record[]> discontinuityRecordQueue;
+    DiscontinuityWriterCounters discontinuityWriterCounters;
+    std::atomic_flag discontinuityRecordAvailable;
+    std::atomic_flag discontinuityWriterStopRequested;
+    std::atomic_flag discontinuityWriteFailed;
+    std::optional<DiscontinuityMap::Record> pendingDroppedDiscontinuityRecord;
+    std::optional<DiscontinuityMap::Record> pendingSyncLossRecord;
+
+    // Gap filling state. The frame counter at the start of each frame is compared against the value expected from the
+    // previous frame, and where they show samples were lost, a fill of exactly the missing sample count is recorded at
+    // that point in the disk buffer. The fills are inserted into each output as the buffer is converted. The 10-bit
+    // packed formats can only hold whole groups of samples, so for those outputs alone, each fill is moved to the start
+    // of its group, and the running total of filled samples is rounded to a whole number of groups, so the timeline
+    // never drifts by more than half a group. The raw 16-bit format is never filled.
+    GapFillMode captureGapFillMode = GapFillMode::None;
+    std::vector<GapFill> bufferGapFills;
+    std::vector<uint8_t> gapFillSampleBuffer;
+    bool gapFillExpectedFrameValid = false;
+    uint64_t gapFillExpectedFrameCounter = 0;
+    uint64_t gapFillExpectedFrameSampleOffset = 0;
+    uint16_t gapFillPreviousSampleValue = 0;
+
+    // Log rate limiters for the messages the processing thread can repeat many times a second when the incoming data is
+    // damaged. Every occurrence is still counted in the RF statistics, only the log output is limited.
+    LogRateLimiter syncSearchLogLimiter{ ILogger::Severity::Info, "ProcessSequenceMarkersAndUpdateSampleMetrics(): Searching for sync pattern" };
+    LogRateLimiter syncLockedLogLimiter{ ILogger::Severity::Info, "ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync locked" };
+    LogRateLimiter syncNotFoundLogLimiter{ ILogger::Severity::Warning, "ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern not found" };
+    LogRateLimiter syncLostLogLimiter{ ILogger::Severity::Warning, "ProcessSequenceMarkersAndUpdateSampleMetrics(): Sync pattern lost" };
+    LogRateLimiter counterMismatchLogLimiter{ ILogger::Severity::Warning, "ProcessSequenceMarkersAndUpdateSampleMetrics(): Counter mismatch" };
+    LogRateLimiter gapFilledLogLimiter{ ILogger::Severity::Warning, "AddGapFill(): Gap filled" };
+    LogRateLimiter gapNotFilledLogLimiter{ ILogger::Severity::Warning, "AddGapFill(): Gap can't be filled" };
 
     // Buffer sample state
     std::atomic_flag bufferSampleRequestPending;
@@ -485,6 +485,7 @@ void UsbDeviceLibUsb::CalculateDesiredBufferCountAndSize(bool useSmallUsbTransfe
 void UsbDeviceLibUsb::UsbTransferThread()
 {
     Log().Info("UsbTransferThread(): Starting");
+    CAPTURE_TRACE_REGISTER_THREAD(Trace(), "USB transfer");
 
     // Determine how we're going to split our transfers across our disk buffers
     size_t diskBufferCount = GetDiskBufferCount();
@@ -612,6 +613,7 @@ void UsbDeviceLibUsb::UsbTransferThread()
         for (size_t transferNumber = 0; transferNumber < simultaneousTransfers; ++transferNumber)
         {
             TransferBufferEntry& transferBufferEntry = transferBuffers[transferNumber];
+            CAPTURE_TRACE_INSTANT(Trace(), UsbTransferSubmit, transferBufferEntry.diskBufferIndex);
             int libUsbSubmitTransferReturn = libusb_submit_transfer(transferBufferEntry.transfer);
             if (libUsbSubmitTransferReturn != 0)
             {
@@ -757,6 +759,8 @@ void UsbDeviceLibUsb::BulkTransferCallback(libusb_transfer* transfer, TransferBu
         return;
     }
 
+    CAPTURE_TRACE_INSTANT(Trace(), UsbTransferComplete, transferUserData->diskBufferIndex);
+
     // Ensure we receieved as many bytes as we expected, since we don't handle the case where this isn't true. This
     // check should never fail however, as we specified the LIBUSB_TRANSFER_SHORT_NOT_OK flag when defining the
     // transfers.
@@ -802,6 +806,7 @@ void UsbDeviceLibUsb::BulkTransferCallback(libusb_transfer* transfer, TransferBu
 
         // Notify any threads waiting on this buffer that there is now data for processing
         bufferEntry.isDiskBufferFull.notify_all();
+        RecordDiskBufferFilled(transferUserData->diskBufferIndex);
         Log().Trace("BulkTransferCallback(): Submitted disk buffer {0} for processing", transferUserData->diskBufferIndex);
 
         // If transfer has been requested to stop, mark the capture as complete now that we've reached a disk buffer
@@ -813,7 +818,7 @@ void UsbDeviceLibUsb::BulkTransferCallback(libusb_transfer* transfer, TransferBu
     }
 
     // Increment the count of successfully completed transfers
-    AddCompletedTransferCount(1);
+    AddCompletedTransferCount(1, (size_t)transfer->actual_length);
 
     // If the capture is not complete, submit another transfer request.
     if (!captureComplete)
@@ -837,6 +842,7 @@ void UsbDeviceLibUsb::BulkTransferCallback(libusb_transfer* transfer, TransferBu
         // Queue a USB bulk read request for this transfer slot
         int timeoutInMilliseconds = 0;
         libusb_fill_bulk_transfer(transfer, transfer->dev_handle, transfer->endpoint, resubmissionBufferEntry.readBuffer.data() + transferUserData->transferBufferByteOffset, transfer->length, BulkTransferCallbackStatic, transfer->user_data, timeoutInMilliseconds);
+        CAPTURE_TRACE_INSTANT(Trace(), UsbTransferSubmit, resubmissionDiskBufferIndex);
         int libUsbSubmitTransferReturn = libusb_submit_transfer(transfer);
         if (libUsbSubmitTransferReturn != 0)
         {
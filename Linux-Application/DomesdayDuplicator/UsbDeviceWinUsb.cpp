@@ -496,6 +496,8 @@ void UsbDeviceWinUsb::CalculateDesiredBufferCountAndSize(bool useSmallUsbTransfe
 //----------------------------------------------------------------------------------------------------------------------
 void UsbDeviceWinUsb::UsbTransferThread()
 {
+    CAPTURE_TRACE_REGISTER_THREAD(Trace(), "USB transfer");
+
     // Determine how we're going to split our transfers across our disk buffers
     size_t diskBufferCount = GetDiskBufferCount();
     size_t diskBufferSizeInBytes = GetSingleDiskBufferSizeInBytes();
@@ -654,6 +656,7 @@ void UsbDeviceWinUsb::UsbTransferThread()
 
             // Flag that a transfer is no longer in progress for this slot
             transferBufferEntry.transferSubmitted = false;
+            CAPTURE_TRACE_INSTANT(Trace(), UsbTransferComplete, transferBufferEntry.diskBufferIndex);
 
             // Either discard this transfer, or send it downstream for processing.
             if (dumpedTransferCount < targetDumpedTransferCount)
@@ -677,6 +680,7 @@ void UsbDeviceWinUsb::UsbTransferThread()
 
                 // Notify any threads waiting on this buffer that there is now data for processing
                 diskBufferEntry.isDiskBufferFull.notify_all();
+                RecordDiskBufferFilled(transferBufferEntry.diskBufferIndex);
                 Log().Trace("UsbTransferThread(): Submitted disk buffer {0} for processing", transferBufferEntry.diskBufferIndex);
 
                 // If transfer has been requested to stop, mark the capture as complete now that we've reached a disk
@@ -688,7 +692,7 @@ void UsbDeviceWinUsb::UsbTransferThread()
             }
 
             // Increment the count of successfully completed transfers
-            AddCompletedTransferCount(1);
+            AddCompletedTransferCount(1, transferSizeInBytes);
         }
 
         // If the capture is not complete, submit another transfer request.
@@ -711,6 +715,7 @@ void UsbDeviceWinUsb::UsbTransferThread()
             }
 
             // Queue a USB bulk read request for this transfer slot
+            CAPTURE_TRACE_INSTANT(Trace(), UsbTransferSubmit, resubmissionDiskBufferIndex);
             BOOL winUsbReadPipeReturn = WinUsb_ReadPipe(captureWinUsbInterfaceHandle, captureWinUsbBulkInPipeId, resubmissionBufferEntry.readBuffer.data() + transferBufferEntry.transferBufferByteOffset, (ULONG)transferSizeInBytes, NULL, &transferBufferEntry.overlappedStructure);
             if (winUsbReadPipeReturn == FALSE)
             {
@@ -0,0 +1,64 @@
+#include "WavHeader.h"
+#include "ByteOrder.h"
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+// Header methods
+//----------------------------------------------------------------------------------------------------------------------
+void WavHeader::Build(uint8_t* buffer, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample, uint64_t dataSizeInBytes)
+{
+    // Determine if the data will fit within the limits of a standard WAV file. A size field of 0xFFFFFFFF indicates the
+    // real size is held in the ds64 chunk, so that value isn't available to a standard file.
+    const uint64_t riffSizeInBytes = (HeaderSizeInBytes - 8) + dataSizeInBytes;
+    const bool useRf64 = (riffSizeInBytes >= 0xFFFFFFFF);
+    const uint16_t blockAlign = (uint16_t)(channelCount * (bitsPerSample / 8));
+
+    // Write the RIFF header
+    memset(buffer, 0, HeaderSizeInBytes);
+    WriteTag(buffer + 0, useRf64 ? "RF64" : "RIFF");
+    WriteLE32(buffer + 4, useRf64 ? 0xFFFFFFFF : (uint32_t)riffSizeInBytes);
+    WriteTag(buffer + 8, "WAVE");
+
+    // Write the ds64 chunk, or a placeholder of the same size which readers will skip over.
+    WriteTag(buffer + 12, useRf64 ? "ds64" : "JUNK");
+    WriteLE32(buffer + 16, 28);
+    if (useRf64)
+    {
+        WriteLE64(buffer + 20, riffSizeInBytes);
+        WriteLE64(buffer + 28, dataSizeInBytes);
+        WriteLE64(buffer + 36, dataSizeInBytes / blockAlign);
+        WriteLE32(buffer + 44, 0);
+    }
+
+    // Write the format chunk
+    WriteTag(buffer + 48, "fmt ");
+    WriteLE32(buffer + 52, 16);
+    WriteLE16(buffer + 56, 1);
+    WriteLE16(buffer + 58, channelCount);
+    WriteLE32(buffer + 60, sampleRate);
+    WriteLE32(buffer + 64, sampleRate * blockAlign);
+    WriteLE16(buffer + 68, blockAlign);
+    WriteLE16(buffer + 70, bitsPerSample);
+
+    // Write the data chunk header. The sample data follows immediately after this.
+    WriteTag(buffer + 72, "data");
+    WriteLE32(buffer + 76, useRf64 ? 0xFFFFFFFF : (uint32_t)dataSizeInBytes);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void WavHeader::BuildStream(uint8_t* buffer, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample)
+{
+    // A stream has no known length, so we declare the largest data size a standard WAV file can hold. Players treat
+    // this as an instruction to keep reading until the stream ends, and unlike an RF64 header, it's widely supported.
+    const uint16_t blockAlign = (uint16_t)(channelCount * (bitsPerSample / 8));
+    const uint64_t maxDataSizeInBytes = 0xFFFFFFFEULL - (HeaderSizeInBytes - 8);
+    Build(buffer, channelCount, sampleRate, bitsPerSample, maxDataSizeInBytes - (maxDataSizeInBytes % blockAlign));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Serialization methods
+//----------------------------------------------------------------------------------------------------------------------
+void WavHeader::WriteTag(uint8_t* buffer, const char* tag)
+{
+    memcpy(buffer, tag, 4);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Builds the header for a PCM WAV file whose sample data is streamed to disk as it's captured. The header has a fixed
+// size, so it can be written with a zero data length when the file is created, then rewritten in place once the real
+// length is known without moving any of the data that follows it. A placeholder "JUNK" chunk is reserved after the
+// RIFF header, which is turned into the "ds64" chunk of an RF64 file (EBU Tech 3306) if the data grows beyond the 4GiB
+// limit of a standard WAV file.
+class WavHeader
+{
+public:
+    // Constants
+    static const size_t HeaderSizeInBytes = 80;
+
+public:
+    // Header methods
+    static void Build(uint8_t* buffer, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample, uint64_t dataSizeInBytes);
+    static void BuildStream(uint8_t* buffer, uint16_t channelCount, uint32_t sampleRate, uint16_t bitsPerSample);
+
+private:
+    // Serialization methods
+    static void WriteTag(uint8_t* buffer, const char* tag);
+};
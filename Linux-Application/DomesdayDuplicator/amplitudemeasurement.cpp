@@ -79,6 +79,27 @@ void AmplitudeMeasurement::updateBuffer(const std::vector<uint8_t>& bufferSample
     }
 }
 
+// Add a pair of audio channel levels to the graph. The left channel is drawn above the axis and the right channel
+// below it, so a dead channel is obvious at a glance.
+void AmplitudeMeasurement::updateLevels(double leftLevel, double rightLevel)
+{
+    if (rightLevelPlot == nullptr) {
+        rightLevelPlot = addGraph();
+        rightLevelPlot->setPen(QPen(Qt::red));
+        rightGraphYValues.fill(0, GRAPH_POINTS);
+    }
+
+    // Trim both channels here, as this can be called while the chart isn't being plotted
+    graphYValues.append(leftLevel);
+    if (graphYValues.size() > GRAPH_POINTS) {
+        graphYValues.remove(0, graphYValues.size() - GRAPH_POINTS);
+    }
+    rightGraphYValues.append(-rightLevel);
+    if (rightGraphYValues.size() > GRAPH_POINTS) {
+        rightGraphYValues.remove(0, rightGraphYValues.size() - GRAPH_POINTS);
+    }
+}
+
 // Draw the graph
 void AmplitudeMeasurement::plotGraph()
 {
@@ -95,6 +116,10 @@ void AmplitudeMeasurement::plotGraph()
         wavePlot->data()->clear();
     }
     wavePlot->addData(graphXValues, graphYValues);
+    if (rightLevelPlot != nullptr) {
+        rightLevelPlot->data()->clear();
+        rightLevelPlot->addData(graphXValues, rightGraphYValues);
+    }
     xAxis->setRange(QCPRange(0, GRAPH_POINTS));
     replot();
 }
@@ -41,11 +41,13 @@ public:
 
 public slots:
     void updateBuffer(const std::vector<uint8_t>& bufferSample);
+    void updateLevels(double leftLevel, double rightLevel);
     void plotGraph();
 
 private:
     std::vector<qint16> inputSamples;
-    QVector<double> graphXValues, graphYValues;
+    QVector<double> graphXValues, graphYValues, rightGraphYValues;
     std::array<double, 20> rollingAmp;
     QCPGraph *wavePlot;
+    QCPGraph *rightLevelPlot = nullptr;
 };
@@ -63,8 +63,16 @@ void Configuration::writeConfiguration()
     configuration->beginGroup("capture");
     configuration->setValue("captureDirectory", settings.capture.captureDirectory);
     configuration->setValue("captureFormat", convertCaptureFormatToInt(settings.capture.captureFormat));
+    configuration->setValue("additionalCaptureFormats", convertCaptureFormatsToMask(settings.capture.additionalCaptureFormats));
     configuration->setValue("audioSource", convertAudioSourceToInt(settings.capture.audioSource));
+    configuration->setValue("audioResampling", convertAudioResamplingToInt(settings.capture.audioResampling));
+    configuration->setValue("integrityHash", convertHashAlgorithmToInt(settings.capture.integrityHash));
     configuration->setValue("stopOnDroppedSamples", settings.capture.stopOnDroppedSamples);
+    configuration->setValue("gapFill", convertGapFillToInt(settings.capture.gapFill));
+    configuration->setValue("syncAudioHeaders", settings.capture.syncAudioHeaders);
+    configuration->setValue("audioPreviewPath", settings.capture.audioPreviewPath);
+    configuration->setValue("writeBestAudio", settings.capture.writeBestAudio);
+    configuration->setValue("metricsExportPath", settings.capture.metricsExportPath);
     configuration->endGroup();
 
     // UI
@@ -82,6 +90,7 @@ void Configuration::writeConfiguration()
     configuration->setValue("pid", settings.usb.pid);
     configuration->setValue("preferredDevice", settings.usb.preferredDevice);
     configuration->setValue("diskBufferQueueSize", (quint64)settings.usb.diskBufferQueueSize);
+    configuration->setValue("stagingBufferSize", (quint64)settings.usb.stagingBufferSize);
     configuration->setValue("useSmallUsbTransferQueue", settings.usb.useSmallUsbTransferQueue);
     configuration->setValue("useSmallUsbTransfers", settings.usb.useSmallUsbTransfers);
     configuration->setValue("useWinUsb", settings.usb.useWinUsb);
@@ -119,8 +128,16 @@ void Configuration::readConfiguration()
     configuration->beginGroup("capture");
     settings.capture.captureDirectory = configuration->value("captureDirectory").toString();
     settings.capture.captureFormat = convertIntToCaptureFormat(configuration->value("captureFormat").toInt());
+    settings.capture.additionalCaptureFormats = convertMaskToCaptureFormats(configuration->value("additionalCaptureFormats").toInt());
     settings.capture.audioSource = convertIntToAudioSource(configuration->value("audioSource").toInt());
+    settings.capture.audioResampling = convertIntToAudioResampling(configuration->value("audioResampling").toInt());
+    settings.capture.integrityHash = convertIntToHashAlgorithm(configuration->value("integrityHash").toInt());
     settings.capture.stopOnDroppedSamples = configuration->value("stopOnDroppedSamples").toBool();
+    settings.capture.gapFill = convertIntToGapFill(configuration->value("gapFill").toInt());
+    settings.capture.syncAudioHeaders = configuration->value("syncAudioHeaders").toBool();
+    settings.capture.audioPreviewPath = configuration->value("audioPreviewPath").toString();
+    settings.capture.writeBestAudio = configuration->value("writeBestAudio").toBool();
+    settings.capture.metricsExportPath = configuration->value("metricsExportPath").toString();
     configuration->endGroup();
 
     // UI
@@ -138,6 +155,7 @@ void Configuration::readConfiguration()
     settings.usb.pid = static_cast<quint16>(configuration->value("pid").toUInt());
     settings.usb.preferredDevice = configuration->value("preferredDevice").toString();
     settings.usb.diskBufferQueueSize = (size_t)configuration->value("diskBufferQueueSize").toULongLong();
+    settings.usb.stagingBufferSize = (size_t)configuration->value("stagingBufferSize").toULongLong();
     settings.usb.useSmallUsbTransferQueue = configuration->value("useSmallUsbTransferQueue").toBool();
     settings.usb.useSmallUsbTransfers = configuration->value("useSmallUsbTransfers").toBool();
     settings.usb.useWinUsb = configuration->value("useWinUsb").toBool();
@@ -169,8 +187,16 @@ void Configuration::setDefault()
     // Capture
     settings.capture.captureDirectory = QDir::homePath();
     settings.capture.captureFormat = CaptureFormat::tenBitPacked;
+    settings.capture.additionalCaptureFormats.clear();
     settings.capture.audioSource = AudioSource::none;
+    settings.capture.audioResampling = AudioResampling::noResampling;
+    settings.capture.integrityHash = HashAlgorithm::noHash;
     settings.capture.stopOnDroppedSamples = false;
+    settings.capture.gapFill = GapFill::noGapFill;
+    settings.capture.syncAudioHeaders = false;
+    settings.capture.audioPreviewPath.clear();
+    settings.capture.writeBestAudio = false;
+    settings.capture.metricsExportPath.clear();
 
     // UI
     settings.ui.perSideNotesEnabled = false;
@@ -184,6 +210,7 @@ void Configuration::setDefault()
     settings.usb.pid = 0x603B;
     settings.usb.preferredDevice = "";
     settings.usb.diskBufferQueueSize = 256 * 1024 * 1024;
+    settings.usb.stagingBufferSize = 0;
     settings.usb.useSmallUsbTransferQueue = false;
     settings.usb.useSmallUsbTransfers = true;
 #ifdef _WIN32
@@ -215,6 +242,8 @@ qint32 Configuration::convertCaptureFormatToInt(CaptureFormat captureFormat)
     if (captureFormat == CaptureFormat::tenBitPacked) return 0;
     if (captureFormat == CaptureFormat::sixteenBitSigned) return 1;
     if (captureFormat == CaptureFormat::tenBitCdPacked) return 2;
+    if (captureFormat == CaptureFormat::tenBitBlocked) return 3;
+    if (captureFormat == CaptureFormat::sixteenBitRaw) return 4;
 
     // Default to 0
     return 0;
@@ -226,11 +255,33 @@ Configuration::CaptureFormat Configuration::convertIntToCaptureFormat(qint32 cap
     if (captureInt == 0) return CaptureFormat::tenBitPacked;
     if (captureInt == 1) return CaptureFormat::sixteenBitSigned;
     if (captureInt == 2) return CaptureFormat::tenBitCdPacked;
+    if (captureInt == 3) return CaptureFormat::tenBitBlocked;
+    if (captureInt == 4) return CaptureFormat::sixteenBitRaw;
 
     // Default to 10 bit packed
     return CaptureFormat::tenBitPacked;
 }
 
+// Conversion from a set of CaptureFormats to a bitmask, with one bit per format
+qint32 Configuration::convertCaptureFormatsToMask(const QList<CaptureFormat>& captureFormats)
+{
+    qint32 captureMask = 0;
+    for (CaptureFormat captureFormat : captureFormats) {
+        captureMask |= (1 << convertCaptureFormatToInt(captureFormat));
+    }
+    return captureMask;
+}
+
+// Conversion from a bitmask to a set of CaptureFormats
+QList<Configuration::CaptureFormat> Configuration::convertMaskToCaptureFormats(qint32 captureMask)
+{
+    QList<CaptureFormat> captureFormats;
+    for (qint32 captureInt = 0; captureInt <= 4; ++captureInt) {
+        if ((captureMask & (1 << captureInt)) != 0) captureFormats.append(convertIntToCaptureFormat(captureInt));
+    }
+    return captureFormats;
+}
+
 // Enum conversion from serial speed to int
 qint32 Configuration::convertSerialSpeedsToInt(SerialSpeeds serialSpeeds)
 {
@@ -281,6 +332,76 @@ Configuration::AudioSource Configuration::convertIntToAudioSource(qint32 audioIn
     return AudioSource::none;
 }
 
+// Enum conversion from HashAlgorithm to int
+qint32 Configuration::convertHashAlgorithmToInt(HashAlgorithm hashAlgorithm)
+{
+    if (hashAlgorithm == HashAlgorithm::noHash) return 0;
+    if (hashAlgorithm == HashAlgorithm::crc32c) return 1;
+    if (hashAlgorithm == HashAlgorithm::xxHash64) return 2;
+
+    // Default to none
+    return 0;
+}
+
+// Enum conversion from int to HashAlgorithm
+Configuration::HashAlgorithm Configuration::convertIntToHashAlgorithm(qint32 hashInt)
+{
+    if (hashInt == 0) return HashAlgorithm::noHash;
+    if (hashInt == 1) return HashAlgorithm::crc32c;
+    if (hashInt == 2) return HashAlgorithm::xxHash64;
+
+    // Default to none
+    return HashAlgorithm::noHash;
+}
+
+// Enum conversion from AudioResampling to int
+qint32 Configuration::convertAudioResamplingToInt(AudioResampling audioResampling)
+{
+    if (audioResampling == AudioResampling::noResampling) return 0;
+    if (audioResampling == AudioResampling::resample48kHz) return 1;
+    if (audioResampling == AudioResampling::resample44kHz) return 2;
+    if (audioResampling == AudioResampling::resampleBoth) return 3;
+
+    // Default to none
+    return 0;
+}
+
+// Enum conversion from int to AudioResampling
+Configuration::AudioResampling Configuration::convertIntToAudioResampling(qint32 resamplingInt)
+{
+    if (resamplingInt == 0) return AudioResampling::noResampling;
+    if (resamplingInt == 1) return AudioResampling::resample48kHz;
+    if (resamplingInt == 2) return AudioResampling::resample44kHz;
+    if (resamplingInt == 3) return AudioResampling::resampleBoth;
+
+    // Default to none
+    return AudioResampling::noResampling;
+}
+
+// Enum conversion from GapFill to int
+qint32 Configuration::convertGapFillToInt(GapFill gapFill)
+{
+    if (gapFill == GapFill::noGapFill) return 0;
+    if (gapFill == GapFill::zeroFill) return 1;
+    if (gapFill == GapFill::midScaleFill) return 2;
+    if (gapFill == GapFill::interpolatedFill) return 3;
+
+    // Default to none
+    return 0;
+}
+
+// Enum conversion from int to GapFill
+Configuration::GapFill Configuration::convertIntToGapFill(qint32 gapFillInt)
+{
+    if (gapFillInt == 0) return GapFill::noGapFill;
+    if (gapFillInt == 1) return GapFill::zeroFill;
+    if (gapFillInt == 2) return GapFill::midScaleFill;
+    if (gapFillInt == 3) return GapFill::interpolatedFill;
+
+    // Default to none
+    return GapFill::noGapFill;
+}
+
 // Functions to get and set configuration values ----------------------------------------------------------------------
 
 // Capture settings
@@ -304,6 +425,16 @@ Configuration::CaptureFormat Configuration::getCaptureFormat() const
     return settings.capture.captureFormat;
 }
 
+void Configuration::setAdditionalCaptureFormats(QList<CaptureFormat> additionalCaptureFormats)
+{
+    settings.capture.additionalCaptureFormats = additionalCaptureFormats;
+}
+
+QList<Configuration::CaptureFormat> Configuration::getAdditionalCaptureFormats() const
+{
+    return settings.capture.additionalCaptureFormats;
+}
+
 void Configuration::setStopOnDroppedSamples(bool stopOnDroppedSamples)
 {
     settings.capture.stopOnDroppedSamples = stopOnDroppedSamples;
@@ -314,6 +445,56 @@ bool Configuration::getStopOnDroppedSamples() const
     return settings.capture.stopOnDroppedSamples;
 }
 
+void Configuration::setGapFill(GapFill gapFill)
+{
+    settings.capture.gapFill = gapFill;
+}
+
+Configuration::GapFill Configuration::getGapFill() const
+{
+    return settings.capture.gapFill;
+}
+
+void Configuration::setSyncAudioHeaders(bool syncAudioHeaders)
+{
+    settings.capture.syncAudioHeaders = syncAudioHeaders;
+}
+
+bool Configuration::getSyncAudioHeaders() const
+{
+    return settings.capture.syncAudioHeaders;
+}
+
+void Configuration::setAudioPreviewPath(QString audioPreviewPath)
+{
+    settings.capture.audioPreviewPath = audioPreviewPath;
+}
+
+QString Configuration::getAudioPreviewPath() const
+{
+    return settings.capture.audioPreviewPath;
+}
+
+void Configuration::setWriteBestAudio(bool writeBestAudio)
+{
+    settings.capture.writeBestAudio = writeBestAudio;
+}
+
+bool Configuration::getWriteBestAudio() const
+{
+    return settings.capture.writeBestAudio;
+}
+
+void Configuration::setMetricsExportPath(QString metricsExportPath)
+{
+    settings.capture.metricsExportPath = metricsExportPath;
+}
+
+QString Configuration::getMetricsExportPath() const
+{
+    return settings.capture.metricsExportPath;
+}
+
 // USB settings
 void Configuration::setUsbVid(quint16 vid)
 {
@@ -355,6 +536,16 @@ size_t Configuration::getDiskBufferQueueSize() const
     return settings.usb.diskBufferQueueSize;
 }
 
+void Configuration::setStagingBufferSize(size_t state)
+{
+    settings.usb.stagingBufferSize = state;
+}
+
+size_t Configuration::getStagingBufferSize() const
+{
+    return settings.usb.stagingBufferSize;
+}
+
 void Configuration::setUseSmallUsbTransferQueue(bool state)
 {
     settings.usb.useSmallUsbTransferQueue = state;
@@ -487,6 +678,26 @@ Configuration::AudioSource Configuration::getAudioSource() const
     return settings.capture.audioSource;
 }
 
+void Configuration::setIntegrityHash(HashAlgorithm integrityHash)
+{
+    settings.capture.integrityHash = integrityHash;
+}
+
+Configuration::HashAlgorithm Configuration::getIntegrityHash() const
+{
+    return settings.capture.integrityHash;
+}
+
+void Configuration::setAudioResampling(AudioResampling audioResampling)
+{
+    settings.capture.audioResampling = audioResampling;
+}
+
+Configuration::AudioResampling Configuration::getAudioResampling() const
+{
+    return settings.capture.audioResampling;
+}
+
 // Windows
 void Configuration::setMainWindowGeometry(QByteArray mainWindowGeometry)
 {
@@ -32,6 +32,7 @@
 #include <QApplication>
 #include <QDir>
 #include <QDebug>
+#include <QList>
 #include <memory>
 
 class Configuration : public QObject
@@ -42,7 +43,9 @@ public:
     enum CaptureFormat {
         tenBitPacked,
         sixteenBitSigned,
-        tenBitCdPacked
+        tenBitCdPacked,
+        tenBitBlocked,
+        sixteenBitRaw
     };
 
     // Define the possible serial communication speeds
@@ -62,6 +65,29 @@ public:
         both
     };
 
+    // Define the possible integrity hash algorithms
+    enum HashAlgorithm {
+        noHash,
+        crc32c,
+        xxHash64
+    };
+
+    // Define the possible audio resampling modes
+    enum AudioResampling {
+        noResampling,
+        resample48kHz,
+        resample44kHz,
+        resampleBoth
+    };
+
+    // Define the possible ways of filling gaps left by dropped samples
+    enum GapFill {
+        noGapFill,
+        zeroFill,
+        midScaleFill,
+        interpolatedFill
+    };
+
     explicit Configuration(QObject *parent = nullptr);
 
     void writeConfiguration();
@@ -74,8 +100,20 @@ public:
     QString getCaptureDirectory() const;
     void setCaptureFormat(CaptureFormat captureFormat);
     CaptureFormat getCaptureFormat() const;
+    void setAdditionalCaptureFormats(QList<CaptureFormat> additionalCaptureFormats);
+    QList<CaptureFormat> getAdditionalCaptureFormats() const;
     void setStopOnDroppedSamples(bool stopOnDroppedSamples);
     bool getStopOnDroppedSamples() const;
+    void setGapFill(GapFill gapFill);
+    GapFill getGapFill() const;
+    void setSyncAudioHeaders(bool syncAudioHeaders);
+    bool getSyncAudioHeaders() const;
+    void setAudioPreviewPath(QString audioPreviewPath);
+    QString getAudioPreviewPath() const;
+    void setWriteBestAudio(bool writeBestAudio);
+    bool getWriteBestAudio() const;
+    void setMetricsExportPath(QString metricsExportPath);
+    QString getMetricsExportPath() const;
     void setUsbVid(quint16 vid);
     quint16 getUsbVid() const;
     void setUsbPid(quint16 pid);
@@ -84,6 +122,8 @@ public:
     QString getUsbPreferredDevice() const;
     void setDiskBufferQueueSize(size_t state);
     size_t getDiskBufferQueueSize() const;
+    void setStagingBufferSize(size_t state);
+    size_t getStagingBufferSize() const;
     void setUseSmallUsbTransferQueue(bool state);
     bool getUseSmallUsbTransferQueue() const;
     void setUseSmallUsbTransfers(bool state);
@@ -110,6 +150,10 @@ public:
     bool getShowAdvancedCaptureStats() const;
     void setAudioSource(AudioSource audioSource);
     AudioSource getAudioSource() const;
+    void setIntegrityHash(HashAlgorithm integrityHash);
+    HashAlgorithm getIntegrityHash() const;
+    void setAudioResampling(AudioResampling audioResampling);
+    AudioResampling getAudioResampling() const;
 
     void setMainWindowGeometry(QByteArray mainWindowGeometry);
     QByteArray getMainWindowGeometry() const;
@@ -134,8 +178,16 @@ private:
     struct Capture {
         QString captureDirectory;
         CaptureFormat captureFormat;
+        QList<CaptureFormat> additionalCaptureFormats;
         AudioSource audioSource;
+        AudioResampling audioResampling;
+        HashAlgorithm integrityHash;
         bool stopOnDroppedSamples;
+        GapFill gapFill;
+        bool syncAudioHeaders;
+        QString audioPreviewPath;
+        bool writeBestAudio;
+        QString metricsExportPath;
     };
 
     struct Usb {
@@ -143,6 +195,7 @@ private:
         quint16 pid;    // Product ID of USB device
         QString preferredDevice;
         size_t diskBufferQueueSize;
+        size_t stagingBufferSize;
         bool useSmallUsbTransferQueue;
         bool useSmallUsbTransfers;
         bool useWinUsb;
@@ -183,9 +236,17 @@ private:
 
     qint32 convertCaptureFormatToInt(CaptureFormat captureFormat);
     CaptureFormat convertIntToCaptureFormat(qint32 captureInt);
+    qint32 convertCaptureFormatsToMask(const QList<CaptureFormat>& captureFormats);
+    QList<CaptureFormat> convertMaskToCaptureFormats(qint32 captureMask);
     qint32 convertSerialSpeedsToInt(SerialSpeeds serialSpeeds);
     SerialSpeeds convertIntToSerialSpeeds(qint32 serialInt);
     qint32 convertAudioSourceToInt(AudioSource audioSource);
     AudioSource convertIntToAudioSource(qint32 audioInt);
+    qint32 convertHashAlgorithmToInt(HashAlgorithm hashAlgorithm);
+    HashAlgorithm convertIntToHashAlgorithm(qint32 hashInt);
+    qint32 convertAudioResamplingToInt(AudioResampling audioResampling);
+    AudioResampling convertIntToAudioResampling(qint32 resamplingInt);
+    qint32 convertGapFillToInt(GapFill gapFill);
+    GapFill convertIntToGapFill(qint32 gapFillInt);
 };
 
@@ -39,6 +39,8 @@ ConfigurationDialog::ConfigurationDialog(QWidget *parent) :
     ui->captureFormatComboBox->addItem("16-bit Signed Scaled", Configuration::CaptureFormat::sixteenBitSigned);
     ui->captureFormatComboBox->addItem("10-bit Packed Unsigned", Configuration::CaptureFormat::tenBitPacked);
     ui->captureFormatComboBox->addItem("10-bit Packed Unsigned (4:1 decimation for CD)", Configuration::CaptureFormat::tenBitCdPacked);
+    ui->captureFormatComboBox->addItem("10-bit Packed Unsigned (block container with checksums)", Configuration::CaptureFormat::tenBitBlocked);
+    ui->captureFormatComboBox->addItem("16-bit Raw Unsigned (sideband data retained)", Configuration::CaptureFormat::sixteenBitRaw);
 
     // Build the diskBufferQueueSizeComboBox
     ui->diskBufferQueueSizeComboBox->clear();
@@ -47,6 +49,15 @@ ConfigurationDialog::ConfigurationDialog(QWidget *parent) :
     ui->diskBufferQueueSizeComboBox->addItem("256MB", 256 * 1024 * 1024);
     ui->diskBufferQueueSizeComboBox->addItem("512MB", 512 * 1024 * 1024);
 
+    // Build the stagingBufferSizeComboBox
+    ui->stagingBufferSizeComboBox->clear();
+    ui->stagingBufferSizeComboBox->addItem("Disabled", (qulonglong)0);
+    ui->stagingBufferSizeComboBox->addItem("1GiB", (qulonglong)1 * 1024 * 1024 * 1024);
+    ui->stagingBufferSizeComboBox->addItem("2GiB", (qulonglong)2 * 1024 * 1024 * 1024);
+    ui->stagingBufferSizeComboBox->addItem("4GiB", (qulonglong)4 * 1024 * 1024 * 1024);
+    ui->stagingBufferSizeComboBox->addItem("8GiB", (qulonglong)8 * 1024 * 1024 * 1024);
+    ui->stagingBufferSizeComboBox->addItem("16GiB", (qulonglong)16 * 1024 * 1024 * 1024);
+
     // Build the serialSpeedComboBox
     ui->serialSpeedComboBox->clear();
     ui->serialSpeedComboBox->addItem("Auto", Configuration::SerialSpeeds::autoDetect);
@@ -62,6 +73,26 @@ ConfigurationDialog::ConfigurationDialog(QWidget *parent) :
     ui->audioSourceComboBox->addItem("ADC128s022 (integrated ADC, 12-bit stereo)", Configuration::AudioSource::adc128s022);
     ui->audioSourceComboBox->addItem("Both", Configuration::AudioSource::both);
 
+    // Build the audioResamplingComboBox
+    ui->audioResamplingComboBox->clear();
+    ui->audioResamplingComboBox->addItem("None", Configuration::AudioResampling::noResampling);
+    ui->audioResamplingComboBox->addItem("48kHz", Configuration::AudioResampling::resample48kHz);
+    ui->audioResamplingComboBox->addItem("44.1kHz", Configuration::AudioResampling::resample44kHz);
+    ui->audioResamplingComboBox->addItem("48kHz and 44.1kHz", Configuration::AudioResampling::resampleBoth);
+
+    // Build the integrityHashComboBox
+    ui->integrityHashComboBox->clear();
+    ui->integrityHashComboBox->addItem("None", Configuration::HashAlgorithm::noHash);
+    ui->integrityHashComboBox->addItem("CRC32C", Configuration::HashAlgorithm::crc32c);
+    ui->integrityHashComboBox->addItem("xxHash64", Configuration::HashAlgorithm::xxHash64);
+
+    // Build the gapFillComboBox
+    ui->gapFillComboBox->clear();
+    ui->gapFillComboBox->addItem("None", Configuration::GapFill::noGapFill);
+    ui->gapFillComboBox->addItem("Zero", Configuration::GapFill::zeroFill);
+    ui->gapFillComboBox->addItem("Mid-scale", Configuration::GapFill::midScaleFill);
+    ui->gapFillComboBox->addItem("Interpolated", Configuration::GapFill::interpolatedFill);
+
     // If we're running on Linux, disable Windows-specific options.
 #ifndef _WIN32
     ui->useWinUsb->setChecked(false);
@@ -96,14 +127,27 @@ void ConfigurationDialog::loadConfiguration(const Configuration& configuration)
     // Capture
     ui->captureDirectoryLineEdit->setText(configuration.getCaptureDirectory());
     ui->captureFormatComboBox->setCurrentIndex(ui->captureFormatComboBox->findData(static_cast<unsigned int>(configuration.getCaptureFormat())));
+    QList<Configuration::CaptureFormat> additionalCaptureFormats = configuration.getAdditionalCaptureFormats();
+    ui->additionalSixteenBitCheckBox->setChecked(additionalCaptureFormats.contains(Configuration::CaptureFormat::sixteenBitSigned));
+    ui->additionalTenBitCheckBox->setChecked(additionalCaptureFormats.contains(Configuration::CaptureFormat::tenBitPacked));
+    ui->additionalTenBitCdCheckBox->setChecked(additionalCaptureFormats.contains(Configuration::CaptureFormat::tenBitCdPacked));
+    ui->additionalSixteenBitRawCheckBox->setChecked(additionalCaptureFormats.contains(Configuration::CaptureFormat::sixteenBitRaw));
     ui->audioSourceComboBox->setCurrentIndex(ui->audioSourceComboBox->findData(static_cast<unsigned int>(configuration.getAudioSource())));
+    ui->audioResamplingComboBox->setCurrentIndex(ui->audioResamplingComboBox->findData(static_cast<unsigned int>(configuration.getAudioResampling())));
+    ui->integrityHashComboBox->setCurrentIndex(ui->integrityHashComboBox->findData(static_cast<unsigned int>(configuration.getIntegrityHash())));
     ui->stopOnDroppedSamplesCheckBox->setChecked(configuration.getStopOnDroppedSamples());
+    ui->gapFillComboBox->setCurrentIndex(ui->gapFillComboBox->findData(static_cast<unsigned int>(configuration.getGapFill())));
+    ui->syncAudioHeadersCheckBox->setChecked(configuration.getSyncAudioHeaders());
+    ui->audioPreviewPathLineEdit->setText(configuration.getAudioPreviewPath());
+    ui->writeBestAudioCheckBox->setChecked(configuration.getWriteBestAudio());
+    ui->metricsExportPathLineEdit->setText(configuration.getMetricsExportPath());
 
     // USB
     ui->vendorIdLineEdit->setText(QString::number(configuration.getUsbVid()));
     ui->productIdLineEdit->setText(QString::number(configuration.getUsbPid()));
     ui->preferredDeviceComboBox->setCurrentText(configuration.getUsbPreferredDevice());
     ui->diskBufferQueueSizeComboBox->setCurrentIndex(ui->diskBufferQueueSizeComboBox->findData((qulonglong)configuration.getDiskBufferQueueSize()));
+    ui->stagingBufferSizeComboBox->setCurrentIndex(ui->stagingBufferSizeComboBox->findData((qulonglong)configuration.getStagingBufferSize()));
     ui->useSmallUsbTransferQueue->setChecked(configuration.getUseSmallUsbTransferQueue());
     ui->useSmallUsbTransfers->setChecked(configuration.getUseSmallUsbTransfers());
 #ifdef _WIN32
@@ -166,14 +210,28 @@ void ConfigurationDialog::saveConfiguration(Configuration& configuration)
     // Capture
     configuration.setCaptureDirectory(ui->captureDirectoryLineEdit->text());
     configuration.setCaptureFormat(static_cast<Configuration::CaptureFormat>(ui->captureFormatComboBox->itemData(ui->captureFormatComboBox->currentIndex()).toInt()));
+    QList<Configuration::CaptureFormat> additionalCaptureFormats;
+    if (ui->additionalSixteenBitCheckBox->isChecked()) additionalCaptureFormats.append(Configuration::CaptureFormat::sixteenBitSigned);
+    if (ui->additionalTenBitCheckBox->isChecked()) additionalCaptureFormats.append(Configuration::CaptureFormat::tenBitPacked);
+    if (ui->additionalTenBitCdCheckBox->isChecked()) additionalCaptureFormats.append(Configuration::CaptureFormat::tenBitCdPacked);
+    if (ui->additionalSixteenBitRawCheckBox->isChecked()) additionalCaptureFormats.append(Configuration::CaptureFormat::sixteenBitRaw);
+    configuration.setAdditionalCaptureFormats(additionalCaptureFormats);
     configuration.setAudioSource(static_cast<Configuration::AudioSource>(ui->audioSourceComboBox->itemData(ui->audioSourceComboBox->currentIndex()).toInt()));
+    configuration.setAudioResampling(static_cast<Configuration::AudioResampling>(ui->audioResamplingComboBox->itemData(ui->audioResamplingComboBox->currentIndex()).toInt()));
+    configuration.setIntegrityHash(static_cast<Configuration::HashAlgorithm>(ui->integrityHashComboBox->itemData(ui->integrityHashComboBox->currentIndex()).toInt()));
     configuration.setStopOnDroppedSamples(ui->stopOnDroppedSamplesCheckBox->isChecked());
+    configuration.setGapFill(static_cast<Configuration::GapFill>(ui->gapFillComboBox->itemData(ui->gapFillComboBox->currentIndex()).toInt()));
+    configuration.setSyncAudioHeaders(ui->syncAudioHeadersCheckBox->isChecked());
+    configuration.setAudioPreviewPath(ui->audioPreviewPathLineEdit->text());
+    configuration.setWriteBestAudio(ui->writeBestAudioCheckBox->isChecked());
+    configuration.setMetricsExportPath(ui->metricsExportPathLineEdit->text());
 
     // USB
     configuration.setUsbVid(static_cast<quint16>(ui->vendorIdLineEdit->text().toInt()));
     configuration.setUsbPid(static_cast<quint16>(ui->productIdLineEdit->text().toInt()));
     configuration.setUsbPreferredDevice(ui->preferredDeviceComboBox->currentText());
     configuration.setDiskBufferQueueSize((size_t)ui->diskBufferQueueSizeComboBox->itemData(ui->diskBufferQueueSizeComboBox->currentIndex()).toULongLong());
+    configuration.setStagingBufferSize((size_t)ui->stagingBufferSizeComboBox->itemData(ui->stagingBufferSizeComboBox->currentIndex()).toULongLong());
     configuration.setUseSmallUsbTransferQueue(ui->useSmallUsbTransferQueue->isChecked());
     configuration.setUseSmallUsbTransfers(ui->useSmallUsbTransfers->isChecked());
     configuration.setUseWinUsb(ui->useWinUsb->isChecked());
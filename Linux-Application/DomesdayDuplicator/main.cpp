@@ -25,6 +25,7 @@
 
 ************************************************************************/
 #include "mainwindow.h"
+#include "AsyncLogger.h"
 #include "QtLogger.h"
 #include <QApplication>
 #include <QDebug>
@@ -235,7 +236,8 @@ int main(int argc, char *argv[])
 
     // Create our logger
     ILogger::SeverityFilter logSeverityFilter = ILogger::SeverityFilter::DebugOrHigher;
-    QtLogger::unique_ptr log = QtLogger::Create(logSeverityFilter);
+    QtLogger::unique_ptr qtLog = QtLogger::Create(logSeverityFilter);
+    AsyncLogger::unique_ptr log = AsyncLogger::Create(*qtLog.get());
 
     // Process the command line options
     if (isDebugOn) showDebug = true;
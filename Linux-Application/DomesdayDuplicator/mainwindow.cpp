@@ -163,6 +163,17 @@ MainWindow::MainWindow(const ILogger& log, QWidget* parent) :
     connect(storageInfoTimer.get(), SIGNAL(timeout()), this, SLOT(updateStorageInformation()));
     storageInfoTimer->start(200); // Update 5 times per second
 
+    // Create the capture disk benchmark, so we can warn before capture if the disk is too slow for the selected format.
+    // The benchmark writes a significant amount of data, so it's only run when the user requests it.
+    diskBenchmark.reset(new DiskBenchmark(log));
+
+    // Export live capture metrics for external monitoring, if a target has been configured
+    metricsExporter.reset(new MetricsExporter(log));
+    StartMetricsExport();
+    metricsExportTimer.reset(new QTimer(this));
+    connect(metricsExportTimer.get(), SIGNAL(timeout()), this, SLOT(updateMetricsExport()));
+    metricsExportTimer->start(1000); // Update once per second
+
     // Set player as disconnected
     isPlayerConnected = false;
 
@@ -191,7 +202,9 @@ MainWindow::~MainWindow()
     // Ask the threads to stop
     qDebug() << "MainWindow::~MainWindow(): Quit selected; asking threads to stop...";
     if (playerControl->isRunning()) playerControl->stop();
+    metricsExporter.reset();
     usbDevice.reset();
+    diskBenchmark.reset();
 
     // Schedule the objects for deletion
     playerControl->deleteLater();
@@ -227,6 +240,17 @@ void MainWindow::RefreshControlVisibility()
     ui->recentMaxValueLabel->setVisible(showAdvancedCaptureStats);
     ui->recentMaxValueClippedPreLabel->setVisible(showAdvancedCaptureStats);
     ui->recentMaxValueClippedLabel->setVisible(showAdvancedCaptureStats);
+    ui->diskBufferHeadroomPreLabel->setVisible(showAdvancedCaptureStats);
+    ui->diskBufferHeadroomLabel->setVisible(showAdvancedCaptureStats);
+    ui->usbCompletionIntervalPreLabel->setVisible(showAdvancedCaptureStats);
+    ui->usbCompletionIntervalLabel->setVisible(showAdvancedCaptureStats);
+    ui->writeLatencyPreLabel->setVisible(showAdvancedCaptureStats);
+    ui->writeLatencyLabel->setVisible(showAdvancedCaptureStats);
+
+    // Update the staging buffer status visibility
+    bool showStagingBufferStatus = (configuration->getStagingBufferSize() > 0);
+    ui->stagingBufferPreLabel->setVisible(showStagingBufferStatus);
+    ui->stagingBufferLabel->setVisible(showStagingBufferStatus);
     
     // Update audio statistics visibility and title
     auto audioSource = configuration->getAudioSource();
@@ -276,6 +300,9 @@ void MainWindow::configurationChangedSignalHandler()
     // Update the target directory for the storage information
     storageInfo->setPath(configuration->getCaptureDirectory());
 
+    // Restart the metrics export if its target has changed
+    StartMetricsExport();
+
     // Update advanced naming UI
     advancedNamingDialog->setPerSideNotesEnabled(configuration->getPerSideNotesEnabled());
     advancedNamingDialog->setPerSideMintEnabled(configuration->getPerSideMintEnabled());
@@ -542,20 +569,73 @@ void MainWindow::playerDisconnectedSignalHandler()
 
 void MainWindow::updateCaptureStatus()
 {
-    // Update our transfer statistics. We update these even if a transfer is stopping or stopped.
-    size_t mbWritten = usbDevice->GetFileSizeWrittenInBytes() / (1024 * 1024);
+    // Update our transfer statistics. We update these even if a transfer is stopping or stopped. The statistics are
+    // all taken from a single snapshot, so the values shown always belong together.
+    UsbDeviceBase::CaptureStatsSnapshot stats = usbDevice->GetStatsSnapshot();
+    size_t mbWritten = stats.fileSizeWrittenInBytes / (1024 * 1024);
     ui->dataCapturedLabel->setText(QString::number(mbWritten) + (tr(" MiB")));
-    ui->numberOfTransfersLabel->setText(QString::number(usbDevice->GetNumberOfTransfers()));
-    ui->sampleCountLabel->setText(std::to_string(usbDevice->GetProcessedSampleCount()).c_str());
-    ui->minValueLabel->setText(std::to_string(usbDevice->GetMinSampleValue()).c_str());
-    ui->maxValueLabel->setText(std::to_string(usbDevice->GetMaxSampleValue()).c_str());
-    ui->minValueClippedLabel->setText(std::to_string(usbDevice->GetClippedMinSampleCount()).c_str());
-    ui->maxValueClippedLabel->setText(std::to_string(usbDevice->GetClippedMaxSampleCount()).c_str());
-    ui->recentMinValueLabel->setText(std::to_string(usbDevice->GetRecentMinSampleValue()).c_str());
-    ui->recentMaxValueLabel->setText(std::to_string(usbDevice->GetRecentMaxSampleValue()).c_str());
-    ui->recentMinValueClippedLabel->setText(std::to_string(usbDevice->GetRecentClippedMinSampleCount()).c_str());
-    ui->recentMaxValueClippedLabel->setText(std::to_string(usbDevice->GetRecentClippedMaxSampleCount()).c_str());
-    ui->syncLossCountLabel->setText(std::to_string(usbDevice->GetSyncLossCount()).c_str());
+    ui->numberOfTransfersLabel->setText(QString::number(stats.transferCount));
+    ui->sampleCountLabel->setText(std::to_string(stats.rf.processedSampleCount).c_str());
+    ui->minValueLabel->setText(std::to_string(stats.rf.minSampleValue).c_str());
+    ui->maxValueLabel->setText(std::to_string(stats.rf.maxSampleValue).c_str());
+    ui->minValueClippedLabel->setText(std::to_string(stats.rf.clippedMinSampleCount).c_str());
+    ui->maxValueClippedLabel->setText(std::to_string(stats.rf.clippedMaxSampleCount).c_str());
+    ui->recentMinValueLabel->setText(std::to_string(stats.rf.recentMinSampleValue).c_str());
+    ui->recentMaxValueLabel->setText(std::to_string(stats.rf.recentMaxSampleValue).c_str());
+    ui->recentMinValueClippedLabel->setText(std::to_string(stats.rf.recentClippedMinSampleCount).c_str());
+    ui->recentMaxValueClippedLabel->setText(std::to_string(stats.rf.recentClippedMaxSampleCount).c_str());
+    ui->syncLossCountLabel->setText(std::to_string(stats.rf.syncLossCount).c_str());
+
+    // Update the pipeline timing statistics. The fewest free disk buffers seen so far shows how close the capture has
+    // come to overflowing, and the interval and latency percentiles show where any shortfall is coming from.
+    if (configuration->getShowAdvancedCaptureStats())
+    {
+        UsbDeviceBase::PipelineHistograms histograms = usbDevice->GetPipelineHistograms();
+        if (histograms.diskBufferQueueDepth.count > 0)
+        {
+            ui->diskBufferHeadroomLabel->setText(tr("%1 of %2 free at worst, %3 full at p99").arg(histograms.minFreeDiskBufferCount).arg(histograms.diskBufferCount).arg(histograms.diskBufferQueueDepth.GetPercentile(99.0)));
+        }
+        if (histograms.usbCompletionIntervalInMicroseconds.count > 0)
+        {
+            const auto& interval = histograms.usbCompletionIntervalInMicroseconds;
+            ui->usbCompletionIntervalLabel->setText(tr("%1 / %2 / %3 ms (p50 / p99 / max)").arg(interval.GetPercentile(50.0) / 1000.0, 0, 'f', 2).arg(interval.GetPercentile(99.0) / 1000.0, 0, 'f', 2).arg(interval.maxValue / 1000.0, 0, 'f', 2));
+        }
+        if (histograms.writeLatencyInMicroseconds.count > 0)
+        {
+            const auto& latency = histograms.writeLatencyInMicroseconds;
+            ui->writeLatencyLabel->setText(tr("%1 / %2 / %3 ms (p50 / p99 / max)").arg(latency.GetPercentile(50.0) / 1000.0, 0, 'f', 2).arg(latency.GetPercentile(99.0) / 1000.0, 0, 'f', 2).arg(latency.maxValue / 1000.0, 0, 'f', 2));
+        }
+    }
+
+    // Update the staging buffer status. We track a smoothed fill rate for the buffer, and use it to project how long
+    // it'll be until the buffer is full if the disk continues to fall behind at the current rate.
+    size_t stagingBufferSizeInBytes = usbDevice->GetStagingBufferSizeInBytes();
+    if (usbDevice->GetStagingBufferEnabled() && (stagingBufferSizeInBytes > 0))
+    {
+        auto currentTime = std::chrono::steady_clock::now();
+        size_t stagingOccupancyInBytes = usbDevice->GetStagingBufferOccupancyInBytes();
+        double secondsSinceLastSample = std::chrono::duration<double>(currentTime - stagingLastSampleTime).count();
+        if (secondsSinceLastSample > 0.0)
+        {
+            double recentFillRate = ((double)stagingOccupancyInBytes - (double)stagingLastOccupancyInBytes) / secondsSinceLastSample;
+            stagingFillRateInBytesPerSecond = (0.9 * stagingFillRateInBytesPerSecond) + (0.1 * recentFillRate);
+        }
+        stagingLastSampleTime = currentTime;
+        stagingLastOccupancyInBytes = stagingOccupancyInBytes;
+
+        QString stagingStatus = QString("%1 / %2 MiB (%3%)").arg(stagingOccupancyInBytes / (1024 * 1024)).arg(stagingBufferSizeInBytes / (1024 * 1024)).arg((stagingOccupancyInBytes * 100) / stagingBufferSizeInBytes);
+        const double minSignificantFillRate = 1024.0 * 1024.0;
+        if (stagingFillRateInBytesPerSecond >= minSignificantFillRate)
+        {
+            qint64 secondsUntilFull = (qint64)((double)(stagingBufferSizeInBytes - stagingOccupancyInBytes) / stagingFillRateInBytesPerSecond);
+            stagingStatus += tr(", full in ") + QTime(0, 0, 0, 0).addSecs(secondsUntilFull).toString("hh:mm:ss");
+        }
+        else if ((stagingOccupancyInBytes > 0) && (stagingFillRateInBytesPerSecond <= -minSignificantFillRate))
+        {
+            stagingStatus += tr(", draining");
+        }
+        ui->stagingBufferLabel->setText(stagingStatus);
+    }
     
     // Update audio statistics
     auto audioSource = configuration->getAudioSource();
@@ -566,26 +646,26 @@ void MainWindow::updateCaptureStatus()
         size_t audioSampleCount = 0;
         if (audioSource == Configuration::AudioSource::pcm1802 || audioSource == Configuration::AudioSource::both)
         {
-            audioMbWritten = usbDevice->GetAudio24FileSizeWrittenInBytes() / (1024 * 1024);
-            audioSampleCount = usbDevice->GetAudio24FrameCount();
+            audioMbWritten = stats.audio.file24SizeWrittenInBytes / (1024 * 1024);
+            audioSampleCount = stats.audio.frame24Count;
         }
         else if (audioSource == Configuration::AudioSource::adc128s022)
         {
-            audioMbWritten = usbDevice->GetAudioFileSizeWrittenInBytes() / (1024 * 1024);
-            audioSampleCount = usbDevice->GetAudioFrameCount();
+            audioMbWritten = stats.audio.fileSizeWrittenInBytes / (1024 * 1024);
+            audioSampleCount = stats.audio.frameCount;
         }
         
         ui->dataCapturedLabel_2->setText(QString::number(audioMbWritten) + (tr(" MiB")));
         ui->sampleCountLabel_2->setText(std::to_string(audioSampleCount).c_str());
-        ui->minValueLabel_2->setText(std::to_string(usbDevice->GetAudioMinSampleValue()).c_str());
-        ui->maxValueLabel_2->setText(std::to_string(usbDevice->GetAudioMaxSampleValue()).c_str());
-        ui->minValueClippedLabel_2->setText(std::to_string(usbDevice->GetAudioClippedMinSampleCount()).c_str());
-        ui->maxValueClippedLabel_2->setText(std::to_string(usbDevice->GetAudioClippedMaxSampleCount()).c_str());
-        ui->recentMinValueLabel_2->setText(std::to_string(usbDevice->GetAudioRecentMinSampleValue()).c_str());
-        ui->recentMaxValueLabel_2->setText(std::to_string(usbDevice->GetAudioRecentMaxSampleValue()).c_str());
-        ui->recentMinValueClippedLabel_2->setText(std::to_string(usbDevice->GetAudioRecentClippedMinSampleCount()).c_str());
-        ui->recentMaxValueClippedLabel_2->setText(std::to_string(usbDevice->GetAudioRecentClippedMaxSampleCount()).c_str());
-        ui->meanAmplitudeLabel_2->setText(QString::number(usbDevice->GetAudioMeanAmplitude(), 'f', 3));
+        ui->minValueLabel_2->setText(std::to_string(stats.audio.minSampleValue).c_str());
+        ui->maxValueLabel_2->setText(std::to_string(stats.audio.maxSampleValue).c_str());
+        ui->minValueClippedLabel_2->setText(std::to_string(stats.audio.clippedMinSampleCount).c_str());
+        ui->maxValueClippedLabel_2->setText(std::to_string(stats.audio.clippedMaxSampleCount).c_str());
+        ui->recentMinValueLabel_2->setText(std::to_string(stats.audio.recentMinSampleValue).c_str());
+        ui->recentMaxValueLabel_2->setText(std::to_string(stats.audio.recentMaxSampleValue).c_str());
+        ui->recentMinValueClippedLabel_2->setText(std::to_string(stats.audio.recentClippedMinSampleCount).c_str());
+        ui->recentMaxValueClippedLabel_2->setText(std::to_string(stats.audio.recentClippedMaxSampleCount).c_str());
+        ui->meanAmplitudeLabel_2->setText(QString::number(stats.audio.meanAmplitude, 'f', 3));
     }
 
     // If the capture process was requeted to stop and has now in fact stopped, perform our final tasks for this capture
@@ -634,6 +714,21 @@ void MainWindow::updateCaptureStatus()
             usedCaptureFilePath = durationFilePath;
         }
 
+        // Rename any additional output files to match the main output file
+        std::vector<std::filesystem::path> usedAdditionalOutputFilePaths;
+        for (size_t i = 0; i < usbDevice->GetAdditionalOutputCount(); ++i)
+        {
+            auto additionalOutputFilePath = usbDevice->GetAdditionalOutputFilePath(i);
+            auto usedAdditionalOutputFilePath = usedCaptureFilePath;
+            usedAdditionalOutputFilePath.replace_extension(additionalOutputFilePath.extension());
+            if (usedAdditionalOutputFilePath != additionalOutputFilePath)
+            {
+                std::filesystem::rename(additionalOutputFilePath, usedAdditionalOutputFilePath);
+                qDebug() << "MainWindow::StartCapture(): Renamed file to" << usedAdditionalOutputFilePath;
+            }
+            usedAdditionalOutputFilePaths.push_back(usedAdditionalOutputFilePath);
+        }
+
         // Build our json metadata
         nlohmann::json infoFile;
 
@@ -758,16 +853,155 @@ void MainWindow::updateCaptureStatus()
         // Populate the capture info
         infoFile["captureInfo"]["transferResult"] = (int)usbDevice->GetTransferResult();
         infoFile["captureInfo"]["durationInMilliseconds"] = std::chrono::round<std::chrono::milliseconds>(captureElapsedTime).count();
-        infoFile["captureInfo"]["transferCount"] = usbDevice->GetNumberOfTransfers();
-        infoFile["captureInfo"]["numberOfDiskBuffersWritten"] = usbDevice->GetNumberOfDiskBuffersWritten();
-        infoFile["captureInfo"]["fileSizeWrittenInBytes"] = usbDevice->GetFileSizeWrittenInBytes();
-        infoFile["captureInfo"]["sampleCount"] = usbDevice->GetProcessedSampleCount();
-        infoFile["captureInfo"]["minSampleValue"] = usbDevice->GetMinSampleValue();
-        infoFile["captureInfo"]["maxSampleValue"] = usbDevice->GetMaxSampleValue();
-        infoFile["captureInfo"]["clippedMinSampleCount"] = usbDevice->GetClippedMinSampleCount();
-        infoFile["captureInfo"]["clippedMaxSampleCount"] = usbDevice->GetClippedMaxSampleCount();
+        infoFile["captureInfo"]["transferCount"] = stats.transferCount;
+        infoFile["captureInfo"]["numberOfDiskBuffersWritten"] = stats.diskBufferWrittenCount;
+        infoFile["captureInfo"]["fileSizeWrittenInBytes"] = stats.fileSizeWrittenInBytes;
+        infoFile["captureInfo"]["sampleCount"] = stats.rf.processedSampleCount;
+        infoFile["captureInfo"]["minSampleValue"] = stats.rf.minSampleValue;
+        infoFile["captureInfo"]["maxSampleValue"] = stats.rf.maxSampleValue;
+        infoFile["captureInfo"]["clippedMinSampleCount"] = stats.rf.clippedMinSampleCount;
+        infoFile["captureInfo"]["clippedMaxSampleCount"] = stats.rf.clippedMaxSampleCount;
         infoFile["captureInfo"]["sequenceMarkersPresent"] = usbDevice->GetTransferHadSequenceNumbers();
+        infoFile["captureInfo"]["discontinuityMapFileName"] = usbDevice->GetDiscontinuityMapFilePath().filename().string();
+        infoFile["captureInfo"]["discontinuityCount"] = usbDevice->GetDiscontinuityRecordCount();
+        infoFile["captureInfo"]["discontinuityDroppedCount"] = usbDevice->GetDiscontinuityDroppedRecordCount();
+        infoFile["captureInfo"]["syncLossCount"] = stats.rf.syncLossCount;
+        infoFile["captureInfo"]["counterMismatchCount"] = stats.rf.counterMismatchCount;
+        infoFile["captureInfo"]["suppressedLogMessageCount"] = stats.rf.suppressedLogMessageCount;
+        infoFile["captureInfo"]["gapFill"]["mode"] = UsbDeviceBase::GetGapFillModeName(usbDevice->GetGapFillMode());
+        infoFile["captureInfo"]["gapFill"]["filledSampleCount"] = stats.rf.filledSampleCount;
         infoFile["captureInfo"]["creationTimestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString();
+        UsbDeviceBase::PipelineHistograms histograms = usbDevice->GetPipelineHistograms();
+        auto histogramToJson = [](const Histogram::Snapshot& snapshot)
+        {
+            nlohmann::json histogramInfo;
+            histogramInfo["count"] = snapshot.count;
+            histogramInfo["min"] = snapshot.minValue;
+            histogramInfo["mean"] = snapshot.GetMean();
+            histogramInfo["p50"] = snapshot.GetPercentile(50.0);
+            histogramInfo["p90"] = snapshot.GetPercentile(90.0);
+            histogramInfo["p99"] = snapshot.GetPercentile(99.0);
+            histogramInfo["p999"] = snapshot.GetPercentile(99.9);
+            histogramInfo["max"] = snapshot.maxValue;
+            return histogramInfo;
+        };
+        infoFile["captureInfo"]["pipeline"]["diskBufferCount"] = histograms.diskBufferCount;
+        infoFile["captureInfo"]["pipeline"]["minFreeDiskBufferCount"] = histograms.minFreeDiskBufferCount;
+        infoFile["captureInfo"]["pipeline"]["diskBufferQueueDepth"] = histogramToJson(histograms.diskBufferQueueDepth);
+        infoFile["captureInfo"]["pipeline"]["usbCompletionIntervalInMicroseconds"] = histogramToJson(histograms.usbCompletionIntervalInMicroseconds);
+        infoFile["captureInfo"]["pipeline"]["writeLatencyInMicroseconds"] = histogramToJson(histograms.writeLatencyInMicroseconds);
+        if (usbDevice->GetStagingBufferEnabled())
+        {
+            infoFile["captureInfo"]["stagingBufferSizeInBytes"] = configuration->getStagingBufferSize();
+            infoFile["captureInfo"]["stagingBufferPeakOccupancyInBytes"] = usbDevice->GetStagingBufferPeakOccupancyInBytes();
+        }
+        if (configuration->getAudioSource() != Configuration::AudioSource::none)
+        {
+            infoFile["captureInfo"]["audio"]["complete"] = !usbDevice->GetAudioWriteFailed() && (stats.audioDroppedFrameCount == 0) && (stats.audioSegmentOverflowFrameCount == 0);
+            infoFile["captureInfo"]["audio"]["droppedFrameCount"] = stats.audioDroppedFrameCount;
+            infoFile["captureInfo"]["audio"]["segmentOverflowFrameCount"] = stats.audioSegmentOverflowFrameCount;
+            infoFile["captureInfo"]["audio"]["missingFrameCount"] = stats.audio.missingFrameCount;
+            infoFile["captureInfo"]["audio"]["filledFrameCount"] = stats.audio.filledFrameCount;
+            infoFile["captureInfo"]["audio"]["alignmentIndexFileName"] = usbDevice->GetAudioAlignmentFilePath().filename().string();
+            for (size_t i = 0; i < usbDevice->GetResampledAudioOutputCount(); ++i)
+            {
+                nlohmann::json resampledOutputInfo;
+                resampledOutputInfo["sampleRate"] = usbDevice->GetResampledAudioOutputSampleRate(i);
+                resampledOutputInfo["fileName"] = usbDevice->GetResampledAudioOutputFilePath(i).filename().string();
+                resampledOutputInfo["fileSizeWrittenInBytes"] = usbDevice->GetResampledAudioOutputFileSizeWrittenInBytes(i);
+                resampledOutputInfo["complete"] = usbDevice->GetResampledAudioOutputComplete(i);
+                infoFile["captureInfo"]["audio"]["resampledOutputs"].push_back(resampledOutputInfo);
+            }
+            if (usbDevice->GetAudioSourceAnalysisEnabled())
+            {
+                // Summarize how the two converters compared, and record the measurements for every window
+                std::vector<AudioSourceAnalyzer::WindowResult> sourceAnalysis = usbDevice->GetAudioSourceAnalysis();
+                size_t adc128s022PreferredWindowCount = 0;
+                size_t adc128s022ClippedSampleCount = 0;
+                size_t pcm1802ClippedSampleCount = 0;
+                double minCorrelation = sourceAnalysis.empty() ? 0.0 : 1.0;
+                nlohmann::json windowInfoList = nlohmann::json::array();
+                for (const AudioSourceAnalyzer::WindowResult& window : sourceAnalysis)
+                {
+                    nlohmann::json windowInfo;
+                    windowInfo["firstSampleIndex"] = window.firstSampleIndex;
+                    windowInfo["sampleCount"] = window.sampleCount;
+                    for (size_t channel = 0; channel < 2; ++channel)
+                    {
+                        windowInfo["adc128s022"]["snrDb"].push_back(window.adc128s022[channel].snrDb);
+                        windowInfo["adc128s022"]["clippedSampleCount"].push_back(window.adc128s022[channel].clippedSampleCount);
+                        windowInfo["pcm1802"]["snrDb"].push_back(window.pcm1802[channel].snrDb);
+                        windowInfo["pcm1802"]["clippedSampleCount"].push_back(window.pcm1802[channel].clippedSampleCount);
+                        windowInfo["correlation"].push_back(window.correlation[channel]);
+                        adc128s022ClippedSampleCount += window.adc128s022[channel].clippedSampleCount;
+                        pcm1802ClippedSampleCount += window.pcm1802[channel].clippedSampleCount;
+                        minCorrelation = std::min(minCorrelation, window.correlation[channel]);
+                    }
+                    windowInfo["preferredSource"] = (window.preferredSource == AudioSourceAnalyzer::Source::Adc128s022) ? "adc128s022" : "pcm1802";
+                    windowInfo["selectedSource"] = (window.selectedSource == AudioSourceAnalyzer::Source::Adc128s022) ? "adc128s022" : "pcm1802";
+                    windowInfoList.push_back(windowInfo);
+                    adc128s022PreferredWindowCount += (window.preferredSource == AudioSourceAnalyzer::Source::Adc128s022) ? 1 : 0;
+                }
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["windowCount"] = sourceAnalysis.size();
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["adc128s022PreferredWindowCount"] = adc128s022PreferredWindowCount;
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["pcm1802PreferredWindowCount"] = sourceAnalysis.size() - adc128s022PreferredWindowCount;
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["adc128s022ClippedSampleCount"] = adc128s022ClippedSampleCount;
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["pcm1802ClippedSampleCount"] = pcm1802ClippedSampleCount;
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["minCorrelation"] = minCorrelation;
+                infoFile["captureInfo"]["audio"]["sourceAnalysis"]["windows"] = windowInfoList;
+                if (!usbDevice->GetAudioBestFilePath().empty())
+                {
+                    infoFile["captureInfo"]["audio"]["sourceAnalysis"]["bestFileName"] = usbDevice->GetAudioBestFilePath().filename().string();
+                    infoFile["captureInfo"]["audio"]["sourceAnalysis"]["bestFileSizeWrittenInBytes"] = usbDevice->GetAudioBestFileSizeWrittenInBytes();
+                }
+            }
+        }
+
+        // Record every RF output file written during the capture, starting with the main output.
+        nlohmann::json mainOutputInfo;
+        mainOutputInfo["format"] = UsbDeviceBase::GetCaptureFormatName(usbDevice->GetCaptureFormat());
+        mainOutputInfo["fileName"] = usedCaptureFilePath.filename().string();
+        mainOutputInfo["fileSizeWrittenInBytes"] = stats.fileSizeWrittenInBytes;
+        if (usbDevice->GetHashAlgorithm() != StreamHasher::Algorithm::None)
+        {
+            mainOutputInfo["integrityHash"] = usbDevice->GetFileHash();
+        }
+        infoFile["captureInfo"]["outputs"].push_back(mainOutputInfo);
+        for (size_t i = 0; i < usbDevice->GetAdditionalOutputCount(); ++i)
+        {
+            nlohmann::json additionalOutputInfo;
+            additionalOutputInfo["format"] = UsbDeviceBase::GetCaptureFormatName(usbDevice->GetAdditionalOutputFormat(i));
+            additionalOutputInfo["fileName"] = usedAdditionalOutputFilePaths[i].filename().string();
+            additionalOutputInfo["fileSizeWrittenInBytes"] = usbDevice->GetAdditionalOutputFileSizeWrittenInBytes(i);
+            additionalOutputInfo["complete"] = usbDevice->GetAdditionalOutputComplete(i);
+            additionalOutputInfo["droppedBufferCount"] = usbDevice->GetAdditionalOutputDroppedBufferCount(i);
+            if (usbDevice->GetHashAlgorithm() != StreamHasher::Algorithm::None)
+            {
+                additionalOutputInfo["integrityHash"] = usbDevice->GetAdditionalOutputFileHash(i);
+            }
+            infoFile["captureInfo"]["outputs"].push_back(additionalOutputInfo);
+        }
+
+        // Record the hash algorithm and the integrity hashes of the audio streams, if they were calculated during the
+        // capture. The hash of each RF output is recorded with the output above. The audio hashes only cover the data
+        // chunk of each wave file, which starts at the recorded offset, since the header is rewritten when the capture
+        // ends. To verify a file, hash its contents from that offset to the end.
+        if (usbDevice->GetHashAlgorithm() != StreamHasher::Algorithm::None)
+        {
+            infoFile["captureInfo"]["integrityHash"]["algorithm"] = usbDevice->GetHashAlgorithmName();
+            if ((stats.audio.fileSizeWrittenInBytes > 0) || (stats.audio.file24SizeWrittenInBytes > 0))
+            {
+                infoFile["captureInfo"]["integrityHash"]["audioDataOffsetInBytes"] = WavHeader::HeaderSizeInBytes;
+            }
+            if (stats.audio.fileSizeWrittenInBytes > 0)
+            {
+                infoFile["captureInfo"]["integrityHash"]["audioIntegratedAdcData"] = usbDevice->GetAudioDataHash();
+            }
+            if (stats.audio.file24SizeWrittenInBytes > 0)
+            {
+                infoFile["captureInfo"]["integrityHash"]["audioExternalAdcData"] = usbDevice->GetAudio24DataHash();
+            }
+        }
 
         // Helper function to turn our sample times into a millisecond count since the start of the capture process,
         // encoded as fixed-length strings with 8 characters. This is enough to keep the indexes in numeric order for
@@ -790,6 +1024,43 @@ void MainWindow::updateCaptureStatus()
             }
         }
 
+        // Populate the audio level record. When both audio sources were captured, the channels of the PCM1802 are
+        // recorded as usual, and the ADC128S022 levels are recorded under their own key.
+        for (const auto& entry : audioLevelRecord)
+        {
+            auto sampleTimeString = sampleTimeToString(entry.sampleTime);
+            const char* channelNames[] = { "left", "right" };
+            for (size_t channel = 0; channel < entry.levels.channels.size(); ++channel)
+            {
+                const auto& channelLevels = entry.levels.channels[channel];
+                auto& channelRecord = infoFile["timeSampledData"]["audioLevelRecord"][sampleTimeString][channelNames[channel]];
+                channelRecord["peak"] = channelLevels.peak;
+                channelRecord["rms"] = channelLevels.rms;
+                channelRecord["truePeak"] = channelLevels.truePeak;
+                if (entry.levels.secondaryChannelsPresent)
+                {
+                    const auto& secondaryChannelLevels = entry.levels.secondaryChannels[channel];
+                    auto& secondaryChannelRecord = infoFile["timeSampledData"]["audioLevelRecord"][sampleTimeString]["adc128s022"][channelNames[channel]];
+                    secondaryChannelRecord["peak"] = secondaryChannelLevels.peak;
+                    secondaryChannelRecord["rms"] = secondaryChannelLevels.rms;
+                    secondaryChannelRecord["truePeak"] = secondaryChannelLevels.truePeak;
+                }
+            }
+        }
+
+        // Populate the throughput record. Each entry covers the interval since the previous entry, which is nominally one
+        // second.
+        for (const auto& entry : usbDevice->GetThroughputSamples())
+        {
+            auto sampleTimeString = sampleTimeToString(entry.sampleTime);
+            auto& throughputRecord = infoFile["timeSampledData"]["throughputRecord"][sampleTimeString];
+            throughputRecord["transferredSizeInBytes"] = entry.transferredSizeInBytes;
+            throughputRecord["writtenSizeInBytes"] = entry.writtenSizeInBytes;
+            throughputRecord["syncLossCount"] = entry.syncLossCount;
+            throughputRecord["minFreeDiskBufferCount"] = entry.minFreeDiskBufferCount;
+            throughputRecord["processingCpuTimeInMicroseconds"] = entry.processingCpuTime.count();
+        }
+
         // Populate the timecode/frame number record
         for (const auto& entry : playerTimeCodeRecord)
         {
@@ -852,6 +1123,7 @@ void MainWindow::updateCaptureStatus()
         ui->capturePushButton->setEnabled(true);
         ui->actionTest_mode->setEnabled(true);
         ui->actionPreferences->setEnabled(true);
+        ui->actionTest_disk_speed->setEnabled(true);
         return;
     }
 
@@ -1187,23 +1459,7 @@ void MainWindow::updateStorageInformation()
     storageInfo->refresh();
     if (storageInfo->isValid()) {
         // Calculate the space required per second based on the selected sample format
-        size_t samplesPerSecond = 40 * 1000 * 1000;
-        size_t bytesPerSecond = 0;
-        switch (configuration->getCaptureFormat())
-        {
-        case Configuration::CaptureFormat::sixteenBitSigned:
-            // 2 bytes per sample
-            bytesPerSecond = samplesPerSecond * 2;
-            break;
-        case Configuration::CaptureFormat::tenBitPacked:
-            // 5 bytes every 4 samples
-            bytesPerSecond = (samplesPerSecond / 4) * 5;
-            break;
-        case Configuration::CaptureFormat::tenBitCdPacked:
-            // 5 bytes every 16 samples
-            bytesPerSecond = (samplesPerSecond / 16) * 5;
-            break;
-        }
+        size_t bytesPerSecond = GetCaptureDataRateInBytesPerSecond();
 
         // Calculate the amount of time we can record based on the available space
         size_t bytesAvailable = (size_t)storageInfo->bytesAvailable();
@@ -1228,6 +1484,245 @@ void MainWindow::updateStorageInformation()
         ui->spaceAvailableLabel->setText(tr("Unknown"));
     }
 
+    // Show the result of the disk benchmark, highlighting it if the disk can't keep up with the selected format.
+    std::optional<DiskBenchmark::Result> benchmarkResult = GetDiskBenchmarkResult();
+    QString insufficientReason;
+    if (diskBenchmark->IsRunning())
+    {
+        ui->diskSpeedLabel->setText(tr("Testing..."));
+        ui->diskSpeedLabel->setStyleSheet("");
+    }
+    else if (!benchmarkResult.has_value())
+    {
+        ui->diskSpeedLabel->setText(tr("Not tested"));
+        ui->diskSpeedLabel->setStyleSheet("");
+    }
+    else
+    {
+        QString speedText = QString("%1 MB/s, p99 %2 ms").arg(benchmarkResult->throughputInBytesPerSecond / (1000.0 * 1000.0), 0, 'f', 1)
+                                                         .arg((double)benchmarkResult->p99WriteLatency.count() / 1000.0, 0, 'f', 1);
+        if (IsDiskBenchmarkSufficient(*benchmarkResult, insufficientReason))
+        {
+            ui->diskSpeedLabel->setText(speedText);
+            ui->diskSpeedLabel->setStyleSheet("");
+        }
+        else
+        {
+            ui->diskSpeedLabel->setText(speedText + tr(" (too slow)"));
+            ui->diskSpeedLabel->setStyleSheet("color: red");
+        }
+    }
+}
+
+size_t MainWindow::GetCaptureDataRateInBytesPerSecond() const
+{
+    // Build the set of formats being written, since any additional outputs are written to the same volume
+    QList<Configuration::CaptureFormat> captureFormats = { configuration->getCaptureFormat() };
+    for (Configuration::CaptureFormat additionalFormat : configuration->getAdditionalCaptureFormats())
+    {
+        if (!captureFormats.contains(additionalFormat))
+        {
+            captureFormats.append(additionalFormat);
+        }
+    }
+
+    // Calculate the amount of data written per second based on the selected sample formats
+    size_t samplesPerSecond = 40 * 1000 * 1000;
+    size_t bytesPerSecond = 0;
+    for (Configuration::CaptureFormat captureFormat : captureFormats)
+    {
+        switch (captureFormat)
+        {
+        case Configuration::CaptureFormat::sixteenBitSigned:
+            // 2 bytes per sample
+            bytesPerSecond += samplesPerSecond * 2;
+            break;
+        case Configuration::CaptureFormat::tenBitPacked:
+            // 5 bytes every 4 samples
+            bytesPerSecond += (samplesPerSecond / 4) * 5;
+            break;
+        case Configuration::CaptureFormat::tenBitCdPacked:
+            // 5 bytes every 16 samples
+            bytesPerSecond += (samplesPerSecond / 16) * 5;
+            break;
+        case Configuration::CaptureFormat::tenBitBlocked:
+            // 5 bytes every 4 samples, plus a small allowance for the block headers and index
+            bytesPerSecond += ((samplesPerSecond / 4) * 5) + (((samplesPerSecond / 4) * 5) / 1000);
+            break;
+        case Configuration::CaptureFormat::sixteenBitRaw:
+            // 2 bytes per sample
+            bytesPerSecond += samplesPerSecond * 2;
+            break;
+        }
+    }
+    return bytesPerSecond;
+}
+
+void MainWindow::GetDiskBenchmarkTarget(std::filesystem::path& directory, bool& useWriteThrough) const
+{
+    // Determine how the capture process will write to the target directory. Write-through is only used on Windows,
+    // when asynchronous IO is selected and the output isn't being staged in memory.
+    directory = std::filesystem::path((char8_t const*)configuration->getCaptureDirectory().toUtf8().data());
+#ifdef _WIN32
+    useWriteThrough = configuration->getUseAsyncFileIo() && (configuration->getStagingBufferSize() == 0);
+#else
+    useWriteThrough = false;
+#endif
+}
+
+std::optional<DiskBenchmark::Result> MainWindow::GetDiskBenchmarkResult() const
+{
+    // Only return the last benchmark result if it was measured for the current capture directory and write method
+    std::filesystem::path directory;
+    bool useWriteThrough;
+    GetDiskBenchmarkTarget(directory, useWriteThrough);
+    std::optional<DiskBenchmark::Result> benchmarkResult = diskBenchmark->GetResult();
+    if (!benchmarkResult.has_value() || (benchmarkResult->directory != directory) || (benchmarkResult->usedWriteThrough != useWriteThrough))
+    {
+        return std::nullopt;
+    }
+    return benchmarkResult;
+}
+
+void MainWindow::StartDiskBenchmark()
+{
+    // Never benchmark while capturing, as we'd be competing with the capture for disk bandwidth.
+    if (isCaptureRunning)
+    {
+        return;
+    }
+
+    // Start the benchmark
+    std::filesystem::path directory;
+    bool useWriteThrough;
+    GetDiskBenchmarkTarget(directory, useWriteThrough);
+    qDebug() << "MainWindow::StartDiskBenchmark(): Benchmarking capture directory" << configuration->getCaptureDirectory();
+    diskBenchmark->Start(directory, useWriteThrough);
+}
+
+bool MainWindow::IsDiskBenchmarkSufficient(const DiskBenchmark::Result& result, QString& reason) const
+{
+    // Ensure the sustained throughput exceeds the capture data rate with a reasonable margin, to allow for the audio
+    // streams and other activity on the same volume.
+    double requiredBytesPerSecond = (double)GetCaptureDataRateInBytesPerSecond() * 1.1;
+    if (result.throughputInBytesPerSecond < requiredBytesPerSecond)
+    {
+        reason = tr("The capture disk can sustain %1 MB/s, but the selected capture format requires at least %2 MB/s.")
+                     .arg(result.throughputInBytesPerSecond / (1000.0 * 1000.0), 0, 'f', 1)
+                     .arg(requiredBytesPerSecond / (1000.0 * 1000.0), 0, 'f', 1);
+        return false;
+    }
+
+    // Ensure no single write stalled for long enough to use up a large part of our buffering. The disk buffer queue
+    // and any staging buffer both allow writes to fall behind temporarily without losing data.
+    double bufferedSeconds = (double)(configuration->getDiskBufferQueueSize() + configuration->getStagingBufferSize()) / (double)GetCaptureDataRateInBytesPerSecond();
+    double maxWriteLatencySeconds = (double)result.maxWriteLatency.count() / (1000.0 * 1000.0);
+    if (maxWriteLatencySeconds > (bufferedSeconds / 2))
+    {
+        reason = tr("A write to the capture disk stalled for %1 ms, but the configured buffers only cover %2 ms of capture data.")
+                     .arg(maxWriteLatencySeconds * 1000.0, 0, 'f', 0)
+                     .arg(bufferedSeconds * 1000.0, 0, 'f', 0);
+        return false;
+    }
+    return true;
+}
+
+bool MainWindow::ConfirmDiskSpeedSufficient()
+{
+    // If the capture disk benchmark found the disk too slow for the selected format, give the user the chance to back
+    // out before starting the capture.
+    std::optional<DiskBenchmark::Result> benchmarkResult = GetDiskBenchmarkResult();
+    QString insufficientReason;
+    if (diskBenchmark->IsRunning() || !benchmarkResult.has_value() || IsDiskBenchmarkSufficient(*benchmarkResult, insufficientReason))
+    {
+        return true;
+    }
+    qDebug() << "MainWindow::ConfirmDiskSpeedSufficient():" << insufficientReason;
+    QMessageBox::StandardButton response = QMessageBox::warning(this, tr("Capture disk too slow"),
+        insufficientReason + tr("\n\nSamples are likely to be dropped during capture. Do you want to start the capture anyway?"),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+    return (response == QMessageBox::Yes);
+}
+
+void MainWindow::StartMetricsExport()
+{
+    // If we're already exporting to the configured target, there's nothing to do
+    std::filesystem::path metricsExportPath((char8_t const*)configuration->getMetricsExportPath().toUtf8().data());
+    if (metricsExporter->IsRunning() && (metricsExporter->GetPath() == metricsExportPath))
+    {
+        return;
+    }
+    metricsExporter->Stop();
+    if (metricsExportPath.empty())
+    {
+        return;
+    }
+    if (!metricsExporter->Start(metricsExportPath))
+    {
+        qDebug() << "MainWindow::StartMetricsExport(): Failed to start the metrics export to" << configuration->getMetricsExportPath();
+        return;
+    }
+    updateMetricsExport();
+}
+
+// Timer callback to publish the live capture metrics
+void MainWindow::updateMetricsExport()
+{
+    if (!metricsExporter->IsRunning())
+    {
+        return;
+    }
+
+    // Build the metrics from the same published statistics shown in the capture status. These can be read at any time
+    // without waiting on the capture threads.
+    UsbDeviceBase::CaptureStatsSnapshot stats = usbDevice->GetStatsSnapshot();
+    UsbDeviceBase::PipelineHistograms histograms = usbDevice->GetPipelineHistograms();
+    double captureElapsedSeconds = isCaptureRunning ? std::chrono::duration<double>(std::chrono::steady_clock::now() - captureStartTime).count() : 0.0;
+    std::string metricsText;
+
+    // Capture state
+    MetricsExporter::AppendGauge(metricsText, "device_present", "Whether a capture device is attached", usbDevicePresentLastCheck ? 1.0 : 0.0);
+    MetricsExporter::AppendGauge(metricsText, "capture_running", "Whether a capture is in progress", isCaptureRunning ? 1.0 : 0.0);
+    MetricsExporter::AppendGauge(metricsText, "capture_elapsed_seconds", "Time since the current capture started, or zero if no capture is in progress", captureElapsedSeconds);
+    MetricsExporter::AppendInfo(metricsText, "capture_result", "Result of the current or most recent capture", "result", UsbDeviceBase::GetTransferResultName(usbDevice->GetTransferResult()));
+
+    // Transfer progress. These counters restart from zero with each capture.
+    MetricsExporter::AppendCounter(metricsText, "usb_transfers_total", "USB transfers completed in the current capture", (double)stats.transferCount);
+    MetricsExporter::AppendCounter(metricsText, "disk_buffers_written_total", "Disk buffers processed and written in the current capture", (double)stats.diskBufferWrittenCount);
+    MetricsExporter::AppendCounter(metricsText, "written_bytes_total", "Bytes written to the capture file in the current capture", (double)stats.fileSizeWrittenInBytes);
+
+    // RF statistics
+    MetricsExporter::AppendCounter(metricsText, "rf_samples_total", "RF samples processed in the current capture", (double)stats.rf.processedSampleCount);
+    MetricsExporter::AppendCounter(metricsText, "rf_clipped_min_samples_total", "RF samples clipped at the minimum value in the current capture", (double)stats.rf.clippedMinSampleCount);
+    MetricsExporter::AppendCounter(metricsText, "rf_clipped_max_samples_total", "RF samples clipped at the maximum value in the current capture", (double)stats.rf.clippedMaxSampleCount);
+    MetricsExporter::AppendCounter(metricsText, "rf_sync_losses_total", "Losses of sequence sync in the current capture", (double)stats.rf.syncLossCount);
+    MetricsExporter::AppendCounter(metricsText, "rf_counter_mismatches_total", "Sequence counter mismatches in the current capture", (double)stats.rf.counterMismatchCount);
+    MetricsExporter::AppendCounter(metricsText, "log_messages_suppressed_total", "Repeated capture log messages suppressed by rate limiting in the current capture", (double)stats.rf.suppressedLogMessageCount);
+    MetricsExporter::AppendCounter(metricsText, "rf_filled_samples_total", "RF samples inserted to fill gaps in the current capture", (double)stats.rf.filledSampleCount);
+    MetricsExporter::AppendGauge(metricsText, "rf_recent_min_sample_value", "Lowest RF sample value in the most recent disk buffer", (double)stats.rf.recentMinSampleValue);
+    MetricsExporter::AppendGauge(metricsText, "rf_recent_max_sample_value", "Highest RF sample value in the most recent disk buffer", (double)stats.rf.recentMaxSampleValue);
+
+    // Audio statistics
+    MetricsExporter::AppendCounter(metricsText, "audio_integrated_adc_frames_total", "Audio frames written from the integrated ADC in the current capture", (double)stats.audio.frameCount);
+    MetricsExporter::AppendCounter(metricsText, "audio_external_adc_frames_total", "Audio frames written from the external ADC in the current capture", (double)stats.audio.frame24Count);
+    MetricsExporter::AppendCounter(metricsText, "audio_missing_frames_total", "Audio frames missing from the sideband data in the current capture", (double)stats.audio.missingFrameCount);
+    MetricsExporter::AppendCounter(metricsText, "audio_filled_frames_total", "Silent audio frames inserted to fill gaps in the current capture", (double)stats.audio.filledFrameCount);
+    MetricsExporter::AppendCounter(metricsText, "audio_dropped_frames_total", "Audio frames dropped because the audio writer fell behind in the current capture", (double)stats.audioDroppedFrameCount);
+    MetricsExporter::AppendCounter(metricsText, "audio_segment_overflow_frames_total", "Audio frames dropped because frame sync was lost too often within a disk buffer in the current capture", (double)stats.audioSegmentOverflowFrameCount);
+    MetricsExporter::AppendGauge(metricsText, "audio_mean_amplitude", "Mean audio amplitude over the most recent batch", stats.audio.meanAmplitude);
+
+    // Buffer state
+    MetricsExporter::AppendGauge(metricsText, "disk_buffers", "Disk buffers allocated for the current capture", (double)histograms.diskBufferCount);
+    MetricsExporter::AppendGauge(metricsText, "disk_buffers_min_free", "Fewest disk buffers free at any point in the current capture", (double)histograms.minFreeDiskBufferCount);
+    MetricsExporter::AppendGauge(metricsText, "staging_buffer_size_bytes", "Size of the staging buffer, or zero if not in use", usbDevice->GetStagingBufferEnabled() ? (double)usbDevice->GetStagingBufferSizeInBytes() : 0.0);
+    MetricsExporter::AppendGauge(metricsText, "staging_buffer_occupancy_bytes", "Bytes waiting in the staging buffer to be written", usbDevice->GetStagingBufferEnabled() ? (double)usbDevice->GetStagingBufferOccupancyInBytes() : 0.0);
+
+    // Pipeline timing
+    MetricsExporter::AppendHistogram(metricsText, "disk_buffer_queue_depth", "Full disk buffers waiting for processing as each USB transfer completes", histograms.diskBufferQueueDepth, 1.0);
+    MetricsExporter::AppendHistogram(metricsText, "usb_completion_interval_seconds", "Time between USB transfer completions", histograms.usbCompletionIntervalInMicroseconds, 1e-6);
+    MetricsExporter::AppendHistogram(metricsText, "write_latency_seconds", "Time taken by each write to the capture file", histograms.writeLatencyInMicroseconds, 1e-6);
+
+    metricsExporter->Publish(std::move(metricsText));
 }
 
 void MainWindow::startPlayerControl()
@@ -1308,6 +1803,12 @@ void MainWindow::on_actionPreferences_triggered()
     configurationDialog->show();
 }
 
+// Menu option: Edit->Test capture disk speed
+void MainWindow::on_actionTest_disk_speed_triggered()
+{
+    StartDiskBenchmark();
+}
+
 void MainWindow::StopCapture()
 {
     // If no capture is currently in progress or it is currently stopping, abort any further processing.
@@ -1339,6 +1840,14 @@ void MainWindow::StartCapture()
         return;
     }
 
+    // Stop any disk benchmark which is still running, so it doesn't compete with the capture for disk bandwidth. This
+    // doesn't wait for the benchmark to stop, which will happen at the end of its current write.
+    if (diskBenchmark->IsRunning())
+    {
+        qDebug() << "MainWindow::StartCapture(): Cancelling disk benchmark in progress";
+        diskBenchmark->Cancel();
+    }
+
     // Ensure that the test mode option matches the device configuration
     bool isTestMode = ui->actionTest_mode->isChecked();
     qDebug() << "MainWindow::StartCapture(): Setting device's test mode flag to" << isTestMode;
@@ -1347,6 +1856,10 @@ void MainWindow::StartCapture()
     // Reset the amplitude buffers
     ui->am->clearBuffer();
     ui->am_2->clearBuffer();
+    ui->leftLevelLabel_2->setText("N/A");
+    ui->rightLevelLabel_2->setText("N/A");
+    ui->leftLevelLabel_3->setText("N/A");
+    ui->rightLevelLabel_3->setText("N/A");
 
     // Use the advanced naming dialogue to generate the capture file name
     captureFilePath = std::filesystem::path((char8_t const*)configuration->getCaptureDirectory().toUtf8().data());
@@ -1356,6 +1869,8 @@ void MainWindow::StartCapture()
     // interval, to prevent stalls from a large memory allocation/relocation operation during capture.
     amplitudeRecord.clear();
     amplitudeRecord.reserve(24 * 60 * 60);
+    audioLevelRecord.clear();
+    audioLevelRecord.reserve(24 * 60 * 60);
 
     // Reset our time code/frame number and player status buffers. We reserve enough storage to capture 24 hours worth
     // of samples at the 100ms timer interval, to prevent stalls from a large memory allocation/relocation operation
@@ -1430,6 +1945,14 @@ void MainWindow::StartCapture()
     {
         captureFilePath += ".raw";
     }
+    else if (configuration->getCaptureFormat() == Configuration::CaptureFormat::tenBitBlocked)
+    {
+        captureFilePath += ".ldc";
+    }
+    else if (configuration->getCaptureFormat() == Configuration::CaptureFormat::sixteenBitRaw)
+    {
+        captureFilePath += ".ddr";
+    }
     else
     {
         captureFilePath += ".cds";
@@ -1440,6 +1963,7 @@ void MainWindow::StartCapture()
     ui->capturePushButton->setStyleSheet("background-color: red");
     ui->actionTest_mode->setEnabled(false);
     ui->actionPreferences->setEnabled(false);
+    ui->actionTest_disk_speed->setEnabled(false);
 
     // Make sure the configuration dialogue is closed
     configurationDialog->hide();
@@ -1459,12 +1983,52 @@ void MainWindow::StartCapture()
         qDebug() << "MainWindow::StartCapture(): Starting transfer - 10-bit packed 4:1 decimated";
         captureFormat = UsbDeviceBase::CaptureFormat::Unsigned10Bit4to1Decimation;
     }
+    else if (configuration->getCaptureFormat() == Configuration::CaptureFormat::tenBitBlocked)
+    {
+        qDebug() << "MainWindow::StartCapture(): Starting transfer - 10-bit packed block container";
+        captureFormat = UsbDeviceBase::CaptureFormat::Unsigned10BitBlocked;
+    }
+    else if (configuration->getCaptureFormat() == Configuration::CaptureFormat::sixteenBitRaw)
+    {
+        qDebug() << "MainWindow::StartCapture(): Starting transfer - 16-bit raw with sideband";
+        captureFormat = UsbDeviceBase::CaptureFormat::Unsigned16BitRaw;
+    }
     else
     {
         qDebug() << "MainWindow::StartCapture(): Starting transfer - 16-bit";
         captureFormat = UsbDeviceBase::CaptureFormat::Signed16Bit;
     }
 
+    // Determine any additional output formats to write alongside the main output. Capture containers can only be
+    // written as the main output, and are never offered as an additional format.
+    std::vector<UsbDeviceBase::CaptureFormat> additionalFormats;
+    for (Configuration::CaptureFormat additionalFormat : configuration->getAdditionalCaptureFormats())
+    {
+        UsbDeviceBase::CaptureFormat additionalCaptureFormat = UsbDeviceBase::CaptureFormat::Signed16Bit;
+        switch (additionalFormat)
+        {
+        case Configuration::CaptureFormat::sixteenBitSigned:
+            additionalCaptureFormat = UsbDeviceBase::CaptureFormat::Signed16Bit;
+            break;
+        case Configuration::CaptureFormat::tenBitPacked:
+            additionalCaptureFormat = UsbDeviceBase::CaptureFormat::Unsigned10Bit;
+            break;
+        case Configuration::CaptureFormat::tenBitCdPacked:
+            additionalCaptureFormat = UsbDeviceBase::CaptureFormat::Unsigned10Bit4to1Decimation;
+            break;
+        case Configuration::CaptureFormat::sixteenBitRaw:
+            additionalCaptureFormat = UsbDeviceBase::CaptureFormat::Unsigned16BitRaw;
+            break;
+        case Configuration::CaptureFormat::tenBitBlocked:
+            continue;
+        }
+        if (additionalCaptureFormat != captureFormat)
+        {
+            qDebug() << "MainWindow::StartCapture(): Additional output -" << UsbDeviceBase::GetCaptureFormatName(additionalCaptureFormat).c_str();
+            additionalFormats.push_back(additionalCaptureFormat);
+        }
+    }
+
     // Determine the audio source
     UsbDeviceBase::AudioSource audioSource = UsbDeviceBase::AudioSource::None;
     if (configuration->getAudioSource() == Configuration::AudioSource::none)
@@ -1487,6 +2051,54 @@ void MainWindow::StartCapture()
         audioSource = UsbDeviceBase::AudioSource::Both;
     }
 
+    // Determine which resampled audio outputs to produce
+    std::vector<uint32_t> audioResampleRates;
+    if (audioSource != UsbDeviceBase::AudioSource::None)
+    {
+        Configuration::AudioResampling audioResampling = configuration->getAudioResampling();
+        if ((audioResampling == Configuration::AudioResampling::resample48kHz) || (audioResampling == Configuration::AudioResampling::resampleBoth))
+        {
+            qDebug() << "MainWindow::StartCapture(): Audio resampling - 48kHz";
+            audioResampleRates.push_back(48000);
+        }
+        if ((audioResampling == Configuration::AudioResampling::resample44kHz) || (audioResampling == Configuration::AudioResampling::resampleBoth))
+        {
+            qDebug() << "MainWindow::StartCapture(): Audio resampling - 44.1kHz";
+            audioResampleRates.push_back(44100);
+        }
+    }
+
+    // Determine the integrity hash algorithm
+    StreamHasher::Algorithm hashAlgorithm = StreamHasher::Algorithm::None;
+    if (configuration->getIntegrityHash() == Configuration::HashAlgorithm::crc32c)
+    {
+        qDebug() << "MainWindow::StartCapture(): Integrity hash - CRC32C";
+        hashAlgorithm = StreamHasher::Algorithm::Crc32c;
+    }
+    else if (configuration->getIntegrityHash() == Configuration::HashAlgorithm::xxHash64)
+    {
+        qDebug() << "MainWindow::StartCapture(): Integrity hash - xxHash64";
+        hashAlgorithm = StreamHasher::Algorithm::XxHash64;
+    }
+
+    // Determine how gaps left by dropped samples are filled
+    UsbDeviceBase::GapFillMode gapFillMode = UsbDeviceBase::GapFillMode::None;
+    if (configuration->getGapFill() == Configuration::GapFill::zeroFill)
+    {
+        qDebug() << "MainWindow::StartCapture(): Gap fill - zero";
+        gapFillMode = UsbDeviceBase::GapFillMode::Zero;
+    }
+    else if (configuration->getGapFill() == Configuration::GapFill::midScaleFill)
+    {
+        qDebug() << "MainWindow::StartCapture(): Gap fill - mid-scale";
+        gapFillMode = UsbDeviceBase::GapFillMode::MidScale;
+    }
+    else if (configuration->getGapFill() == Configuration::GapFill::interpolatedFill)
+    {
+        qDebug() << "MainWindow::StartCapture(): Gap fill - interpolated";
+        gapFillMode = UsbDeviceBase::GapFillMode::Interpolate;
+    }
+
     // Initialize our transfer state settings
     playerStopRequested = false;
     amplitudeDropStartTime.reset();
@@ -1496,15 +2108,29 @@ void MainWindow::StartCapture()
     // benefit of linux, where the "usbfs_memory_mb" kernel setting is often 16mb for the entire system. If a small
     // queue is selected, we assume no more than 12mb of memory can be queued, which is 3/4 of that limit.
     const size_t smallUsbTransferQueueSize = 12 * 1024 * 1024;
-    size_t maxDiskBufferQueueSizeInBytes = configuration->getDiskBufferQueueSize();
-    size_t maxUsbTransferQueueSizeInBytes = (configuration->getUseSmallUsbTransferQueue() ? smallUsbTransferQueueSize : maxDiskBufferQueueSizeInBytes);
-    bool useSmallUsbTransfers = configuration->getUseSmallUsbTransfers();
-    bool useAsyncFileIo = configuration->getUseAsyncFileIo();
+    UsbDeviceBase::CaptureSettings captureSettings;
+    captureSettings.diskBufferQueueSizeInBytes = configuration->getDiskBufferQueueSize();
+    captureSettings.usbTransferQueueSizeInBytes = (configuration->getUseSmallUsbTransferQueue() ? smallUsbTransferQueueSize : captureSettings.diskBufferQueueSizeInBytes);
+    captureSettings.useSmallUsbTransfers = configuration->getUseSmallUsbTransfers();
+    captureSettings.useAsyncFileIo = configuration->getUseAsyncFileIo();
+    captureSettings.stagingBufferSizeInBytes = configuration->getStagingBufferSize();
 
     // Attempt to start the capture process
     qDebug() << "MainWindow::StartCapture(): Starting capture to file:" << captureFilePath.string().c_str();
-    bool stopOnDroppedSamples = configuration->getStopOnDroppedSamples();
-    if (!usbDevice->StartCapture(captureFilePath, captureFormat, audioSource, configuration->getUsbPreferredDevice().toStdString(), isTestMode, useSmallUsbTransfers, useAsyncFileIo, maxUsbTransferQueueSizeInBytes, maxDiskBufferQueueSizeInBytes, stopOnDroppedSamples))
+    captureSettings.filePath = captureFilePath;
+    captureSettings.format = captureFormat;
+    captureSettings.additionalFormats = additionalFormats;
+    captureSettings.audioSource = audioSource;
+    captureSettings.preferredDevicePath = configuration->getUsbPreferredDevice().toStdString();
+    captureSettings.isTestMode = isTestMode;
+    captureSettings.stopOnDroppedSamples = configuration->getStopOnDroppedSamples();
+    captureSettings.gapFillMode = gapFillMode;
+    captureSettings.hashAlgorithm = hashAlgorithm;
+    captureSettings.syncAudioHeaders = configuration->getSyncAudioHeaders();
+    captureSettings.audioResampleRates = audioResampleRates;
+    captureSettings.audioPreviewPath = std::filesystem::path((char8_t const*)configuration->getAudioPreviewPath().toUtf8().data());
+    captureSettings.writeBestAudio = configuration->getWriteBestAudio();
+    if (!usbDevice->StartCapture(captureSettings))
     {
         // Show an error based on the transfer result
         qDebug() << "MainWindow::StartCapture(): Failed to begin the capture process";
@@ -1522,6 +2148,9 @@ void MainWindow::StartCapture()
             case UsbDeviceBase::TransferResult::ConnectionFailure:
                 errorMessage = "Failed to start capture. A connection could not be established to the USB capture device.";
                 break;
+            case UsbDeviceBase::TransferResult::MemoryAllocationFailure:
+                errorMessage = "Failed to start capture. The memory staging buffer could not be allocated. Select a smaller staging buffer in the USB preferences.";
+                break;
         }
         messageBox.critical(this, "Error", errorMessage.c_str());
         messageBox.setFixedSize(500, 200);
@@ -1538,9 +2167,13 @@ void MainWindow::StartCapture()
         ui->capturePushButton->setStyleSheet("background-color: none");
         ui->actionTest_mode->setEnabled(true);
         ui->actionPreferences->setEnabled(true);
+        ui->actionTest_disk_speed->setEnabled(true);
         return;
     }
     captureStartTime = std::chrono::steady_clock::now();
+    stagingLastSampleTime = captureStartTime;
+    stagingLastOccupancyInBytes = 0;
+    stagingFillRateInBytesPerSecond = 0.0;
     isCaptureRunning = true;
     isCaptureStopping = false;
     qDebug() << "MainWindow::StartCapture(): Transfer started";
@@ -1558,7 +2191,10 @@ void MainWindow::on_capturePushButton_clicked()
 {
     if (!isCaptureRunning)
     {
-        StartCapture();
+        if (ConfirmDiskSpeedSufficient())
+        {
+            StartCapture();
+        }
     }
     else
     {
@@ -1658,30 +2294,39 @@ void MainWindow::updateAmplitudeLabel()
     checkAmplitudeDropStop();
 }
 
-// Timer callback to update audio amplitude display
+// Timer callback to update audio level display and record
 void MainWindow::updateAudioAmplitudeLabel()
 {
-    auto audioAmplitude = usbDevice->GetAudioMeanAmplitude();
-    ui->meanAmplitudeLabel_2->setText(QString::number(audioAmplitude, 'f', 3));
-    
-    // Update the audio amplitude graph by simulating a buffer with the amplitude value
-    // We create a synthetic buffer that represents the current audio amplitude
+    ui->meanAmplitudeLabel_2->setText(QString::number(usbDevice->GetStatsSnapshot().audio.meanAmplitude, 'f', 3));
+
+    // Wait until the first batch of audio has been measured
+    auto audioLevels = usbDevice->GetAudioLevels();
+    if (audioLevels.updateCount == 0)
+    {
+        return;
+    }
     if (isCaptureRunning && !isCaptureStopping)
     {
-        // Create a small buffer with samples representing the current amplitude
-        // We'll use 16-bit signed samples scaled by the amplitude
-        std::vector<uint8_t> syntheticBuffer;
-        syntheticBuffer.resize(512);  // 256 samples
-        int16_t sampleValue = static_cast<int16_t>(audioAmplitude * 32767.0);
-        
-        for (size_t i = 0; i < syntheticBuffer.size(); i += 2)
+        audioLevelRecord.push_back({ std::chrono::steady_clock::now(), audioLevels });
+    }
+
+    // Show the level of each channel in decibels relative to full scale
+    auto levelToString = [](double level)
         {
-            syntheticBuffer[i] = sampleValue & 0xFF;
-            syntheticBuffer[i + 1] = (sampleValue >> 8) & 0xFF;
-        }
-        
-        ui->am_2->updateBuffer(syntheticBuffer);
+            return (level > 0.0) ? QString::number(20.0 * std::log10(level), 'f', 1) : QString("-inf");
+        };
+    auto channelLevelsToString = [&](const UsbDeviceBase::AudioChannelLevels& channelLevels)
+        {
+            return tr("RMS %1 dBFS, peak %2 dBFS, true peak %3 dBTP").arg(levelToString(channelLevels.rms), levelToString(channelLevels.peak), levelToString(channelLevels.truePeak));
+        };
+    ui->leftLevelLabel_2->setText(channelLevelsToString(audioLevels.channels[0]));
+    ui->rightLevelLabel_2->setText(channelLevelsToString(audioLevels.channels[1]));
+    if (audioLevels.secondaryChannelsPresent)
+    {
+        ui->leftLevelLabel_3->setText(channelLevelsToString(audioLevels.secondaryChannels[0]));
+        ui->rightLevelLabel_3->setText(channelLevelsToString(audioLevels.secondaryChannels[1]));
     }
+    ui->am_2->updateLevels(audioLevels.channels[0].truePeak, audioLevels.channels[1].truePeak);
 }
 
 // Update amplitude UI elements
@@ -1716,12 +2361,25 @@ void MainWindow::updateAmplitudeUI()
     auto audioSource = configuration->getAudioSource();
     bool audioEnabled = (audioSource != Configuration::AudioSource::none);
     
+    // When both audio sources are being captured, the main level readout and graph show the PCM1802, and the levels of
+    // the ADC128S022 are shown on their own rows below it.
+    bool showBothAudioSourceLevels = (audioSource == Configuration::AudioSource::both);
+    ui->leftLevelPreLabel_2->setText(showBothAudioSourceLevels ? tr("PCM1802 left:") : tr("Left:"));
+    ui->rightLevelPreLabel_2->setText(showBothAudioSourceLevels ? tr("PCM1802 right:") : tr("Right:"));
+    ui->leftLevelPreLabel_3->setVisible(showBothAudioSourceLevels);
+    ui->leftLevelLabel_3->setVisible(showBothAudioSourceLevels);
+    ui->rightLevelPreLabel_3->setVisible(showBothAudioSourceLevels);
+    ui->rightLevelLabel_3->setVisible(showBothAudioSourceLevels);
+
+    if (audioEnabled) {
+        connect(amplitudeTimer.get(), SIGNAL(timeout()), this, SLOT(updateAudioAmplitudeLabel()), Qt::UniqueConnection);
+    } else {
+        disconnect(amplitudeTimer.get(), SIGNAL(timeout()), this, SLOT(updateAudioAmplitudeLabel()));
+    }
     if (audioEnabled && configuration->getAmplitudeChartEnabled()) {
         ui->am_2->setVisible(true);
-        connect(amplitudeTimer.get(), SIGNAL(timeout()), this, SLOT(updateAudioAmplitudeLabel()));
         connect(amplitudeTimer.get(), SIGNAL(timeout()), ui->am_2, SLOT(plotGraph()));
     } else {
-        disconnect(amplitudeTimer.get(), SIGNAL(timeout()), this, SLOT(updateAudioAmplitudeLabel()));
         disconnect(amplitudeTimer.get(), SIGNAL(timeout()), ui->am_2, SLOT(plotGraph()));
         ui->am_2->setVisible(false);
     }
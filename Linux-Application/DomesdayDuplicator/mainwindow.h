@@ -40,6 +40,8 @@
 #include "automaticcapturedialog.h"
 #include "advancednamingdialog.h"
 #include "amplitudemeasurement.h"
+#include "DiskBenchmark.h"
+#include "MetricsExporter.h"
 #include "ILogger.h"
 #include <chrono>
 #include <filesystem>
@@ -84,6 +86,7 @@ private slots:
     void updateAmplitudeDataBuffer();
     void updateAmplitudeLabel();
     void updateAudioAmplitudeLabel();
+    void updateMetricsExport();
 
     void on_actionExit_triggered();
     void on_actionTest_mode_toggled(bool arg1);
@@ -95,6 +98,7 @@ private slots:
     void on_limitDurationCheckBox_stateChanged(int arg1);
     void on_stopCaptureOnAmplitudeDropCheckBox_stateChanged(int arg1);
     void on_actionAdvanced_naming_triggered();
+    void on_actionTest_disk_speed_triggered();
 
 private:
     struct AmplitudeRecord
@@ -102,6 +106,11 @@ private:
         std::chrono::time_point<std::chrono::steady_clock> sampleTime;
         double amplitude;
     };
+    struct AudioLevelRecord
+    {
+        std::chrono::time_point<std::chrono::steady_clock> sampleTime;
+        UsbDeviceBase::AudioLevels levels;
+    };
     struct TimeCodeRecord
     {
         std::chrono::time_point<std::chrono::steady_clock> sampleTime;
@@ -124,6 +133,13 @@ private:
     void RefreshControlVisibility();
     void StopCapture();
     void StartCapture();
+    size_t GetCaptureDataRateInBytesPerSecond() const;
+    void GetDiskBenchmarkTarget(std::filesystem::path& directory, bool& useWriteThrough) const;
+    std::optional<DiskBenchmark::Result> GetDiskBenchmarkResult() const;
+    void StartDiskBenchmark();
+    bool IsDiskBenchmarkSufficient(const DiskBenchmark::Result& result, QString& reason) const;
+    bool ConfirmDiskSpeedSufficient();
+    void StartMetricsExport();
 
 private:
     const ILogger& log;
@@ -131,6 +147,8 @@ private:
     std::unique_ptr<UsbDeviceBase> usbDevice;
     std::unique_ptr<QLabel> usbStatusLabel;
     std::unique_ptr<QStorageInfo> storageInfo;
+    std::unique_ptr<DiskBenchmark> diskBenchmark;
+    std::unique_ptr<MetricsExporter> metricsExporter;
 
     std::unique_ptr<Ui::MainWindow> ui;
     std::unique_ptr<AboutDialog> aboutDialog;
@@ -150,9 +168,11 @@ private:
     std::unique_ptr<QTimer> automaticCaptureTimer;
     std::unique_ptr<QTimer> storageInfoTimer;
     std::unique_ptr<QTimer> amplitudeTimer;
+    std::unique_ptr<QTimer> metricsExportTimer;
     std::chrono::time_point<std::chrono::steady_clock> captureStartTime;
     std::chrono::time_point<std::chrono::steady_clock> captureEndTime;
     std::vector<AmplitudeRecord> amplitudeRecord;
+    std::vector<AudioLevelRecord> audioLevelRecord;
     std::vector<TimeCodeRecord> playerTimeCodeRecord;
     std::vector<PlayerStatusRecord> playerStatusRecord;
     std::vector<PhysicalPositionRecord> playerPhysicalPositionRecord;
@@ -187,6 +207,11 @@ private:
     qint32 remoteSpeed;
     PlayerCommunication::ChapterFrameMode remoteChapterFrameMode;
 
+    // Staging buffer fill rate tracking
+    std::chrono::time_point<std::chrono::steady_clock> stagingLastSampleTime;
+    size_t stagingLastOccupancyInBytes = 0;
+    double stagingFillRateInBytesPerSecond = 0.0;
+
     // Amplitude drop tracking for auto-stop
     std::optional<std::chrono::time_point<std::chrono::steady_clock>> amplitudeDropStartTime;
 
@@ -0,0 +1,420 @@
+#include "containerconversion.h"
+#include <cstring>
+
+ContainerConversion::ContainerConversion(QString inputFileNameParam, QString outputFileNameParam, bool isWrappingParam, QObject *parent) : QObject(parent)
+{
+    // Store the configuration parameters
+    inputFileName = inputFileNameParam;
+    outputFileName = outputFileNameParam;
+    isWrapping = isWrappingParam;
+}
+
+// Method to process the conversion of the file
+bool ContainerConversion::process()
+{
+    // Open the input file
+    if (!openInputFile()) {
+        qCritical("Could not open input file!");
+        return false;
+    }
+
+    // Open the output file
+    if (!openOutputFile()) {
+        qCritical("Could not open output file!");
+        return false;
+    }
+
+    // Wrapping or unwrapping?
+    bool result;
+    if (isWrapping) result = wrapFile();
+    else result = unwrapFile();
+
+    // Close the input file
+    closeInputFile();
+
+    // Close the output file
+    closeOutputFile();
+
+    return result;
+}
+
+// Method to open the input file for reading
+bool ContainerConversion::openInputFile()
+{
+    // Do we have a file name for the input file?
+    if (inputFileName.isEmpty()) {
+        // No source input file name was specified, using stdin instead
+        qDebug() << "No input filename was provided, using stdin";
+        inputFileHandle = new QFile;
+        if (!inputFileHandle->open(stdin, QIODevice::ReadOnly)) {
+            // Failed to open stdin
+            qWarning() << "Could not open stdin as input file";
+            return false;
+        }
+        qDebug() << "Reading input data from stdin";
+    } else {
+        // Open input file for reading
+        inputFileHandle = new QFile(inputFileName);
+        if (!inputFileHandle->open(QIODevice::ReadOnly)) {
+            // Failed to open source sample file
+            qDebug() << "Could not open " << inputFileName << "as input file";
+            return false;
+        }
+        qDebug() << "Input file is" << inputFileName << "and is" << inputFileHandle->size() << "bytes in length";
+    }
+
+    // Exit with success
+    return true;
+}
+
+// Method to close the input file
+void ContainerConversion::closeInputFile()
+{
+    // Is an input file open?
+    if (inputFileHandle != nullptr) {
+        inputFileHandle->close();
+    }
+
+    // Clear the file handle pointer
+    delete inputFileHandle;
+    inputFileHandle = nullptr;
+}
+
+// Method to open the output file for writing
+bool ContainerConversion::openOutputFile()
+{
+    // Do we have a file name for the output file?
+    if (outputFileName.isEmpty()) {
+        // No output file name was specified, using stdout instead
+        qDebug() << "No output filename was provided, using stdout";
+        outputFileHandle = new QFile;
+        if (!outputFileHandle->open(stdout, QIODevice::WriteOnly)) {
+            // Failed to open stdout
+            qWarning() << "Could not open stdout as output file";
+            return false;
+        }
+        qDebug() << "Writing output data to stdout";
+    } else {
+        // Open the output file for writing
+        outputFileHandle = new QFile(outputFileName);
+        if (!outputFileHandle->open(QIODevice::WriteOnly)) {
+            // Failed to open output file
+            qDebug() << "Could not open " << outputFileName << "as output file";
+            return false;
+        }
+        qDebug() << "Output file is" << outputFileName;
+    }
+
+    // Exit with success
+    return true;
+}
+
+// Method to close the output file
+void ContainerConversion::closeOutputFile()
+{
+    // Is an output file open?
+    if (outputFileHandle != nullptr) {
+        outputFileHandle->close();
+    }
+
+    // Clear the file handle pointer
+    delete outputFileHandle;
+    outputFileHandle = nullptr;
+}
+
+// Method to top up a buffer from the input file until it holds the required number of bytes. Returns false if the end
+// of the input was reached first.
+bool ContainerConversion::fillBuffer(QByteArray &buffer, qint32 requiredSizeInBytes)
+{
+    qint64 receivedBytes = 1;
+    while (buffer.size() < requiredSizeInBytes && receivedBytes > 0) {
+        qint32 existingBytes = buffer.size();
+        buffer.resize(requiredSizeInBytes);
+        receivedBytes = inputFileHandle->read(buffer.data() + existingBytes, requiredSizeInBytes - existingBytes);
+        buffer.resize(existingBytes + static_cast<qint32>(qMax(receivedBytes, static_cast<qint64>(0))));
+    }
+    return buffer.size() >= requiredSizeInBytes;
+}
+
+// Method to wrap 10-bit packed data into a block container
+bool ContainerConversion::wrapFile()
+{
+    qDebug() << "ContainerConversion::wrapFile(): Wrapping";
+
+    // Each block holds 1Mi samples, which keeps the payload size divisible into whole 5 byte groups
+    const qint32 samplesPerBlock = 1024 * 1024;
+    const qint32 payloadSizeInBytes = static_cast<qint32>(CaptureContainer::PackedPayloadSizeInBytes(samplesPerBlock));
+    const qint32 headerSizeInBytes = static_cast<qint32>(CaptureContainer::BlockHeaderSizeInBytes);
+
+    std::vector<CaptureContainer::IndexEntry> index;
+    QByteArray inputBuffer;
+    QByteArray outputBuffer;
+    quint64 fileOffset = 0;
+    quint64 sampleIndex = 0;
+    bool isComplete = false;
+
+    while (!isComplete) {
+        // Read the next block of packed data
+        inputBuffer.clear();
+        isComplete = !fillBuffer(inputBuffer, payloadSizeInBytes);
+
+        // Only whole 5 byte groups can be stored, so discard any trailing partial group
+        qint32 blockPayloadSizeInBytes = (inputBuffer.size() / 5) * 5;
+        if (blockPayloadSizeInBytes != inputBuffer.size()) {
+            qWarning() << "Input file ended with a partial 10-bit sample group, discarding" << (inputBuffer.size() - blockPayloadSizeInBytes) << "bytes";
+        }
+        if (blockPayloadSizeInBytes == 0) break;
+
+        // Build the block. Data converted from a plain .lds file has no sequence counter information available.
+        CaptureContainer::BlockHeader header;
+        header.blockIndex = static_cast<quint32>(index.size());
+        header.sampleCount = static_cast<quint32>((blockPayloadSizeInBytes / 5) * 4);
+        header.payloadSizeInBytes = static_cast<quint32>(blockPayloadSizeInBytes);
+        header.payloadCrc = CaptureContainer::Crc32c(reinterpret_cast<const uint8_t *>(inputBuffer.constData()), blockPayloadSizeInBytes);
+        outputBuffer.resize(headerSizeInBytes + blockPayloadSizeInBytes);
+        CaptureContainer::WriteBlockHeader(reinterpret_cast<uint8_t *>(outputBuffer.data()), header);
+        memcpy(outputBuffer.data() + headerSizeInBytes, inputBuffer.constData(), blockPayloadSizeInBytes);
+
+        // Write the block to the output file
+        if (outputFileHandle->write(outputBuffer) != outputBuffer.size()) {
+            qCritical("Could not write to output file!");
+            return false;
+        }
+        index.push_back(CaptureContainer::MakeIndexEntry(header, fileOffset, sampleIndex));
+        fileOffset += static_cast<quint64>(outputBuffer.size());
+        sampleIndex += header.sampleCount;
+    }
+
+    // Write the block index and footer
+    std::vector<uint8_t> trailer;
+    CaptureContainer::BuildTrailer(index, fileOffset, trailer);
+    if (outputFileHandle->write(reinterpret_cast<const char *>(trailer.data()), static_cast<qint64>(trailer.size())) != static_cast<qint64>(trailer.size())) {
+        qCritical("Could not write to output file!");
+        return false;
+    }
+
+    qInfo() << "Wrapped" << sampleIndex << "samples into" << index.size() << "blocks";
+    return true;
+}
+
+// Method to extract 10-bit packed data from a block container. The blocks are located and verified using the index at
+// the end of the file. If the footer is missing or damaged, which happens when a capture wasn't closed cleanly, the
+// blocks are found by scanning the file from the start instead. Any damaged, missing or truncated block fails the
+// conversion, although the remaining data is still extracted.
+bool ContainerConversion::unwrapFile()
+{
+    qDebug() << "ContainerConversion::unwrapFile(): Unwrapping";
+
+    std::vector<CaptureContainer::IndexEntry> index;
+    quint64 indexOffset = 0;
+    if (readIndex(index, indexOffset)) {
+        return unwrapIndexedBlocks(index, indexOffset);
+    }
+    return unwrapSequentialBlocks();
+}
+
+// Method to read the block index from the end of the input file. Returns false if the input can't be seeked, or the
+// footer or index is missing or damaged.
+bool ContainerConversion::readIndex(std::vector<CaptureContainer::IndexEntry> &index, quint64 &indexOffset)
+{
+    const qint64 footerSizeInBytes = static_cast<qint64>(CaptureContainer::FooterSizeInBytes);
+    const qint64 entrySizeInBytes = static_cast<qint64>(CaptureContainer::IndexEntrySizeInBytes);
+
+    // The index can only be located if we can seek within the input
+    if (inputFileHandle->isSequential()) {
+        qWarning() << "Input is not seekable, so the block index can't be used. Falling back to a sequential scan of the blocks";
+        return false;
+    }
+
+    // Read and verify the footer, and ensure the index it describes fits exactly between the blocks and the footer
+    qint64 fileSizeInBytes = inputFileHandle->size();
+    CaptureContainer::Footer footer;
+    QByteArray footerBuffer;
+    bool footerValid = (fileSizeInBytes >= footerSizeInBytes) && inputFileHandle->seek(fileSizeInBytes - footerSizeInBytes);
+    footerValid = footerValid && fillBuffer(footerBuffer, static_cast<qint32>(footerSizeInBytes));
+    footerValid = footerValid && CaptureContainer::ReadFooter(reinterpret_cast<const uint8_t *>(footerBuffer.constData()), footer);
+    quint64 indexEndOffset = static_cast<quint64>(fileSizeInBytes - footerSizeInBytes);
+    footerValid = footerValid && (footer.indexOffset <= indexEndOffset) && ((indexEndOffset - footer.indexOffset) == (footer.entryCount * static_cast<quint64>(entrySizeInBytes)));
+    if (!footerValid) {
+        qWarning() << "Container footer is missing or damaged. Falling back to a sequential scan of the blocks";
+        inputFileHandle->seek(0);
+        return false;
+    }
+
+    // Read and verify the index
+    QByteArray indexBuffer;
+    bool indexValid = inputFileHandle->seek(static_cast<qint64>(footer.indexOffset));
+    indexValid = indexValid && fillBuffer(indexBuffer, static_cast<qint32>(footer.entryCount * static_cast<quint64>(entrySizeInBytes)));
+    indexValid = indexValid && CaptureContainer::ReadIndex(reinterpret_cast<const uint8_t *>(indexBuffer.constData()), footer, index);
+    if (!indexValid) {
+        qWarning() << "Container index is damaged. Falling back to a sequential scan of the blocks";
+        index.clear();
+        inputFileHandle->seek(0);
+        return false;
+    }
+
+    indexOffset = footer.indexOffset;
+    qDebug() << "ContainerConversion::readIndex(): Read" << index.size() << "index entries";
+    return true;
+}
+
+// Method to extract the blocks listed in the index, verifying each block against its index entry
+bool ContainerConversion::unwrapIndexedBlocks(const std::vector<CaptureContainer::IndexEntry> &index, quint64 indexOffset)
+{
+    const qint32 headerSizeInBytes = static_cast<qint32>(CaptureContainer::BlockHeaderSizeInBytes);
+
+    QByteArray buffer;
+    quint64 sampleCount = 0;
+    quint64 expectedFileOffset = 0;
+    quint64 expectedSampleIndex = 0;
+    quint64 crcErrorCount = 0;
+    quint64 sequenceErrorCount = 0;
+    quint64 truncatedBlockCount = 0;
+
+    for (size_t i = 0; i < index.size(); ++i) {
+        const CaptureContainer::IndexEntry &entry = index[i];
+
+        // Each block should follow directly on from the last, in the same sample sequence. The expected position of
+        // the next block is taken from the index, so a damaged block doesn't throw out the checks on those after it.
+        if ((entry.fileOffset != expectedFileOffset) || (entry.firstSampleIndex != expectedSampleIndex)) {
+            qWarning() << "Index entry" << i << "is out of sequence with the previous block";
+            ++sequenceErrorCount;
+        }
+        expectedFileOffset = entry.fileOffset + static_cast<quint64>(headerSizeInBytes) + CaptureContainer::PackedPayloadSizeInBytes(entry.sampleCount);
+        expectedSampleIndex = entry.firstSampleIndex + entry.sampleCount;
+
+        // Read the block header, and ensure it agrees with the index
+        buffer.clear();
+        CaptureContainer::BlockHeader header;
+        if ((entry.fileOffset + static_cast<quint64>(headerSizeInBytes) > indexOffset) || !inputFileHandle->seek(static_cast<qint64>(entry.fileOffset)) || !fillBuffer(buffer, headerSizeInBytes)) {
+            qWarning() << "Block" << i << "is truncated, discarding it";
+            ++truncatedBlockCount;
+            continue;
+        }
+        if (!CaptureContainer::ReadBlockHeader(reinterpret_cast<const uint8_t *>(buffer.constData()), header)) {
+            qWarning() << "Block" << i << "has a damaged header, discarding it";
+            ++crcErrorCount;
+            continue;
+        }
+        if ((header.blockIndex != i) || (header.sampleCount != entry.sampleCount) || (header.sequenceCounter != entry.sequenceCounter) || (header.frameOffset != entry.frameOffset) || (header.flags != entry.flags)) {
+            qWarning() << "Block" << i << "doesn't match its index entry";
+            ++sequenceErrorCount;
+        }
+
+        // Read the block payload
+        qint32 blockSizeInBytes = headerSizeInBytes + static_cast<qint32>(header.payloadSizeInBytes);
+        if ((entry.fileOffset + static_cast<quint64>(blockSizeInBytes) > indexOffset) || !fillBuffer(buffer, blockSizeInBytes)) {
+            qWarning() << "Block" << i << "is truncated, discarding it";
+            ++truncatedBlockCount;
+            continue;
+        }
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(buffer.constData()) + headerSizeInBytes;
+        if (CaptureContainer::Crc32c(payload, header.payloadSizeInBytes) != header.payloadCrc) {
+            qWarning() << "Block" << i << "failed its CRC check";
+            ++crcErrorCount;
+        }
+
+        // Write the payload to the output file
+        if (outputFileHandle->write(reinterpret_cast<const char *>(payload), header.payloadSizeInBytes) != static_cast<qint64>(header.payloadSizeInBytes)) {
+            qCritical("Could not write to output file!");
+            return false;
+        }
+        sampleCount += header.sampleCount;
+    }
+
+    // The index should immediately follow the last block
+    if (expectedFileOffset != indexOffset) {
+        qWarning() << "The last indexed block ends at offset" << expectedFileOffset << "but the index starts at offset" << indexOffset;
+        ++sequenceErrorCount;
+    }
+
+    qInfo() << "Unwrapped" << sampleCount << "samples from" << index.size() << "indexed blocks";
+    if (crcErrorCount > 0 || sequenceErrorCount > 0 || truncatedBlockCount > 0) {
+        qCritical() << "Container had" << crcErrorCount << "CRC errors," << sequenceErrorCount << "sequence errors and" << truncatedBlockCount << "truncated blocks";
+        return false;
+    }
+    return true;
+}
+
+// Method to extract the blocks by scanning the file from the start, for use when the index can't be read
+bool ContainerConversion::unwrapSequentialBlocks()
+{
+    const qint32 headerSizeInBytes = static_cast<qint32>(CaptureContainer::BlockHeaderSizeInBytes);
+    const char blockMagic[4] = { 'D', 'D', 'C', 'B' };
+
+    QByteArray buffer;
+    quint64 blockCount = 0;
+    quint64 sampleCount = 0;
+    quint64 crcErrorCount = 0;
+    quint64 sequenceBreakCount = 0;
+    quint64 damagedRegionCount = 0;
+    bool isTruncated = false;
+    qint64 expectedBlockIndex = 0;
+    quint64 skippedBytes = 0;
+
+    while (fillBuffer(buffer, headerSizeInBytes)) {
+        // Decode the block header. If it's invalid, we've either reached the index at the end of the file, or the
+        // block header is damaged. In either case, search for the next intact block header.
+        CaptureContainer::BlockHeader header;
+        if (!CaptureContainer::ReadBlockHeader(reinterpret_cast<const uint8_t *>(buffer.constData()), header)) {
+            qint32 nextMagic = buffer.indexOf(QByteArray(blockMagic, sizeof(blockMagic)), 1);
+            if (nextMagic < 0) {
+                // Keep the last few bytes, in case the magic straddles the read boundary
+                qint32 keptBytes = static_cast<qint32>(sizeof(blockMagic)) - 1;
+                skippedBytes += static_cast<quint64>(buffer.size() - keptBytes);
+                buffer.remove(0, buffer.size() - keptBytes);
+                if (!fillBuffer(buffer, 1024 * 1024)) {
+                    skippedBytes += static_cast<quint64>(buffer.size());
+                    break;
+                }
+            } else {
+                skippedBytes += static_cast<quint64>(nextMagic);
+                buffer.remove(0, nextMagic);
+            }
+            continue;
+        }
+
+        // If we skipped data before this block, it was damaged rather than part of the trailer
+        if (skippedBytes > 0) {
+            qWarning() << "Skipped" << skippedBytes << "bytes of damaged data before block" << header.blockIndex;
+            ++damagedRegionCount;
+            skippedBytes = 0;
+        }
+
+        // Read the block payload
+        qint32 blockSizeInBytes = headerSizeInBytes + static_cast<qint32>(header.payloadSizeInBytes);
+        if (!fillBuffer(buffer, blockSizeInBytes)) {
+            qWarning() << "Block" << header.blockIndex << "is truncated, discarding it";
+            isTruncated = true;
+            break;
+        }
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(buffer.constData()) + headerSizeInBytes;
+
+        // Verify the payload and block sequence
+        if (CaptureContainer::Crc32c(payload, header.payloadSizeInBytes) != header.payloadCrc) {
+            qWarning() << "Block" << header.blockIndex << "failed its CRC check";
+            ++crcErrorCount;
+        }
+        if (static_cast<qint64>(header.blockIndex) != expectedBlockIndex) {
+            qWarning() << "Expected block" << expectedBlockIndex << "but found block" << header.blockIndex;
+            ++sequenceBreakCount;
+        }
+        expectedBlockIndex = static_cast<qint64>(header.blockIndex) + 1;
+
+        // Write the payload to the output file
+        if (outputFileHandle->write(reinterpret_cast<const char *>(payload), header.payloadSizeInBytes) != static_cast<qint64>(header.payloadSizeInBytes)) {
+            qCritical("Could not write to output file!");
+            return false;
+        }
+        buffer.remove(0, blockSizeInBytes);
+        ++blockCount;
+        sampleCount += header.sampleCount;
+    }
+
+    qInfo() << "Unwrapped" << sampleCount << "samples from" << blockCount << "blocks";
+    if (crcErrorCount > 0 || sequenceBreakCount > 0 || damagedRegionCount > 0 || isTruncated) {
+        qCritical() << "Container had" << crcErrorCount << "CRC errors," << sequenceBreakCount << "block sequence breaks and" << damagedRegionCount << "damaged regions" << (isTruncated ? ", and the last block was truncated" : "");
+        return false;
+    }
+    return true;
+}
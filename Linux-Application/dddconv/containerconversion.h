@@ -0,0 +1,43 @@
+#ifndef CONTAINERCONVERSION_H
+#define CONTAINERCONVERSION_H
+
+#include <QObject>
+#include <QDebug>
+#include <QFile>
+#include <vector>
+
+#include "CaptureContainer.h"
+
+class ContainerConversion : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ContainerConversion(QString inputFileNameParam, QString outputFileNameParam, bool isWrappingParam, QObject *parent = nullptr);
+
+    bool process();
+signals:
+
+public slots:
+
+private:
+    QString inputFileName;
+    QString outputFileName;
+    bool isWrapping;
+
+    QFile *inputFileHandle;
+    QFile *outputFileHandle;
+
+    // Private methods
+    bool openInputFile();
+    void closeInputFile();
+    bool openOutputFile();
+    void closeOutputFile();
+    bool fillBuffer(QByteArray &buffer, qint32 requiredSizeInBytes);
+    bool wrapFile();
+    bool unwrapFile();
+    bool readIndex(std::vector<CaptureContainer::IndexEntry> &index, quint64 &indexOffset);
+    bool unwrapIndexedBlocks(const std::vector<CaptureContainer::IndexEntry> &index, quint64 indexOffset);
+    bool unwrapSequentialBlocks();
+};
+
+#endif // CONTAINERCONVERSION_H
@@ -1,6 +1,6 @@
 QT -= gui
 
-CONFIG += c++11 console
+CONFIG += c++17 console
 CONFIG -= app_bundle
 
 # The following define makes your compiler emit warnings if you use
@@ -16,7 +16,13 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
         main.cpp \
-    dataconversion.cpp
+    dataconversion.cpp \
+    containerconversion.cpp \
+    sidebanddemux.cpp \
+    ../DomesdayDuplicator/AudioAlignmentIndex.cpp \
+    ../DomesdayDuplicator/CaptureContainer.cpp \
+    ../DomesdayDuplicator/SidebandFrame.cpp \
+    ../DomesdayDuplicator/WavHeader.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -24,4 +30,12 @@ else: unix:!android: target.path = /usr/local/bin/
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
-    dataconversion.h
+    dataconversion.h \
+    containerconversion.h \
+    sidebanddemux.h \
+    ../DomesdayDuplicator/AudioAlignmentIndex.h \
+    ../DomesdayDuplicator/CaptureContainer.h \
+    ../DomesdayDuplicator/SidebandFrame.h \
+    ../DomesdayDuplicator/WavHeader.h
+
+INCLUDEPATH += ../DomesdayDuplicator
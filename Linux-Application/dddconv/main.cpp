@@ -29,6 +29,8 @@
 #include <QCommandLineParser>
 
 #include "dataconversion.h"
+#include "containerconversion.h"
+#include "sidebanddemux.h"
 
 // Global for debug output
 static bool showDebug = false;
@@ -118,6 +120,27 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Pack 16-bit data into 10-bit"));
     parser.addOption(showPackOption);
 
+    // Option to wrap 10-bit data into a block container (-w)
+    QCommandLineOption showWrapOption(QStringList() << "w" << "wrap",
+                                       QCoreApplication::translate("main", "Wrap 10-bit packed data into a block container"));
+    parser.addOption(showWrapOption);
+
+    // Option to extract 10-bit data from a block container (-x)
+    QCommandLineOption showUnwrapOption(QStringList() << "x" << "unwrap",
+                                       QCoreApplication::translate("main", "Extract 10-bit packed data from a block container"));
+    parser.addOption(showUnwrapOption);
+
+    // Option to demultiplex a raw capture with sideband data (-s)
+    QCommandLineOption showDemuxOption(QStringList() << "s" << "demux",
+                                       QCoreApplication::translate("main", "Demultiplex a 16-bit raw capture with sideband data (.ddr) into 10-bit packed RF, audio and alignment index files named after the output file"));
+    parser.addOption(showDemuxOption);
+
+    // Option to specify the number of threads to demultiplex with (-t)
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads",
+                QCoreApplication::translate("main", "Specify the number of threads to use when demultiplexing (default is one per CPU core)"),
+                QCoreApplication::translate("main", "number"));
+    parser.addOption(threadsOption);
+
     // Process the command line arguments given by the user
     parser.process(a);
 
@@ -125,6 +148,10 @@ int main(int argc, char *argv[])
     bool isDebugOn = parser.isSet(showDebugOption);
     bool isUnpacking = parser.isSet(showUnpackOption);
     bool isPacking = parser.isSet(showPackOption);
+    bool isWrapping = parser.isSet(showWrapOption);
+    bool isUnwrapping = parser.isSet(showUnwrapOption);
+    bool isDemuxing = parser.isSet(showDemuxOption);
+    qint32 threadCount = parser.value(threadsOption).toInt();
     QString inputFileName = parser.value(sourceVideoFileOption);
     QString outputFileName = parser.value(targetVideoFileOption);
 
@@ -141,6 +168,32 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // Check that only one container conversion is set, and that it isn't combined with packing or unpacking
+    if ((isWrapping || isUnwrapping) && (isWrapping == isUnwrapping || isUnpacking || isPacking)) {
+        // Quit with error
+        qCritical("Specify only one of --wrap (-w), --unwrap (-x), --unpack (-u) or --pack (-p)!");
+        return -1;
+    }
+
+    // Check that demultiplexing isn't combined with any other conversion
+    if (isDemuxing && (isWrapping || isUnwrapping || isUnpacking || isPacking)) {
+        // Quit with error
+        qCritical("Specify --demux (-s) on its own, without any other conversion!");
+        return -1;
+    }
+
+    // Demultiplexing is handled separately to the other conversions
+    if (isDemuxing) {
+        SidebandDemux sidebandDemux(inputFileName, outputFileName, threadCount);
+        return sidebandDemux.process() ? 0 : -1;
+    }
+
+    // Container conversions are handled separately to packing and unpacking
+    if (isWrapping || isUnwrapping) {
+        ContainerConversion containerConversion(inputFileName, outputFileName, isWrapping);
+        return containerConversion.process() ? 0 : -1;
+    }
+
     // Initialise the data conversion object
     DataConversion dataConversion(inputFileName, outputFileName, !modeUnpack);
 
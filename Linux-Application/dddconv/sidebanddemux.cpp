@@ -0,0 +1,328 @@
+#include "sidebanddemux.h"
+#include "WavHeader.h"
+#include <QFileInfo>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <thread>
+
+// The input is divided into chunks which are demultiplexed independently. Each chunk is a whole number of 4-sample
+// groups, so the packed RF data from each chunk can simply be appended to the output. Chunks are read with one frame of
+// overlap from the following chunk, so that a frame which starts near the end of a chunk can be decoded in full by it.
+static const qint64 chunkSizeInBytes = 32 * 1024 * 1024;
+static const qint64 overlapSizeInBytes = SidebandFrame::SamplesPerFrame * 2;
+
+SidebandDemux::SidebandDemux(QString inputFileNameParam, QString outputBaseNameParam, qint32 threadCountParam, QObject *parent) : QObject(parent)
+{
+    // Store the configuration parameters
+    inputFileName = inputFileNameParam;
+    outputBaseName = outputBaseNameParam;
+    threadCount = threadCountParam;
+
+    rfFileHandle = nullptr;
+    adcAudioFileHandle = nullptr;
+    pcmAudioFileHandle = nullptr;
+    alignmentFileHandle = nullptr;
+}
+
+// Method to demultiplex a raw capture file with sideband data into its separate streams
+bool SidebandDemux::process()
+{
+    // The input is read from several threads at once, so it has to be a real file
+    if (inputFileName.isEmpty() || outputBaseName.isEmpty()) {
+        qCritical("Demultiplexing requires both an input file and an output base name, stdin and stdout are not supported!");
+        return false;
+    }
+    QFileInfo inputFileInfo(inputFileName);
+    if (!inputFileInfo.isFile() || !inputFileInfo.isReadable()) {
+        qCritical("Could not open input file!");
+        return false;
+    }
+    qint64 inputSizeInBytes = inputFileInfo.size() & ~static_cast<qint64>(1);
+    if (inputFileInfo.size() != inputSizeInBytes) {
+        qWarning() << "Input file has an odd length, the final byte will be ignored";
+    }
+    qDebug() << "Input file is" << inputFileName << "and is" << inputFileInfo.size() << "bytes in length";
+
+    // Open the output files
+    if (!openOutputFiles()) {
+        qCritical("Could not open output files!");
+        closeOutputFiles();
+        return false;
+    }
+
+    // Decide how many chunks to have in flight at once. We allow twice as many chunks as worker threads, so the workers
+    // can carry on with later chunks while the completed ones are being written out in order.
+    if (threadCount <= 0) threadCount = static_cast<qint32>(qMax(1u, std::thread::hardware_concurrency()));
+    qint64 chunkCount = (inputSizeInBytes + chunkSizeInBytes - 1) / chunkSizeInBytes;
+    size_t maxChunksInFlight = static_cast<size_t>(threadCount) * 2;
+    qDebug() << "SidebandDemux::process(): Demultiplexing" << chunkCount << "chunks using" << threadCount << "threads";
+
+    // Demultiplex the chunks in parallel, and stitch the results together in order
+    adcAudioSizeInBytes = 0;
+    pcmAudioSizeInBytes = 0;
+    pendingSegmentValid = false;
+    pendingSegmentFrameCount = 0;
+    pendingSegmentSampleIndex = 0;
+    audioSampleIndex = 0;
+    gapFrameCount = 0;
+    discontinuityCount = 0;
+    qint64 syncLossCount = 0;
+    bool result = true;
+    std::deque<std::future<ChunkResult>> chunksInFlight;
+    qint64 nextChunkIndex = 0;
+    while (result && ((nextChunkIndex < chunkCount) || !chunksInFlight.empty())) {
+        while ((nextChunkIndex < chunkCount) && (chunksInFlight.size() < maxChunksInFlight)) {
+            chunksInFlight.push_back(std::async(std::launch::async, &SidebandDemux::processChunk, this, inputSizeInBytes, nextChunkIndex));
+            ++nextChunkIndex;
+        }
+
+        ChunkResult chunkResult = chunksInFlight.front().get();
+        chunksInFlight.pop_front();
+        if (!chunkResult.success) {
+            qCritical("Could not read from input file!");
+            result = false;
+            break;
+        }
+        if (!writeChunk(chunkResult)) {
+            qCritical("Could not write to output files!");
+            result = false;
+            break;
+        }
+        syncLossCount += chunkResult.syncLossCount;
+    }
+
+    // If we stopped early, wait for any chunks still being processed before tearing down
+    for (auto &chunk : chunksInFlight) chunk.wait();
+
+    // Complete the alignment index and the WAV headers
+    if (result) {
+        result = flushPendingSegment()
+                && writeWavHeader(adcAudioFileHandle, 16, adcAudioSizeInBytes)
+                && writeWavHeader(pcmAudioFileHandle, 24, pcmAudioSizeInBytes);
+        if (!result) qCritical("Could not write to output files!");
+    }
+    closeOutputFiles();
+
+    if (result) {
+        qInfo() << "Demultiplexed" << audioSampleIndex << "frames," << gapFrameCount << "frames missing," << discontinuityCount << "counter discontinuities," << syncLossCount << "sync losses";
+    }
+    return result;
+}
+
+// Method to create the output files, and write the placeholder headers
+bool SidebandDemux::openOutputFiles()
+{
+    rfFileHandle = new QFile(outputBaseName + ".lds");
+    adcAudioFileHandle = new QFile(outputBaseName + "_audio_integrated_adc.wav");
+    pcmAudioFileHandle = new QFile(outputBaseName + "_audio_external_adc.wav");
+    alignmentFileHandle = new QFile(outputBaseName + "_audio_alignment.bin");
+    for (QFile *fileHandle : { rfFileHandle, adcAudioFileHandle, pcmAudioFileHandle, alignmentFileHandle }) {
+        if (!fileHandle->open(QIODevice::WriteOnly)) {
+            // Failed to open output file
+            qDebug() << "Could not open " << fileHandle->fileName() << "as output file";
+            return false;
+        }
+        qDebug() << "Output file is" << fileHandle->fileName();
+    }
+
+    // The WAV headers are written with a zero data length, and updated once all the audio has been written
+    if (!writeWavHeader(adcAudioFileHandle, 16, 0) || !writeWavHeader(pcmAudioFileHandle, 24, 0)) return false;
+
+    uint8_t header[AudioAlignmentIndex::HeaderSizeInBytes];
+    AudioAlignmentIndex::BuildHeader(header, SidebandFrame::SamplesPerFrame, SidebandFrame::CounterValuesPerFrame, SidebandFrame::AudioSampleRate);
+    return alignmentFileHandle->write(reinterpret_cast<const char *>(header), sizeof(header)) == sizeof(header);
+}
+
+// Method to close the output files
+void SidebandDemux::closeOutputFiles()
+{
+    for (QFile **fileHandle : { &rfFileHandle, &adcAudioFileHandle, &pcmAudioFileHandle, &alignmentFileHandle }) {
+        if (*fileHandle != nullptr) {
+            (*fileHandle)->close();
+        }
+
+        // Clear the file handle pointer
+        delete *fileHandle;
+        *fileHandle = nullptr;
+    }
+}
+
+// Method to demultiplex a single chunk of the input file. This runs on a worker thread, so it only touches the input
+// file through its own file handle, and returns everything it produces for the main thread to write out.
+SidebandDemux::ChunkResult SidebandDemux::processChunk(qint64 inputSizeInBytes, qint64 chunkIndex) const
+{
+    ChunkResult result;
+
+    // Read the chunk, along with the overlap from the following chunk
+    qint64 chunkStartInBytes = chunkIndex * chunkSizeInBytes;
+    qint64 chunkEndInBytes = qMin(chunkStartInBytes + chunkSizeInBytes, inputSizeInBytes);
+    qint64 readEndInBytes = qMin(chunkEndInBytes + overlapSizeInBytes, inputSizeInBytes);
+    QFile inputFile(inputFileName);
+    if (!inputFile.open(QIODevice::ReadOnly) || !inputFile.seek(chunkStartInBytes)) {
+        qWarning() << "Could not open" << inputFileName << "to read chunk" << chunkIndex;
+        return result;
+    }
+    QByteArray inputBuffer = inputFile.read(readEndInBytes - chunkStartInBytes);
+    if (inputBuffer.size() != (readEndInBytes - chunkStartInBytes)) {
+        qWarning() << "Could not read chunk" << chunkIndex << "from" << inputFileName;
+        return result;
+    }
+    inputFile.close();
+
+    const uint8_t *inputData = reinterpret_cast<const uint8_t *>(inputBuffer.constData());
+    const size_t chunkSampleCount = static_cast<size_t>((chunkEndInBytes - chunkStartInBytes) / 2);
+    const size_t availableSampleCount = static_cast<size_t>(inputBuffer.size() / 2);
+    const quint64 chunkStartSample = static_cast<quint64>(chunkStartInBytes / 2);
+
+    // Pack the lower 10 bits of every sample into the RF output. Only the final chunk can end part way through a group
+    // of 4 samples, in which case the group is padded out with zero samples.
+    result.rfData.resize(static_cast<qint32>(((chunkSampleCount + 3) / 4) * 5));
+    uint8_t *rfPointer = reinterpret_cast<uint8_t *>(result.rfData.data());
+    for (size_t sampleIndex = 0; sampleIndex < chunkSampleCount; sampleIndex += 4) {
+        uint16_t originalWords[4];
+        for (size_t i = 0; i < 4; ++i) {
+            size_t byteOffset = (sampleIndex + i) * 2;
+            originalWords[i] = ((sampleIndex + i) < chunkSampleCount) ? (((uint16_t)inputData[byteOffset] | ((uint16_t)inputData[byteOffset + 1] << 8)) & 0x03FF) : 0;
+        }
+
+        // Convert into 5 bytes of packed 10-bit data
+        rfPointer[0] = (uint8_t)((originalWords[0] & 0x03FC) >> 2);
+        rfPointer[1] = (uint8_t)((originalWords[0] & 0x0003) << 6) | (uint8_t)((originalWords[1] & 0x03F0) >> 4);
+        rfPointer[2] = (uint8_t)((originalWords[1] & 0x000F) << 4) | (uint8_t)((originalWords[2] & 0x03C0) >> 6);
+        rfPointer[3] = (uint8_t)((originalWords[2] & 0x003F) << 2) | (uint8_t)((originalWords[3] & 0x0300) >> 8);
+        rfPointer[4] = (uint8_t)((originalWords[3] & 0x00FF));
+        rfPointer += 5;
+    }
+
+    // Walk the frames which start within this chunk. The frame position isn't known at the start of a chunk, so we
+    // search for the first sync pattern, then step from frame to frame, searching again whenever the sync is lost.
+    size_t maxFrameCount = (chunkSampleCount / SidebandFrame::SamplesPerFrame) + 1;
+    result.adcAudioData.resize(static_cast<qint32>(maxFrameCount * 4));
+    result.pcmAudioData.resize(static_cast<qint32>(maxFrameCount * 6));
+    std::vector<uint8_t> audioFieldBlocks(maxFrameCount * SidebandFrame::AudioFieldBlockSizeInBytes);
+    size_t sampleIndex = 0;
+    bool syncLocked = false;
+    while (sampleIndex < chunkSampleCount) {
+        if (!syncLocked) {
+            while ((sampleIndex < chunkSampleCount) && ((sampleIndex + SidebandFrame::SyncSampleCount) <= availableSampleCount) && !SidebandFrame::IsFrameStart(inputData, sampleIndex * 2)) {
+                ++sampleIndex;
+            }
+            if ((sampleIndex >= chunkSampleCount) || ((sampleIndex + SidebandFrame::SyncSampleCount) > availableSampleCount)) break;
+            syncLocked = true;
+        }
+
+        // A frame which is cut short by the end of the file can't be decoded
+        if ((sampleIndex + SidebandFrame::DecodedSampleCount) > availableSampleCount) break;
+        if (!SidebandFrame::IsFrameStart(inputData, sampleIndex * 2)) {
+            ++result.syncLossCount;
+            syncLocked = false;
+            ++sampleIndex;
+            continue;
+        }
+
+        // Start a new segment unless this frame directly follows the previous one
+        quint64 frameCounter = SidebandFrame::Extract48BitCounter(inputData, (sampleIndex + SidebandFrame::CounterStart) * 2);
+        quint64 rfSampleOffset = chunkStartSample + sampleIndex;
+        bool startNewSegment = result.segments.empty();
+        if (!startNewSegment) {
+            const Segment &segment = result.segments.back();
+            quint64 segmentFrameCount = static_cast<quint64>(result.frameCount - segment.firstFrameIndex);
+            startNewSegment = (frameCounter != ((segment.frameCounter + (segmentFrameCount * SidebandFrame::CounterValuesPerFrame)) & SidebandFrame::CounterMask))
+                    || (rfSampleOffset != (segment.rfSampleOffset + (segmentFrameCount * SidebandFrame::SamplesPerFrame)));
+        }
+        if (startNewSegment) result.segments.push_back({ result.frameCount, frameCounter, rfSampleOffset });
+
+        // Gather the audio fields of the frame, to be decoded along with the rest of the chunk
+        memcpy(audioFieldBlocks.data() + (static_cast<size_t>(result.frameCount) * SidebandFrame::AudioFieldBlockSizeInBytes), inputData + ((sampleIndex + SidebandFrame::Adc128Start) * 2), SidebandFrame::AudioFieldBlockSizeInBytes);
+        ++result.frameCount;
+        sampleIndex += SidebandFrame::SamplesPerFrame;
+    }
+
+    // Decode the audio from both ADCs, converting the ADC128 12-bit audio to signed and scaling it up to 16 bits as it
+    // is during capture
+    SidebandFrame::DecodeAdc128s022Audio(audioFieldBlocks.data(), static_cast<size_t>(result.frameCount), reinterpret_cast<uint8_t *>(result.adcAudioData.data()));
+    SidebandFrame::DecodePcm1802Audio(audioFieldBlocks.data(), static_cast<size_t>(result.frameCount), reinterpret_cast<uint8_t *>(result.pcmAudioData.data()));
+    result.adcAudioData.resize(static_cast<qint32>(result.frameCount * 4));
+    result.pcmAudioData.resize(static_cast<qint32>(result.frameCount * 6));
+
+    result.success = true;
+    return result;
+}
+
+// Method to append the results of a chunk to the output files. Chunks must be written in order.
+bool SidebandDemux::writeChunk(const ChunkResult &result)
+{
+    // Write the demultiplexed data
+    if (rfFileHandle->write(result.rfData) != result.rfData.size()) return false;
+    if (adcAudioFileHandle->write(result.adcAudioData) != result.adcAudioData.size()) return false;
+    if (pcmAudioFileHandle->write(result.pcmAudioData) != result.pcmAudioData.size()) return false;
+    adcAudioSizeInBytes += result.adcAudioData.size();
+    pcmAudioSizeInBytes += result.pcmAudioData.size();
+
+    // Stitch the segments from this chunk onto those before it. A segment which carries straight on from the end of the
+    // previous chunk is merged into it, otherwise the break is recorded in the same way as during capture.
+    const quint64 maxPlausibleMissingFrameCount = static_cast<quint64>(SidebandFrame::AudioSampleRate) * 10;
+    for (size_t segmentIndex = 0; segmentIndex < result.segments.size(); ++segmentIndex) {
+        const Segment &segment = result.segments[segmentIndex];
+        qint64 segmentEndFrameIndex = ((segmentIndex + 1) < result.segments.size()) ? result.segments[segmentIndex + 1].firstFrameIndex : result.frameCount;
+        qint64 segmentFrameCount = segmentEndFrameIndex - segment.firstFrameIndex;
+        quint64 segmentSampleIndex = audioSampleIndex + static_cast<quint64>(segment.firstFrameIndex);
+
+        if (pendingSegmentValid) {
+            quint64 expectedFrameCounter = (pendingSegment.frameCounter + (static_cast<quint64>(pendingSegmentFrameCount) * SidebandFrame::CounterValuesPerFrame)) & SidebandFrame::CounterMask;
+            quint64 expectedRfSampleOffset = pendingSegment.rfSampleOffset + (static_cast<quint64>(pendingSegmentFrameCount) * SidebandFrame::SamplesPerFrame);
+            if ((segment.frameCounter == expectedFrameCounter) && (segment.rfSampleOffset == expectedRfSampleOffset)) {
+                pendingSegmentFrameCount += segmentFrameCount;
+                continue;
+            }
+            if (!flushPendingSegment()) return false;
+
+            if (segment.frameCounter != expectedFrameCounter) {
+                quint64 counterDelta = (segment.frameCounter - expectedFrameCounter) & SidebandFrame::CounterMask;
+                if (((counterDelta % SidebandFrame::CounterValuesPerFrame) == 0) && ((counterDelta / SidebandFrame::CounterValuesPerFrame) <= maxPlausibleMissingFrameCount)) {
+                    gapFrameCount += counterDelta / SidebandFrame::CounterValuesPerFrame;
+                    if (!writeAlignmentRecord(AudioAlignmentIndex::RecordType::Gap, static_cast<quint32>(counterDelta / SidebandFrame::CounterValuesPerFrame), segmentSampleIndex, segment.rfSampleOffset, expectedFrameCounter)) return false;
+                } else {
+                    qDebug() << "SidebandDemux::writeChunk(): Frame counter discontinuity at sample" << segment.rfSampleOffset;
+                    ++discontinuityCount;
+                    if (!writeAlignmentRecord(AudioAlignmentIndex::RecordType::Discontinuity, 0, segmentSampleIndex, segment.rfSampleOffset, expectedFrameCounter)) return false;
+                }
+            }
+        }
+
+        pendingSegmentValid = true;
+        pendingSegment = segment;
+        pendingSegmentFrameCount = segmentFrameCount;
+        pendingSegmentSampleIndex = segmentSampleIndex;
+    }
+    audioSampleIndex += static_cast<quint64>(result.frameCount);
+    return true;
+}
+
+// Method to write a single record to the alignment index
+bool SidebandDemux::writeAlignmentRecord(AudioAlignmentIndex::RecordType recordType, quint32 frameCount, quint64 sampleIndex, quint64 rfSampleOffset, quint64 frameCounter)
+{
+    uint8_t record[AudioAlignmentIndex::RecordSizeInBytes];
+    AudioAlignmentIndex::BuildRecord(record, recordType, frameCount, sampleIndex, rfSampleOffset, frameCounter);
+    return alignmentFileHandle->write(reinterpret_cast<const char *>(record), sizeof(record)) == sizeof(record);
+}
+
+// Method to write the segment record for the segment currently being built, once its length is known
+bool SidebandDemux::flushPendingSegment()
+{
+    if (!pendingSegmentValid) return true;
+    pendingSegmentValid = false;
+    return writeAlignmentRecord(AudioAlignmentIndex::RecordType::Segment, static_cast<quint32>(pendingSegmentFrameCount), pendingSegmentSampleIndex, pendingSegment.rfSampleOffset, pendingSegment.frameCounter);
+}
+
+// Method to write the header at the start of a WAV file, leaving the write position at the end of the file
+bool SidebandDemux::writeWavHeader(QFile *fileHandle, quint16 bitsPerSample, qint64 dataSizeInBytes)
+{
+    uint8_t header[WavHeader::HeaderSizeInBytes];
+    WavHeader::Build(header, 2, SidebandFrame::AudioSampleRate, bitsPerSample, static_cast<uint64_t>(dataSizeInBytes));
+    qint64 endPosition = qMax(fileHandle->pos(), static_cast<qint64>(sizeof(header)));
+    if (!fileHandle->seek(0)) return false;
+    if (fileHandle->write(reinterpret_cast<const char *>(header), sizeof(header)) != sizeof(header)) return false;
+    return fileHandle->seek(endPosition);
+}
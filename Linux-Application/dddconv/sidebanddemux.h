@@ -0,0 +1,72 @@
+#ifndef SIDEBANDDEMUX_H
+#define SIDEBANDDEMUX_H
+
+#include <QObject>
+#include <QDebug>
+#include <QFile>
+#include <vector>
+
+#include "AudioAlignmentIndex.h"
+#include "SidebandFrame.h"
+
+class SidebandDemux : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SidebandDemux(QString inputFileNameParam, QString outputBaseNameParam, qint32 threadCountParam, QObject *parent = nullptr);
+
+    bool process();
+signals:
+
+public slots:
+
+private:
+    // A run of consecutive frames within a chunk, in both the sample stream and the frame counter sequence
+    struct Segment {
+        qint64 firstFrameIndex;
+        quint64 frameCounter;
+        quint64 rfSampleOffset;
+    };
+
+    // Everything demultiplexed from one chunk of the input file
+    struct ChunkResult {
+        bool success = false;
+        QByteArray rfData;
+        QByteArray adcAudioData;
+        QByteArray pcmAudioData;
+        qint64 frameCount = 0;
+        qint64 syncLossCount = 0;
+        std::vector<Segment> segments;
+    };
+
+    QString inputFileName;
+    QString outputBaseName;
+    qint32 threadCount;
+
+    QFile *rfFileHandle;
+    QFile *adcAudioFileHandle;
+    QFile *pcmAudioFileHandle;
+    QFile *alignmentFileHandle;
+
+    // Output state carried between chunks
+    qint64 adcAudioSizeInBytes;
+    qint64 pcmAudioSizeInBytes;
+    bool pendingSegmentValid;
+    Segment pendingSegment;
+    qint64 pendingSegmentFrameCount;
+    quint64 pendingSegmentSampleIndex;
+    quint64 audioSampleIndex;
+    quint64 gapFrameCount;
+    quint64 discontinuityCount;
+
+    // Private methods
+    bool openOutputFiles();
+    void closeOutputFiles();
+    ChunkResult processChunk(qint64 inputSizeInBytes, qint64 chunkIndex) const;
+    bool writeChunk(const ChunkResult &result);
+    bool writeAlignmentRecord(AudioAlignmentIndex::RecordType recordType, quint32 frameCount, quint64 sampleIndex, quint64 rfSampleOffset, quint64 frameCounter);
+    bool flushPendingSegment();
+    bool writeWavHeader(QFile *fileHandle, quint16 bitsPerSample, qint64 dataSizeInBytes);
+};
+
+#endif // SIDEBANDDEMUX_H